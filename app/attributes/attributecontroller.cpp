@@ -23,6 +23,7 @@
 
 #include <QDebug>
 #include <QSet>
+#include <algorithm>
 #include "qgsvectorlayer.h"
 #include "qgsattributeeditorfield.h"
 #include "qgsattributeeditorrelation.h"
@@ -351,6 +352,155 @@ void AttributeController::clearAll()
   mFormItems.clear();
   mTabItems.clear();
   mHasTabs = false;
+
+  mExpressionContext = QgsExpressionContext();
+  mExpressionCache.clear();
+  mDefaultValueExpressions.clear();
+  mDefaultValuesOrder.clear();
+  mFieldFormItems.clear();
+  mFormVisibilityExpressions.clear();
+  mTabVisibilityExpressions.clear();
+}
+
+bool AttributeController::CachedExpression::dependsOn( const QSet<int> &changedFields ) const
+{
+  // expressions without field references (e.g. now() or position variables)
+  // can change with any update, so these are always re-evaluated
+  if ( referencedFields.isEmpty() )
+    return true;
+
+  return referencedFields.intersects( changedFields );
+}
+
+std::shared_ptr<AttributeController::CachedExpression> AttributeController::cachedExpression( const QString &expression )
+{
+  if ( expression.isEmpty() )
+    return nullptr;
+
+  auto it = mExpressionCache.constFind( expression );
+  if ( it != mExpressionCache.constEnd() )
+    return it.value();
+
+  std::shared_ptr<CachedExpression> cached = std::make_shared<CachedExpression>();
+  cached->expression = QgsExpression( expression );
+  cached->expression.prepare( &mExpressionContext );
+  cached->referencedFields = cached->expression.referencedAttributeIndexes( mExpressionContext.fields() );
+
+  mExpressionCache.insert( expression, cached );
+  return cached;
+}
+
+void AttributeController::buildExpressionCache()
+{
+  QgsVectorLayer *layer = mFeatureLayerPair.layer();
+  Q_ASSERT( layer );
+
+  // Position variables are left out on purpose: they are static in their scope,
+  // so preparing with them would freeze the current position into the expressions
+  mExpressionContext = layer->createExpressionContext();
+  mExpressionContext.setFields( layer->fields() );
+
+  for ( const std::shared_ptr<TabItem> &tab : qAsConst( mTabItems ) )
+  {
+    mTabVisibilityExpressions.append( cachedExpression( tab->visibilityExpression().expression() ) );
+  }
+
+  for ( const std::shared_ptr<FormItem> &item : qAsConst( mFormItems ) )
+  {
+    std::shared_ptr<CachedExpression> visibility = cachedExpression( item->visibilityExpression().expression() );
+    if ( visibility )
+      mFormVisibilityExpressions.insert( item->id(), visibility );
+
+    if ( item->type() != FormItem::Field )
+      continue;
+
+    // the same field can be in the form more than once
+    mFieldFormItems[item->fieldIndex()].append( item->id() );
+    if ( mDefaultValueExpressions.contains( item->fieldIndex() ) )
+      continue;
+
+    const QgsField field = item->field();
+    std::shared_ptr<CachedExpression> defaultValue = cachedExpression( field.defaultValueDefinition().expression() );
+    if ( !defaultValue )
+      continue;
+
+    if ( defaultValue->expression.hasParserError() )
+      QgsMessageLog::logMessage( tr( "Default value expression for %1:%2 has parser error: %3" ).arg(
+                                   layer->name(),
+                                   field.name(),
+                                   defaultValue->expression.parserErrorString() ),
+                                 QStringLiteral( "Input" ),
+                                 Qgis::Warning );
+
+    mDefaultValueExpressions.insert( item->fieldIndex(), defaultValue );
+  }
+
+  sortDefaultValues();
+}
+
+void AttributeController::sortDefaultValues()
+{
+  // Dependency graph of fields with default values: an edge goes from a field
+  // to every field whose default value references it. References to fields
+  // without default values and self references do not affect the order.
+  QMap<int, QSet<int>> dependents;
+  QMap<int, int> unresolvedDependencies;
+
+  for ( auto it = mDefaultValueExpressions.constBegin(); it != mDefaultValueExpressions.constEnd(); ++it )
+  {
+    const int fieldIndex = it.key();
+    int dependenciesCount = 0;
+    for ( int referencedField : qAsConst( it.value()->referencedFields ) )
+    {
+      if ( referencedField == fieldIndex || !mDefaultValueExpressions.contains( referencedField ) )
+        continue;
+
+      dependents[referencedField].insert( fieldIndex );
+      ++dependenciesCount;
+    }
+    unresolvedDependencies.insert( fieldIndex, dependenciesCount );
+  }
+
+  // Kahn's algorithm, ready fields are taken in order of field index to keep the result deterministic
+  QSet<int> ready;
+  for ( auto it = unresolvedDependencies.constBegin(); it != unresolvedDependencies.constEnd(); ++it )
+  {
+    if ( it.value() == 0 )
+      ready.insert( it.key() );
+  }
+
+  while ( !ready.isEmpty() )
+  {
+    const int fieldIndex = *std::min_element( ready.constBegin(), ready.constEnd() );
+    ready.remove( fieldIndex );
+    unresolvedDependencies.remove( fieldIndex );
+    mDefaultValuesOrder.append( fieldIndex );
+
+    for ( int dependent : dependents.value( fieldIndex ) )
+    {
+      if ( --unresolvedDependencies[dependent] == 0 )
+        ready.insert( dependent );
+    }
+  }
+
+  if ( unresolvedDependencies.isEmpty() )
+    return;
+
+  // Whatever is left is part of a cycle or depends on one. Such default values
+  // are evaluated once, after all the others, in order of field index.
+  QStringList names;
+  const QgsFields fields = mFeatureLayerPair.layer()->fields();
+  for ( auto it = unresolvedDependencies.constBegin(); it != unresolvedDependencies.constEnd(); ++it )
+  {
+    mDefaultValuesOrder.append( it.key() );
+    names << fields.at( it.key() ).name();
+  }
+
+  QgsMessageLog::logMessage( tr( "Default value expressions for %1:%2 have circular dependencies" ).arg(
+                               mFeatureLayerPair.layer()->name(),
+                               names.join( QStringLiteral( ", " ) ) ),
+                             QStringLiteral( "Input" ),
+                             Qgis::Warning );
 }
 
 void AttributeController::updateOnLayerChange()
@@ -407,6 +557,8 @@ void AttributeController::updateOnLayerChange()
 
     if ( mRememberAttributesController )
       mRememberAttributesController->storeLayerFields( layer );
+
+    buildExpressionCache();
   }
 
   // 2) MODELS
@@ -486,74 +638,25 @@ void AttributeController::acquireId()
 
 bool AttributeController::recalculateDefaultValues(
   QSet<QUuid> &changedFormItems,
+  QSet<int> &changedFields,
+  bool evaluateAll,
   QgsExpressionContext &expressionContext,
   bool isFormValueChange,
   bool isFirstUpdateOfNewFeature
 )
 {
-  bool hasChanges = false;
-  QMap<QUuid, std::shared_ptr<FormItem>>::iterator formItemsIterator = mFormItems.begin();
-  while ( formItemsIterator != mFormItems.end() )
+  if ( isFirstUpdateOfNewFeature )
   {
-    std::shared_ptr<FormItem> item = formItemsIterator.value();
-    const QgsField field = item->field();
-    const QgsDefaultValue defaultDefinition = field.defaultValueDefinition();
-
-    bool shouldApplyDefaultValue =
-      !defaultDefinition.expression().isEmpty() &&
-      ( isFirstUpdateOfNewFeature || ( isFormValueChange && defaultDefinition.applyOnUpdate() ) );
-
-    if ( shouldApplyDefaultValue )
+    QMap<QUuid, std::shared_ptr<FormItem>>::iterator formItemsIterator = mFormItems.begin();
+    while ( formItemsIterator != mFormItems.end() )
     {
-      QgsExpression exp( field.defaultValueDefinition().expression() );
-      exp.prepare( &expressionContext );
-      if ( exp.hasParserError() )
-        QgsMessageLog::logMessage( tr( "Default value expression for %1:%2 has parser error: %3" ).arg(
-                                     mFeatureLayerPair.layer()->name(),
-                                     field.name(),
-                                     exp.parserErrorString() ),
-                                   QStringLiteral( "Input" ),
-                                   Qgis::Warning );
-
-      QVariant value = exp.evaluate( &expressionContext );
-
-      if ( exp.hasEvalError() )
-        QgsMessageLog::logMessage( tr( "Default value expression for %1:%2 has evaluation error: %3" ).arg(
-                                     mFeatureLayerPair.layer()->name(),
-                                     field.name(),
-                                     exp.evalErrorString() ),
-                                   QStringLiteral( "Input" ),
-                                   Qgis::Warning );
-      else
-      {
-        QVariant val( value );
-        if ( !field.convertCompatible( val ) )
-        {
-          QString msg( tr( "Value \"%1\" %4 could not be converted to a compatible value for field %2(%3)." ).arg( value.toString(), field.name(), field.typeName(), value.isNull() ? "NULL" : "NOT NULL" ) );
-          QgsMessageLog::logMessage( msg );
-        }
-        else
-        {
-          QVariant oldVal = mFeatureLayerPair.feature().attribute( item->fieldIndex() );
-          if ( val != oldVal )
-          {
-            mFeatureLayerPair.featureRef().setAttribute( item->fieldIndex(), val );
-            // Update also expression context after an attribute change
-            expressionContext.setFeature( featureLayerPair().featureRef() );
-            changedFormItems.insert( item->id() );
-            hasChanges = true;
-          }
-        }
-      }
-    }
+      std::shared_ptr<FormItem> item = formItemsIterator.value();
 
-    if ( isFirstUpdateOfNewFeature )
-    {
       // check if item is a slider, if so and it does not have default value,
       // set it's initial value from NULL to zero or minimum
       bool isSlider = item->editorWidgetType() == QStringLiteral( "Range" ) &&
                       item->editorWidgetConfig().value( QStringLiteral( "Style" ) ) == QStringLiteral( "Slider" );
-      bool hasDefaultValueDefinition = !defaultDefinition.expression().isEmpty();
+      bool hasDefaultValueDefinition = !item->field().defaultValueDefinition().expression().isEmpty();
 
       if ( isSlider && !hasDefaultValueDefinition )
       {
@@ -568,18 +671,77 @@ bool AttributeController::recalculateDefaultValues(
 
         mFeatureLayerPair.featureRef().setAttribute( item->fieldIndex(), valueToSet );
         changedFormItems.insert( item->id() );
+        changedFields.insert( item->fieldIndex() );
       }
+
+      ++formItemsIterator;
     }
+    expressionContext.setFeature( featureLayerPair().featureRef() );
+  }
 
-    ++formItemsIterator;
+  // Default values are in dependency order, so a single pass is enough
+  const QgsFields fields = mFeatureLayerPair.layer()->fields();
+  bool hasChanges = false;
+  for ( int fieldIndex : qAsConst( mDefaultValuesOrder ) )
+  {
+    const QgsField field = fields.at( fieldIndex );
+    const std::shared_ptr<CachedExpression> defaultValueExpression = mDefaultValueExpressions.value( fieldIndex );
+
+    bool shouldApplyDefaultValue =
+      ( isFirstUpdateOfNewFeature || ( isFormValueChange && field.defaultValueDefinition().applyOnUpdate() ) ) &&
+      ( evaluateAll || defaultValueExpression->dependsOn( changedFields ) );
+
+    if ( !shouldApplyDefaultValue )
+      continue;
+
+    QgsExpression &exp = defaultValueExpression->expression;
+    QVariant value = exp.evaluate( &expressionContext );
+
+    if ( exp.hasEvalError() )
+    {
+      QgsMessageLog::logMessage( tr( "Default value expression for %1:%2 has evaluation error: %3" ).arg(
+                                   mFeatureLayerPair.layer()->name(),
+                                   field.name(),
+                                   exp.evalErrorString() ),
+                                 QStringLiteral( "Input" ),
+                                 Qgis::Warning );
+      continue;
+    }
+
+    QVariant val( value );
+    if ( !field.convertCompatible( val ) )
+    {
+      QString msg( tr( "Value \"%1\" %4 could not be converted to a compatible value for field %2(%3)." ).arg( value.toString(), field.name(), field.typeName(), value.isNull() ? "NULL" : "NOT NULL" ) );
+      QgsMessageLog::logMessage( msg );
+      continue;
+    }
+
+    QVariant oldVal = mFeatureLayerPair.feature().attribute( fieldIndex );
+    if ( val != oldVal )
+    {
+      mFeatureLayerPair.featureRef().setAttribute( fieldIndex, val );
+      // Update also expression context after an attribute change
+      expressionContext.setFeature( featureLayerPair().featureRef() );
+      for ( const QUuid &id : mFieldFormItems.value( fieldIndex ) )
+        changedFormItems.insert( id );
+      changedFields.insert( fieldIndex );
+      hasChanges = true;
+    }
   }
   return hasChanges;
 }
 
-void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool isFirstUpdateOfNewFeature )
+void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool isFirstUpdateOfNewFeature, int changedFieldIndex )
 {
   QSet<QUuid> changedFormItems;
 
+  // When we know which field has changed, only expressions that depend on it
+  // (directly or through changed default values) are evaluated
+  const bool evaluateAll = changedFieldIndex < 0;
+  QSet<int> changedFields;
+  if ( !evaluateAll )
+    changedFields.insert( changedFieldIndex );
+
   QgsVectorLayer *layer = mFeatureLayerPair.layer();
   if ( !layer || !layer->isValid() )
     return;
@@ -587,31 +749,16 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
   if ( !mFeatureLayerPair.feature().isValid() )
     return;
 
-  // Create context
-  QgsFields fields = mFeatureLayerPair.feature().fields();
-  QgsExpressionContext expressionContext = layer->createExpressionContext();
+  // Create context from the cached layer scopes
+  QgsExpressionContext expressionContext = mExpressionContext;
   if ( mVariablesManager )
     expressionContext << mVariablesManager->positionScope();
 
-  expressionContext.setFields( fields );
+  expressionContext.setFields( mFeatureLayerPair.feature().fields() );
   expressionContext.setFeature( featureLayerPair().featureRef() );
 
   // Evaluate default values
-  // it could be recursive, so
-  // let say try few times
-  const int LIMIT = 3;
-  int tryNumber = 0;
-  bool anyValueChanged = true;
-  while ( anyValueChanged && tryNumber < LIMIT )
-  {
-    anyValueChanged = recalculateDefaultValues( changedFormItems, expressionContext, isFormValueChange, isFirstUpdateOfNewFeature );
-    ++tryNumber;
-  }
-  if ( anyValueChanged )
-  {
-    // ok we cut the loop on limit...
-    qDebug() << "Evaluation of default values was not finished in " << LIMIT << " tries. Giving up, sorry!";
-  }
+  recalculateDefaultValues( changedFormItems, changedFields, evaluateAll, expressionContext, isFormValueChange, isFirstUpdateOfNewFeature );
 
   // Evaluate tab items visiblity
   {
@@ -619,12 +766,17 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
     while ( tabItemsIterator != mTabItems.end() )
     {
       std::shared_ptr<TabItem> item = *tabItemsIterator;
-      QgsExpression exp = item->visibilityExpression();
-      exp.prepare( &expressionContext );
+      const std::shared_ptr<CachedExpression> exp = mTabVisibilityExpressions.value( item->tabIndex() );
+      if ( !evaluateAll && ( !exp || !exp->dependsOn( changedFields ) ) )
+      {
+        ++tabItemsIterator;
+        continue;
+      }
+
       bool visible = true;
-      if ( exp.isValid() )
+      if ( exp && exp->expression.isValid() )
       {
-        visible = exp.evaluate( &expressionContext ).toBool();
+        visible = exp->expression.evaluate( &expressionContext ).toBool();
       }
 
       if ( item->isVisible() != visible )
@@ -642,18 +794,21 @@ void AttributeController::recalculateDerivedItems( bool isFormValueChange, bool
     while ( formItemsIterator != mFormItems.end() )
     {
       std::shared_ptr<FormItem> item = formItemsIterator.value();
+      const std::shared_ptr<CachedExpression> exp = mFormVisibilityExpressions.value( item->id() );
+      if ( !evaluateAll && ( !exp || !exp->dependsOn( changedFields ) ) )
+      {
+        ++formItemsIterator;
+        continue;
+      }
+
       bool visible = true;
       if ( item->editorWidgetType() == QLatin1String( "Hidden" ) )
       {
         visible = false;
       }
-      else
+      else if ( exp && exp->expression.isValid() )
       {
-        QgsExpression exp = item->visibilityExpression();
-        exp.prepare( &expressionContext );
-
-        if ( exp.isValid() )
-          visible = exp.evaluate( &expressionContext ).toInt();
+        visible = exp->expression.evaluate( &expressionContext ).toInt();
       }
 
       if ( item->visible() != visible )
@@ -1048,7 +1203,7 @@ bool AttributeController::setFormValue( const QUuid &id, QVariant value )
 
     emit formDataChanged( item->id(), { AttributeFormModel::AttributeValue, AttributeFormModel::AttributeValueIsNull } );
 
-    recalculateDerivedItems( true, false );
+    recalculateDerivedItems( true, false, item->fieldIndex() );
     return true;
   }
   else
@@ -21,6 +21,8 @@
 #include <QVariant>
 #include <memory>
 #include <QMap>
+#include <QHash>
+#include <QSet>
 #include <QVector>
 #include <QUuid>
 
@@ -30,6 +32,7 @@
 
 #include "qgsfeature.h"
 #include "qgseditformconfig.h"
+#include "qgsexpression.h"
 #include "qgsexpressioncontext.h"
 #include "qgsattributeeditorcontainer.h"
 #include "variablesmanager.h"
@@ -165,6 +168,20 @@ class  AttributeController : public QObject
     void featureIdChanged();
 
   private:
+
+    /**
+     * Expression of the form (default value, tab or form item visibility) parsed
+     * and prepared once per layer, together with indexes of fields it references.
+     */
+    struct CachedExpression
+    {
+      QgsExpression expression;
+      QSet<int> referencedFields;
+
+      //! Returns true if the expression needs to be re-evaluated after given fields have changed
+      bool dependsOn( const QSet<int> &changedFields ) const;
+    };
+
     void clearAll();
 
     void setHasAnyChanges( bool hasChanges );
@@ -180,14 +197,36 @@ class  AttributeController : public QObject
     void updateOnLayerChange();
     void updateOnFeatureChange();
 
+    //! Parses and prepares default value and visibility expressions of all tabs and form items
+    void buildExpressionCache();
+
+    //! Orders fields with default values so that every field comes after the fields its default value depends on
+    void sortDefaultValues();
+
+    //! Returns cached expression for the text, or nullptr if the text is empty
+    std::shared_ptr<CachedExpression> cachedExpression( const QString &expression );
+
     /**
      * Recalculates visibility & constrains & default values
      * Note that reevaluate default values is needed only when an attribnute has changed.
      * Evaluation of default values for a new feature is done in digitizing controller when a feature is created.
      * @param isFormValueChange True if recalculation has to be done after an attribute has changed (called by setFormValue function).
+     * @param changedFieldIndex Index of the field that has changed. Only expressions that depend on it are re-evaluated. When -1, all expressions are evaluated.
+     */
+    void recalculateDerivedItems( bool isFormValueChange = false, bool isFirstUpdateOfNewFeature = false, int changedFieldIndex = -1 );
+
+    /**
+     * Evaluates default values once, in dependency order
+     * @return true if any value has changed
      */
-    void recalculateDerivedItems( bool isFormValueChange = false, bool isFirstUpdateOfNewFeature = false );
-    bool recalculateDefaultValues( QSet<QUuid> &changedFormItems, QgsExpressionContext &context, bool isFormValueChange = false, bool isFirstUpdateOfNewFeature = false );
+    bool recalculateDefaultValues(
+      QSet<QUuid> &changedFormItems,
+      QSet<int> &changedFields,
+      bool evaluateAll,
+      QgsExpressionContext &context,
+      bool isFormValueChange = false,
+      bool isFirstUpdateOfNewFeature = false
+    );
 
     // generate tab
     void createTab( QgsAttributeEditorContainer *container );
@@ -225,6 +264,14 @@ class  AttributeController : public QObject
     QMap<QUuid, std::shared_ptr<FormItem>> mFormItems; // order of fields in tab is in tab item
     QVector<std::shared_ptr<TabItem>> mTabItems; // order of tabs by tab row number
 
+    QgsExpressionContext mExpressionContext; // layer scopes, without position variables and feature
+    QHash<QString, std::shared_ptr<CachedExpression>> mExpressionCache; // by expression text
+    QHash<int, std::shared_ptr<CachedExpression>> mDefaultValueExpressions; // by field index
+    QVector<int> mDefaultValuesOrder; // field indexes with default values, in evaluation order
+    QHash<int, QVector<QUuid>> mFieldFormItems; // form item ids by field index
+    QHash<QUuid, std::shared_ptr<CachedExpression>> mFormVisibilityExpressions; // by form item id
+    QVector<std::shared_ptr<CachedExpression>> mTabVisibilityExpressions; // by tab row number
+
     RememberAttributesController *mRememberAttributesController = nullptr; // not owned
     VariablesManager *mVariablesManager = nullptr; // not owned
 
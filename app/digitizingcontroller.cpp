@@ -15,6 +15,7 @@
 #include "qgspolygon.h"
 
 #include "inpututils.h"
+#include "qgsquickcoordinatetransformcache.h"
 #include "qgsvectorlayerutils.h"
 
 DigitizingController::DigitizingController( QObject *parent )
@@ -115,27 +116,39 @@ QgsCoordinateTransform DigitizingController::transformer() const
   if ( mMapSettings )
     context = mMapSettings->transformContext();
 
-  QgsCoordinateTransform transform( QgsCoordinateReferenceSystem( "EPSG:4326" ),
-                                    featureLayerPair().layer()->crs(),
-                                    context );
-  return transform;
+  return QgsQuickCoordinateTransformCache::transform( QgsCoordinateReferenceSystem( "EPSG:4326" ),
+         featureLayerPair().layer()->crs(),
+         context );
 }
 
 bool DigitizingController::hasEnoughPoints() const
 {
   if ( hasLineGeometry( featureLayerPair().layer() ) )
   {
-    return mRecordedPoints.length() >= 2;
+    return mRecordedPoints.size() >= 2;
   }
   else if ( hasPolygonGeometry( featureLayerPair().layer() ) )
   {
-    return mRecordedPoints.length() >= 3;
+    return mRecordedPoints.size() >= 3;
   }
 
   // Point capturing doesn't use mRecordedPoints
   return true;
 }
 
+double DigitizingController::displayTolerance() const
+{
+  if ( !mMapSettings || !featureLayerPair().layer() )
+    return 0;
+
+  const QgsMapSettings mapSettings = mMapSettings->mapSettings();
+  if ( mapSettings.outputSize().width() <= 0 )
+    return 0;
+
+  const QgsRectangle layerExtent = mapSettings.mapToLayerCoordinates( featureLayerPair().layer(), mapSettings.visibleExtent() );
+  return layerExtent.width() / mapSettings.outputSize().width();
+}
+
 VariablesManager *DigitizingController::variablesManager() const
 {
   return mVariablesManager;
@@ -169,6 +182,8 @@ bool DigitizingController::manualRecording() const
 void DigitizingController::setManualRecording( bool manualRecording )
 {
   mManualRecording = manualRecording;
+  // every point added by the user must stay visible, streamed tracks only need the detail of the screen
+  mRecordedPoints.setTolerance( mManualRecording ? 0 : displayTolerance() );
   emit manualRecordingChanged();
 }
 
@@ -192,14 +207,16 @@ std::unique_ptr<QgsPoint> DigitizingController::getLayerPoint( const QgsPoint &p
 
     QgsPoint *tempPoint = point.clone();
     QgsGeometry geom( tempPoint );
-    QgsCoordinateTransform ct( mPositionKit->positionCRS(), featureLayerPair().layer()->crs(), mMapSettings->mapSettings().transformContext() );
+    const QgsCoordinateTransform ct = QgsQuickCoordinateTransformCache::transform( mPositionKit->positionCRS(), featureLayerPair().layer()->crs(), mMapSettings->transformContext() );
     geom.transform( ct );
     layerPoint = std::unique_ptr<QgsPoint>( qgsgeometry_cast<QgsPoint *>( geom.get() )->clone() );
 
   }
   else
   {
-    QgsPointXY layerPointXY = mMapSettings->mapSettings().mapToLayerCoordinates( featureLayerPair().layer(), QgsPointXY( point.x(), point.y() ) );
+    // GPS points are kept as they are, snapping them would distort tracks recorded in streaming mode
+    QgsPoint mapPoint = mSnappingKit ? mSnappingKit->snapPoint( point ) : point;
+    QgsPointXY layerPointXY = mMapSettings->mapSettings().mapToLayerCoordinates( featureLayerPair().layer(), QgsPointXY( mapPoint.x(), mapPoint.y() ) );
     layerPoint = std::unique_ptr<QgsPoint>( new QgsPoint( layerPointXY ) );
   }
   fixZ( *layerPoint );
@@ -244,13 +261,28 @@ void DigitizingController::startRecording()
   if ( mRecording ) return;
 
   mRecordedPoints.clear();
+  mRecordedPoints.setTolerance( mManualRecording ? 0 : displayTolerance() );
+
+  bool restored = false;
+  if ( !mTrackJournalPath.isEmpty() && featureLayerPair().layer() )
+  {
+    // points of a recording interrupted by a crash of the app
+    restored = mRecordedPoints.restoreJournal( mTrackJournalPath, featureLayerPair().layer()->id() ) > 0;
+    if ( !restored )
+      mRecordedPoints.startJournal( mTrackJournalPath, featureLayerPair().layer()->id() );
+  }
+
   mRecording = true;
   emit recordingChanged();
+
+  if ( restored )
+    setFeatureLayerPair( displayFeature() );
 }
 
 void DigitizingController::stopRecording()
 {
   mRecording = false;
+  mRecordedPoints.discardJournal();
   mRecordedPoints.clear();
   emit recordingChanged();
 }
@@ -276,15 +308,10 @@ void DigitizingController::onPositionChanged()
   }
   else
   {
-    if ( !mRecordedPoints.isEmpty() )
-    {
-      mRecordedPoints.last().setX( layerPoint->x() );
-      mRecordedPoints.last().setY( layerPoint->y() );
-      mRecordedPoints.last().setZ( layerPoint->z() );
-    }
+    mRecordedPoints.updateLast( *layerPoint.get() );
   }
 
-  setFeatureLayerPair( lineOrPolygonFeature() );
+  setFeatureLayerPair( displayFeature() );
 }
 
 
@@ -296,10 +323,23 @@ FeatureLayerPair DigitizingController::lineOrPolygonFeature()
   if ( mRecordedPoints.isEmpty() )
     return FeatureLayerPair();
 
+  return featureFromLineString( mRecordedPoints.lineString() );
+}
+
+FeatureLayerPair DigitizingController::displayFeature()
+{
+  if ( !featureLayerPair().layer() )
+    return FeatureLayerPair();
+
+  if ( mRecordedPoints.isEmpty() )
+    return FeatureLayerPair();
+
+  return featureFromLineString( mRecordedPoints.displayLineString() );
+}
+
+FeatureLayerPair DigitizingController::featureFromLineString( QgsLineString *linestring )
+{
   QgsGeometry geom;
-  QgsLineString *linestring = new QgsLineString;
-  Q_FOREACH ( const QgsPoint &pt, mRecordedPoints )
-    linestring->addVertex( pt );
   if ( hasLineGeometry( featureLayerPair().layer() ) )
   {
     geom = QgsGeometry( linestring );
@@ -310,6 +350,10 @@ FeatureLayerPair DigitizingController::lineOrPolygonFeature()
     polygon->setExteriorRing( linestring );
     geom = QgsGeometry( polygon );
   }
+  else
+  {
+    delete linestring;
+  }
 
   return createFeatureLayerPair( geom );
 }
@@ -343,7 +387,7 @@ void DigitizingController::addRecordPoint( const QgsPoint &point, bool isGpsPoin
   std::unique_ptr<QgsPoint> layerPoint = getLayerPoint( point, isGpsPoint );
   mRecordedPoints.append( *layerPoint.get() );
 
-  setFeatureLayerPair( lineOrPolygonFeature() );
+  setFeatureLayerPair( displayFeature() );
 }
 
 void DigitizingController::removeLastPoint()
@@ -355,11 +399,12 @@ void DigitizingController::removeLastPoint()
   {
     // cancel recording
     mRecording = false;
+    mRecordedPoints.discardJournal();
     emit recordingChanged();
 
     return;
   }
 
   mRecordedPoints.removeLast();
-  setFeatureLayerPair( lineOrPolygonFeature() );
+  setFeatureLayerPair( displayFeature() );
 }
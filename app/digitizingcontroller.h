@@ -19,6 +19,8 @@
 #include "positionkit.h"
 #include "featurelayerpair.h"
 #include "variablesmanager.h"
+#include "snappingkit.h"
+#include "trackrecorder.h"
 
 class DigitizingController : public QObject
 {
@@ -34,6 +36,10 @@ class DigitizingController : public QObject
     Q_PROPERTY( QgsQuickMapSettings *mapSettings MEMBER mMapSettings NOTIFY mapSettingsChanged )
     //! If True, recorded point is from GPS and contains z-coord
     Q_PROPERTY( bool useGpsPoint MEMBER mUseGpsPoint NOTIFY useGpsPointChanged )
+    //! If set, points recorded by the user (not from GPS) are snapped to the features of the map
+    Q_PROPERTY( SnappingKit *snappingKit MEMBER mSnappingKit NOTIFY snappingKitChanged )
+    //! If set, recorded points are journaled to this file and restored from it when recording in the same layer starts after a crash
+    Q_PROPERTY( QString trackJournalPath MEMBER mTrackJournalPath NOTIFY trackJournalPathChanged )
 
   public:
     explicit DigitizingController( QObject *parent = nullptr );
@@ -96,6 +102,8 @@ class DigitizingController : public QObject
     void mapSettingsChanged();
     void lineRecordingIntervalChanged();
     void useGpsPointChanged();
+    void snappingKitChanged();
+    void trackJournalPathChanged();
 
   private slots:
     void onPositionChanged();
@@ -104,19 +112,26 @@ class DigitizingController : public QObject
     void fixZ( QgsPoint &point ) const; // add/remove Z coordinate based on layer wkb type
     QgsCoordinateTransform transformer() const;
     bool hasEnoughPoints() const;
+    //! Returns size of a screen pixel in layer units, used to simplify the highlight of streamed tracks
+    double displayTolerance() const;
+    //! Creates a feature with simplified geometry for the highlight
+    FeatureLayerPair displayFeature();
+    FeatureLayerPair featureFromLineString( QgsLineString *linestring );
 
     bool mRecording = false;
     //! Flag if a point is added to mRecordedPoints by user interaction (true) or onPositionChanged (false)
     //! Used only for polyline and polygon features.
     bool mManualRecording = true;
     PositionKit *mPositionKit = nullptr;
-    QVector<QgsPoint> mRecordedPoints;  //!< for recording of linestrings, point's coord in layer CRS
+    TrackRecorder mRecordedPoints;  //!< for recording of linestrings, point's coord in layer CRS
     FeatureLayerPair mFeatureLayerPair; //!< to be used for highlight of feature being recorded
     QgsQuickMapSettings *mMapSettings = nullptr;
     VariablesManager *mVariablesManager = nullptr; // not owned
     int mLineRecordingInterval = 3; // in seconds
     QDateTime mLastTimeRecorded;
     bool mUseGpsPoint = false;
+    SnappingKit *mSnappingKit = nullptr; // not owned
+    QString mTrackJournalPath;
 };
 
 #endif // DIGITIZINGCONTROLLER_H
@@ -15,10 +15,12 @@
 
 #include <memory>
 
+#include "qgscoordinatetransform.h"
 #include "qgsvectorlayer.h"
 
 #include "featurehighlight.h"
 #include "qgsquickmapsettings.h"
+#include "qgsquickcoordinatetransformcache.h"
 #include "highlightsgnode.h"
 
 
@@ -28,57 +30,108 @@ FeatureHighlight::FeatureHighlight( QQuickItem *parent )
   setFlags( QQuickItem::ItemHasContents );
   setAntialiasing( true );
 
-  // transform to device coords
-  mTransform.appendToItem( this );
-
   connect( this, &FeatureHighlight::mapSettingsChanged, this, &FeatureHighlight::onMapSettingsChanged );
-  connect( this, &FeatureHighlight::featureLayerPairChanged, this, &FeatureHighlight::markDirty );
-  connect( this, &FeatureHighlight::colorChanged, this, &FeatureHighlight::markDirty );
-  connect( this, &FeatureHighlight::widthChanged, this, &FeatureHighlight::markDirty );
+  connect( this, &FeatureHighlight::featureLayerPairChanged, this, &FeatureHighlight::updateGeometries );
+  connect( this, &FeatureHighlight::featureLayerPairsChanged, this, &FeatureHighlight::updateGeometries );
+  connect( this, &FeatureHighlight::colorChanged, this, &FeatureHighlight::markStyleDirty );
+  connect( this, &FeatureHighlight::widthChanged, this, &FeatureHighlight::markStyleDirty );
 }
 
-void FeatureHighlight::markDirty()
+void FeatureHighlight::markStyleDirty()
 {
-  mDirty = true;
+  mStyleDirty = true;
   update();
 }
 
 void FeatureHighlight::onMapSettingsChanged()
 {
-  mTransform.setMapSettings( mMapSettings );
-  markDirty();
+  disconnect( mCrsConnection );
+  disconnect( mContextConnection );
+  disconnect( mExtentConnection );
+  if ( mMapSettings )
+  {
+    mCrsConnection = connect( mMapSettings, &QgsQuickMapSettings::destinationCrsChanged, this, &FeatureHighlight::updateGeometries );
+    mContextConnection = connect( mMapSettings, &QgsQuickMapSettings::transformContextChanged, this, &FeatureHighlight::updateGeometries );
+    mExtentConnection = connect( mMapSettings, &QgsQuickMapSettings::visibleExtentChanged, this, &FeatureHighlight::onVisibleExtentChanged );
+  }
+
+  onVisibleExtentChanged();
+  updateGeometries();
 }
 
-QSGNode *FeatureHighlight::updatePaintNode( QSGNode *n, QQuickItem::UpdatePaintNodeData * )
+void FeatureHighlight::onVisibleExtentChanged()
 {
-  if ( !mDirty || !mMapSettings || !mFeatureLayerPair.isValid() )
-    return n;
+  if ( !mMapSettings )
+    return;
 
-  delete n;
-  n = new QSGNode;
+  // map to item coordinates, applied in the node matrix
+  mVisibleExtent = mMapSettings->visibleExtent();
+  mMapUnitsPerPixel = mMapSettings->mapUnitsPerPixel();
+  update();
+}
 
-  QgsVectorLayer *layer = mFeatureLayerPair.layer();
-  Q_ASSERT( layer ); // we checked the validity of feature-layer pair
-  QgsCoordinateTransform transf( layer->crs(), mMapSettings->destinationCrs(), mMapSettings->transformContext() );
+void FeatureHighlight::updateGeometries()
+{
+  mGeometries.clear();
 
-  QgsFeature feature = mFeatureLayerPair.feature();
-  if ( feature.hasGeometry() )
+  if ( mMapSettings )
   {
-    QgsGeometry geom( feature.geometry() );
-    try
-    {
-      geom.transform( transf );
-      std::unique_ptr<HighlightSGNode> rb( new HighlightSGNode( geom, mColor, mWidth ) );
-      rb->setFlag( QSGNode::OwnedByParent );
-      n->appendChildNode( rb.release() );
-    }
-    catch ( QgsCsException &e )
+    FeatureLayerPairs pairs = mFeatureLayerPairs;
+    if ( mFeatureLayerPair.isValid() )
+      pairs.prepend( mFeatureLayerPair );
+
+    mGeometries.reserve( pairs.size() );
+
+    for ( const FeatureLayerPair &pair : qAsConst( pairs ) )
     {
-      Q_UNUSED( e )
-      // Caught an error in transform
+      if ( !pair.isValid() || !pair.feature().hasGeometry() )
+        continue;
+
+      QgsVectorLayer *layer = pair.layer();
+      const QgsCoordinateTransform ct = QgsQuickCoordinateTransformCache::transform( layer->crs(), mMapSettings->destinationCrs(), mMapSettings->transformContext() );
+
+      QgsGeometry geom( pair.feature().geometry() );
+      try
+      {
+        geom.transform( ct );
+        mGeometries << geom;
+      }
+      catch ( QgsCsException &e )
+      {
+        Q_UNUSED( e )
+        // Caught an error in transform
+      }
     }
   }
-  mDirty = false;
 
-  return n;
+  mGeometryDirty = true;
+  update();
+}
+
+QSGNode *FeatureHighlight::updatePaintNode( QSGNode *n, QQuickItem::UpdatePaintNodeData * )
+{
+  HighlightSGNode *node = static_cast<HighlightSGNode *>( n );
+  if ( !node )
+  {
+    node = new HighlightSGNode( mColor, mWidth );
+    mGeometryDirty = true;
+    mStyleDirty = false;
+  }
+
+  if ( mStyleDirty )
+  {
+    node->setColor( mColor );
+    node->setWidth( mWidth );
+    mStyleDirty = false;
+  }
+
+  // vertices stay in map coordinates, panning and zooming only changes the node matrix
+  if ( mGeometryDirty )
+  {
+    node->setGeometries( mGeometries );
+    mGeometryDirty = false;
+  }
+  node->setMapTransform( mVisibleExtent, mMapUnitsPerPixel );
+
+  return node;
 }
@@ -19,8 +19,9 @@
 #include <QQuickItem>
 
 #include "featurelayerpair.h"
+#include "qgsgeometry.h"
 
-#include "qgsquickmaptransform.h"
+#include "qgsrectangle.h"
 
 class QgsQuickMapSettings;
 
@@ -32,6 +33,9 @@ class QgsQuickMapSettings;
  * The highlights are compatible with the QtQuick scene graph and
  * can be directly shown on map canvas
  *
+ * Geometries are transformed to the map CRS only when the highlighted features
+ * or the map CRS change. Panning and zooming just updates the node matrix.
+ *
  * \note QML Type: FeatureHighlight
  *
  * \since QGIS 3.4
@@ -50,6 +54,12 @@ class  FeatureHighlight : public QQuickItem
      */
     Q_PROPERTY( FeatureLayerPair featureLayerPair MEMBER mFeatureLayerPair NOTIFY featureLayerPairChanged )
 
+    /**
+     * Further features to highlight together with featureLayerPair, e.g. a selection.
+     * All of them are rendered with the same color and width.
+     */
+    Q_PROPERTY( FeatureLayerPairs featureLayerPairs MEMBER mFeatureLayerPairs NOTIFY featureLayerPairsChanged )
+
     /**
      * Color of the highlighted geometry (feature).
      *
@@ -72,6 +82,9 @@ class  FeatureHighlight : public QQuickItem
     //! \copydoc FeatureHighlight::featureLayerPair
     void featureLayerPairChanged();
 
+    //! \copydoc FeatureHighlight::featureLayerPairs
+    void featureLayerPairsChanged();
+
     //! \copydoc FeatureHighlight::color
     void colorChanged();
 
@@ -82,18 +95,29 @@ class  FeatureHighlight : public QQuickItem
     void mapSettingsChanged();
 
   private slots:
-    void markDirty();
+    void markStyleDirty();
     void onMapSettingsChanged();
+    void onVisibleExtentChanged();
+
+    //! Transforms geometries of highlighted features to the map CRS
+    void updateGeometries();
 
   private:
     QSGNode *updatePaintNode( QSGNode *n, UpdatePaintNodeData * ) override;
 
     QColor mColor = Qt::yellow;
-    bool mDirty = false;
+    bool mGeometryDirty = false;
+    bool mStyleDirty = false;
     float mWidth = 20;
     FeatureLayerPair mFeatureLayerPair;
+    FeatureLayerPairs mFeatureLayerPairs;
+    QVector<QgsGeometry> mGeometries; // in map CRS
+    QMetaObject::Connection mCrsConnection;
+    QMetaObject::Connection mContextConnection;
+    QMetaObject::Connection mExtentConnection;
     QgsQuickMapSettings *mMapSettings = nullptr; // not owned
-    QgsQuickMapTransform mTransform;
+    QgsRectangle mVisibleExtent;
+    double mMapUnitsPerPixel = 1;
 };
 
 #endif // FEATUREHIGHLIGHT_H
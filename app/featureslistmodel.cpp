@@ -14,19 +14,39 @@
  ***************************************************************************/
 
 #include "featureslistmodel.h"
+#include "featuressearchindex.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsvectorlayerfeatureiterator.h"
 #include "qgslogger.h"
 #include "coreutils.h"
 
+#include <QtConcurrent>
+#include <atomic>
+
+struct FeaturesListModel::FetchJob
+{
+  std::unique_ptr<QgsVectorLayerFeatureSource> source;
+  QgsFeatureRequest request;
+  QgsFeatureIterator iterator;  //!< created with the first page
+  bool started = false;
+  std::atomic<bool> exhausted { false };  //!< set on the worker thread when there are no more features
+  std::atomic<bool> canceled { false };  //!< set when results of the job are not needed anymore (e.g. search expression changed)
+};
+
 FeaturesListModel::FeaturesListModel( QObject *parent )
   : QAbstractListModel( parent ),
     mCurrentLayer( nullptr )
 {
   // avoid dangling pointers to mCurrentLayer/mCurrentFeature when switching projects
   QObject::connect( QgsProject::instance(), &QgsProject::cleared, this, &FeaturesListModel::emptyData );
+  QObject::connect( &mFetchWatcher, &QFutureWatcher<QgsFeatureList>::finished, this, &FeaturesListModel::pageFetched );
 }
 
-FeaturesListModel::~FeaturesListModel() = default;
+FeaturesListModel::~FeaturesListModel()
+{
+  cancelFetchJob();
+  mFetchWatcher.waitForFinished();
+}
 
 int FeaturesListModel::rowCount( const QModelIndex &parent ) const
 {
@@ -69,14 +89,17 @@ QVariant FeaturesListModel::data( const QModelIndex &index, int role ) const
   if ( !index.isValid() )
     return QVariant();
 
-  const FeatureLayerPair pair = mFeatures.at( index.row() );
+  return pairData( mFeatures.at( index.row() ), role );
+}
 
+QVariant FeaturesListModel::pairData( const FeatureLayerPair &pair, int role ) const
+{
   switch ( role )
   {
     case FeatureTitle: return featureTitle( pair );
     case FeatureId: return QVariant( pair.feature().id() );
-    case Feature: return QVariant::fromValue<QgsFeature>( pair.feature() );
-    case FeaturePair: return QVariant::fromValue<FeatureLayerPair>( pair );
+    case Feature: return QVariant::fromValue<QgsFeature>( completeFeaturePair( pair ).feature() );
+    case FeaturePair: return QVariant::fromValue<FeatureLayerPair>( completeFeaturePair( pair ) );
     case Description: return QVariant( QString( "Feature ID %1" ).arg( pair.feature().id() ) );
     case KeyColumn: return mKeyField.isEmpty() ? QVariant() : pair.feature().attribute( mKeyField );
     case FoundPair: return foundPair( pair );
@@ -156,7 +179,24 @@ QString FeaturesListModel::buildSearchExpression()
 
 void FeaturesListModel::setupFeatureRequest( QgsFeatureRequest &request )
 {
-  if ( !mFilterExpression.isEmpty() && !mSearchExpression.isEmpty() )
+  QgsFeatureIds searchFids;
+
+  if ( !mSearchExpression.isEmpty() && searchIndexFids( searchFids ) )
+  {
+    if ( mFilterExpression.isEmpty() || searchFids.isEmpty() )
+    {
+      request.setFilterFids( searchFids );
+    }
+    else
+    {
+      QStringList fids;
+      for ( QgsFeatureId fid : qAsConst( searchFids ) )
+        fids << FID_TO_STRING( fid );
+      request.setFilterExpression( QStringLiteral( "$id IN (%1)" ).arg( fids.join( ',' ) ) );
+      request.combineFilterExpression( mFilterExpression );
+    }
+  }
+  else if ( !mFilterExpression.isEmpty() && !mSearchExpression.isEmpty() )
   {
     request.setFilterExpression( buildSearchExpression() );
     request.combineFilterExpression( mFilterExpression );
@@ -185,12 +225,33 @@ void FeaturesListModel::setupFeatureRequest( QgsFeatureRequest &request )
   }
 }
 
-void FeaturesListModel::loadFeaturesFromLayer( QgsVectorLayer *layer )
+void FeaturesListModel::loadFeaturesFromLayer( QgsVectorLayer *layer, bool inBackground )
 {
   if ( layer && layer->isValid() )
     mCurrentLayer = layer;
 
-  if ( mCurrentLayer )
+  if ( mCurrentLayer && mIncremental )
+  {
+    beginResetModel();
+    mFeatures.clear();
+
+    startFetchJob();
+    if ( inBackground )
+    {
+      fetchNextPage();
+    }
+    else
+    {
+      // the first page is loaded right away so that the model is usable as soon as it is populated
+      const QgsFeatureList features = fetchPage( mFetchJob, FETCH_PAGE_SIZE );
+      for ( const QgsFeature &f : features )
+        mFeatures << FeatureLayerPair( f, mCurrentLayer );
+    }
+
+    emit featuresCountChanged( featuresCount() );
+    endResetModel();
+  }
+  else if ( mCurrentLayer )
   {
     beginResetModel();
     mFeatures.clear();
@@ -259,8 +320,167 @@ void FeaturesListModel::reloadFeatures()
   loadFeaturesFromLayer();
 }
 
+void FeaturesListModel::startFetchJob()
+{
+  cancelFetchJob();
+
+  std::shared_ptr<FetchJob> job = std::make_shared<FetchJob>();
+  job->source.reset( new QgsVectorLayerFeatureSource( mCurrentLayer ) );
+
+  setupFeatureRequest( job->request );
+  job->request.setLimit( -1 );
+  job->request.setFlags( QgsFeatureRequest::NoGeometry );
+
+  // fetch only attributes needed for the list (attributes used in the filter expression are added by the iterator)
+  QSet<QString> attributes;
+  if ( !mKeyField.isEmpty() )
+    attributes << mKeyField;
+  if ( !mFeatureTitleField.isEmpty() )
+    attributes << mFeatureTitleField;
+  attributes.unite( QgsExpression( mCurrentLayer->displayExpression() ).referencedColumns() );
+
+  if ( !attributes.contains( QgsFeatureRequest::ALL_ATTRIBUTES ) )
+    job->request.setSubsetOfAttributes( attributes, mCurrentLayer->fields() );
+
+  mFetchJob = job;
+}
+
+void FeaturesListModel::cancelFetchJob()
+{
+  if ( mFetchJob )
+  {
+    mFetchJob->canceled = true;
+    mFetchJob.reset();
+  }
+
+  // a page that is still being fetched belongs to a canceled job, it gets dropped in pageFetched()
+}
+
+void FeaturesListModel::fetchNextPage()
+{
+  if ( !mFetchJob || mFetchJob->exhausted || mFetchingJob == mFetchJob )
+    return;
+
+  bool wasFetching = fetching();
+  mFetchingJob = mFetchJob;
+
+  // the watcher drops the future of a previous (canceled) job when watching a new one
+  mFetchWatcher.setFuture( QtConcurrent::run( &FeaturesListModel::fetchPage, mFetchJob, FETCH_PAGE_SIZE ) );
+
+  if ( !wasFetching )
+    emit fetchingChanged( true );
+}
+
+void FeaturesListModel::pageFetched()
+{
+  std::shared_ptr<FetchJob> job = mFetchingJob;
+  mFetchingJob.reset();
+
+  if ( !job || job != mFetchJob )
+  {
+    // the search has changed meanwhile
+    emit fetchingChanged( false );
+    return;
+  }
+
+  const QgsFeatureList features = mFetchWatcher.result();
+  if ( !features.isEmpty() && mCurrentLayer )
+  {
+    beginInsertRows( QModelIndex(), mFeatures.count(), mFeatures.count() + features.count() - 1 );
+    for ( const QgsFeature &f : features )
+      mFeatures << FeatureLayerPair( f, mCurrentLayer );
+    endInsertRows();
+  }
+
+  emit fetchingChanged( false );
+}
+
+QgsFeatureList FeaturesListModel::fetchPage( std::shared_ptr<FetchJob> job, int count )
+{
+  QgsFeatureList features;
+  if ( job->exhausted )
+    return features;
+
+  if ( !job->started )
+  {
+    job->iterator = job->source->getFeatures( job->request );
+    job->started = true;
+  }
+
+  QgsFeature f;
+  while ( features.count() < count )
+  {
+    if ( job->canceled )
+      return QgsFeatureList();
+
+    if ( !job->iterator.nextFeature( f ) )
+    {
+      job->exhausted = true;
+      job->iterator.close();
+      break;
+    }
+    features << f;
+  }
+
+  return features;
+}
+
+bool FeaturesListModel::canFetchMore( const QModelIndex &parent ) const
+{
+  if ( parent.isValid() )
+    return false;
+
+  return mIncremental && mFetchJob && !mFetchJob->exhausted;
+}
+
+void FeaturesListModel::fetchMore( const QModelIndex &parent )
+{
+  if ( parent.isValid() )
+    return;
+
+  fetchNextPage();
+}
+
+FeatureLayerPair FeaturesListModel::findFeatureInLayer( int role, const QVariant &value ) const
+{
+  if ( !mIncremental || !mCurrentLayer || !mFetchJob || mFetchJob->exhausted )
+    return FeatureLayerPair();  // all features are loaded, no need to look further
+
+  QString expression;
+  if ( role == FeatureId )
+    expression = QStringLiteral( "$id = %1" ).arg( value.toLongLong() );
+  else if ( role == KeyColumn && !mKeyField.isEmpty() )
+    expression = QgsExpression::createFieldEqualityExpression( mKeyField, value.toString().trimmed() );
+  else
+    return FeatureLayerPair();
+
+  QgsFeatureRequest request( mFetchJob->request );
+  request.combineFilterExpression( expression );
+  request.setLimit( 1 );
+
+  QgsFeature f;
+  if ( mCurrentLayer->getFeatures( request ).nextFeature( f ) )
+    return FeatureLayerPair( f, mCurrentLayer );
+
+  return FeatureLayerPair();
+}
+
+FeatureLayerPair FeaturesListModel::completeFeaturePair( const FeatureLayerPair &pair ) const
+{
+  if ( !mIncremental || !pair.layer() )
+    return pair;
+
+  return FeatureLayerPair( pair.layer()->getFeature( pair.feature().id() ), pair.layer() );
+}
+
 void FeaturesListModel::emptyData()
 {
+  cancelFetchJob();
+  if ( mSearchIndex )
+  {
+    disconnect( mSearchIndex.get(), &FeaturesSearchIndex::ready, this, &FeaturesListModel::searchIndexReady );
+    mSearchIndex.reset();
+  }
   mFeatures.clear();
   mCurrentLayer = nullptr;
   mKeyField.clear();
@@ -300,7 +520,8 @@ void FeaturesListModel::setSearchExpression( const QString &searchExpression )
   mSearchExpression = searchExpression;
   emit searchExpressionChanged( mSearchExpression );
 
-  loadFeaturesFromLayer();
+  // do not block typing in incremental mode - results of a previous search are dropped
+  loadFeaturesFromLayer( nullptr, true );
 }
 
 void FeaturesListModel::setFeatureTitleField( const QString &attribute )
@@ -338,6 +559,65 @@ int FeaturesListModel::featuresLimit() const
   return FEATURES_LIMIT;
 }
 
+bool FeaturesListModel::incremental() const
+{
+  return mIncremental;
+}
+
+void FeaturesListModel::setIncremental( bool incremental )
+{
+  if ( mIncremental == incremental )
+    return;
+
+  mIncremental = incremental;
+  emit incrementalChanged( mIncremental );
+}
+
+bool FeaturesListModel::fetching() const
+{
+  return static_cast<bool>( mFetchingJob );
+}
+
+bool FeaturesListModel::useSearchIndex() const
+{
+  return mUseSearchIndex;
+}
+
+void FeaturesListModel::setUseSearchIndex( bool useSearchIndex )
+{
+  if ( mUseSearchIndex == useSearchIndex )
+    return;
+
+  mUseSearchIndex = useSearchIndex;
+  if ( !mUseSearchIndex )
+    mSearchIndex.reset();
+  emit useSearchIndexChanged( mUseSearchIndex );
+}
+
+bool FeaturesListModel::searchIndexFids( QgsFeatureIds &fids )
+{
+  if ( !mUseSearchIndex || !mCurrentLayer )
+    return false;
+
+  std::shared_ptr<FeaturesSearchIndex> index = FeaturesSearchIndex::forLayer( mCurrentLayer );
+  if ( index != mSearchIndex )
+  {
+    if ( mSearchIndex )
+      disconnect( mSearchIndex.get(), &FeaturesSearchIndex::ready, this, &FeaturesListModel::searchIndexReady );
+    mSearchIndex = index;
+    connect( mSearchIndex.get(), &FeaturesSearchIndex::ready, this, &FeaturesListModel::searchIndexReady );
+  }
+
+  return mSearchIndex->search( mSearchExpression, fids );
+}
+
+void FeaturesListModel::searchIndexReady()
+{
+  // the current search is still evaluated without the index - redo it with the index
+  if ( !mSearchExpression.isEmpty() && fetching() )
+    loadFeaturesFromLayer( nullptr, true );
+}
+
 int FeaturesListModel::rowFromAttribute( const int role, const QVariant &value ) const
 {
   for ( int i = 0; i < mFeatures.count(); ++i )
@@ -362,6 +642,11 @@ QVariant FeaturesListModel::attributeFromValue( const int role, const QVariant &
       return key;
     }
   }
+
+  FeatureLayerPair pair = findFeatureInLayer( role, value );
+  if ( pair.feature().isValid() )
+    return pairData( pair, requestedRole );
+
   return QVariant();
 }
 
@@ -385,7 +670,7 @@ FeatureLayerPair FeaturesListModel::featureLayerPair( const int &featureId )
   for ( const FeatureLayerPair &i : mFeatures )
   {
     if ( i.feature().id() == featureId )
-      return i;
+      return completeFeaturePair( i );
   }
-  return FeatureLayerPair();
+  return completeFeaturePair( findFeatureInLayer( FeatureId, featureId ) );
 }
@@ -17,11 +17,16 @@
 #define FEATURESMODEL_H
 
 #include <QAbstractListModel>
+#include <QFutureWatcher>
+
+#include <memory>
 
 #include "qgsvectorlayer.h"
 #include "featurelayerpair.h"
 #include "qgsvaluerelationfieldformatter.h"
 
+class FeaturesSearchIndex;
+
 /**
  * \brief List Model holding features of specific layer.
  *
@@ -57,6 +62,25 @@ class  FeaturesListModel : public QAbstractListModel
       */
     Q_PROPERTY( QgsFeature currentFeature READ currentFeature WRITE setCurrentFeature NOTIFY currentFeatureChanged )
 
+    /**
+     * When set, features are loaded in pages of FETCH_PAGE_SIZE features (see canFetchMore() and fetchMore()).
+     * The first page is loaded right away, further pages and results of searches are fetched on a worker thread.
+     * Only attributes needed for title and key are fetched without geometry, so Feature and FeaturePair roles
+     * read the complete feature from the layer. featuresLimit does not apply in this mode.
+     * Needs to be set before the model is populated. False by default.
+     */
+    Q_PROPERTY( bool incremental READ incremental WRITE setIncremental NOTIFY incrementalChanged )
+
+    //! True while a page of features is being fetched in background (only in incremental mode)
+    Q_PROPERTY( bool fetching READ fetching NOTIFY fetchingChanged )
+
+    /**
+     * When set, search expression is evaluated with an in-memory index of the layer (see FeaturesSearchIndex)
+     * and matching features are requested by their IDs. Until the index is built in background, the search
+     * is done with a filter expression. False by default.
+     */
+    Q_PROPERTY( bool useSearchIndex READ useSearchIndex WRITE setUseSearchIndex NOTIFY useSearchIndexChanged )
+
   public:
 
     //! Roles for FeaturesListModel
@@ -83,6 +107,9 @@ class  FeaturesListModel : public QAbstractListModel
     QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
     QHash<int, QByteArray> roleNames() const override;
 
+    bool canFetchMore( const QModelIndex &parent ) const override;
+    void fetchMore( const QModelIndex &parent ) override;
+
     /**
      * \brief setupValueRelation populates model with value relation data from config
      * \param config to be used
@@ -162,6 +189,17 @@ class  FeaturesListModel : public QAbstractListModel
     //! Gets current feature property
     QgsFeature currentFeature() const;
 
+    bool incremental() const;
+    void setIncremental( bool incremental );
+
+    bool fetching() const;
+
+    bool useSearchIndex() const;
+    void setUseSearchIndex( bool useSearchIndex );
+
+    //! Number of features fetched at once in incremental mode
+    static const int FETCH_PAGE_SIZE = 100;
+
   signals:
 
     /**
@@ -179,13 +217,25 @@ class  FeaturesListModel : public QAbstractListModel
     //! Signal emitted when current feature has changed
     void currentFeatureChanged( QgsFeature feature );
 
+    void incrementalChanged( bool incremental );
+
+    void fetchingChanged( bool fetching );
+
+    void useSearchIndexChanged( bool useSearchIndex );
+
   protected:
 
     //! Sets maximum limit and filter expression for request.
     void setupFeatureRequest( QgsFeatureRequest &request );
 
-    //! Reloads features from layer, if layer is not provided, uses current layer, If layer is provided, saves it as current.
-    void loadFeaturesFromLayer( QgsVectorLayer *layer = nullptr );
+    /**
+     * Reloads features from layer, if layer is not provided, uses current layer, If layer is provided, saves it as current.
+     * In incremental mode the first page is fetched in background if \a inBackground is true.
+     */
+    void loadFeaturesFromLayer( QgsVectorLayer *layer = nullptr, bool inBackground = false );
+
+    //! Returns value of a role for given feature
+    QVariant pairData( const FeatureLayerPair &pair, int role ) const;
 
     //! Empty data when resetting model
     virtual void emptyData();
@@ -227,6 +277,45 @@ class  FeaturesListModel : public QAbstractListModel
     //! Field that represents field used as a feature title, if not set, display expression is used
     QString mFeatureTitleField;
 
+  private slots:
+    void pageFetched();
+    void searchIndexReady();
+
+  private:
+    //! State of the incremental loading of features for the current layer and search
+    struct FetchJob;
+
+    //! Starts a new fetch job for the current layer and request, previous job gets canceled
+    void startFetchJob();
+
+    //! Drops the current fetch job (a page that is being fetched is thrown away)
+    void cancelFetchJob();
+
+    //! Starts fetching of the next page in background
+    void fetchNextPage();
+
+    //! Reads next page of features, called on a worker thread
+    static QgsFeatureList fetchPage( std::shared_ptr<FetchJob> job, int count );
+
+    //! In incremental mode, looks for a feature not fetched yet directly in the layer
+    FeatureLayerPair findFeatureInLayer( int role, const QVariant &value ) const;
+
+    //! Reads complete feature from the layer (features are fetched only with some attributes in incremental mode)
+    FeatureLayerPair completeFeaturePair( const FeatureLayerPair &pair ) const;
+
+    /**
+     * Looks up features matching the search expression in the search index of the current layer.
+     * Returns false if the index is not used or not ready yet.
+     */
+    bool searchIndexFids( QgsFeatureIds &fids );
+
+    bool mIncremental = false;
+    std::shared_ptr<FetchJob> mFetchJob;
+    std::shared_ptr<FetchJob> mFetchingJob;  //!< job whose page is being fetched
+    QFutureWatcher<QgsFeatureList> mFetchWatcher;
+
+    bool mUseSearchIndex = false;
+    std::shared_ptr<FeaturesSearchIndex> mSearchIndex;
 };
 
 #endif // FEATURESMODEL_H
@@ -0,0 +1,209 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "featuressearchindex.h"
+
+#include <QElapsedTimer>
+
+#include "coreutils.h"
+
+std::shared_ptr<FeaturesSearchIndex> FeaturesSearchIndex::forLayer( QgsVectorLayer *layer )
+{
+  // indexes live as long as some model uses them
+  return sharedForLayer<FeaturesSearchIndex>( layer, []( QgsVectorLayer * l )
+  {
+    return new FeaturesSearchIndex( l );
+  } );
+}
+
+FeaturesSearchIndex::FeaturesSearchIndex( QgsVectorLayer *layer )
+  : LayerIndex<FeaturesSearchIndexData>( layer )
+{
+  updateFields();
+
+  connect( layer, &QgsVectorLayer::updatedFields, this, &FeaturesSearchIndex::updateFields );
+  connect( layer, &QgsVectorLayer::featureAdded, this, &FeaturesSearchIndex::invalidate );
+  connect( layer, &QgsVectorLayer::featureDeleted, this, &FeaturesSearchIndex::invalidate );
+  connect( layer, &QgsVectorLayer::attributeValueChanged, this, &FeaturesSearchIndex::invalidate );
+  connect( layer, &QgsVectorLayer::dataChanged, this, &FeaturesSearchIndex::invalidate );
+}
+
+bool FeaturesSearchIndex::isSearchable( const QgsField &field )
+{
+  if ( field.configurationFlags().testFlag( QgsField::ConfigurationFlag::NotSearchable ) )
+    return false;
+
+  return field.isNumeric() || field.type() == QVariant::String;
+}
+
+bool FeaturesSearchIndex::search( const QString &text, QgsFeatureIds &fids )
+{
+  if ( !mData )
+  {
+    startBuild();
+    return false;
+  }
+
+  const Data &data = *mData;
+  const QStringList words = text.toLower().split( ' ', QString::SplitBehavior::SkipEmptyParts );
+
+  QVector<int> rows;
+  bool first = true;
+  for ( const QString &word : words )
+  {
+    bool wordIsNumeric;
+    word.toInt( &wordIsNumeric );
+
+    QVector<int> candidates;
+    if ( first )
+    {
+      // take the rarest trigram of the word, there is no need to intersect all of them as candidates get checked anyway
+      const QVector<int> *rarest = nullptr;
+      for ( int i = 0; i + TRIGRAM_LENGTH <= word.length(); ++i )
+      {
+        auto it = data.trigrams.constFind( word.mid( i, TRIGRAM_LENGTH ) );
+        if ( it == data.trigrams.constEnd() )
+        {
+          fids.clear();
+          return true;  // no feature can contain the word
+        }
+        if ( !rarest || it->count() < rarest->count() )
+          rarest = &it.value();
+      }
+
+      if ( rarest )
+      {
+        candidates = *rarest;
+      }
+      else
+      {
+        // too short word - check all features
+        candidates.resize( data.fids.count() );
+        for ( int i = 0; i < candidates.count(); ++i )
+          candidates[i] = i;
+      }
+      first = false;
+    }
+    else
+    {
+      candidates = rows;
+    }
+
+    rows.clear();
+    for ( int row : qAsConst( candidates ) )
+    {
+      if ( matches( data, row, word, wordIsNumeric ) )
+        rows << row;
+    }
+  }
+
+  fids.clear();
+  if ( first )
+  {
+    // no words - everything matches
+    for ( QgsFeatureId fid : data.fids )
+      fids << fid;
+  }
+  else
+  {
+    for ( int row : qAsConst( rows ) )
+      fids << data.fids.at( row );
+  }
+  return true;
+}
+
+bool FeaturesSearchIndex::matches( const Data &data, int row, const QString &word, bool wordIsNumeric )
+{
+  const QStringList &values = data.values.at( row );
+  for ( int i = 0; i < values.count(); ++i )
+  {
+    if ( data.numericFields.at( i ) && !wordIsNumeric )
+      continue;
+
+    if ( values.at( i ).contains( word ) )
+      return true;
+  }
+  return false;
+}
+
+void FeaturesSearchIndex::updateFields()
+{
+  mAttributes.clear();
+  mNumericFields.clear();
+
+  if ( mLayer )
+  {
+    const QgsFields fields = mLayer->fields();
+    for ( int i = 0; i < fields.count(); ++i )
+    {
+      if ( isSearchable( fields.at( i ) ) )
+      {
+        mAttributes << i;
+        mNumericFields << fields.at( i ).isNumeric();
+      }
+    }
+  }
+
+  invalidate();
+}
+
+std::function<std::shared_ptr<FeaturesSearchIndexData>()> FeaturesSearchIndex::buildFunction( std::shared_ptr<QgsVectorLayerFeatureSource> source ) const
+{
+  const QgsAttributeList attributes = mAttributes;
+  const QVector<bool> numericFields = mNumericFields;
+  return [source, attributes, numericFields]()
+  {
+    return build( source, attributes, numericFields );
+  };
+}
+
+void FeaturesSearchIndex::built()
+{
+  emit ready();
+}
+
+std::shared_ptr<FeaturesSearchIndex::Data> FeaturesSearchIndex::build( std::shared_ptr<QgsVectorLayerFeatureSource> source, const QgsAttributeList &attributes, const QVector<bool> &numericFields )
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  std::shared_ptr<Data> data = std::make_shared<Data>();
+  data->numericFields = numericFields;
+
+  QgsFeatureRequest request;
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+  request.setSubsetOfAttributes( attributes );
+
+  QgsFeatureIterator it = source->getFeatures( request );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    int row = data->fids.count();
+    QStringList values;
+    for ( int attr : attributes )
+    {
+      const QVariant value = f.attribute( attr );
+      QString str = value.isNull() ? QString() : value.toString().toLower();
+
+      for ( int i = 0; i + TRIGRAM_LENGTH <= str.length(); ++i )
+      {
+        QVector<int> &rows = data->trigrams[str.mid( i, TRIGRAM_LENGTH )];
+        if ( rows.isEmpty() || rows.last() != row )
+          rows << row;
+      }
+      values << str;
+    }
+    data->fids << f.id();
+    data->values << values;
+  }
+
+  CoreUtils::log( QStringLiteral( "FeaturesSearchIndex" ), QStringLiteral( "Indexed %1 features (%2 trigrams) in %3 ms" )
+                  .arg( data->fids.count() ).arg( data->trigrams.count() ).arg( timer.elapsed() ) );
+  return data;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FEATURESSEARCHINDEX_H
+#define FEATURESSEARCHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+
+#include <memory>
+
+#include "qgsfeatureid.h"
+#include "qgsvectorlayer.h"
+
+#include "layerindex.h"
+
+//! Indexed values of features, see FeaturesSearchIndex
+struct FeaturesSearchIndexData
+{
+  QVector<QgsFeatureId> fids;
+  QVector<QStringList> values;  //!< per feature: lower case values of indexed fields
+  QVector<bool> numericFields;  //!< per indexed field: whether it is numeric
+  QHash<QString, QVector<int>> trigrams;  //!< trigram -> indexes of features having it in some value (ascending)
+};
+
+/**
+ * In-memory trigram index of searchable attributes of a vector layer, used by FeaturesListModel
+ * to answer search queries without evaluating ILIKE expressions on every feature of the layer.
+ *
+ * A query matches the same features as FeaturesListModel::buildSearchExpression(): every word
+ * of the query must be contained (case insensitive) in some string field, or in some numeric field
+ * if the word is a number. Trigrams of the words narrow down the candidate features, which are then
+ * checked against the indexed values.
+ *
+ * The index is built lazily on a worker thread and dropped whenever features of the layer change,
+ * so it gets rebuilt with the next search. Indexes are shared by all users of the same layer.
+ */
+class FeaturesSearchIndex : public LayerIndex<FeaturesSearchIndexData>
+{
+    Q_OBJECT
+
+  public:
+    //! Returns index of the layer's searchable fields (created when needed)
+    static std::shared_ptr<FeaturesSearchIndex> forLayer( QgsVectorLayer *layer );
+
+    /**
+     * Looks up features matching the search \a text and stores their IDs in \a fids.
+     * Returns false if the index is not ready - it starts building it in background then and emits ready() when done.
+     */
+    bool search( const QString &text, QgsFeatureIds &fids );
+
+    //! Returns whether a field is used in search queries (and is therefore indexed)
+    static bool isSearchable( const QgsField &field );
+
+  signals:
+    //! Emitted when the index has been built and search() can answer queries
+    void ready();
+
+  protected:
+    std::function<std::shared_ptr<FeaturesSearchIndexData>()> buildFunction( std::shared_ptr<QgsVectorLayerFeatureSource> source ) const override;
+    void built() override;
+
+  private slots:
+    void updateFields();
+
+  private:
+    typedef FeaturesSearchIndexData Data;
+
+    explicit FeaturesSearchIndex( QgsVectorLayer *layer );
+
+    //! Reads the features and builds the index, called on a worker thread
+    static std::shared_ptr<Data> build( std::shared_ptr<QgsVectorLayerFeatureSource> source, const QgsAttributeList &attributes, const QVector<bool> &numericFields );
+
+    static bool matches( const Data &data, int row, const QString &word, bool wordIsNumeric );
+
+    QgsAttributeList mAttributes;  //!< indexed fields
+    QVector<bool> mNumericFields;
+
+    static const int TRIGRAM_LENGTH = 3;
+};
+
+#endif // FEATURESSEARCHINDEX_H
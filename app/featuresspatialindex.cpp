@@ -0,0 +1,77 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "featuresspatialindex.h"
+
+#include <QElapsedTimer>
+
+#include "coreutils.h"
+
+std::shared_ptr<FeaturesSpatialIndex> FeaturesSpatialIndex::forLayer( QgsVectorLayer *layer )
+{
+  // indexes live as long as some identify kit uses them
+  return sharedForLayer<FeaturesSpatialIndex>( layer, []( QgsVectorLayer * l )
+  {
+    return new FeaturesSpatialIndex( l );
+  } );
+}
+
+bool FeaturesSpatialIndex::isNeeded( QgsVectorLayer *layer )
+{
+  return layer && layer->isSpatial() && layer->hasSpatialIndex() != QgsFeatureSource::SpatialIndexPresent;
+}
+
+FeaturesSpatialIndex::FeaturesSpatialIndex( QgsVectorLayer *layer )
+  : LayerIndex<QgsSpatialIndex>( layer )
+{
+  connect( layer, &QgsVectorLayer::featureAdded, this, &FeaturesSpatialIndex::invalidate );
+  connect( layer, &QgsVectorLayer::featureDeleted, this, &FeaturesSpatialIndex::invalidate );
+  connect( layer, &QgsVectorLayer::geometryChanged, this, &FeaturesSpatialIndex::invalidate );
+  connect( layer, &QgsVectorLayer::subsetStringChanged, this, &FeaturesSpatialIndex::invalidate );
+  connect( layer, &QgsVectorLayer::dataChanged, this, &FeaturesSpatialIndex::invalidate );
+}
+
+bool FeaturesSpatialIndex::intersects( const QgsRectangle &rect, QgsFeatureIds &fids )
+{
+  if ( !mData )
+  {
+    startBuild();
+    return false;
+  }
+
+  fids.clear();
+  const QList<QgsFeatureId> ids = mData->intersects( rect );
+  for ( QgsFeatureId fid : ids )
+    fids << fid;
+  return true;
+}
+
+std::function<std::shared_ptr<QgsSpatialIndex>()> FeaturesSpatialIndex::buildFunction( std::shared_ptr<QgsVectorLayerFeatureSource> source ) const
+{
+  return [source]()
+  {
+    return build( source );
+  };
+}
+
+std::shared_ptr<QgsSpatialIndex> FeaturesSpatialIndex::build( std::shared_ptr<QgsVectorLayerFeatureSource> source )
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QgsFeatureRequest request;
+  request.setNoAttributes();
+
+  // bulk loading is much faster than inserting features one by one
+  std::shared_ptr<QgsSpatialIndex> index = std::make_shared<QgsSpatialIndex>( source->getFeatures( request ) );
+
+  CoreUtils::log( QStringLiteral( "FeaturesSpatialIndex" ), QStringLiteral( "Indexed features of %1 in %2 ms" )
+                  .arg( source->id() ).arg( timer.elapsed() ) );
+  return index;
+}
@@ -0,0 +1,58 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FEATURESSPATIALINDEX_H
+#define FEATURESSPATIALINDEX_H
+
+#include <QObject>
+
+#include <memory>
+
+#include "qgsfeatureid.h"
+#include "qgsspatialindex.h"
+#include "qgsvectorlayer.h"
+
+#include "layerindex.h"
+
+/**
+ * In-memory spatial index of feature bounding boxes of a vector layer, used by IdentifyKit
+ * to find candidate features for layers whose data provider has no spatial index of its own
+ * (e.g. shapefiles without .qix, CSV or memory layers).
+ *
+ * The index is built lazily on a worker thread and dropped whenever features of the layer change,
+ * so it gets rebuilt with the next query. Indexes are shared by all users of the same layer.
+ */
+class FeaturesSpatialIndex : public LayerIndex<QgsSpatialIndex>
+{
+    Q_OBJECT
+
+  public:
+    //! Returns index of the layer (created when needed)
+    static std::shared_ptr<FeaturesSpatialIndex> forLayer( QgsVectorLayer *layer );
+
+    //! Returns whether queries on the layer benefit from the index, i.e. its provider has no spatial index
+    static bool isNeeded( QgsVectorLayer *layer );
+
+    /**
+     * Looks up features with bounding box intersecting \a rect (in layer CRS) and stores their IDs in \a fids.
+     * Returns false if the index is not ready - it starts building it in background then.
+     */
+    bool intersects( const QgsRectangle &rect, QgsFeatureIds &fids );
+
+  protected:
+    std::function<std::shared_ptr<QgsSpatialIndex>()> buildFunction( std::shared_ptr<QgsVectorLayerFeatureSource> source ) const override;
+
+  private:
+    explicit FeaturesSpatialIndex( QgsVectorLayer *layer );
+
+    //! Reads bounding boxes of the features and builds the index, called on a worker thread
+    static std::shared_ptr<QgsSpatialIndex> build( std::shared_ptr<QgsVectorLayerFeatureSource> source );
+};
+
+#endif // FEATURESSPATIALINDEX_H
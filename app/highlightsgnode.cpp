@@ -15,6 +15,11 @@
 
 #include "highlightsgnode.h"
 
+#include <cstring>
+#include <memory>
+
+#include <QMatrix4x4>
+
 #include "qgstessellator.h"
 #include "qgsgeometrycollection.h"
 #include "qgsgeometry.h"
@@ -22,16 +27,100 @@
 #include "qgspoint.h"
 #include "qgspolygon.h"
 
+HighlightSGNode::HighlightSGNode( const QColor &color, float width )
+  : QSGTransformNode()
+  , mWidth( width )
+{
+  mMaterial.setColor( color );
+
+  mFillNode = createGeometryNode( &mMaterial, GL_TRIANGLES );
+  mLineNode = createGeometryNode( &mMaterial, GL_LINES );
+  mPointNode = createGeometryNode( &mMaterial, GL_POINTS );
+  appendChildNode( mFillNode );
+  appendChildNode( mLineNode );
+  appendChildNode( mPointNode );
+
+  setWidth( width );
+}
+
 HighlightSGNode::HighlightSGNode( const QgsGeometry &geom,
                                   const QColor &color, float width )
-  : QSGNode()
-  , mWidth( width )
+  : HighlightSGNode( color, width )
+{
+  setGeometries( QVector<QgsGeometry>() << geom );
+}
+
+void HighlightSGNode::setGeometries( const QVector<QgsGeometry> &geometries )
 {
+  QgsRectangle extent;
+  for ( const QgsGeometry &geom : geometries )
+  {
+    if ( !geom.isNull() )
+      extent.combineExtentWith( geom.boundingBox() );
+  }
+  mOrigin = extent.isNull() ? QgsPointXY() : extent.center();
+  updateMatrix();
+
+  mLineVertices.resize( 0 );
+  mPointVertices.resize( 0 );
+  QgsTessellator tessellator( mOrigin.x(), mOrigin.y(), false, false, false );
+
+  for ( const QgsGeometry &geom : geometries )
+  {
+    if ( !geom.isNull() )
+      addGeometryCollection( geom.constGet(), geom.type(), tessellator );
+  }
+
+  updateFillGeometry( tessellator );
+  updateGeometryNode( mLineNode, mLineVertices );
+  updateGeometryNode( mPointNode, mPointVertices );
+}
+
+void HighlightSGNode::setColor( const QColor &color )
+{
+  if ( mMaterial.color() == color )
+    return;
+
   mMaterial.setColor( color );
-  handleGeometryCollection( geom.constGet(), geom.type() );
+  mFillNode->markDirty( QSGNode::DirtyMaterial );
+  mLineNode->markDirty( QSGNode::DirtyMaterial );
+  mPointNode->markDirty( QSGNode::DirtyMaterial );
+}
+
+void HighlightSGNode::setWidth( float width )
+{
+  mWidth = width;
+  mLineNode->geometry()->setLineWidth( mWidth );
+  mPointNode->geometry()->setLineWidth( mWidth );
+  mLineNode->markDirty( QSGNode::DirtyGeometry );
+  mPointNode->markDirty( QSGNode::DirtyGeometry );
+}
+
+void HighlightSGNode::setMapTransform( const QgsRectangle &visibleExtent, double mapUnitsPerPixel )
+{
+  if ( visibleExtent == mVisibleExtent && qgsDoubleNear( mapUnitsPerPixel, mMapUnitsPerPixel ) )
+    return;
+
+  mVisibleExtent = visibleExtent;
+  mMapUnitsPerPixel = mapUnitsPerPixel;
+  updateMatrix();
 }
 
-void HighlightSGNode::handleGeometryCollection( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type )
+void HighlightSGNode::updateMatrix()
+{
+  QMatrix4x4 matrix;
+  if ( mMapUnitsPerPixel > 0 )
+  {
+    const float scaleFactor = static_cast< float >( 1.0 / mMapUnitsPerPixel );
+    matrix.scale( scaleFactor, -scaleFactor );
+  }
+  // offset of the origin from the extent is computed in doubles, it is small for geometries in view
+  matrix.translate( static_cast< float >( mOrigin.x() - mVisibleExtent.xMinimum() ),
+                    static_cast< float >( mOrigin.y() - mVisibleExtent.yMaximum() ) );
+  setMatrix( matrix );
+}
+
+void HighlightSGNode::addGeometryCollection( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type, QgsTessellator &tessellator )
 {
   const QgsGeometryCollection *collection = qgsgeometry_cast<const QgsGeometryCollection *>( geom );
   if ( collection && !collection->isEmpty() )
@@ -39,16 +128,16 @@ void HighlightSGNode::handleGeometryCollection( const QgsAbstractGeometry *geom,
     for ( int i = 0; i < collection->numGeometries(); ++i )
     {
       const QgsAbstractGeometry *geomN = collection->geometryN( i );
-      handleSingleGeometry( geomN, type );
+      addSingleGeometry( geomN, type, tessellator );
     }
   }
   else
   {
-    handleSingleGeometry( geom, type );
+    addSingleGeometry( geom, type, tessellator );
   }
 }
 
-void HighlightSGNode::handleSingleGeometry( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type )
+void HighlightSGNode::addSingleGeometry( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type, QgsTessellator &tessellator )
 {
   switch ( type )
   {
@@ -56,7 +145,7 @@ void HighlightSGNode::handleSingleGeometry( const QgsAbstractGeometry *geom, Qgs
     {
       const QgsPoint *point = qgsgeometry_cast<const QgsPoint *>( geom );
       if ( point )
-        appendChildNode( createPointGeometry( point ) );
+        addPoint( point );
       break;
     }
 
@@ -64,7 +153,7 @@ void HighlightSGNode::handleSingleGeometry( const QgsAbstractGeometry *geom, Qgs
     {
       const QgsLineString *line = qgsgeometry_cast<const QgsLineString *>( geom );
       if ( line )
-        appendChildNode( createLineGeometry( line ) );
+        addLine( line );
       break;
     }
 
@@ -72,7 +161,7 @@ void HighlightSGNode::handleSingleGeometry( const QgsAbstractGeometry *geom, Qgs
     {
       const QgsPolygon *poly = qgsgeometry_cast<const QgsPolygon *>( geom );
       if ( poly )
-        appendChildNode( createPolygonGeometry( poly ) );
+        tessellator.addPolygon( *poly, 0.0 );
       break;
     }
 
@@ -82,93 +171,87 @@ void HighlightSGNode::handleSingleGeometry( const QgsAbstractGeometry *geom, Qgs
   }
 }
 
-QSGGeometryNode *HighlightSGNode::createLineGeometry( const QgsLineString *line )
+void HighlightSGNode::addLine( const QgsLineString *line )
 {
   Q_ASSERT( line );
 
-  std::unique_ptr<QSGGeometryNode> node( new QSGGeometryNode() );
-  std::unique_ptr<QSGGeometry> sgGeom( new QSGGeometry( QSGGeometry::defaultAttributes_Point2D(), line->numPoints() ) );
-  QSGGeometry::Point2D *vertices = sgGeom->vertexDataAsPoint2D();
+  const int numPoints = line->numPoints();
+  if ( numPoints < 2 )
+    return;
 
   const double *x = line->xData();
   const double *y = line->yData();
 
-  for ( int i = 0; i < line->numPoints(); ++i )
+  // line strips of all parts are batched as separate segments
+  mLineVertices.reserve( mLineVertices.size() + ( numPoints - 1 ) * 2 );
+  QSGGeometry::Point2D vertex;
+  for ( int i = 0; i < numPoints - 1; ++i )
   {
-    vertices[i].set(
-      static_cast< float >( x[i] ),
-      static_cast< float >( y[i] )
-    );
+    vertex.set( static_cast< float >( x[i] - mOrigin.x() ), static_cast< float >( y[i] - mOrigin.y() ) );
+    mLineVertices.append( vertex );
+    vertex.set( static_cast< float >( x[i + 1] - mOrigin.x() ), static_cast< float >( y[i + 1] - mOrigin.y() ) );
+    mLineVertices.append( vertex );
   }
-
-  sgGeom->setLineWidth( mWidth );
-  sgGeom->setDrawingMode( GL_LINE_STRIP );
-  node->setGeometry( sgGeom.release() );
-  node->setMaterial( &mMaterial );
-  node->setFlag( QSGNode::OwnsGeometry );
-  node->setFlag( QSGNode::OwnedByParent );
-  return node.release();
 }
 
-QSGGeometryNode *HighlightSGNode::createPointGeometry( const QgsPoint *point )
+void HighlightSGNode::addPoint( const QgsPoint *point )
 {
   Q_ASSERT( point );
 
-  std::unique_ptr<QSGGeometryNode> node( new QSGGeometryNode() );
-  std::unique_ptr<QSGGeometry> sgGeom( new QSGGeometry( QSGGeometry::defaultAttributes_Point2D(), 1 ) );
-
-  QSGGeometry::Point2D *vertices = sgGeom->vertexDataAsPoint2D();
-  vertices[0].set(
-    static_cast< float >( point->x() ),
-    static_cast< float >( point->y() )
+  QSGGeometry::Point2D vertex;
+  vertex.set(
+    static_cast< float >( point->x() - mOrigin.x() ),
+    static_cast< float >( point->y() - mOrigin.y() )
   );
-  sgGeom->setDrawingMode( GL_POINTS );
-  sgGeom->setLineWidth( mWidth );
-
-  node->setGeometry( sgGeom.release() );
-  node->setMaterial( &mMaterial );
-  node->setFlag( QSGNode::OwnsGeometry );
-  node->setFlag( QSGNode::OwnedByParent );
-  return node.release();
+  mPointVertices.append( vertex );
 }
 
-QSGGeometryNode *HighlightSGNode::createPolygonGeometry( const QgsPolygon *polygon )
+void HighlightSGNode::updateFillGeometry( const QgsTessellator &tessellator )
 {
-  Q_ASSERT( polygon );
-
-  const QgsRectangle bounds = polygon->boundingBox();
-  QgsTessellator tes( bounds.xMinimum(), bounds.yMinimum(), false, false, false );
-  tes.addPolygon( *polygon, 0.0 );
-
-  QSGGeometryNode *node = new QSGGeometryNode;
-  QSGGeometry *sgGeom = new QSGGeometry( QSGGeometry::defaultAttributes_Point2D(), tes.dataVerticesCount() );
+  QSGGeometry *sgGeom = mFillNode->geometry();
+  sgGeom->allocate( tessellator.dataVerticesCount() );
 
   QSGGeometry::Point2D *vertices = sgGeom->vertexDataAsPoint2D();
 
-  // we need to revert translation in tessellator
-  float translateX = static_cast< float >( bounds.xMinimum() );
-  float translateY = static_cast< float >( bounds.yMinimum() );
-
-  const QVector<float> data = tes.data();
+  // tessellator already made the vertices relative to the origin
+  const QVector<float> data = tessellator.data();
   int i = 0;
   for ( auto it = data.constBegin(); it != data.constEnd(); )
   {
     float x = *it;
-    vertices[i].x = translateX + x;
+    vertices[i].x = x;
     ++it;
 
     ++it; // we do not need z coordinate
 
     float y = -( *it );
-    vertices[i].y = translateY + y;
+    vertices[i].y = y;
     ++it;
 
     ++i;
   }
-  sgGeom->setDrawingMode( GL_TRIANGLES );
-  node->setGeometry( sgGeom );
-  node->setMaterial( &mMaterial );
+
+  mFillNode->markDirty( QSGNode::DirtyGeometry );
+}
+
+void HighlightSGNode::updateGeometryNode( QSGGeometryNode *node, const QVector<QSGGeometry::Point2D> &vertices )
+{
+  QSGGeometry *sgGeom = node->geometry();
+  sgGeom->allocate( vertices.size() );
+  if ( !vertices.isEmpty() )
+    memcpy( sgGeom->vertexDataAsPoint2D(), vertices.constData(), static_cast< size_t >( vertices.size() ) * sizeof( QSGGeometry::Point2D ) );
+  node->markDirty( QSGNode::DirtyGeometry );
+}
+
+QSGGeometryNode *HighlightSGNode::createGeometryNode( QSGMaterial *material, unsigned int drawingMode )
+{
+  std::unique_ptr<QSGGeometryNode> node( new QSGGeometryNode() );
+  std::unique_ptr<QSGGeometry> sgGeom( new QSGGeometry( QSGGeometry::defaultAttributes_Point2D(), 0 ) );
+  sgGeom->setDrawingMode( drawingMode );
+
+  node->setGeometry( sgGeom.release() );
+  node->setMaterial( material );
   node->setFlag( QSGNode::OwnsGeometry );
   node->setFlag( QSGNode::OwnedByParent );
-  return node;
+  return node.release();
 }
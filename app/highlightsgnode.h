@@ -20,25 +20,45 @@
 #include <QtQuick/QSGFlatColorMaterial>
 
 #include "qgsgeometry.h"
+#include "qgspointxy.h"
+#include "qgsrectangle.h"
 
 
 class QgsLineString;
 class QgsPoint;
 class QgsPolygon;
+class QgsTessellator;
 
 /**
  * \ingroup quick
  *
  * \brief This is used to transform (render) QgsGeometry to node for QtQuick scene graph.
  *
+ * The node is retained by the item: geometries are kept in map coordinates and the node matrix
+ * takes care of panning and zooming, so vertices are only rebuilt when the highlighted
+ * geometries change. Parts of all geometries are batched into three geometry nodes (polygon fills,
+ * line segments and points), whose vertex buffers are reused between updates.
+ *
+ * Vertices are stored relative to a local origin close to the geometries. The offset of the origin
+ * from the visible extent is computed in double precision before it goes to the (single precision)
+ * node matrix, so vertices stay precise with large map coordinates.
+ *
  * \note QML Type: not exported
  *
  * \since QGIS 3.4
  */
-class  HighlightSGNode : public QSGNode
+class  HighlightSGNode : public QSGTransformNode
 {
   public:
 
+    /**
+     * Constructor of new QT Quick scene node, without any geometry
+     *
+     * \param color color used to render geometries
+     * \param width width of pen, see QSGGeometry::setLineWidth()
+     */
+    HighlightSGNode( const QColor &color, float width );
+
     /**
      * Constructor of new QT Quick scene node based on geometry
      *
@@ -50,16 +70,46 @@ class  HighlightSGNode : public QSGNode
     //! Destructor
     ~HighlightSGNode() = default;
 
+    //! Replaces rendered geometries, all in the map coordinates
+    void setGeometries( const QVector<QgsGeometry> &geometries );
+
+    //! Sets color of all geometries
+    void setColor( const QColor &color );
+
+    //! Sets width of pen for lines and points, see QSGGeometry::setLineWidth()
+    void setWidth( float width );
+
+    //! Sets the map view, geometries are rendered in the item coordinates of the map
+    void setMapTransform( const QgsRectangle &visibleExtent, double mapUnitsPerPixel );
+
   private:
-    void handleGeometryCollection( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type );
-    void handleSingleGeometry( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type );
+    void addGeometryCollection( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type, QgsTessellator &tessellator );
+    void addSingleGeometry( const QgsAbstractGeometry *geom, QgsWkbTypes::GeometryType type, QgsTessellator &tessellator );
+
+    void addLine( const QgsLineString *line );
+    void addPoint( const QgsPoint *point );
 
-    QSGGeometryNode *createLineGeometry( const QgsLineString *line );
-    QSGGeometryNode *createPointGeometry( const QgsPoint *point );
-    QSGGeometryNode *createPolygonGeometry( const QgsPolygon *polygon );
+    void updateFillGeometry( const QgsTessellator &tessellator );
+    void updateGeometryNode( QSGGeometryNode *node, const QVector<QSGGeometry::Point2D> &vertices );
+
+    //! Updates the node matrix from the origin of vertices and the map view
+    void updateMatrix();
+
+    static QSGGeometryNode *createGeometryNode( QSGMaterial *material, unsigned int drawingMode );
 
     QSGFlatColorMaterial mMaterial;
     float mWidth  = 20;
+    QgsPointXY mOrigin;
+    QgsRectangle mVisibleExtent;
+    double mMapUnitsPerPixel = 1;
+
+    QSGGeometryNode *mFillNode = nullptr; // owned by this node
+    QSGGeometryNode *mLineNode = nullptr; // owned by this node
+    QSGGeometryNode *mPointNode = nullptr; // owned by this node
+
+    // vertices collected while building geometries, kept to reuse their capacity
+    QVector<QSGGeometry::Point2D> mLineVertices;
+    QVector<QSGGeometry::Point2D> mPointVertices;
 };
 
 #endif // HIGHLIGHTSGNODE
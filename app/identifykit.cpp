@@ -13,13 +13,17 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <QtConcurrent>
+
 #include "qgsmessagelog.h"
 #include "qgsproject.h"
 #include "qgslogger.h"
 #include "qgsrenderer.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
 
 #include "identifykit.h"
+#include "featuresspatialindex.h"
 #include "qgsquickmapsettings.h"
 #include "qgsexpressioncontextutils.h"
 
@@ -40,7 +44,23 @@ void IdentifyKit::setMapSettings( QgsQuickMapSettings *mapSettings )
   if ( mapSettings == mMapSettings )
     return;
 
+  if ( mMapSettings )
+    disconnect( mMapSettings, nullptr, this, nullptr );
+
   mMapSettings = mapSettings;
+  mRendererFilters.clear();
+  mSpatialIndexes.clear();
+
+  if ( mMapSettings )
+  {
+    // prepared renderers and indexes of layers no longer in the map are not needed
+    connect( mMapSettings, &QgsQuickMapSettings::layersChanged, this, [this]()
+    {
+      mRendererFilters.clear();
+      mSpatialIndexes.clear();
+    } );
+  }
+
   emit mapSettingsChanged();
 }
 
@@ -57,7 +77,7 @@ FeatureLayerPairs IdentifyKit::identify( const QPointF &point, QgsVectorLayer *l
 
   if ( layer )
   {
-    QgsFeatureList featureList = identifyVectorLayer( layer, mapPoint );
+    QgsFeatureList featureList = identifyVectorLayers( QList<QgsVectorLayer *>() << layer, mapPoint ).first();
     for ( const QgsFeature &feature : featureList )
     {
       results.append( FeatureLayerPair( feature, layer ) );
@@ -66,6 +86,7 @@ FeatureLayerPairs IdentifyKit::identify( const QPointF &point, QgsVectorLayer *l
   }
   else
   {
+    QList<QgsVectorLayer *> layers;
     for ( QgsMapLayer *layer : mMapSettings->mapSettings().layers() )
     {
       if ( mMapSettings->project() && !layer->flags().testFlag( QgsMapLayer::Identifiable ) )
@@ -73,14 +94,18 @@ FeatureLayerPairs IdentifyKit::identify( const QPointF &point, QgsVectorLayer *l
 
       QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer );
       if ( vl )
-      {
-        QgsFeatureList featureList = identifyVectorLayer( vl, mapPoint );
+        layers << vl;
+    }
 
-        for ( const QgsFeature &feature : featureList )
-        {
-          results.append( FeatureLayerPair( feature, vl ) );
-        }
+    // all layers are queried at once, TopDownStopAtFirst picks the first layer with results afterwards
+    const QVector<QgsFeatureList> featureLists = identifyVectorLayers( layers, mapPoint );
+    for ( int i = 0; i < layers.count(); ++i )
+    {
+      for ( const QgsFeature &feature : featureLists.at( i ) )
+      {
+        results.append( FeatureLayerPair( feature, layers.at( i ) ) );
       }
+
       if ( mIdentifyMode == IdentifyMode::TopDownStopAtFirst && !results.isEmpty() )
       {
         QgsDebugMsg( QStringLiteral( "IdentifyKit identified %1 results with TopDownStopAtFirst mode." ).arg( results.count() ) );
@@ -164,78 +189,151 @@ FeatureLayerPair IdentifyKit::identifyOne( const QPointF &point, QgsVectorLayer
   return _closestFeature( results, mMapSettings->mapSettings(), point, searchRadiusMU() );
 }
 
-QgsFeatureList IdentifyKit::identifyVectorLayer( QgsVectorLayer *layer, const QgsPointXY &point ) const
+QVector<QgsFeatureList> IdentifyKit::identifyVectorLayers( const QList<QgsVectorLayer *> &layers, const QgsPointXY &point )
 {
-  QgsFeatureList results;
+  QVector<QgsFeatureList> results( layers.count() );
 
-  if ( !layer || !layer->isSpatial() )
-    return results;
-
-  if ( !layer->isInScaleRange( mMapSettings->mapSettings().scale() ) )
-    return results;
+  // create the search rectangle
+  double searchRadius = searchRadiusMU();
 
-  QgsFeatureList featureList;
+  QgsRectangle r;
+  r.setXMinimum( point.x() - searchRadius );
+  r.setXMaximum( point.x() + searchRadius );
+  r.setYMinimum( point.y() - searchRadius );
+  r.setYMaximum( point.y() + searchRadius );
 
-  // toLayerCoordinates will throw an exception for an 'invalid' point.
-  // For example, if you project a world map onto a globe using EPSG 2163
-  // and then click somewhere off the globe, an exception will be thrown.
-  try
+  // queries are prepared here, as layers can only be accessed from the main thread
+  QVector<int> queriedLayers;
+  QVector<LayerQuery> queries;
+  for ( int i = 0; i < layers.count(); ++i )
   {
-    // create the search rectangle
-    double searchRadius = searchRadiusMU();
+    QgsVectorLayer *layer = layers.at( i );
+    if ( !layer || !layer->isSpatial() )
+      continue;
+
+    if ( !layer->isInScaleRange( mMapSettings->mapSettings().scale() ) )
+      continue;
 
-    QgsRectangle r;
-    r.setXMinimum( point.x() - searchRadius );
-    r.setXMaximum( point.x() + searchRadius );
-    r.setYMinimum( point.y() - searchRadius );
-    r.setYMaximum( point.y() + searchRadius );
+    LayerQuery query;
 
-    r = toLayerCoordinates( layer, r );
+    // toLayerCoordinates will throw an exception for an 'invalid' point.
+    // For example, if you project a world map onto a globe using EPSG 2163
+    // and then click somewhere off the globe, an exception will be thrown.
+    try
+    {
+      query.rect = toLayerCoordinates( layer, r );
+    }
+    catch ( QgsCsException &cse )
+    {
+      QgsDebugMsg( QStringLiteral( "Invalid point, proceed without a found features." ) );
+      Q_UNUSED( cse )
+      continue;
+    }
 
-    QgsFeatureRequest req;
-    req.setFilterRect( r );
-    req.setLimit( mFeaturesLimit );
-    req.setFlags( QgsFeatureRequest::ExactIntersect );
+    if ( FeaturesSpatialIndex::isNeeded( layer ) )
+    {
+      std::shared_ptr<FeaturesSpatialIndex> &index = mSpatialIndexes[layer->id()];
+      if ( !index )
+        index = FeaturesSpatialIndex::forLayer( layer );
 
-    QgsFeatureIterator fit = layer->getFeatures( req );
-    QgsFeature f;
-    while ( fit.nextFeature( f ) )
-      featureList << QgsFeature( f );
-  }
-  catch ( QgsCsException &cse )
-  {
-    QgsDebugMsg( QStringLiteral( "Invalid point, proceed without a found features." ) );
-    Q_UNUSED( cse )
+      // the index gets ready in background, until then the query goes to the provider
+      query.hasCandidates = index->intersects( query.rect, query.candidates );
+      if ( query.hasCandidates && query.candidates.isEmpty() )
+        continue;
+    }
+
+    query.source = std::make_shared<QgsVectorLayerFeatureSource>( layer );
+    query.filter = rendererFilter( layer );
+    query.fields = layer->fields();
+    query.limit = mFeaturesLimit;
+
+    queriedLayers << i;
+    queries << query;
   }
 
-  bool filter = false;
+  const QList<QgsFeatureIds> identified = QtConcurrent::blockingMapped<QList<QgsFeatureIds>>( queries, &IdentifyKit::queryLayer );
 
-  QgsRenderContext context( QgsRenderContext::fromMapSettings( mMapSettings->mapSettings() ) );
-  context.expressionContext() << QgsExpressionContextUtils::layerScope( layer );
-  QgsFeatureRenderer *renderer = layer->renderer();
-  if ( renderer && renderer->capabilities() & QgsFeatureRenderer::ScaleDependent )
+  // only the identified features are loaded with all attributes
+  for ( int i = 0; i < queriedLayers.count(); ++i )
   {
-    // setup scale for scale dependent visibility (rule based)
-    renderer->startRender( context, layer->fields() );
-    filter = renderer->capabilities() & QgsFeatureRenderer::Filter;
+    if ( identified.at( i ).isEmpty() )
+      continue;
+
+    QgsFeatureIterator fit = layers.at( queriedLayers.at( i ) )->getFeatures( QgsFeatureRequest( identified.at( i ) ) );
+    QgsFeature f;
+    while ( fit.nextFeature( f ) )
+      results[queriedLayers.at( i )] << QgsFeature( f );
   }
 
-  for ( const QgsFeature &feature : featureList )
-  {
-    context.expressionContext().setFeature( feature );
+  return results;
+}
 
-    if ( filter && !renderer->willRenderFeature( const_cast<QgsFeature &>( feature ), context ) )
-      continue;
+QgsFeatureIds IdentifyKit::queryLayer( const LayerQuery &query )
+{
+  QgsFeatureIds fids;
+
+  QgsFeatureRequest req;
+  if ( query.hasCandidates )
+    req.setFilterFids( query.candidates );
+  req.setFilterRect( query.rect );
+  req.setFlags( QgsFeatureRequest::ExactIntersect );
+  if ( query.filter )
+    req.setSubsetOfAttributes( query.filter->attributes, query.fields );
+  else
+    req.setNoAttributes();
 
-    results.append( feature );
+  if ( !query.filter )
+    req.setLimit( query.limit );
+
+  QgsFeatureIterator fit = query.source->getFeatures( req );
+  QgsFeature f;
+  while ( fids.count() < query.limit && fit.nextFeature( f ) )
+  {
+    if ( query.filter )
+    {
+      query.filter->context->expressionContext().setFeature( f );
+      if ( !query.filter->renderer->willRenderFeature( f, *query.filter->context ) )
+        continue;
+    }
+
+    fids << f.id();
   }
 
-  if ( renderer && renderer->capabilities() & QgsFeatureRenderer::ScaleDependent )
+  return fids;
+}
+
+std::shared_ptr<IdentifyKit::RendererFilter> IdentifyKit::rendererFilter( QgsVectorLayer *layer )
+{
+  QgsFeatureRenderer *renderer = layer->renderer();
+  if ( !renderer || !( renderer->capabilities() & QgsFeatureRenderer::ScaleDependent ) || !( renderer->capabilities() & QgsFeatureRenderer::Filter ) )
   {
-    renderer->stopRender( context );
+    mRendererFilters.remove( layer->id() );
+    return nullptr;
   }
 
-  return results;
+  const double scale = mMapSettings->mapSettings().scale();
+  std::shared_ptr<RendererFilter> filter = mRendererFilters.value( layer->id() );
+  if ( filter && filter->layerRenderer == renderer && qgsDoubleNear( filter->scale, scale ) )
+    return filter;
+
+  // setup scale for scale dependent visibility (rule based)
+  filter = std::make_shared<RendererFilter>();
+  filter->layerRenderer = renderer;
+  filter->scale = scale;
+  filter->context.reset( new QgsRenderContext( QgsRenderContext::fromMapSettings( mMapSettings->mapSettings() ) ) );
+  filter->context->expressionContext() << QgsExpressionContextUtils::layerScope( layer );
+  filter->renderer.reset( renderer->clone() );
+  filter->renderer->startRender( *filter->context, layer->fields() );
+  filter->attributes = filter->renderer->usedAttributes( *filter->context );
+
+  mRendererFilters.insert( layer->id(), filter );
+  return filter;
+}
+
+IdentifyKit::RendererFilter::~RendererFilter()
+{
+  if ( renderer )
+    renderer->stopRender( *context );
 }
 
 double IdentifyKit::searchRadiusMU( const QgsRenderContext &context ) const
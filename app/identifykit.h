@@ -17,7 +17,11 @@
 #define IDENTIFYKIT_H
 
 #include <QObject>
+#include <QHash>
 #include <QPair>
+#include <QPointer>
+
+#include <memory>
 
 #include "qgsfeature.h"
 #include "qgsmapsettings.h"
@@ -27,9 +31,12 @@
 
 #include "featurelayerpair.h"
 
+class FeaturesSpatialIndex;
+class QgsFeatureRenderer;
 class QgsMapLayer;
 class QgsQuickMapSettings;
 class QgsVectorLayer;
+class QgsVectorLayerFeatureSource;
 
 /**
  * \ingroup quick
@@ -39,6 +46,12 @@ class QgsVectorLayer;
  * - get a list of features in a defined radius from a point.
  * - get a feature with the closest distance to the point
  *
+ * All identifiable layers are queried in parallel on worker threads. The queries read
+ * only the attributes needed by the renderer's filter, attributes of the identified features
+ * are loaded at the end. Layers without a spatial index in their data provider use FeaturesSpatialIndex
+ * to narrow down the candidate features. Renderers are prepared for the filtering once and
+ * kept for the following identifications at the same scale.
+ *
  * \note QML Type: IdentifyKit
  *
  * \since QGIS 3.4
@@ -158,13 +171,49 @@ class  IdentifyKit : public QObject
     void identifyModeChanged();
 
   private:
+
+    //! Renderer of a layer started for filtering of features at a map scale
+    struct RendererFilter
+    {
+      ~RendererFilter();
+
+      const QgsFeatureRenderer *layerRenderer = nullptr; //!< renderer of the layer the filter was cloned from
+      double scale = 0;
+      std::unique_ptr<QgsFeatureRenderer> renderer;
+      std::unique_ptr<QgsRenderContext> context;
+      QSet<QString> attributes; //!< attributes needed to filter features
+    };
+
+    //! Query of a single layer, run on a worker thread
+    struct LayerQuery
+    {
+      std::shared_ptr<QgsVectorLayerFeatureSource> source;
+      QgsRectangle rect; //!< search rectangle in layer CRS
+      bool hasCandidates = false; //!< whether candidates have been looked up in the spatial index
+      QgsFeatureIds candidates;
+      std::shared_ptr<RendererFilter> filter; //!< nullptr if the renderer does not filter features
+      QgsFields fields;
+      int limit = 0;
+    };
+
     QgsQuickMapSettings *mMapSettings = nullptr; // not owned
 
     double searchRadiusMU( const QgsRenderContext &context ) const;
     double searchRadiusMU() const;
 
     QgsRectangle toLayerCoordinates( QgsMapLayer *layer, const QgsRectangle &rect ) const;
-    QgsFeatureList identifyVectorLayer( QgsVectorLayer *layer, const QgsPointXY &point ) const;
+
+    //! Identifies features of the layers in parallel, returns features per layer in the same order as the layers
+    QVector<QgsFeatureList> identifyVectorLayers( const QList<QgsVectorLayer *> &layers, const QgsPointXY &point );
+
+    //! Returns the started renderer of the layer if it filters features at the current scale, nullptr otherwise
+    std::shared_ptr<RendererFilter> rendererFilter( QgsVectorLayer *layer );
+
+    //! Returns IDs of features matching the query
+    static QgsFeatureIds queryLayer( const LayerQuery &query );
+
+    QHash<QString, std::shared_ptr<RendererFilter>> mRendererFilters; // by layer id
+    QHash<QString, std::shared_ptr<FeaturesSpatialIndex>> mSpatialIndexes; // by layer id
 
     double mSearchRadiusMm = 5;
     int mFeaturesLimit = 100;
@@ -15,6 +15,7 @@
 #include "merginapi.h"
 #include "inpututils.h"
 #include "coreutils.h"
+#include "logwriter.h"
 
 #include "inpututils.h"
 
@@ -120,6 +121,8 @@ QString InputHelp::fullLog( bool isHtml )
   qint64 limit = 500000;
   QVector<QString> retLines = logHeader( isHtml );
 
+  CoreUtils::flushLog();
+
   QFile file( CoreUtils::logFilename() );
   if ( file.open( QIODevice::ReadOnly ) )
   {
@@ -127,6 +130,24 @@ QString InputHelp::fullLog( bool isHtml )
     if ( fileSize > limit )
       file.seek( file.size() - limit );
 
+    // the log file has been rotated recently, older entries are in the rotated file
+    QFile rotatedFile( LogWriter::rotatedFilePath( CoreUtils::logFilename() ) );
+    if ( fileSize < limit && rotatedFile.open( QIODevice::ReadOnly ) )
+    {
+      if ( rotatedFile.size() > limit - fileSize )
+      {
+        rotatedFile.seek( rotatedFile.size() - ( limit - fileSize ) );
+        rotatedFile.readLine(); // skip the incomplete line
+      }
+
+      QString line = rotatedFile.readLine();
+      while ( !line.isNull() )
+      {
+        retLines.push_back( line );
+        line = rotatedFile.readLine();
+      }
+    }
+
     QString line = file.readLine();
     while ( !line.isNull() )
     {
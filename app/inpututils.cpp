@@ -35,6 +35,7 @@
 
 #include "featurelayerpair.h"
 #include "qgsquickmapsettings.h"
+#include "qgsquickcoordinatetransformcache.h"
 #include "qgsquickutils.h"
 #include "qgsunittypes.h"
 #include "qgsfeatureid.h"
@@ -344,7 +345,7 @@ QVector<double> InputUtils::extractGeometryCoordinates( const FeatureLayerPair &
 
   QgsGeometry g = pair.feature().geometry();
 
-  QgsCoordinateTransform ct( pair.layer()->crs(), mapSettings->destinationCrs(), mapSettings->transformContext() );
+  const QgsCoordinateTransform ct = QgsQuickCoordinateTransformCache::transform( pair.layer()->crs(), mapSettings->destinationCrs(), mapSettings->transformContext() );
   if ( !ct.isShortCircuited() )
   {
     try
@@ -597,20 +598,15 @@ QgsPointXY InputUtils::transformPoint( const QgsCoordinateReferenceSystem &srcCr
                                        const QgsCoordinateTransformContext &context,
                                        const QgsPointXY &srcPoint )
 {
-  try
-  {
-    QgsCoordinateTransform ct( srcCrs, destCrs, context );
-    if ( ct.isValid() )
-    {
-      const QgsPointXY pt = ct.transform( srcPoint );
-      return pt;
-    }
-  }
-  catch ( QgsCsException &cse )
-  {
-    Q_UNUSED( cse )
-  }
-  return srcPoint;
+  return QgsQuickCoordinateTransformCache::transformPoint( srcCrs, destCrs, context, srcPoint );
+}
+
+bool InputUtils::transformPoints( const QgsCoordinateReferenceSystem &srcCrs,
+                                  const QgsCoordinateReferenceSystem &destCrs,
+                                  const QgsCoordinateTransformContext &context,
+                                  QVector<double> &x, QVector<double> &y, QVector<double> &z )
+{
+  return QgsQuickCoordinateTransformCache::transformPoints( srcCrs, destCrs, context, x, y, z );
 }
 
 double InputUtils::screenUnitsToMeters( QgsQuickMapSettings *mapSettings, int baseLengthPixels )
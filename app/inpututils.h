@@ -185,6 +185,15 @@ class InputUtils: public QObject
         const QgsCoordinateTransformContext &context,
         const QgsPointXY &srcPoint );
 
+    /**
+      * Transforms arrays of coordinates between different crs in place, \a z may be empty.
+      * Returns false if the transformation fails, coordinates stay unchanged then.
+      */
+    static bool transformPoints( const QgsCoordinateReferenceSystem &srcCrs,
+                                 const QgsCoordinateReferenceSystem &destCrs,
+                                 const QgsCoordinateTransformContext &context,
+                                 QVector<double> &x, QVector<double> &y, QVector<double> &z );
+
     /**
       * Calculates the distance in meter representing baseLengthPixels pixels on the screen based on the current map settings.
       */
@@ -0,0 +1,128 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LAYERINDEX_H
+#define LAYERINDEX_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPointer>
+#include <QtConcurrent>
+
+#include <functional>
+#include <memory>
+
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerfeatureiterator.h"
+
+/**
+ * Base of in-memory indexes of vector layer features (FeaturesSearchIndex, FeaturesSpatialIndex).
+ *
+ * The index \a Data is built lazily on a worker thread from a snapshot of the layer's features.
+ * Subclasses call invalidate() whenever the features change, the index is then dropped and gets rebuilt
+ * with the next startBuild(). An index finished from stale features is dropped and built again.
+ */
+template <typename Data>
+class LayerIndex : public QObject
+{
+  public:
+    ~LayerIndex() override
+    {
+      mBuildWatcher.waitForFinished();
+    }
+
+    bool isReady() const
+    {
+      return static_cast<bool>( mData );
+    }
+
+  protected:
+    explicit LayerIndex( QgsVectorLayer *layer )
+      : mLayer( layer )
+    {
+      connect( &mBuildWatcher, &QFutureWatcher<std::shared_ptr<Data>>::finished, this, [this]() { buildFinished(); } );
+    }
+
+    /**
+     * Returns index of type \a Index of the layer, \a create makes a new one when there is none yet.
+     * Indexes are shared by all users of the same layer and live as long as some of them holds the index.
+     */
+    template <typename Index>
+    static std::shared_ptr<Index> sharedForLayer( QgsVectorLayer *layer, std::function<Index *( QgsVectorLayer * )> create )
+    {
+      static QHash<QgsVectorLayer *, std::weak_ptr<Index>> sIndexes;
+
+      if ( !layer )
+        return nullptr;
+
+      std::shared_ptr<Index> index = sIndexes.value( layer ).lock();
+      if ( !index || index->mLayer != layer )
+      {
+        index.reset( create( layer ) );
+        sIndexes.insert( layer, index );
+      }
+
+      // forget entries of indexes that are gone
+      for ( auto it = sIndexes.begin(); it != sIndexes.end(); )
+      {
+        if ( it->expired() )
+          it = sIndexes.erase( it );
+        else
+          ++it;
+      }
+
+      return index;
+    }
+
+    //! Returns function reading the features of \a source into the index data, it is called on a worker thread
+    virtual std::function<std::shared_ptr<Data>()> buildFunction( std::shared_ptr<QgsVectorLayerFeatureSource> source ) const = 0;
+
+    //! Called when the index has been built
+    virtual void built() {}
+
+    void invalidate()
+    {
+      ++mGeneration;
+      mData.reset();
+    }
+
+    void startBuild()
+    {
+      if ( !mLayer || mBuildWatcher.isRunning() )
+        return;
+
+      mBuildGeneration = mGeneration;
+      std::shared_ptr<QgsVectorLayerFeatureSource> source = std::make_shared<QgsVectorLayerFeatureSource>( mLayer );
+      mBuildWatcher.setFuture( QtConcurrent::run( buildFunction( source ) ) );
+    }
+
+    QPointer<QgsVectorLayer> mLayer;
+    std::shared_ptr<Data> mData;
+
+  private:
+    void buildFinished()
+    {
+      if ( mBuildGeneration != mGeneration )
+      {
+        // features have changed while building - try again
+        startBuild();
+        return;
+      }
+
+      mData = mBuildWatcher.result();
+      built();
+    }
+
+    int mGeneration = 0;  //!< incremented on invalidation so that an index built from stale data is dropped
+    int mBuildGeneration = -1;
+    QFutureWatcher<std::shared_ptr<Data>> mBuildWatcher;
+};
+
+#endif // LAYERINDEX_H
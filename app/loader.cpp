@@ -28,6 +28,7 @@
 #include "qgsexpressioncontextutils.h"
 #endif
 #include <QDebug>
+#include <QFileInfo>
 
 const QString Loader::LOADING_FLAG_FILE_PATH = QString( "%1/.input_loading_project" ).arg( QStandardPaths::standardLocations( QStandardPaths::TempLocation ).first() );
 
@@ -175,6 +176,22 @@ QgsQuickMapSettings *Loader::mapSettings() const
   return mMapSettings;
 }
 
+QString Loader::renderCacheDir() const
+{
+  if ( mProject->fileName().isEmpty() )
+    return QString();
+
+  return QFileInfo( mProject->fileName() ).absolutePath() + "/.mergin/render-cache";
+}
+
+QString Loader::trackJournalPath() const
+{
+  if ( mProject->fileName().isEmpty() )
+    return QString();
+
+  return QFileInfo( mProject->fileName() ).absolutePath() + "/.mergin/track-journal";
+}
+
 void Loader::zoomToProject( QgsQuickMapSettings *mapSettings )
 {
   if ( !mapSettings )
@@ -252,6 +269,12 @@ void Loader::appStateChanged( Qt::ApplicationState state )
   logHelper << "Application changed state to: " << state;
   CoreUtils::log( "Input", msg );
 
+  // the system may kill the app in background without notice, queued log entries would be lost
+  if ( state == Qt::ApplicationSuspended || state == Qt::ApplicationInactive )
+  {
+    CoreUtils::flushLog();
+  }
+
   if ( !mRecording && mPositionKit )
   {
     if ( state == Qt::ApplicationActive )
@@ -268,6 +291,7 @@ void Loader::appStateChanged( Qt::ApplicationState state )
 void Loader::appAboutToQuit()
 {
   CoreUtils::log( "Input", "Application has quit" );
+  CoreUtils::flushLog();
 }
 
 
@@ -35,6 +35,8 @@ class Loader: public QObject
     Q_PROPERTY( PositionKit *positionKit READ positionKit WRITE setPositionKit NOTIFY positionKitChanged )
     Q_PROPERTY( bool recording READ isRecording WRITE setRecording NOTIFY recordingChanged )
     Q_PROPERTY( QgsQuickMapSettings *mapSettings READ mapSettings WRITE setMapSettings NOTIFY mapSettingsChanged )
+    Q_PROPERTY( QString renderCacheDir READ renderCacheDir NOTIFY projectReloaded )
+    Q_PROPERTY( QString trackJournalPath READ trackJournalPath NOTIFY projectReloaded )
 
   public:
     explicit Loader(
@@ -97,6 +99,18 @@ class Loader: public QObject
      */
     bool layerVisible( QgsMapLayer *layer );
 
+    /**
+     * renderCacheDir returns directory for cached map tiles of the current project,
+     * empty string if no project is loaded. The directory is not synchronized.
+     */
+    QString renderCacheDir() const;
+
+    /**
+     * trackJournalPath returns file for journal of points of the feature being recorded in the current project,
+     * empty string if no project is loaded. The file is not synchronized.
+     */
+    QString trackJournalPath() const;
+
   signals:
     void projectChanged();
     void projectReloaded( QgsProject *project );
@@ -49,6 +49,7 @@
 #include "merginuserinfo.h"
 #include "variablesmanager.h"
 #include "inputhelp.h"
+#include "startuppipeline.h"
 #include "inputprojutils.h"
 #include "fieldsmodel.h"
 #include "projectwizard.h"
@@ -77,6 +78,7 @@
 #include "featurehighlight.h"
 #include "qgsquickcoordinatetransformer.h"
 #include "identifykit.h"
+#include "snappingkit.h"
 #include "featurelayerpair.h"
 #include "qgsquickmapcanvasmap.h"
 #include "qgsquickmapsettings.h"
@@ -298,6 +300,7 @@ void initDeclarative()
   qmlRegisterType< RememberAttributesController >( "lc", 1, 0, "RememberAttributesController" );
   qmlRegisterType< FeatureHighlight >( "lc", 1, 0, "FeatureHighlight" );
   qmlRegisterType< IdentifyKit >( "lc", 1, 0, "IdentifyKit" );
+  qmlRegisterType< SnappingKit >( "lc", 1, 0, "SnappingKit" );
   qmlRegisterType< PositionKit >( "lc", 1, 0, "PositionKit" );
   qmlRegisterType< ScaleBarKit >( "lc", 1, 0, "ScaleBarKit" );
   qmlRegisterType< FeaturesListModel >( "lc", 1, 0, "FeaturesListModel" );
@@ -343,6 +346,7 @@ void addQmlImportPath( QQmlEngine &engine )
 int main( int argc, char *argv[] )
 {
   QgsApplication app( argc, argv, true );
+  StartupPipeline startup;
 
   const QString version = CoreUtils::appVersion();
 
@@ -365,9 +369,11 @@ int main( int argc, char *argv[] )
     qDebug() <<  "Error in loading input translation for " << locale;
   }
 
+  bool testing = false;
 #ifdef INPUT_TEST
   InputTests tests;
   tests.parseArgs( argc, argv );
+  testing = tests.testingRequested();
 #endif
   qDebug() << "Built with QGIS version " << VERSION_INT;
 
@@ -388,6 +394,19 @@ int main( int argc, char *argv[] )
 
   CoreUtils::setLogFilename( projectDir + "/.logs" );
   setEnvironmentQgisPrefixPath();
+  startup.stageFinished( QStringLiteral( "environment" ) );
+
+  // Local projects are needed only after the first frame, scan them while QGIS is initialized.
+  // Tests expect the projects to be loaded right away.
+  LocalProjectsManager localProjectsManager( projectDir, !testing );
+  if ( !localProjectsManager.isLoaded() )
+  {
+    startup.backgroundWorkStarted( QStringLiteral( "local projects" ) );
+    QObject::connect( &localProjectsManager, &LocalProjectsManager::dataDirReloaded, &startup, [&startup]()
+    {
+      startup.backgroundWorkFinished( QStringLiteral( "local projects" ) );
+    } );
+  }
 
   QString appBundleDir;
   QString demoDir;
@@ -405,7 +424,9 @@ int main( int argc, char *argv[] )
 #endif
   InputProjUtils inputProjUtils;
   inputProjUtils.initProjLib( appBundleDir, dataDir, projectDir );
+  startup.stageFinished( QStringLiteral( "proj" ) );
   init_qgis( appBundleDir );
+  startup.stageFinished( QStringLiteral( "qgis" ) );
 
   // AppSettings has to be initialized after QGIS app init (because of correct reading/writing QSettings).
   AppSettings as;
@@ -414,12 +435,16 @@ int main( int argc, char *argv[] )
   {
     copy_demo_projects( demoDir, projectDir );
     as.setDemoProjectsCopied( true );
+
+    if ( testing )
+      localProjectsManager.reloadDataDir();
+    else
+      localProjectsManager.reloadDataDirInBackground();
   }
 
   // Create Input classes
   AndroidUtils au;
   IosUtils iosUtils;
-  LocalProjectsManager localProjectsManager( projectDir );
   MapThemesModel mtm;
   std::unique_ptr<MerginApi> ma =  std::unique_ptr<MerginApi>( new MerginApi( localProjectsManager ) );
   InputUtils iu;
@@ -434,7 +459,8 @@ int main( int argc, char *argv[] )
 
   ActiveLayer al;
   Loader loader( mtm, as, al, recordingLpm );
-  std::unique_ptr<Purchasing> purchasing( new Purchasing( ma.get() ) );
+  // the store backend is set up after the first frame
+  std::unique_ptr<Purchasing> purchasing( new Purchasing( ma.get(), !testing ) );
   std::unique_ptr<VariablesManager> vm( new VariablesManager( ma.get() ) );
   vm->registerInputExpressionFunctions();
 
@@ -461,6 +487,7 @@ int main( int argc, char *argv[] )
     projectLoadingFile.remove();
     CoreUtils::log( QStringLiteral( "Loading project error" ), QStringLiteral( "The Input has been unexpectedly finished during the last run." ) );
   }
+  startup.stageFinished( QStringLiteral( "app classes" ) );
 
 #ifdef INPUT_TEST
   if ( tests.testingRequested() )
@@ -483,10 +510,12 @@ int main( int argc, char *argv[] )
       qDebug() << "Loaded font" << font;
   }
   app.setFont( QFont( "Lato" ) );
+  startup.stageFinished( QStringLiteral( "fonts" ) );
 
   QQmlEngine engine;
   addQmlImportPath( engine );
   initDeclarative();
+  startup.stageFinished( QStringLiteral( "qml types" ) );
   // QGIS environment variables to set
   // OGR_SQLITE_JOURNAL is set to DELETE to avoid working with WAL files
   // and properly close connection after writting changes to gpkg.
@@ -532,6 +561,7 @@ int main( int argc, char *argv[] )
 
   QQmlComponent component( &engine, QUrl( "qrc:/main.qml" ) );
   QObject *object = component.create();
+  startup.stageFinished( QStringLiteral( "qml" ) );
 
   if ( !component.errors().isEmpty() )
   {
@@ -559,11 +589,19 @@ int main( int argc, char *argv[] )
 #else
   QString logoUrl = ":/logo.png";
 #endif
-  if ( QQuickWindow *quickWindow = qobject_cast<QQuickWindow *>( object ) )
+  QQuickWindow *quickWindow = qobject_cast<QQuickWindow *>( object );
+  if ( quickWindow )
   {
     quickWindow->setIcon( QIcon( logoUrl ) );
   }
 
+  // work not needed for the first frame, the QR code reader is created by QML when first used
+  startup.defer( QStringLiteral( "purchasing" ), [&purchasing]()
+  {
+    purchasing->initBackend();
+  } );
+  startup.start( quickWindow );
+
 #ifdef DESKTOP_OS
   QCommandLineParser parser;
   parser.addVersionOption();
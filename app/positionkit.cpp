@@ -330,7 +330,8 @@ void PositionKit::setMapSettings( QgsQuickMapSettings *mapSettings )
 
   if ( mMapSettings )
   {
-    mMapSettings->disconnect();
+    // only our connections, map settings connect their own signals too
+    disconnect( mMapSettings, nullptr, this, nullptr );
   }
 
   mMapSettings = mapSettings;
@@ -343,6 +344,7 @@ void PositionKit::setMapSettings( QgsQuickMapSettings *mapSettings )
     connect( mMapSettings, &QgsQuickMapSettings::visibleExtentChanged, this, &PositionKit::onMapSettingsUpdated );
     connect( mMapSettings, &QgsQuickMapSettings::outputSizeChanged, this, &PositionKit::onMapSettingsUpdated );
     connect( mMapSettings, &QgsQuickMapSettings::outputDpiChanged, this, &PositionKit::onMapSettingsUpdated );
+    connect( mMapSettings, &QgsQuickMapSettings::transformContextChanged, this, &PositionKit::onMapSettingsUpdated );
   }
 
   emit mapSettingsChanged();
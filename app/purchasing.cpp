@@ -190,12 +190,13 @@ PurchasingPlan *PurchasingTransaction::plan() const
 /* ********************************************************************************************************/
 /* ********************************************************************************************************/
 
-Purchasing::Purchasing( MerginApi *merginApi, QObject *parent )
+Purchasing::Purchasing( MerginApi *merginApi, bool deferBackend, QObject *parent )
   : QObject( parent )
   , mMerginApi( merginApi )
 {
   setDefaultUrls();
-  createBackend();
+  if ( !deferBackend )
+    createBackend();
 
   connect( mMerginApi, &MerginApi::apiRootChanged, this, &Purchasing::onMerginServerChanged );
   connect( mMerginApi, &MerginApi::apiSupportsSubscriptionsChanged, this, &Purchasing::onMerginServerStatusChanged );
@@ -206,6 +207,15 @@ Purchasing::Purchasing( MerginApi *merginApi, QObject *parent )
   connect( this, &Purchasing::hasInAppPurchasesChanged, this, &Purchasing::onHasInAppPurchasesChanged );
 }
 
+void Purchasing::initBackend()
+{
+  if ( mBackend )
+    return;
+
+  createBackend();
+  evaluateHasInAppPurchases();
+}
+
 void Purchasing::createBackend()
 {
   mBackend.reset();
@@ -248,7 +248,14 @@ class Purchasing : public QObject
     Q_PROPERTY( QString subscriptionBillingUrl READ subscriptionBillingUrl NOTIFY subscriptionBillingUrlChanged )
 
   public:
-    explicit Purchasing( MerginApi *merginApi, QObject *parent = nullptr );
+    /**
+     * Creates purchasing for \a merginApi. Setting up the store backend is slow on some platforms,
+     * with \a deferBackend it is not created until initBackend() is called.
+     */
+    explicit Purchasing( MerginApi *merginApi, bool deferBackend = false, QObject *parent = nullptr );
+
+    //! Creates the store backend if it has been deferred and evaluates availability of in-app purchases
+    void initBackend();
 
     Q_INVOKABLE void purchase( const QString &planId );
     Q_INVOKABLE void restore();
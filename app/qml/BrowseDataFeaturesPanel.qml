@@ -63,7 +63,7 @@ Item {
   ]
 
   Component.onCompleted: {
-    if ( featuresCount > featuresLimit )
+    if ( featuresCount > featuresLimit && !featuresModel.incremental )
       __inputUtils.showNotification( qsTr( "Showing only the first %1 features" ).arg( featuresLimit ) )
   }
 
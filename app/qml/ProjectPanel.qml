@@ -122,10 +122,8 @@ Item {
       }
 
       function showChanges( projectId ) {
-        if ( __merginProjectStatusModel.loadProjectInfo( projectId ) ) {
-          stackView.push( statusPanelComp )
-        }
-        else __inputUtils.showNotification( qsTr( "No Changes" ) )
+        stackView.pending = true
+        __merginProjectStatusModel.loadProjectInfo( projectId )
       }
 
       function refreshProjectList( keepSearchFilter = false ) {
@@ -436,6 +434,17 @@ Item {
         }
       }
 
+      Connections {
+        target: __merginProjectStatusModel
+        onProjectInfoLoaded: {
+          stackView.pending = false
+          if ( hasLocalChanges ) {
+            stackView.push( statusPanelComp )
+          }
+          else __inputUtils.showNotification( qsTr( "No Changes" ) )
+        }
+      }
+
       Connections {
         target: __merginApi
         onListProjectsFinished: stackView.pending = false
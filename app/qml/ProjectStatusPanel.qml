@@ -19,12 +19,24 @@ import "./components"
 Item {
   id: statusPanel
   property real rowHeight: InputStyle.rowHeight * 1.2
+  property bool opening: false
   signal back()
 
   function open(projectFullName) {
-    if (__merginProjectStatusModel.loadProjectInfo(projectFullName)) {
-      statusPanel.visible = true;
-    } else __inputUtils.showNotification(qsTr("No Changes"))
+    statusPanel.opening = true
+    __merginProjectStatusModel.loadProjectInfo(projectFullName)
+  }
+
+  Connections {
+    target: __merginProjectStatusModel
+    onProjectInfoLoaded: {
+      if (!statusPanel.opening)
+        return
+      statusPanel.opening = false
+      if (hasLocalChanges) {
+        statusPanel.visible = true;
+      } else __inputUtils.showNotification(qsTr("No Changes"))
+    }
   }
 
   // background
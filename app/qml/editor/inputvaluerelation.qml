@@ -38,6 +38,10 @@ Item {
 
   property var model: FeaturesListModel {
     id: vrModel
+
+    // lookup tables can be huge - load them page by page and search them with an index
+    incremental: true
+    useSearchIndex: true
   }
 
   id: fieldItem
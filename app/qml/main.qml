@@ -94,8 +94,7 @@ ApplicationWindow {
       }
     }
 
-    Component.onCompleted: {
-      // load default project
+    function loadDefaultProject() {
       if ( __appSettings.defaultProject ) {
         let path = __appSettings.defaultProject
 
@@ -112,11 +111,29 @@ ApplicationWindow {
       }
       else projectPanel.openPanel()
 
-        // get focus when any project is active, otherwise let focus to merginprojectpanel
-        if ( __appSettings.activeProject )
-          mainPanel.forceActiveFocus()
+      // get focus when any project is active, otherwise let focus to merginprojectpanel
+      if ( __appSettings.activeProject )
+        mainPanel.forceActiveFocus()
+    }
+
+    Connections {
+      id: localProjectsLoadedConnection
+      target: __localProjectsManager
+      enabled: false
+      onDataDirReloaded: {
+        localProjectsLoadedConnection.enabled = false
+        window.loadDefaultProject()
+      }
+    }
+
+    Component.onCompleted: {
+      // load default project once local projects are scanned in background
+      if ( __localProjectsManager.loaded )
+        loadDefaultProject()
+      else
+        localProjectsLoadedConnection.enabled = true
 
-        console.log("Application initialized!")
+      console.log("Application initialized!")
     }
 
     MapWrapper {
@@ -242,6 +242,9 @@ Item {
     visible: root.state !== "inactive"
 
     mapSettings.project: __loader.project
+    tiledRendering: true
+    renderCacheDir: __loader.renderCacheDir
+    progressiveRendering: true
 
     IdentifyKit {
       id: _identifyKit
@@ -371,12 +374,20 @@ Item {
     markerAnchorY: InputStyle.mapMarkerAnchorY
   }
 
+  SnappingKit {
+    id: _snappingKit
+
+    mapSettings: _map.mapSettings
+  }
+
   DigitizingController  {
     id: _digitizingController
 
     positionKit: _positionKit
     layer: __activeLayer.vectorLayer
     mapSettings: _map.mapSettings
+    snappingKit: _snappingKit
+    trackJournalPath: __loader.trackJournalPath
 
     lineRecordingInterval: __appSettings.lineRecordingInterval
     variablesManager: __variablesManager
@@ -0,0 +1,197 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "snappingkit.h"
+
+#include <QSet>
+
+#include "qgis.h"
+#include "qgsvectorlayer.h"
+
+#include "qgsquickmapsettings.h"
+
+SnappingKit::SnappingKit( QObject *parent )
+  : QObject( parent )
+{
+}
+
+QgsQuickMapSettings *SnappingKit::mapSettings() const
+{
+  return mMapSettings;
+}
+
+void SnappingKit::setMapSettings( QgsQuickMapSettings *mapSettings )
+{
+  if ( mapSettings == mMapSettings )
+    return;
+
+  if ( mMapSettings )
+    disconnect( mMapSettings, nullptr, this, nullptr );
+
+  mMapSettings = mapSettings;
+
+  if ( mMapSettings )
+  {
+    connect( mMapSettings, &QgsQuickMapSettings::layersChanged, this, &SnappingKit::updateLocators );
+    connect( mMapSettings, &QgsQuickMapSettings::destinationCrsChanged, this, &SnappingKit::resetLocators );
+  }
+
+  resetLocators();
+  emit mapSettingsChanged();
+}
+
+bool SnappingKit::enabled() const
+{
+  return mEnabled;
+}
+
+void SnappingKit::setEnabled( bool enabled )
+{
+  if ( enabled == mEnabled )
+    return;
+
+  mEnabled = enabled;
+  resetLocators();
+  emit enabledChanged();
+}
+
+double SnappingKit::toleranceMm() const
+{
+  return mToleranceMm;
+}
+
+void SnappingKit::setToleranceMm( double toleranceMm )
+{
+  if ( qgsDoubleNear( mToleranceMm, toleranceMm ) )
+    return;
+
+  mToleranceMm = toleranceMm;
+  emit toleranceMmChanged();
+}
+
+QgsPoint SnappingKit::snapPoint( const QgsPoint &point ) const
+{
+  const QgsPointLocator::Match match = snap( QgsPointXY( point.x(), point.y() ) );
+  if ( !match.isValid() )
+    return point;
+
+  QgsPoint snapped( point );
+  snapped.setX( match.point().x() );
+  snapped.setY( match.point().y() );
+  return snapped;
+}
+
+QgsPointLocator::Match SnappingKit::snap( const QgsPointXY &point ) const
+{
+  QgsPointLocator::Match vertex;
+  QgsPointLocator::Match edge;
+
+  if ( !mEnabled || !mMapSettings )
+    return vertex;
+
+  const double tolerance = toleranceMU();
+
+  for ( auto it = mLocators.constBegin(); it != mLocators.constEnd(); ++it )
+  {
+    // relaxed queries return no match while the index is being built
+    const QgsPointLocator::Match layerVertex = it->locator->nearestVertex( point, tolerance, nullptr, true );
+    if ( layerVertex.isValid() && ( !vertex.isValid() || layerVertex.distance() < vertex.distance() ) )
+      vertex = layerVertex;
+
+    if ( vertex.isValid() )
+      continue;
+
+    const QgsPointLocator::Match layerEdge = it->locator->nearestEdge( point, tolerance, nullptr, true );
+    if ( layerEdge.isValid() && ( !edge.isValid() || layerEdge.distance() < edge.distance() ) )
+      edge = layerEdge;
+  }
+
+  return vertex.isValid() ? vertex : edge;
+}
+
+bool SnappingKit::isReady() const
+{
+  for ( auto it = mLocators.constBegin(); it != mLocators.constEnd(); ++it )
+  {
+    if ( it->locator->isIndexing() )
+      return false;
+  }
+  return true;
+}
+
+void SnappingKit::updateLocators()
+{
+  if ( !mEnabled || !mMapSettings )
+    return;
+
+  QSet<QgsVectorLayer *> layers;
+  const QList<QgsMapLayer *> mapLayers = mMapSettings->layers();
+  for ( QgsMapLayer *mapLayer : mapLayers )
+  {
+    QgsVectorLayer *layer = qobject_cast<QgsVectorLayer *>( mapLayer );
+    if ( layer && layer->isSpatial() )
+      layers << layer;
+  }
+
+  // locators of layers still in the map are kept with their indexes
+  const QList<QgsVectorLayer *> locatorLayers = mLocators.keys();
+  for ( QgsVectorLayer *layer : locatorLayers )
+  {
+    if ( !layers.contains( layer ) )
+      removeLocator( layer );
+  }
+
+  for ( QgsVectorLayer *layer : qAsConst( layers ) )
+  {
+    if ( mLocators.contains( layer ) )
+      continue;
+
+    LayerLocator layerLocator;
+    layerLocator.locator = std::make_shared<QgsPointLocator>( layer, mMapSettings->destinationCrs(), mMapSettings->transformContext() );
+    // the index is built in background, edits of the layer update it afterwards
+    layerLocator.locator->init( -1, true );
+    layerLocator.layerDestroyed = connect( layer, &QObject::destroyed, this, [this, layer]()
+    {
+      removeLocator( layer );
+    } );
+    mLocators.insert( layer, layerLocator );
+  }
+}
+
+void SnappingKit::resetLocators()
+{
+  const QList<QgsVectorLayer *> locatorLayers = mLocators.keys();
+  for ( QgsVectorLayer *layer : locatorLayers )
+    removeLocator( layer );
+
+  updateLocators();
+}
+
+void SnappingKit::removeLocator( QgsVectorLayer *layer )
+{
+  const LayerLocator layerLocator = mLocators.take( layer );
+  disconnect( layerLocator.layerDestroyed );
+
+  if ( !layerLocator.locator || !layerLocator.locator->isIndexing() )
+    return;
+
+  // the locator's destructor waits for the indexing to finish, it is kept until then not to block the GUI
+  QgsPointLocator *locator = layerLocator.locator.get();
+  mRemovedLocators.insert( locator, layerLocator.locator );
+  connect( locator, &QgsPointLocator::initFinished, this, [this, locator]()
+  {
+    mRemovedLocators.remove( locator );
+  }, Qt::QueuedConnection );
+}
+
+double SnappingKit::toleranceMU() const
+{
+  const QgsMapSettings mapSettings = mMapSettings->mapSettings();
+  return mToleranceMm * mapSettings.outputDpi() / 25.4 * mapSettings.mapUnitsPerPixel();
+}
@@ -0,0 +1,129 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SNAPPINGKIT_H
+#define SNAPPINGKIT_H
+
+#include <QObject>
+#include <QHash>
+
+#include <memory>
+
+#include "qgspoint.h"
+#include "qgspointlocator.h"
+
+class QgsQuickMapSettings;
+class QgsVectorLayer;
+
+/**
+ * Snaps recorded points to vertices and segments of vector layers shown in the map.
+ *
+ * Every vector layer of the map settings (i.e. of the current map theme) has its own
+ * QgsPointLocator. Indexes of the locators are built in background as soon as a layer
+ * appears in the map and the locators update them on edits of the layer. Queries never
+ * wait for an index: layers still being indexed are skipped.
+ *
+ * Vertices are preferred over segments, so it is easy to connect to an existing vertex
+ * even when the tap is a bit closer to a segment.
+ *
+ * \note QML Type: SnappingKit
+ */
+class SnappingKit : public QObject
+{
+    Q_OBJECT
+
+    /**
+     * Map settings. Set directly when creating QML object.
+     */
+    Q_PROPERTY( QgsQuickMapSettings *mapSettings READ mapSettings WRITE setMapSettings NOTIFY mapSettingsChanged )
+
+    /**
+     * Whether points are snapped. Indexes are kept only while enabled.
+     *
+     * Default is true.
+     */
+    Q_PROPERTY( bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged )
+
+    /**
+     * Snapping distance on the screen.
+     *
+     * Default is 3.
+     */
+    Q_PROPERTY( double toleranceMm READ toleranceMm WRITE setToleranceMm NOTIFY toleranceMmChanged )
+
+  public:
+    explicit SnappingKit( QObject *parent = nullptr );
+
+    //! \copydoc SnappingKit::mapSettings
+    QgsQuickMapSettings *mapSettings() const;
+
+    //! \copydoc SnappingKit::mapSettings
+    void setMapSettings( QgsQuickMapSettings *mapSettings );
+
+    //! \copydoc SnappingKit::enabled
+    bool enabled() const;
+
+    //! \copydoc SnappingKit::enabled
+    void setEnabled( bool enabled );
+
+    //! \copydoc SnappingKit::toleranceMm
+    double toleranceMm() const;
+
+    //! \copydoc SnappingKit::toleranceMm
+    void setToleranceMm( double toleranceMm );
+
+    /**
+     * Returns the point snapped to the closest vertex or segment within the tolerance.
+     * Returns the point unchanged if there is nothing to snap to.
+     * \param point point in map coordinates, Z and M values are kept
+     */
+    Q_INVOKABLE QgsPoint snapPoint( const QgsPoint &point ) const;
+
+    //! Returns the closest vertex, or if there is none, the closest segment within the tolerance of the point in map coordinates
+    QgsPointLocator::Match snap( const QgsPointXY &point ) const;
+
+    //! Returns true if no index is being built
+    bool isReady() const;
+
+  signals:
+    //! \copydoc SnappingKit::mapSettings
+    void mapSettingsChanged();
+    //! \copydoc SnappingKit::enabled
+    void enabledChanged();
+    //! \copydoc SnappingKit::toleranceMm
+    void toleranceMmChanged();
+
+  private slots:
+    //! Creates locators for new layers of the map and removes the ones of the layers no longer in the map
+    void updateLocators();
+
+    //! Removes all locators, e.g. after the map CRS changes
+    void resetLocators();
+
+  private:
+    double toleranceMU() const;
+
+    //! Removes locator of the layer, a locator still building its index is deleted once the index is built
+    void removeLocator( QgsVectorLayer *layer );
+
+    struct LayerLocator
+    {
+      std::shared_ptr<QgsPointLocator> locator;
+      QMetaObject::Connection layerDestroyed; //!< removes the locator when the layer gets deleted
+    };
+
+    QgsQuickMapSettings *mMapSettings = nullptr; // not owned
+    bool mEnabled = true;
+    double mToleranceMm = 3;
+    QHash<QgsVectorLayer *, LayerLocator> mLocators;
+    //! Removed locators still building their index, deleting them would block until the index is built
+    QHash<QgsPointLocator *, std::shared_ptr<QgsPointLocator>> mRemovedLocators;
+};
+
+#endif // SNAPPINGKIT_H
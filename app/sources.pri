@@ -12,10 +12,15 @@ featurelayerpair.cpp \
 featurehighlight.cpp \
 highlightsgnode.cpp \
 identifykit.cpp \
+snappingkit.cpp \
+trackrecorder.cpp \
+startuppipeline.cpp \
 positionkit.cpp \
 scalebarkit.cpp \
 simulatedpositionsource.cpp \
 featureslistmodel.cpp \
+featuressearchindex.cpp \
+featuresspatialindex.cpp \
 inputhelp.cpp \
 activelayer.cpp \
 fieldsmodel.cpp \
@@ -58,10 +63,16 @@ highlightsgnode.h \
 featurelayerpair.h \
 featurehighlight.h \
 identifykit.h \
+snappingkit.h \
+trackrecorder.h \
+startuppipeline.h \
 positionkit.h \
 scalebarkit.h \
 simulatedpositionsource.h \
 featureslistmodel.h \
+featuressearchindex.h \
+featuresspatialindex.h \
+layerindex.h \
 inputhelp.h \
 activelayer.h \
 fieldsmodel.h \
@@ -111,6 +122,12 @@ contains(DEFINES, INPUT_TEST) {
       test/testscalebarkit.cpp \
       test/testvariablesmanager.cpp \
       test/testformeditors.cpp \
+      test/testmaptiles.cpp \
+      test/testfeaturehighlight.cpp \
+      test/testsnappingkit.cpp \
+      test/testtrackrecorder.cpp \
+      test/testingmerginserver.cpp \
+      test/testsyncbenchmark.cpp \
 
   HEADERS += \
       test/inputtests.h \
@@ -128,6 +145,12 @@ contains(DEFINES, INPUT_TEST) {
       test/testscalebarkit.h \
       test/testvariablesmanager.h \
       test/testformeditors.h \
+      test/testmaptiles.h \
+      test/testfeaturehighlight.h \
+      test/testsnappingkit.h \
+      test/testtrackrecorder.h \
+      test/testingmerginserver.h \
+      test/testsyncbenchmark.h \
 }
 
 contains(DEFINES, APPLE_PURCHASING) {
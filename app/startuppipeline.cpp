@@ -0,0 +1,126 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "startuppipeline.h"
+
+#include <QQuickWindow>
+#include <QStringList>
+#include <QTimer>
+
+#include "coreutils.h"
+
+StartupPipeline::StartupPipeline( QObject *parent )
+  : QObject( parent )
+{
+  mTimer.start();
+}
+
+void StartupPipeline::stageFinished( const QString &stage )
+{
+  const qint64 elapsed = mTimer.elapsed();
+  mStages << qMakePair( stage, elapsed - mLastStageEnd );
+  mLastStageEnd = elapsed;
+}
+
+void StartupPipeline::backgroundWorkStarted( const QString &work )
+{
+  mRunningWork.insert( work, mTimer.elapsed() );
+}
+
+void StartupPipeline::backgroundWorkFinished( const QString &work )
+{
+  if ( !mRunningWork.contains( work ) )
+    return;
+
+  mBackgroundStages << qMakePair( work, mTimer.elapsed() - mRunningWork.take( work ) );
+  checkFinished();
+}
+
+void StartupPipeline::defer( const QString &stage, const std::function<void()> &task )
+{
+  mDeferred.enqueue( qMakePair( stage, task ) );
+}
+
+void StartupPipeline::start( QQuickWindow *window )
+{
+  if ( mStarted )
+    return;
+
+  mStarted = true;
+
+  if ( !window )
+  {
+    QTimer::singleShot( 0, this, &StartupPipeline::runNextDeferred );
+    return;
+  }
+
+  // frames are swapped on the render thread, the connection is queued to the main thread
+  mFrameConnection = connect( window, &QQuickWindow::frameSwapped, this, &StartupPipeline::onFrameSwapped, Qt::QueuedConnection );
+}
+
+QString StartupPipeline::summary() const
+{
+  QStringList stages;
+  for ( const QPair<QString, qint64> &stage : mStages )
+    stages << QStringLiteral( "%1 %2 ms" ).arg( stage.first ).arg( stage.second );
+
+  QStringList backgroundStages;
+  for ( const QPair<QString, qint64> &stage : mBackgroundStages )
+    backgroundStages << QStringLiteral( "%1 %2 ms" ).arg( stage.first ).arg( stage.second );
+
+  QString summary = stages.join( QStringLiteral( ", " ) );
+  if ( !backgroundStages.isEmpty() )
+    summary += QStringLiteral( "; in background: " ) + backgroundStages.join( QStringLiteral( ", " ) );
+  return summary;
+}
+
+void StartupPipeline::onFrameSwapped()
+{
+  if ( !mFrameConnection )
+    return;
+
+  disconnect( mFrameConnection );
+  mFrameConnection = QMetaObject::Connection();
+
+  stageFinished( QStringLiteral( "first frame" ) );
+  CoreUtils::log( QStringLiteral( "Startup" ), QStringLiteral( "First frame shown after %1 ms" ).arg( mLastStageEnd ) );
+  emit firstFrameShown();
+
+  runNextDeferred();
+}
+
+void StartupPipeline::runNextDeferred()
+{
+  if ( mDeferred.isEmpty() )
+  {
+    mDeferredDone = true;
+    checkFinished();
+    return;
+  }
+
+  const QPair<QString, std::function<void()>> task = mDeferred.dequeue();
+
+  QElapsedTimer timer;
+  timer.start();
+  task.second();
+  mStages << qMakePair( task.first, timer.elapsed() );
+
+  // let the event loop process input and paint between the tasks
+  QTimer::singleShot( 0, this, &StartupPipeline::runNextDeferred );
+}
+
+void StartupPipeline::checkFinished()
+{
+  if ( mFinished || !mDeferredDone || !mRunningWork.isEmpty() )
+    return;
+
+  mFinished = true;
+  CoreUtils::log( QStringLiteral( "Startup" ), QStringLiteral( "Finished in %1 ms: %2" ).arg( mTimer.elapsed() ).arg( summary() ) );
+  emit finished();
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef STARTUPPIPELINE_H
+#define STARTUPPIPELINE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QVector>
+
+#include <functional>
+
+class QQuickWindow;
+
+/**
+ * Orders the app startup in stages and records how long each of them takes.
+ *
+ * Stages needed for the first frame run in main() and are marked with stageFinished().
+ * Work that is not needed for the first frame is either deferred with defer() - such
+ * tasks run on the main thread one by one after the first frame is shown - or runs in
+ * background and is tracked with backgroundWorkStarted() and backgroundWorkFinished().
+ *
+ * Once all of it is done, durations of the stages are written to the log, so startup
+ * regressions are visible, and finished() is emitted.
+ */
+class StartupPipeline : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit StartupPipeline( QObject *parent = nullptr );
+
+    //! Records time since the end of the previous stage as duration of \a stage
+    void stageFinished( const QString &stage );
+
+    //! Marks start of \a work running in background
+    void backgroundWorkStarted( const QString &work );
+
+    //! Marks end of \a work running in background, does nothing if it is not running
+    void backgroundWorkFinished( const QString &work );
+
+    //! Adds \a task to run on the main thread after the first frame
+    void defer( const QString &stage, const std::function<void()> &task );
+
+    //! Waits for the first frame of \a window and runs the deferred tasks afterwards, they run right away without window
+    void start( QQuickWindow *window );
+
+    //! Returns true when the deferred tasks and the background work are done
+    bool isFinished() const { return mFinished; }
+
+    //! Returns recorded durations of the stages
+    QString summary() const;
+
+  signals:
+    //! Emitted when the first frame of the window has been shown
+    void firstFrameShown();
+
+    //! Emitted when the deferred tasks and the background work are done
+    void finished();
+
+  private slots:
+    void onFrameSwapped();
+    void runNextDeferred();
+
+  private:
+    void checkFinished();
+
+    QElapsedTimer mTimer;
+    qint64 mLastStageEnd = 0;
+    QVector<QPair<QString, qint64>> mStages; //!< stage name and duration in ms
+    QVector<QPair<QString, qint64>> mBackgroundStages;
+    QHash<QString, qint64> mRunningWork; //!< background work and its start time
+
+    QQueue<QPair<QString, std::function<void()>>> mDeferred;
+    QMetaObject::Connection mFrameConnection;
+    bool mStarted = false;
+    bool mDeferredDone = false;
+    bool mFinished = false;
+};
+
+#endif // STARTUPPIPELINE_H
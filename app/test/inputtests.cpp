@@ -23,6 +23,11 @@
 #include "test/testscalebarkit.h"
 #include "test/testvariablesmanager.h"
 #include "test/testformeditors.h"
+#include "test/testmaptiles.h"
+#include "test/testfeaturehighlight.h"
+#include "test/testsnappingkit.h"
+#include "test/testtrackrecorder.h"
+#include "test/testsyncbenchmark.h"
 
 #if not defined APPLE_PURCHASING
 #include "test/testpurchasing.h"
@@ -147,6 +152,31 @@ int InputTests::runTest() const
     TestFormEditors edTest;
     nFailed = QTest::qExec( &edTest, mTestArgs );
   }
+  else if ( mTestRequested == "--testMapTiles" )
+  {
+    TestMapTiles mtTest;
+    nFailed = QTest::qExec( &mtTest, mTestArgs );
+  }
+  else if ( mTestRequested == "--testFeatureHighlight" )
+  {
+    TestFeatureHighlight fhTest;
+    nFailed = QTest::qExec( &fhTest, mTestArgs );
+  }
+  else if ( mTestRequested == "--testSnappingKit" )
+  {
+    TestSnappingKit skTest;
+    nFailed = QTest::qExec( &skTest, mTestArgs );
+  }
+  else if ( mTestRequested == "--testTrackRecorder" )
+  {
+    TestTrackRecorder trTest;
+    nFailed = QTest::qExec( &trTest, mTestArgs );
+  }
+  else if ( mTestRequested == "--testSyncBenchmark" )
+  {
+    TestSyncBenchmark sbTest;
+    nFailed = QTest::qExec( &sbTest, mTestArgs );
+  }
 #if not defined APPLE_PURCHASING
   else if ( mTestRequested == "--testPurchasing" )
   {
@@ -439,3 +439,83 @@ void TestAttributeController::testValidationMessages()
 
   QCOMPARE( controller.hasValidationErrors(), true );
 }
+
+void TestAttributeController::testExpressionDependencies()
+{
+  std::unique_ptr<QgsVectorLayer> layer(
+    new QgsVectorLayer( QStringLiteral( "Point?field=a:integer&field=b:integer&field=c:integer" ),
+                        QStringLiteral( "layer" ),
+                        QStringLiteral( "memory" )
+                      )
+  );
+  QVERIFY( layer && layer->isValid() );
+
+  // c depends on b, which depends on a
+  layer->setDefaultValueDefinition( 1, QgsDefaultValue( QStringLiteral( "\"a\" * 2" ), true ) );
+  layer->setDefaultValueDefinition( 2, QgsDefaultValue( QStringLiteral( "\"b\" + 1" ), true ) );
+
+  QgsFeature f1( layer->fields(), 1 );
+  f1.setAttributes( QgsAttributes() << 1 << 2 << 3 );
+  layer->dataProvider()->addFeatures( QgsFeatureList() << f1 );
+
+  AttributeController controller;
+  controller.setFeatureLayerPair( FeatureLayerPair( f1, layer.get() ) );
+
+  const TabItem *tabItem = controller.tabItem( 0 );
+  QVERIFY( tabItem );
+  const QVector<QUuid> formItems = tabItem->formItems();
+  QCOMPARE( formItems.size(), 3 );
+
+  // change of a is propagated through b to c
+  QVERIFY( controller.setFormValue( formItems.at( 0 ), 4 ) );
+  QCOMPARE( controller.formValue( 1 ), 8 );
+  QCOMPARE( controller.formValue( 2 ), 9 );
+
+  // default value of b does not depend on b itself, so it is kept,
+  // but c is recalculated
+  QVERIFY( controller.setFormValue( formItems.at( 1 ), 100 ) );
+  QCOMPARE( controller.formValue( 1 ), 100 );
+  QCOMPARE( controller.formValue( 2 ), 101 );
+}
+
+void TestAttributeController::testDefaultValuesOrder()
+{
+  std::unique_ptr<QgsVectorLayer> layer(
+    new QgsVectorLayer( QStringLiteral( "Point?field=f0:integer&field=f1:integer&field=f2:integer&field=f3:integer&field=f4:integer"
+                                        "&field=cycle1:integer&field=cycle2:integer" ),
+                        QStringLiteral( "layer" ),
+                        QStringLiteral( "memory" )
+                      )
+  );
+  QVERIFY( layer && layer->isValid() );
+
+  // each field depends on the next one, which is more than the old retry limit could resolve
+  for ( int i = 0; i < 4; ++i )
+    layer->setDefaultValueDefinition( i, QgsDefaultValue( QStringLiteral( "\"f%1\" + 1" ).arg( i + 1 ), true ) );
+
+  layer->setDefaultValueDefinition( 5, QgsDefaultValue( QStringLiteral( "coalesce(\"cycle2\", 0) + 1" ), true ) );
+  layer->setDefaultValueDefinition( 6, QgsDefaultValue( QStringLiteral( "coalesce(\"cycle1\", 0) + 1" ), true ) );
+
+  QgsFeature f1( layer->fields(), 1 );
+  f1.setAttributes( QgsAttributes() << 0 << 0 << 0 << 0 << 0 << QVariant() << QVariant() );
+  layer->dataProvider()->addFeatures( QgsFeatureList() << f1 );
+
+  AttributeController controller;
+  controller.setFeatureLayerPair( FeatureLayerPair( f1, layer.get() ) );
+
+  const TabItem *tabItem = controller.tabItem( 0 );
+  QVERIFY( tabItem );
+  const QVector<QUuid> formItems = tabItem->formItems();
+  QCOMPARE( formItems.size(), 7 );
+
+  QVERIFY( controller.setFormValue( formItems.at( 4 ), 10 ) );
+  QCOMPARE( controller.formValue( 3 ), 11 );
+  QCOMPARE( controller.formValue( 2 ), 12 );
+  QCOMPARE( controller.formValue( 1 ), 13 );
+  QCOMPARE( controller.formValue( 0 ), 14 );
+
+  // fields in a cycle are evaluated at most once, in order of field index
+  QVERIFY( controller.setFormValue( formItems.at( 5 ), 5 ) );
+  QCOMPARE( controller.formValue( 5 ), 5 );
+  QCOMPARE( controller.formValue( 6 ), 6 );
+}
@@ -25,6 +25,8 @@ class TestAttributeController: public QObject
     void twoGroupsDragAndDropLayout();
     void tabsAndFieldsMixed();
     void testValidationMessages();
+    void testExpressionDependencies();
+    void testDefaultValuesOrder();
 };
 
 #endif // TESTATTRIBUTECONTROLLER_H
@@ -0,0 +1,136 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "testfeaturehighlight.h"
+
+#include <cmath>
+
+#include <QMatrix4x4>
+#include <QtQuick/QSGGeometryNode>
+
+#include "qgsgeometry.h"
+
+#include "highlightsgnode.h"
+
+// children of the highlight node: polygon fills, line segments and points
+static const int FILL_NODE = 0;
+static const int LINE_NODE = 1;
+static const int POINT_NODE = 2;
+
+static QSGGeometryNode *childNode( HighlightSGNode &node, int index )
+{
+  return static_cast<QSGGeometryNode *>( node.childAtIndex( index ) );
+}
+
+static int vertexCount( HighlightSGNode &node, int index )
+{
+  return childNode( node, index )->geometry()->vertexCount();
+}
+
+static QVector<QgsGeometry> geometries( const QStringList &wkts )
+{
+  QVector<QgsGeometry> geoms;
+  for ( const QString &wkt : wkts )
+    geoms << QgsGeometry::fromWkt( wkt );
+  return geoms;
+}
+
+void TestFeatureHighlight::testVertexCounts()
+{
+  HighlightSGNode node( Qt::yellow, 5 );
+  QCOMPARE( node.childCount(), 3 );
+
+  // square is tessellated to two triangles
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "Polygon((0 0, 10 0, 10 10, 0 10, 0 0))" ) ) );
+  QCOMPARE( vertexCount( node, FILL_NODE ), 6 );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 0 );
+  QCOMPARE( vertexCount( node, POINT_NODE ), 0 );
+
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "MultiPolygon(((0 0, 10 0, 10 10, 0 10, 0 0)),((20 0, 30 0, 30 10, 20 10, 20 0)))" ) ) );
+  QCOMPARE( vertexCount( node, FILL_NODE ), 12 );
+
+  // line strip of three points gives two segments
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "LineString(0 0, 10 0, 10 10)" ) ) );
+  QCOMPARE( vertexCount( node, FILL_NODE ), 0 );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 4 );
+
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "MultiLineString((0 0, 10 0),(0 5, 10 5, 10 10))" ) ) );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 6 );
+
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "MultiPoint((0 0),(1 1),(2 2))" ) ) );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 0 );
+  QCOMPARE( vertexCount( node, POINT_NODE ), 3 );
+
+  // parts of all geometries are batched
+  node.setGeometries( geometries( QStringList()
+                                  << QStringLiteral( "Polygon((0 0, 10 0, 10 10, 0 10, 0 0))" )
+                                  << QStringLiteral( "LineString(0 0, 10 0, 10 10)" )
+                                  << QStringLiteral( "MultiLineString((0 0, 10 0),(0 5, 10 5))" )
+                                  << QStringLiteral( "Point(3 3)" )
+                                  << QStringLiteral( "MultiPoint((0 0),(1 1))" ) ) );
+  QCOMPARE( vertexCount( node, FILL_NODE ), 6 );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 8 );
+  QCOMPARE( vertexCount( node, POINT_NODE ), 3 );
+
+  // null and invalid geometries are skipped
+  node.setGeometries( QVector<QgsGeometry>() << QgsGeometry() << QgsGeometry::fromWkt( QStringLiteral( "LineString(0 0)" ) ) );
+  QCOMPARE( vertexCount( node, FILL_NODE ), 0 );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 0 );
+  QCOMPARE( vertexCount( node, POINT_NODE ), 0 );
+}
+
+void TestFeatureHighlight::testNodesReused()
+{
+  HighlightSGNode node( QgsGeometry::fromWkt( QStringLiteral( "LineString(0 0, 10 0)" ) ), Qt::yellow, 5 );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 2 );
+
+  QSGGeometryNode *fillNode = childNode( node, FILL_NODE );
+  QSGGeometryNode *lineNode = childNode( node, LINE_NODE );
+  QSGGeometryNode *pointNode = childNode( node, POINT_NODE );
+  QSGGeometry *lineGeometry = lineNode->geometry();
+
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "LineString(0 0, 10 0, 10 10, 0 10)" ) ) );
+  node.setColor( Qt::red );
+  node.setWidth( 10 );
+  node.setGeometries( QVector<QgsGeometry>() );
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "LineString(5 5, 6 6)" ) ) );
+
+  // the same nodes and geometries are updated in place
+  QCOMPARE( node.childCount(), 3 );
+  QCOMPARE( childNode( node, FILL_NODE ), fillNode );
+  QCOMPARE( childNode( node, LINE_NODE ), lineNode );
+  QCOMPARE( childNode( node, POINT_NODE ), pointNode );
+  QCOMPARE( lineNode->geometry(), lineGeometry );
+  QCOMPARE( vertexCount( node, LINE_NODE ), 2 );
+  QCOMPARE( lineGeometry->lineWidth(), 10.f );
+  QCOMPARE( static_cast<QSGFlatColorMaterial *>( lineNode->material() )->color(), QColor( Qt::red ) );
+}
+
+void TestFeatureHighlight::testLargeCoordinates()
+{
+  // about 1 cm on the map is 0.1 px, far more than floats can resolve in absolute map coordinates of this size
+  const double x0 = 2500000;
+  const double y0 = 7200000;
+  const double mapUnitsPerPixel = 0.1;
+
+  HighlightSGNode node( Qt::yellow, 5 );
+  node.setGeometries( geometries( QStringList() << QStringLiteral( "Point(%1 %2)" ).arg( x0 + 50.01, 0, 'f', 2 ).arg( y0 - 20.01, 0, 'f', 2 ) ) );
+  node.setMapTransform( QgsRectangle( x0, y0 - 100, x0 + 100, y0 ), mapUnitsPerPixel );
+
+  const QSGGeometry::Point2D vertex = childNode( node, POINT_NODE )->geometry()->vertexDataAsPoint2D()[0];
+  const QPointF itemPoint = node.matrix().map( QPointF( vertex.x, vertex.y ) );
+  QVERIFY( std::fabs( itemPoint.x() - 500.1 ) < 0.01 );
+  QVERIFY( std::fabs( itemPoint.y() - 200.1 ) < 0.01 );
+
+  // panning only changes the matrix
+  node.setMapTransform( QgsRectangle( x0 + 10, y0 - 100, x0 + 110, y0 ), mapUnitsPerPixel );
+  const QPointF pannedPoint = node.matrix().map( QPointF( vertex.x, vertex.y ) );
+  QVERIFY( std::fabs( pannedPoint.x() - 400.1 ) < 0.01 );
+  QVERIFY( std::fabs( pannedPoint.y() - 200.1 ) < 0.01 );
+}
@@ -0,0 +1,27 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QObject>
+#include <QtTest>
+
+#ifndef TESTFEATUREHIGHLIGHT_H
+#define TESTFEATUREHIGHLIGHT_H
+
+class TestFeatureHighlight: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void testVertexCounts(); // polygons, lines and points, also multi-part
+    void testNodesReused(); // geometry nodes are kept between updates
+    void testLargeCoordinates(); // vertices map to the item precisely far from the CRS origin
+};
+
+#endif // TESTFEATUREHIGHLIGHT_H
@@ -15,6 +15,8 @@
 #include "fieldvalidator.h"
 #include "relationfeaturesmodel.h"
 #include "relationreferencefeaturesmodel.h"
+#include "featureslistmodel.h"
+#include "featuressearchindex.h"
 
 #include <QtTest/QtTest>
 #include <memory>
@@ -441,3 +443,85 @@ void TestFormEditors::testRelationsWidgetPresence()
   QVERIFY( relationsCount == 0 );
   QVERIFY( relationReferencesCount == 1 );
 }
+
+void TestFormEditors::testFeaturesListModelIncremental()
+{
+  QString projectDir = TestUtils::testDataDir() + "/planes";
+  QString projectName = "quickapp_project.qgs";
+
+  QVERIFY( QgsProject::instance()->read( projectDir + "/" + projectName ) );
+
+  QgsMapLayer *airportsLayer = QgsProject::instance()->mapLayersByName( QStringLiteral( "airports" ) ).at( 0 );
+  QgsVectorLayer *airportsVLayer = static_cast<QgsVectorLayer *>( airportsLayer );
+  QVERIFY( airportsVLayer && airportsVLayer->isValid() );
+
+  FeaturesListModel model;
+  model.setIncremental( true );
+  model.populateFromLayer( airportsVLayer );
+
+  // first page is loaded right away
+  int featureCount = static_cast<int>( airportsVLayer->featureCount() );
+  int pageSize = FeaturesListModel::FETCH_PAGE_SIZE;
+  QCOMPARE( model.rowCount(), qMin( featureCount, pageSize ) );
+
+  // the rest is fetched in background
+  while ( model.canFetchMore( QModelIndex() ) )
+  {
+    QSignalSpy spy( &model, &FeaturesListModel::fetchingChanged );
+    model.fetchMore( QModelIndex() );
+    QVERIFY( model.fetching() );
+    QVERIFY( spy.wait() );
+    QVERIFY( !model.fetching() );
+  }
+  QCOMPARE( model.rowCount(), featureCount );
+
+  // features are fetched without geometry, complete feature is read from the layer on demand
+  QgsFeature feature = model.data( model.index( 0 ), FeaturesListModel::Feature ).value<QgsFeature>();
+  QVERIFY( feature.hasGeometry() );
+
+  // a search started before the previous one has finished replaces it
+  QSignalSpy spy( &model, &FeaturesListModel::fetchingChanged );
+  model.setSearchExpression( QStringLiteral( "xyz" ) );
+  model.setSearchExpression( QStringLiteral( "does not exist" ) );
+  QVERIFY( spy.wait() );
+  QVERIFY( !model.fetching() );
+  QCOMPARE( model.rowCount(), 0 );
+  QVERIFY( !model.canFetchMore( QModelIndex() ) );
+}
+
+void TestFormEditors::testFeaturesSearchIndex()
+{
+  QString projectDir = TestUtils::testDataDir() + "/planes";
+  QString projectName = "quickapp_project.qgs";
+
+  QVERIFY( QgsProject::instance()->read( projectDir + "/" + projectName ) );
+
+  QgsMapLayer *airportsLayer = QgsProject::instance()->mapLayersByName( QStringLiteral( "airports" ) ).at( 0 );
+  QgsVectorLayer *airportsVLayer = static_cast<QgsVectorLayer *>( airportsLayer );
+  QVERIFY( airportsVLayer && airportsVLayer->isValid() );
+
+  // the index is built lazily with the first search
+  std::shared_ptr<FeaturesSearchIndex> index = FeaturesSearchIndex::forLayer( airportsVLayer );
+  QSignalSpy spy( index.get(), &FeaturesSearchIndex::ready );
+  QgsFeatureIds fids;
+  QVERIFY( !index->search( QStringLiteral( "a" ), fids ) );
+  QVERIFY( spy.wait() );
+  QVERIFY( index->isReady() );
+  QCOMPARE( FeaturesSearchIndex::forLayer( airportsVLayer ), index );
+
+  // index must give the same results as search with expressions
+  FeaturesListModel model;
+  model.populateFromLayer( airportsVLayer );
+
+  const QStringList queries = { "a", "AI", "port", "1", "a 1", "no such airport" };
+  for ( const QString &query : queries )
+  {
+    model.setSearchExpression( query );
+    QgsFeatureIds expected;
+    for ( int i = 0; i < model.rowCount(); ++i )
+      expected << model.data( model.index( i ), FeaturesListModel::FeatureId ).toLongLong();
+
+    QVERIFY( index->search( query, fids ) );
+    QCOMPARE( fids, expected );
+  }
+}
@@ -23,6 +23,8 @@ class TestFormEditors : public QObject
     void testRelationsEditor();
     void testRelationsReferenceEditor();
     void testRelationsWidgetPresence();
+    void testFeaturesListModelIncremental();
+    void testFeaturesSearchIndex();
 };
 
 #endif // TESTFORMEDITORS_H
@@ -27,6 +27,7 @@
 
 #include "qgsquickmapcanvasmap.h"
 #include "identifykit.h"
+#include "featuresspatialindex.h"
 
 
 void TestIdentifyKit::identifyOne()
@@ -168,3 +169,65 @@ void TestIdentifyKit::identifyInRadius()
   res = kit.identify( screenPoint.toQPointF() );
   QVERIFY( res.size() == 2 );
 }
+
+void TestIdentifyKit::identifyWithSpatialIndex()
+{
+  QgsQuickMapCanvasMap canvas;
+
+  QgsVectorLayer *tempLayer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) );
+  QVERIFY( tempLayer->isValid() );
+  QVERIFY( FeaturesSpatialIndex::isNeeded( tempLayer ) );
+
+  // grid of points 5 map units apart
+  QgsFeatureList features;
+  for ( int x = 0; x <= 100; x += 5 )
+  {
+    for ( int y = 0; y <= 50; y += 5 )
+    {
+      QgsFeature f( tempLayer->fields() );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, y ) ) );
+      features << f;
+    }
+  }
+  tempLayer->dataProvider()->addFeatures( features );
+
+  QgsQuickMapSettings *ms = canvas.mapSettings();
+  ms->setDestinationCrs( tempLayer->crs() );
+  ms->setExtent( QgsRectangle( 0, 0, 100, 50 ) );
+  ms->setOutputSize( QSize( 1000, 500 ) );
+  ms->setLayers( QList<QgsMapLayer *>() << tempLayer );
+
+  IdentifyKit kit;
+  kit.setMapSettings( ms );
+  kit.setSearchRadiusMm( 3.0 );
+
+  // map point [10, 10]
+  const QPointF screenPoint( 100, 400 );
+
+  // the index is not ready yet, features come from the provider
+  FeatureLayerPairs res = kit.identify( screenPoint );
+  QCOMPARE( res.size(), 1 );
+  QVERIFY( res.at( 0 ).feature().geometry().asPoint() == QgsPointXY( 10, 10 ) );
+
+  std::shared_ptr<FeaturesSpatialIndex> index = FeaturesSpatialIndex::forLayer( tempLayer );
+  QTRY_VERIFY( index->isReady() );
+
+  res = kit.identify( screenPoint );
+  QCOMPARE( res.size(), 1 );
+  QVERIFY( res.at( 0 ).feature().geometry().asPoint() == QgsPointXY( 10, 10 ) );
+
+  // a new feature invalidates the index and is identified right away
+  tempLayer->startEditing();
+  QgsFeature f( tempLayer->fields() );
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 10.5, 10 ) ) );
+  tempLayer->addFeature( f );
+  QVERIFY( !index->isReady() );
+
+  res = kit.identify( screenPoint );
+  QCOMPARE( res.size(), 2 );
+
+  QTRY_VERIFY( index->isReady() );
+  res = kit.identify( screenPoint );
+  QCOMPARE( res.size(), 2 );
+  tempLayer->rollBack();
+}
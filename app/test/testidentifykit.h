@@ -22,6 +22,7 @@ class TestIdentifyKit: public QObject
     void identifyOne(); // tests identifyOne function without given layer
     void identifyOneDefinedVector(); // tests identifyOne function with given layer
     void identifyInRadius();
+    void identifyWithSpatialIndex(); // same results from the in-memory index, also after features change
 };
 
 #endif // TESTIDENTIFYKIT_H
@@ -0,0 +1,1294 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "testingmerginserver.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUuid>
+#include <QtEndian>
+
+#include <geodiff.h>
+
+#include "blockindex.h"
+#include "coreutils.h"
+#include "merginapi.h"
+
+static const int THROTTLE_INTERVAL_MS = 10;
+
+static QString _now()
+{
+  return QDateTime::currentDateTimeUtc().toString( Qt::ISODateWithMs );
+}
+
+static QByteArray _statusText( int status )
+{
+  switch ( status )
+  {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 415: return "Unsupported Media Type";
+    case 416: return "Range Not Satisfiable";
+    case 422: return "Unprocessable Entity";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+  }
+}
+
+static QString _fileChecksum( const QString &filePath )
+{
+  QFile f( filePath );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return QString();
+
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  if ( !hash.addData( &f ) )
+    return QString();
+  return QString::fromLatin1( hash.result().toHex() );
+}
+
+//! Encodes data with "deflate" content coding (zlib format)
+static QByteArray _deflate( const QByteArray &data )
+{
+  // qCompress() prefixes the zlib data with 4 bytes of the original size
+  return qCompress( data ).mid( 4 );
+}
+
+//! Decodes "deflate" content coding, returns false if the data are not valid
+static bool _inflate( const QByteArray &data, QByteArray &result )
+{
+  // qUncompress() expects the original size in front of the zlib data - it is only a hint for the buffer size
+  QByteArray sizeHint( 4, 0 );
+  qToBigEndian( static_cast<quint32>( qMin( qint64( data.size() ) * 8, qint64( 64 * 1024 * 1024 ) ) ), sizeHint.data() );
+  result = qUncompress( sizeHint + data );
+  return !result.isEmpty() || data.isEmpty();
+}
+
+static int _parseVersion( const QString &versionStr, int defaultVersion )
+{
+  if ( versionStr.startsWith( 'v' ) )
+    return versionStr.mid( 1 ).toInt();
+  return defaultVersion;
+}
+
+/**
+ * Writes the file described by block delta \a blocks to \a outputPath: blocks of the base file are copied from it,
+ * the others are read from the uploaded data in order (a block repeated in the list is uploaded just once).
+ * Returns an error message on failure
+ */
+static QString _applyBlockDelta( const QString &basePath, const QString &deltaPath, const QJsonArray &blocks, const QString &outputPath )
+{
+  QHash<QString, qint64> baseOffsets;
+  const QList<BlockIndex::Block> baseBlocks = BlockIndex::computeBlocks( basePath );
+  for ( const BlockIndex::Block &block : baseBlocks )
+    baseOffsets.insert( block.checksum, block.offset );
+
+  QFile base( basePath );
+  QFile delta( deltaPath );
+  QFile out( outputPath );
+  if ( !base.open( QIODevice::ReadOnly ) || !delta.open( QIODevice::ReadOnly ) || !out.open( QIODevice::WriteOnly ) )
+    return QStringLiteral( "Failed to open files" );
+
+  QHash<QString, qint64> uploadedOffsets;
+  for ( const QJsonValue &value : blocks )
+  {
+    QString checksum = value.toObject().value( "checksum" ).toString();
+    qint64 size = static_cast<qint64>( value.toObject().value( "size" ).toDouble() );
+
+    QByteArray data;
+    if ( baseOffsets.contains( checksum ) )
+    {
+      base.seek( baseOffsets[checksum] );
+      data = base.read( size );
+    }
+    else if ( uploadedOffsets.contains( checksum ) )
+    {
+      qint64 pos = delta.pos();
+      delta.seek( uploadedOffsets[checksum] );
+      data = delta.read( size );
+      delta.seek( pos );
+    }
+    else
+    {
+      uploadedOffsets.insert( checksum, delta.pos() );
+      data = delta.read( size );
+    }
+
+    if ( data.size() != size || QString::fromLatin1( QCryptographicHash::hash( data, QCryptographicHash::Sha1 ).toHex() ) != checksum )
+      return QStringLiteral( "Block %1 is missing" ).arg( checksum );
+    out.write( data );
+  }
+
+  if ( !delta.atEnd() )
+    return QStringLiteral( "Unexpected data after the last block" );
+  return QString();
+}
+
+
+TestingMerginServer::TestingMerginServer( QObject *parent )
+  : QObject( parent )
+  , mServer( new QTcpServer( this ) )
+  , mThrottleTimer( new QTimer( this ) )
+{
+  mThrottleTimer->setInterval( THROTTLE_INTERVAL_MS );
+  connect( mThrottleTimer, &QTimer::timeout, this, &TestingMerginServer::sendThrottled );
+  connect( mServer, &QTcpServer::newConnection, this, &TestingMerginServer::onNewConnection );
+
+  QDir( mStorage.path() ).mkpath( "blobs" );
+  QDir( mStorage.path() ).mkpath( "transactions" );
+}
+
+TestingMerginServer::~TestingMerginServer()
+{
+  const QList<QTcpSocket *> sockets = mConnections.keys();
+  mConnections.clear();
+  for ( QTcpSocket *socket : sockets )
+  {
+    disconnect( socket, nullptr, this, nullptr );
+    socket->abort();
+  }
+}
+
+bool TestingMerginServer::listen()
+{
+  return mServer->listen( QHostAddress::LocalHost );
+}
+
+QString TestingMerginServer::apiRoot() const
+{
+  return QStringLiteral( "http://127.0.0.1:%1/" ).arg( mServer->serverPort() );
+}
+
+void TestingMerginServer::addUser( const QString &username, const QString &password )
+{
+  mUsers.insert( username, password );
+}
+
+bool TestingMerginServer::createProject( const QString &projectNamespace, const QString &projectName )
+{
+  QString projectFullName = MerginApi::getFullProjectName( projectNamespace, projectName );
+  if ( mProjects.contains( projectFullName ) )
+    return false;
+
+  Project project;
+  project.projectNamespace = projectNamespace;
+  project.name = projectName;
+  project.created = _now();
+
+  ProjectVersion v0;
+  v0.created = project.created;
+  project.versions << v0;
+
+  mProjects.insert( projectFullName, project );
+  return true;
+}
+
+bool TestingMerginServer::addProjectVersion( const QString &projectNamespace, const QString &projectName, const QString &sourceDir )
+{
+  QString projectFullName = MerginApi::getFullProjectName( projectNamespace, projectName );
+  if ( !mProjects.contains( projectFullName ) )
+    return false;
+
+  Project &project = mProjects[projectFullName];
+  const ProjectVersion &latest = project.latest();
+
+  QJsonArray added, updated, removed;
+  QHash<QString, QString> content;
+  QSet<QString> present;
+
+  QDir dir( sourceDir );
+  QDirIterator it( sourceDir, QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() )
+  {
+    it.next();
+    QString path = dir.relativeFilePath( it.filePath() );
+    present << path;
+
+    QJsonObject fileObject;
+    fileObject.insert( "path", path );
+    fileObject.insert( "size", it.fileInfo().size() );
+    fileObject.insert( "mtime", it.fileInfo().lastModified().toUTC().toString( Qt::ISODateWithMs ) );
+    fileObject.insert( "checksum", _fileChecksum( it.filePath() ) );
+    content.insert( path, it.filePath() );
+
+    if ( latest.files.contains( path ) )
+      updated.append( fileObject );
+    else
+      added.append( fileObject );
+  }
+
+  for ( const FileEntry &entry : latest.files )
+  {
+    if ( !present.contains( entry.path ) )
+    {
+      QJsonObject fileObject;
+      fileObject.insert( "path", entry.path );
+      removed.append( fileObject );
+    }
+  }
+
+  QJsonObject changes;
+  changes.insert( "added", added );
+  changes.insert( "updated", updated );
+  changes.insert( "removed", removed );
+
+  return commitVersion( project, changes, content ).isEmpty();
+}
+
+int TestingMerginServer::projectVersion( const QString &projectNamespace, const QString &projectName ) const
+{
+  QString projectFullName = MerginApi::getFullProjectName( projectNamespace, projectName );
+  if ( !mProjects.contains( projectFullName ) )
+    return -1;
+  return mProjects[projectFullName].latest().version;
+}
+
+QString TestingMerginServer::projectFileChecksum( const QString &projectNamespace, const QString &projectName, const QString &filePath ) const
+{
+  QString projectFullName = MerginApi::getFullProjectName( projectNamespace, projectName );
+  if ( !mProjects.contains( projectFullName ) || !mProjects[projectFullName].latest().files.contains( filePath ) )
+    return QString();
+  return mProjects[projectFullName].latest().files[filePath].checksum;
+}
+
+void TestingMerginServer::setBlockDeltaSupported( bool supported )
+{
+  mBlockDeltaSupported = supported;
+}
+
+void TestingMerginServer::setCompressionSupported( bool supported )
+{
+  mCompressionSupported = supported;
+}
+
+void TestingMerginServer::dropTransactions()
+{
+  for ( const PushTransaction &transaction : qAsConst( mTransactions ) )
+    QDir( transaction.dir ).removeRecursively();
+  mTransactions.clear();
+}
+
+void TestingMerginServer::setLatency( int latencyMs )
+{
+  mLatencyMs = qMax( 0, latencyMs );
+}
+
+void TestingMerginServer::setBandwidth( qint64 bytesPerSecond )
+{
+  mBandwidth = qMax( qint64( 0 ), bytesPerSecond );
+}
+
+void TestingMerginServer::failRequests( const QString &pathPattern, int httpStatus, int count, int skip )
+{
+  FailureRule rule;
+  rule.pattern = QRegularExpression( pathPattern );
+  rule.httpStatus = httpStatus;
+  rule.remaining = count;
+  rule.skip = skip;
+  mFailureRules << rule;
+}
+
+void TestingMerginServer::setFailureRate( double rate, int httpStatus )
+{
+  mFailureRate = qBound( 0.0, rate, 1.0 );
+  mFailureRateStatus = httpStatus;
+}
+
+void TestingMerginServer::clearFailures()
+{
+  mFailureRules.clear();
+  mFailureRate = 0;
+}
+
+void TestingMerginServer::resetStats()
+{
+  mStats = TestingMerginServerStats();
+}
+
+//
+// HTTP handling
+//
+
+void TestingMerginServer::onNewConnection()
+{
+  while ( QTcpSocket *socket = mServer->nextPendingConnection() )
+  {
+    Connection connection;
+    connection.socket = socket;
+    mConnections.insert( socket, connection );
+
+    connect( socket, &QTcpSocket::readyRead, this, &TestingMerginServer::onReadyRead );
+    connect( socket, &QTcpSocket::disconnected, this, &TestingMerginServer::onDisconnected );
+  }
+}
+
+void TestingMerginServer::onDisconnected()
+{
+  QTcpSocket *socket = qobject_cast<QTcpSocket *>( sender() );
+  mConnections.remove( socket );
+  socket->deleteLater();
+}
+
+void TestingMerginServer::onReadyRead()
+{
+  QTcpSocket *socket = qobject_cast<QTcpSocket *>( sender() );
+  if ( !mConnections.contains( socket ) )
+    return;
+
+  Connection &connection = mConnections[socket];
+  connection.inBuffer.append( socket->readAll() );
+
+  // one request at a time per connection - the next one is parsed once the response is out
+  if ( connection.busy )
+    return;
+
+  Request request;
+  if ( parseRequest( connection, request ) )
+  {
+    connection.busy = true;
+    processRequest( socket, request );
+  }
+}
+
+bool TestingMerginServer::parseRequest( Connection &connection, Request &request )
+{
+  int headerEnd = connection.inBuffer.indexOf( "\r\n\r\n" );
+  if ( headerEnd == -1 )
+    return false;
+
+  QList<QByteArray> lines = connection.inBuffer.left( headerEnd ).split( '\n' );
+  QList<QByteArray> requestLine = lines.takeFirst().trimmed().split( ' ' );
+  if ( requestLine.count() < 2 )
+  {
+    connection.inBuffer.clear();
+    return false;
+  }
+
+  for ( const QByteArray &line : lines )
+  {
+    int colon = line.indexOf( ':' );
+    if ( colon > 0 )
+      request.headers.insert( line.left( colon ).trimmed().toLower(), line.mid( colon + 1 ).trimmed() );
+  }
+
+  qint64 contentLength = request.headers.value( "content-length", "0" ).toLongLong();
+  if ( connection.inBuffer.size() < headerEnd + 4 + contentLength )
+    return false;  // wait for the rest of the body
+
+  request.method = requestLine.at( 0 );
+  request.body = connection.inBuffer.mid( headerEnd + 4, static_cast<int>( contentLength ) );
+  connection.inBuffer.remove( 0, headerEnd + 4 + static_cast<int>( contentLength ) );
+
+  // MerginApi joins the api root and paths with a slash on both sides sometimes, so collapse them.
+  // The target cannot go through QUrl directly - "//v1/..." would be taken for an authority
+  QByteArray target = requestLine.at( 1 );
+  int queryStart = target.indexOf( '?' );
+  QByteArray path = queryStart == -1 ? target : target.left( queryStart );
+  request.path = QUrl::fromPercentEncoding( path ).replace( QRegularExpression( "/+" ), "/" );
+  if ( queryStart != -1 )
+    request.query = QUrlQuery( QString::fromUtf8( target.mid( queryStart + 1 ) ) );
+
+  return true;
+}
+
+void TestingMerginServer::processRequest( QTcpSocket *socket, const Request &request )
+{
+  QString endpoint = endpointName( request.method, request.path );
+  mStats.requestCount++;
+  mStats.bytesReceived += request.body.size();
+  mStats.requestsPerEndpoint[endpoint]++;
+
+  Response response;
+  bool failed = false;
+
+  // the endpoints get the decoded body
+  Request decodedRequest = request;
+  QByteArray contentEncoding = request.headers.value( "content-encoding" ).toLower();
+  if ( !contentEncoding.isEmpty() && contentEncoding != "identity" )
+  {
+    if ( contentEncoding != "deflate" || !mCompressionSupported )
+    {
+      response = error( 415, QStringLiteral( "Unsupported content encoding" ) );
+      failed = true;
+    }
+    else if ( !_inflate( request.body, decodedRequest.body ) )
+    {
+      response = error( 400, QStringLiteral( "Invalid compressed body" ) );
+      failed = true;
+    }
+    else
+    {
+      mStats.compressedRequests[endpoint]++;
+    }
+  }
+
+  for ( FailureRule &rule : mFailureRules )
+  {
+    if ( failed )
+      break;
+
+    if ( rule.remaining > 0 && rule.pattern.match( request.path ).hasMatch() )
+    {
+      if ( rule.skip > 0 )
+      {
+        rule.skip--;
+        continue;
+      }
+
+      rule.remaining--;
+      response = error( rule.httpStatus, QStringLiteral( "Injected failure" ) );
+      response.dropConnection = rule.httpStatus == 0;
+      failed = true;
+      break;
+    }
+  }
+
+  if ( !failed && mFailureRate > 0 && QRandomGenerator::global()->generateDouble() < mFailureRate )
+  {
+    response = error( mFailureRateStatus, QStringLiteral( "Injected random failure" ) );
+    response.dropConnection = mFailureRateStatus == 0;
+    failed = true;
+  }
+
+  if ( !failed )
+  {
+    response = route( decodedRequest );
+    if ( compressResponse( request, response ) )
+      mStats.compressedResponses[endpoint]++;
+  }
+
+  bool keepAlive = request.headers.value( "connection" ).toLower() != "close";
+
+  // uploads take their time too - the request body is accounted by delaying the response
+  qint64 delayMs = mLatencyMs;
+  if ( mBandwidth > 0 )
+    delayMs += request.body.size() * 1000 / mBandwidth;
+
+  if ( delayMs == 0 )
+  {
+    sendResponse( socket, response, keepAlive );
+  }
+  else
+  {
+    QPointer<QTcpSocket> socketPtr( socket );
+    QTimer::singleShot( static_cast<int>( delayMs ), this, [this, socketPtr, response, keepAlive]()
+    {
+      if ( socketPtr )
+        sendResponse( socketPtr, response, keepAlive );
+    } );
+  }
+}
+
+void TestingMerginServer::sendResponse( QTcpSocket *socket, const Response &response, bool keepAlive )
+{
+  if ( !mConnections.contains( socket ) )
+    return;
+
+  if ( response.dropConnection )
+  {
+    disconnect( socket, nullptr, this, nullptr );
+    mConnections.remove( socket );
+    socket->abort();
+    socket->deleteLater();
+    return;
+  }
+
+  mStats.bytesSent += response.body.size();
+
+  QByteArray data;
+  data += "HTTP/1.1 " + QByteArray::number( response.status ) + " " + _statusText( response.status ) + "\r\n";
+  data += "Content-Type: " + response.contentType + "\r\n";
+  data += "Content-Length: " + QByteArray::number( response.body.size() ) + "\r\n";
+  for ( const auto &header : response.headers )
+    data += header.first + ": " + header.second + "\r\n";
+  data += keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+  data += "\r\n";
+  data += response.body;
+
+  Connection &connection = mConnections[socket];
+  connection.outBuffer += data;
+  connection.closeAfterWrite = !keepAlive;
+
+  writeOut( connection );
+}
+
+void TestingMerginServer::writeOut( Connection &connection )
+{
+  if ( mBandwidth <= 0 )
+  {
+    connection.socket->write( connection.outBuffer );
+    connection.outBuffer.clear();
+    connectionDone( connection.socket );
+    return;
+  }
+
+  // the data go out in slices shared with the other connections
+  if ( !mThrottleTimer->isActive() )
+  {
+    mLastThrottleMs = QDateTime::currentMSecsSinceEpoch();
+    mThrottleTimer->start();
+  }
+}
+
+void TestingMerginServer::sendThrottled()
+{
+  qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+  qint64 budget = qMax( qint64( 1 ), mBandwidth * ( nowMs - mLastThrottleMs ) / 1000 );
+  mLastThrottleMs = nowMs;
+
+  QList<QTcpSocket *> pending;
+  for ( auto it = mConnections.begin(); it != mConnections.end(); ++it )
+  {
+    if ( !it->outBuffer.isEmpty() )
+      pending << it.key();
+  }
+
+  if ( pending.isEmpty() || mBandwidth <= 0 )
+  {
+    mThrottleTimer->stop();
+    for ( QTcpSocket *socket : pending )
+      writeOut( mConnections[socket] );
+    return;
+  }
+
+  qint64 share = qMax( qint64( 1 ), budget / pending.count() );
+  for ( QTcpSocket *socket : pending )
+  {
+    Connection &connection = mConnections[socket];
+    int size = static_cast<int>( qMin( share, qint64( connection.outBuffer.size() ) ) );
+    connection.socket->write( connection.outBuffer.left( size ) );
+    connection.outBuffer.remove( 0, size );
+
+    if ( connection.outBuffer.isEmpty() )
+      connectionDone( socket );
+  }
+}
+
+void TestingMerginServer::connectionDone( QTcpSocket *socket )
+{
+  if ( !mConnections.contains( socket ) )
+    return;
+
+  Connection &connection = mConnections[socket];
+  connection.busy = false;
+
+  if ( connection.closeAfterWrite )
+  {
+    socket->disconnectFromHost();  // pending data are still written
+    return;
+  }
+
+  // continue with the next request that may be already waiting in the buffer
+  Request request;
+  if ( parseRequest( connection, request ) )
+  {
+    connection.busy = true;
+    processRequest( socket, request );
+  }
+}
+
+//
+// Mergin API
+//
+
+TestingMerginServer::Response TestingMerginServer::error( int status, const QString &detail )
+{
+  QJsonObject obj;
+  obj.insert( "detail", detail );
+
+  Response response;
+  response.status = status;
+  response.body = QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+bool TestingMerginServer::compressResponse( const Request &request, Response &response )
+{
+  // a range of compressed content would be a range of the compressed data
+  if ( !mCompressionSupported || response.status != 200 || response.body.size() < 1024 ||
+       request.headers.contains( "range" ) || !request.headers.value( "accept-encoding" ).toLower().contains( "deflate" ) )
+    return false;
+
+  QString filePath = request.query.queryItemValue( "file", QUrl::FullyDecoded );
+  if ( !filePath.isEmpty() && MerginApi::isFileCompressed( filePath ) )
+    return false;
+
+  QByteArray compressed = _deflate( response.body );
+  if ( compressed.size() * 10 > response.body.size() * 9 )
+    return false;  // does not pay off
+
+  response.body = compressed;
+  response.headers << qMakePair( QByteArray( "Content-Encoding" ), QByteArray( "deflate" ) );
+  return true;
+}
+
+QString TestingMerginServer::endpointName( const QByteArray &method, const QString &path )
+{
+  QString name;
+  if ( path == "/ping" )
+    name = "ping";
+  else if ( path.startsWith( "/v1/auth/" ) )
+    name = "auth";
+  else if ( path.startsWith( "/v1/user/" ) )
+    name = "user";
+  else if ( path.startsWith( "/v1/project/raw/" ) )
+    name = "raw";
+  else if ( path.startsWith( "/v1/project/blocks/" ) )
+    name = "blocks";
+  else if ( path.startsWith( "/v1/project/push/chunk/" ) )
+    name = "push chunk";
+  else if ( path.startsWith( "/v1/project/push/finish/" ) )
+    name = "push finish";
+  else if ( path.startsWith( "/v1/project/push/cancel/" ) )
+    name = "push cancel";
+  else if ( path.startsWith( "/v1/project/push/" ) )
+    name = "push start";
+  else if ( path.startsWith( "/v1/project/paginated" ) || path.startsWith( "/v1/project/by_names" ) )
+    name = "list";
+  else if ( path.startsWith( "/v1/project/" ) )
+    name = "project";
+  else
+    name = "other";
+  return QString::fromLatin1( method ) + " " + name;
+}
+
+TestingMerginServer::Response TestingMerginServer::route( const Request &request )
+{
+  const QString &path = request.path;
+  const QByteArray &method = request.method;
+  QStringList parts = path.split( '/', QString::SplitBehavior::SkipEmptyParts );
+
+  if ( method == "GET" && path == "/ping" )
+    return ping();
+
+  if ( method == "POST" && path == "/v1/auth/login" )
+    return login( request );
+
+  if ( method == "GET" && parts.count() == 3 && path.startsWith( "/v1/user/" ) )
+  {
+    if ( parts.at( 2 ) == "service" )
+      return error( 404, QStringLiteral( "Subscriptions are not enabled" ) );
+    return userInfo( parts.at( 2 ) );
+  }
+
+  if ( !path.startsWith( "/v1/project/" ) )
+    return error( 404, QStringLiteral( "Unknown endpoint" ) );
+
+  if ( method == "GET" && path == "/v1/project/paginated" )
+    return listProjects( request );
+
+  if ( method == "POST" && path == "/v1/project/by_names" )
+    return listProjectsByName( request );
+
+  if ( method == "GET" && parts.count() == 5 && parts.at( 2 ) == "raw" )
+    return rawDownload( parts.at( 3 ) + "/" + parts.at( 4 ), request );
+
+  if ( method == "GET" && parts.count() == 5 && parts.at( 2 ) == "blocks" && mBlockDeltaSupported )
+    return blockList( parts.at( 3 ) + "/" + parts.at( 4 ), request );
+
+  if ( method == "POST" && parts.count() >= 4 && parts.at( 2 ) == "push" )
+  {
+    if ( parts.count() == 6 && parts.at( 3 ) == "chunk" )
+      return pushChunk( parts.at( 4 ), parts.at( 5 ), request );
+    if ( parts.count() == 5 && parts.at( 3 ) == "finish" )
+      return pushFinish( parts.at( 4 ) );
+    if ( parts.count() == 5 && parts.at( 3 ) == "cancel" )
+      return pushCancel( parts.at( 4 ) );
+    if ( parts.count() == 5 )
+      return pushStart( parts.at( 3 ) + "/" + parts.at( 4 ), request );
+  }
+
+  if ( method == "POST" && parts.count() == 3 )
+    return createProjectRequest( parts.at( 2 ), request );
+
+  if ( parts.count() == 4 )
+  {
+    QString projectFullName = parts.at( 2 ) + "/" + parts.at( 3 );
+    if ( method == "GET" )
+      return projectInfo( projectFullName, request );
+    if ( method == "DELETE" )
+      return deleteProjectRequest( projectFullName );
+  }
+
+  return error( 404, QStringLiteral( "Unknown endpoint" ) );
+}
+
+TestingMerginServer::Response TestingMerginServer::ping()
+{
+  QJsonObject obj;
+  obj.insert( "version", QStringLiteral( "%1.%2.0" ).arg( MerginApi::MERGIN_API_VERSION_MAJOR ).arg( MerginApi::MERGIN_API_VERSION_MINOR ) );
+  obj.insert( "subscriptions_enabled", false );
+  obj.insert( "block_delta", mBlockDeltaSupported );
+  if ( mCompressionSupported )
+    obj.insert( "request_encodings", QJsonArray() << QStringLiteral( "deflate" ) );
+
+  Response response;
+  response.body = QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::login( const Request &request )
+{
+  QJsonObject credentials = QJsonDocument::fromJson( request.body ).object();
+  QString username = credentials.value( "login" ).toString();
+  QString password = credentials.value( "password" ).toString();
+
+  if ( !mUsers.contains( username ) || mUsers.value( username ) != password )
+    return error( 401, QStringLiteral( "Invalid username or password" ) );
+
+  QByteArray token = CoreUtils::uuidWithoutBraces( QUuid::createUuid() ).toLatin1();
+  mTokens.insert( token, username );
+
+  QJsonObject session;
+  session.insert( "token", QString::fromLatin1( token ) );
+  session.insert( "expire", QDateTime::currentDateTimeUtc().addDays( 1 ).toString( Qt::ISODateWithMs ) );
+
+  QJsonObject obj;
+  obj.insert( "user", mUsers.keys().indexOf( username ) + 1 );
+  obj.insert( "username", username );
+  obj.insert( "session", session );
+
+  Response response;
+  response.body = QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::userInfo( const QString &username )
+{
+  if ( !mUsers.contains( username ) )
+    return error( 404, QStringLiteral( "User not found" ) );
+
+  QJsonObject obj;
+  obj.insert( "email", username + "@example.com" );
+  obj.insert( "disk_usage", 0 );
+  obj.insert( "storage", 1024.0 * 1024 * 1024 * 1024 );
+
+  Response response;
+  response.body = QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+QJsonObject TestingMerginServer::projectListEntry( const Project &project ) const
+{
+  QJsonObject obj;
+  obj.insert( "name", project.name );
+  obj.insert( "namespace", project.projectNamespace );
+  obj.insert( "version", QStringLiteral( "v%1" ).arg( project.latest().version ) );
+  obj.insert( "created", project.created );
+  obj.insert( "updated", project.latest().created );
+  return obj;
+}
+
+TestingMerginServer::Response TestingMerginServer::listProjects( const Request &request )
+{
+  QString name = QUrl::fromPercentEncoding( request.query.queryItemValue( "name", QUrl::FullyDecoded ).toUtf8() );
+  QString flag = request.query.queryItemValue( "flag" );
+  int page = qMax( 1, request.query.queryItemValue( "page" ).toInt() );
+  int perPage = qMax( 1, request.query.queryItemValue( "per_page" ).toInt() );
+
+  QString username;
+  QByteArray authorization = request.headers.value( "authorization" );
+  if ( authorization.startsWith( "Bearer " ) )
+    username = mTokens.value( authorization.mid( 7 ) );
+
+  QList<const Project *> matching;
+  for ( const Project &project : mProjects )  // sorted by full name, so also by namespace
+  {
+    if ( !name.isEmpty() && !project.name.contains( name, Qt::CaseInsensitive ) )
+      continue;
+    if ( flag == "created" && project.projectNamespace != username )
+      continue;
+    if ( flag == "shared" && project.projectNamespace == username )
+      continue;
+    matching << &project;
+  }
+
+  QJsonArray projects;
+  for ( int i = ( page - 1 ) * perPage; i < matching.count() && i < page * perPage; ++i )
+    projects.append( projectListEntry( *matching.at( i ) ) );
+
+  QJsonObject obj;
+  obj.insert( "count", matching.count() );
+  obj.insert( "projects", projects );
+
+  Response response;
+  response.body = QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::listProjectsByName( const Request &request )
+{
+  QJsonArray names = QJsonDocument::fromJson( request.body ).object().value( "projects" ).toArray();
+
+  QJsonObject obj;
+  for ( const QJsonValue &value : names )
+  {
+    QString projectFullName = value.toString();
+    if ( mProjects.contains( projectFullName ) )
+    {
+      obj.insert( projectFullName, projectListEntry( mProjects[projectFullName] ) );
+    }
+    else
+    {
+      QJsonObject err;
+      err.insert( "error", 404 );
+      obj.insert( projectFullName, err );
+    }
+  }
+
+  Response response;
+  response.body = QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::createProjectRequest( const QString &projectNamespace, const Request &request )
+{
+  QString projectName = QJsonDocument::fromJson( request.body ).object().value( "name" ).toString();
+  if ( projectName.isEmpty() )
+    return error( 400, QStringLiteral( "Missing project name" ) );
+
+  if ( !createProject( projectNamespace, projectName ) )
+    return error( 409, QStringLiteral( "Project %1 already exists!" ).arg( projectName ) );
+
+  Response response;
+  response.body = "{}";
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::deleteProjectRequest( const QString &projectFullName )
+{
+  if ( !mProjects.remove( projectFullName ) )
+    return error( 404, QStringLiteral( "Project not found" ) );
+
+  Response response;
+  response.body = "{}";
+  return response;
+}
+
+QJsonObject TestingMerginServer::projectJson( const Project &project, int sinceVersion ) const
+{
+  const ProjectVersion &latest = project.latest();
+
+  QJsonArray files;
+  for ( const FileEntry &entry : latest.files )
+  {
+    QJsonObject fileObject;
+    fileObject.insert( "path", entry.path );
+    fileObject.insert( "checksum", entry.checksum );
+    fileObject.insert( "size", entry.size );
+    fileObject.insert( "mtime", entry.mtime );
+
+    if ( sinceVersion != -1 )
+    {
+      // changes of the file since the requested version - diffs can be downloaded for those that have one
+      QJsonObject history;
+      for ( int v = qMax( 0, sinceVersion ); v <= latest.version; ++v )
+      {
+        const ProjectVersion &version = project.versions.at( v );
+        if ( !version.changed.contains( entry.path ) )
+          continue;
+
+        const FileEntry &change = version.changed[entry.path];
+        QJsonObject historyItem;
+        historyItem.insert( "checksum", change.checksum );
+        historyItem.insert( "size", change.size );
+        if ( !change.diffBlob.isEmpty() )
+        {
+          QJsonObject diff;
+          diff.insert( "path", QStringLiteral( "%1-diff-v%2" ).arg( entry.path ).arg( v ) );
+          diff.insert( "checksum", change.diffBlob );
+          diff.insert( "size", change.diffSize );
+          historyItem.insert( "diff", diff );
+        }
+        history.insert( QStringLiteral( "v%1" ).arg( v ), historyItem );
+      }
+      fileObject.insert( "history", history );
+    }
+
+    files.append( fileObject );
+  }
+
+  QJsonArray writers;
+  writers.append( project.projectNamespace );
+  QJsonObject access;
+  access.insert( "writersnames", writers );
+
+  QJsonObject obj;
+  obj.insert( "name", project.name );
+  obj.insert( "namespace", project.projectNamespace );
+  obj.insert( "version", QStringLiteral( "v%1" ).arg( latest.version ) );
+  obj.insert( "created", project.created );
+  obj.insert( "updated", latest.created );
+  obj.insert( "files", files );
+  obj.insert( "access", access );
+  return obj;
+}
+
+TestingMerginServer::Response TestingMerginServer::projectInfo( const QString &projectFullName, const Request &request )
+{
+  if ( !mProjects.contains( projectFullName ) )
+    return error( 404, QStringLiteral( "Project not found" ) );
+
+  int sinceVersion = _parseVersion( request.query.queryItemValue( "since" ), -1 );
+
+  Response response;
+  response.body = QJsonDocument( projectJson( mProjects[projectFullName], sinceVersion ) ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::rawDownload( const QString &projectFullName, const Request &request )
+{
+  if ( !mProjects.contains( projectFullName ) )
+    return error( 404, QStringLiteral( "Project not found" ) );
+
+  const Project &project = mProjects[projectFullName];
+  QString filePath = QUrl::fromPercentEncoding( request.query.queryItemValue( "file", QUrl::FullyDecoded ).toUtf8() );
+  int version = _parseVersion( request.query.queryItemValue( "version" ), project.latest().version );
+  bool diff = request.query.queryItemValue( "diff" ) == "true";
+
+  if ( version < 0 || version >= project.versions.count() )
+    return error( 404, QStringLiteral( "Version not found" ) );
+
+  const ProjectVersion &projectVersion = project.versions.at( version );
+  QString blob;
+  if ( diff )
+  {
+    if ( projectVersion.changed.contains( filePath ) )
+      blob = projectVersion.changed[filePath].diffBlob;
+  }
+  else if ( projectVersion.files.contains( filePath ) )
+  {
+    blob = projectVersion.files[filePath].checksum;
+  }
+
+  if ( blob.isEmpty() )
+    return error( 404, QStringLiteral( "File %1 not found" ).arg( filePath ) );
+
+  QFile f( blobPath( blob ) );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return error( 500, QStringLiteral( "Failed to read stored file" ) );
+
+  Response response;
+  response.contentType = "application/octet-stream";
+
+  QByteArray range = request.headers.value( "range" );
+  if ( range.startsWith( "bytes=" ) )
+  {
+    QList<QByteArray> bounds = range.mid( 6 ).split( '-' );
+    qint64 from = bounds.value( 0 ).toLongLong();
+    qint64 to = bounds.value( 1 ).isEmpty() ? f.size() - 1 : qMin( bounds.value( 1 ).toLongLong(), f.size() - 1 );
+    if ( from > to && f.size() > 0 )
+      return error( 416, QStringLiteral( "Invalid range" ) );
+
+    f.seek( from );
+    response.body = f.read( to - from + 1 );
+    response.status = 206;
+    response.headers << qMakePair( QByteArray( "Content-Range" ), QStringLiteral( "bytes %1-%2/%3" ).arg( from ).arg( to ).arg( f.size() ).toLatin1() );
+  }
+  else
+  {
+    response.body = f.readAll();
+  }
+
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::blockList( const QString &projectFullName, const Request &request )
+{
+  if ( !mProjects.contains( projectFullName ) )
+    return error( 404, QStringLiteral( "Project not found" ) );
+
+  const Project &project = mProjects[projectFullName];
+  QString filePath = QUrl::fromPercentEncoding( request.query.queryItemValue( "file", QUrl::FullyDecoded ).toUtf8() );
+  int version = _parseVersion( request.query.queryItemValue( "version" ), project.latest().version );
+
+  if ( version < 0 || version >= project.versions.count() || !project.versions.at( version ).files.contains( filePath ) )
+    return error( 404, QStringLiteral( "File %1 not found" ).arg( filePath ) );
+
+  const FileEntry &entry = project.versions.at( version ).files[filePath];
+
+  QJsonArray blocks;
+  const QList<BlockIndex::Block> fileBlocks = BlockIndex::computeBlocks( blobPath( entry.checksum ) );
+  for ( const BlockIndex::Block &block : fileBlocks )
+  {
+    QJsonObject blockObject;
+    blockObject.insert( "offset", block.offset );
+    blockObject.insert( "size", block.size );
+    blockObject.insert( "checksum", block.checksum );
+    blocks.append( blockObject );
+  }
+
+  QJsonObject obj;
+  obj.insert( "checksum", entry.checksum );
+  obj.insert( "size", entry.size );
+  obj.insert( "blocks", blocks );
+
+  Response response;
+  response.body = QJsonDocument( obj ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::pushStart( const QString &projectFullName, const Request &request )
+{
+  if ( !mProjects.contains( projectFullName ) )
+    return error( 404, QStringLiteral( "Project not found" ) );
+
+  Project &project = mProjects[projectFullName];
+  QJsonObject obj = QJsonDocument::fromJson( request.body ).object();
+  QJsonObject changes = obj.value( "changes" ).toObject();
+
+  if ( _parseVersion( obj.value( "version" ).toString(), -1 ) != project.latest().version )
+    return error( 409, QStringLiteral( "There is already version v%1 of this project" ).arg( project.latest().version ) );
+
+  for ( const QString &key : { QStringLiteral( "updated" ), QStringLiteral( "removed" ) } )
+  {
+    for ( const QJsonValue &value : changes.value( key ).toArray() )
+    {
+      QString path = value.toObject().value( "path" ).toString();
+      if ( !project.latest().files.contains( path ) )
+        return error( 400, QStringLiteral( "File %1 is not in the project" ).arg( path ) );
+    }
+  }
+
+  if ( changes.value( "added" ).toArray().isEmpty() && changes.value( "updated" ).toArray().isEmpty() )
+  {
+    // nothing to upload - the server creates the version right away
+    QString err = commitVersion( project, changes, QHash<QString, QString>() );
+    if ( !err.isEmpty() )
+      return error( 422, err );
+
+    Response response;
+    response.body = QJsonDocument( projectJson( project ) ).toJson( QJsonDocument::Compact );
+    return response;
+  }
+
+  PushTransaction transaction;
+  transaction.projectFullName = projectFullName;
+  transaction.changes = changes;
+  QString transactionId = CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
+  transaction.dir = mStorage.path() + "/transactions/" + transactionId;
+  QDir().mkpath( transaction.dir );
+  mTransactions.insert( transactionId, transaction );
+
+  QJsonObject reply;
+  reply.insert( "transaction", transactionId );
+
+  Response response;
+  response.body = QJsonDocument( reply ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::pushChunk( const QString &transactionId, const QString &chunkId, const Request &request )
+{
+  if ( !mTransactions.contains( transactionId ) )
+    return error( 404, QStringLiteral( "Transaction not found" ) );
+
+  QFile f( mTransactions[transactionId].dir + "/" + chunkId );
+  if ( !f.open( QIODevice::WriteOnly ) )
+    return error( 500, QStringLiteral( "Failed to store chunk" ) );
+  f.write( request.body );
+  f.close();
+
+  QJsonObject reply;
+  reply.insert( "checksum", QString::fromLatin1( QCryptographicHash::hash( request.body, QCryptographicHash::Sha1 ).toHex() ) );
+  reply.insert( "size", request.body.size() );
+
+  Response response;
+  response.body = QJsonDocument( reply ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::pushFinish( const QString &transactionId )
+{
+  if ( !mTransactions.contains( transactionId ) )
+    return error( 404, QStringLiteral( "Transaction not found" ) );
+
+  PushTransaction transaction = mTransactions.take( transactionId );
+  if ( !mProjects.contains( transaction.projectFullName ) )
+    return error( 404, QStringLiteral( "Project not found" ) );
+
+  // assemble uploaded files from their chunks
+  QHash<QString, QString> content;
+  for ( const QString &key : { QStringLiteral( "added" ), QStringLiteral( "updated" ) } )
+  {
+    for ( const QJsonValue &value : transaction.changes.value( key ).toArray() )
+    {
+      QJsonObject fileObject = value.toObject();
+      QString path = fileObject.value( "path" ).toString();
+      QString assembled = transaction.dir + "/" + CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
+
+      QFile out( assembled );
+      if ( !out.open( QIODevice::WriteOnly ) )
+        return error( 500, QStringLiteral( "Failed to assemble %1" ).arg( path ) );
+
+      for ( const QJsonValue &chunk : fileObject.value( "chunks" ).toArray() )
+      {
+        QFile in( transaction.dir + "/" + chunk.toString() );
+        if ( !in.open( QIODevice::ReadOnly ) )
+        {
+          QDir( transaction.dir ).removeRecursively();
+          return error( 422, QStringLiteral( "Missing chunk %1 of %2" ).arg( chunk.toString(), path ) );
+        }
+        out.write( in.readAll() );
+      }
+      out.close();
+      content.insert( path, assembled );
+    }
+  }
+
+  QString err = commitVersion( mProjects[transaction.projectFullName], transaction.changes, content );
+  QDir( transaction.dir ).removeRecursively();
+  if ( !err.isEmpty() )
+    return error( 422, err );
+
+  Response response;
+  response.body = QJsonDocument( projectJson( mProjects[transaction.projectFullName] ) ).toJson( QJsonDocument::Compact );
+  return response;
+}
+
+TestingMerginServer::Response TestingMerginServer::pushCancel( const QString &transactionId )
+{
+  if ( !mTransactions.contains( transactionId ) )
+    return error( 404, QStringLiteral( "Transaction not found" ) );
+
+  QDir( mTransactions.take( transactionId ).dir ).removeRecursively();
+
+  Response response;
+  response.body = "{}";
+  return response;
+}
+
+//
+// storage
+//
+
+QString TestingMerginServer::blobPath( const QString &checksum ) const
+{
+  return mStorage.path() + "/blobs/" + checksum;
+}
+
+QString TestingMerginServer::storeBlob( const QString &filePath )
+{
+  QString checksum = _fileChecksum( filePath );
+  if ( checksum.isEmpty() )
+    return QString();
+
+  QString dest = blobPath( checksum );
+  if ( !QFile::exists( dest ) && !QFile::copy( filePath, dest ) )
+    return QString();
+
+  return checksum;
+}
+
+QString TestingMerginServer::commitVersion( Project &project, const QJsonObject &changes, const QHash<QString, QString> &content )
+{
+  ProjectVersion newVersion;
+  newVersion.version = project.latest().version + 1;
+  newVersion.created = _now();
+  newVersion.files = project.latest().files;
+
+  for ( const QJsonValue &value : changes.value( "removed" ).toArray() )
+    newVersion.files.remove( value.toObject().value( "path" ).toString() );
+
+  for ( const QString &key : { QStringLiteral( "added" ), QStringLiteral( "updated" ) } )
+  {
+    for ( const QJsonValue &value : changes.value( key ).toArray() )
+    {
+      QJsonObject fileObject = value.toObject();
+
+      FileEntry entry;
+      entry.path = fileObject.value( "path" ).toString();
+      entry.mtime = fileObject.value( "mtime" ).toString();
+
+      QString uploaded = content.value( entry.path );
+      if ( uploaded.isEmpty() )
+        return QStringLiteral( "Missing content of %1" ).arg( entry.path );
+
+      if ( fileObject.contains( "diff" ) )
+      {
+        // the upload is a geodiff changeset to be applied on top of the current file
+        QJsonObject diffObject = fileObject.value( "diff" ).toObject();
+        if ( _fileChecksum( uploaded ) != diffObject.value( "checksum" ).toString() )
+          return QStringLiteral( "Checksum of the diff of %1 does not match" ).arg( entry.path );
+        if ( !project.latest().files.contains( entry.path ) )
+          return QStringLiteral( "No base file for the diff of %1" ).arg( entry.path );
+
+        QString patched = uploaded + "-patched";
+        if ( !QFile::copy( blobPath( project.latest().files[entry.path].checksum ), patched ) )
+          return QStringLiteral( "Failed to copy base file of %1" ).arg( entry.path );
+
+        int res = GEODIFF_applyChangeset( patched.toUtf8().constData(), uploaded.toUtf8().constData() );
+        if ( res != GEODIFF_SUCCESS )
+          return QStringLiteral( "Failed to apply the diff of %1" ).arg( entry.path );
+
+        entry.diffBlob = storeBlob( uploaded );
+        entry.diffSize = QFileInfo( uploaded ).size();
+        entry.checksum = storeBlob( patched );
+        entry.size = QFileInfo( patched ).size();
+        QFile::remove( patched );
+      }
+      else if ( fileObject.contains( "delta" ) )
+      {
+        // the upload are blocks missing in the current file, the rest gets copied from it
+        QJsonObject deltaObject = fileObject.value( "delta" ).toObject();
+        if ( !mBlockDeltaSupported )
+          return QStringLiteral( "Block delta is not supported" );
+        if ( _fileChecksum( uploaded ) != deltaObject.value( "checksum" ).toString() )
+          return QStringLiteral( "Checksum of the delta of %1 does not match" ).arg( entry.path );
+        if ( !project.latest().files.contains( entry.path ) )
+          return QStringLiteral( "No base file for the delta of %1" ).arg( entry.path );
+
+        QString assembled = uploaded + "-assembled";
+        QString err = _applyBlockDelta( blobPath( project.latest().files[entry.path].checksum ), uploaded,
+                                        deltaObject.value( "blocks" ).toArray(), assembled );
+        if ( !err.isEmpty() )
+          return QStringLiteral( "Failed to apply the delta of %1: %2" ).arg( entry.path, err );
+
+        entry.checksum = storeBlob( assembled );
+        entry.size = QFileInfo( assembled ).size();
+        QFile::remove( assembled );
+        if ( entry.checksum != fileObject.value( "checksum" ).toString() )
+          return QStringLiteral( "Checksum of %1 does not match" ).arg( entry.path );
+      }
+      else
+      {
+        entry.checksum = storeBlob( uploaded );
+        entry.size = QFileInfo( uploaded ).size();
+        if ( entry.checksum != fileObject.value( "checksum" ).toString() )
+          return QStringLiteral( "Checksum of %1 does not match" ).arg( entry.path );
+      }
+
+      if ( entry.checksum.isEmpty() )
+        return QStringLiteral( "Failed to store %1" ).arg( entry.path );
+
+      newVersion.files.insert( entry.path, entry );
+      newVersion.changed.insert( entry.path, entry );
+    }
+  }
+
+  project.versions << newVersion;
+  return QString();
+}
@@ -0,0 +1,272 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TESTINGMERGINSERVER_H
+#define TESTINGMERGINSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QList>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QUrlQuery>
+
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+//! Counters of the traffic handled by TestingMerginServer
+struct TestingMerginServerStats
+{
+  int requestCount = 0;
+  qint64 bytesReceived = 0;  //!< request bodies
+  qint64 bytesSent = 0;      //!< response bodies
+  QHash<QString, int> requestsPerEndpoint;  //!< e.g. "GET raw" -> count
+  QHash<QString, int> compressedRequests;   //!< requests with compressed body per endpoint
+  QHash<QString, int> compressedResponses;  //!< compressed responses per endpoint
+};
+
+/**
+ * In-process stand-in for the Mergin server, so that sync can be tested and benchmarked
+ * without TEST_MERGIN_URL pointing to a live instance.
+ *
+ * The server speaks plain HTTP/1.1 on the loopback interface and implements the endpoints
+ * used by MerginApi: ping, login, user info, list projects (paginated and by names),
+ * create/delete project, project info (with "since" history of diffable files), raw download
+ * (with Range and diff) and push start/chunk/finish/cancel. Diffs pushed for GeoPackages
+ * are applied with geodiff, so pulls can use them later.
+ *
+ * Block delta (advertised by "block_delta" in ping) is supported too: blocks of a file
+ * can be listed and a push may upload only blocks that are not in the current file.
+ *
+ * Responses are compressed ("deflate" content coding) when the client accepts it, unless they are
+ * ranges, small or content of already compressed files. Compressed requests are accepted too
+ * (advertised by "request_encodings" in ping). Stats count the bytes as they go over the wire.
+ *
+ * File content is kept on disk in a temporary directory (keyed by checksum) rather than
+ * in memory, so that benchmarks measure memory of the client and not of the server.
+ *
+ * Network conditions can be simulated:
+ *  - latency is added to every response
+ *  - bandwidth is shared by all connections (downloads are shaped, uploads are delayed
+ *    by the time they would take)
+ *  - requests can fail with an HTTP status or a dropped connection, either the next N requests
+ *    matching a pattern or randomly at a given rate
+ *
+ * Authorization tokens are issued by login but not verified.
+ */
+class TestingMerginServer : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit TestingMerginServer( QObject *parent = nullptr );
+    ~TestingMerginServer() override;
+
+    //! Starts listening on a random port of 127.0.0.1
+    bool listen();
+
+    //! Root to be used with MerginApi::setApiRoot()
+    QString apiRoot() const;
+
+    //! Adds a user that is accepted by login
+    void addUser( const QString &username, const QString &password );
+
+    //! Creates an empty project (version 0) directly on the server. Returns false if it exists
+    bool createProject( const QString &projectNamespace, const QString &projectName );
+
+    //! Pushes all files of the directory as a new version of the project directly on the server
+    bool addProjectVersion( const QString &projectNamespace, const QString &projectName, const QString &sourceDir );
+
+    //! Returns the latest version of the project or -1 if it does not exist
+    int projectVersion( const QString &projectNamespace, const QString &projectName ) const;
+
+    //! Returns checksum of the file in the latest version of the project or empty string if there is no such file
+    QString projectFileChecksum( const QString &projectNamespace, const QString &projectName, const QString &filePath ) const;
+
+    //! Forgets all push transactions in progress (like a server where they have expired)
+    void dropTransactions();
+
+    //! Whether the server advertises and accepts block delta transfers (enabled by default)
+    void setBlockDeltaSupported( bool supported );
+
+    //! Whether the server compresses responses and accepts compressed requests (enabled by default)
+    void setCompressionSupported( bool supported );
+
+    //! Delay added to every response (in milliseconds)
+    void setLatency( int latencyMs );
+    int latency() const { return mLatencyMs; }
+
+    //! Bandwidth shared by all connections in bytes per second, 0 means unlimited
+    void setBandwidth( qint64 bytesPerSecond );
+    qint64 bandwidth() const { return mBandwidth; }
+
+    /**
+     * Next \a count requests with path matching \a pathPattern fail with \a httpStatus
+     * (after \a skip matching requests have been served normally).
+     * Status 0 drops the connection instead of sending a response.
+     */
+    void failRequests( const QString &pathPattern, int httpStatus, int count = 1, int skip = 0 );
+
+    //! Each request fails with \a httpStatus with the given probability (0 - 1)
+    void setFailureRate( double rate, int httpStatus = 500 );
+
+    //! Drops all pending failure rules and the failure rate
+    void clearFailures();
+
+    TestingMerginServerStats stats() const { return mStats; }
+    void resetStats();
+
+  private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+    void sendThrottled();
+
+  private:
+
+    struct FileEntry
+    {
+      QString path;
+      QString checksum;
+      qint64 size = 0;
+      QString mtime;
+      QString diffBlob;      //!< checksum of the diff that created this revision (empty for full uploads)
+      qint64 diffSize = 0;
+    };
+
+    struct ProjectVersion
+    {
+      int version = 0;
+      QString created;
+      QMap<QString, FileEntry> files;
+      QMap<QString, FileEntry> changed;  //!< added or updated files in this version
+    };
+
+    struct Project
+    {
+      QString projectNamespace;
+      QString name;
+      QString created;
+      QList<ProjectVersion> versions;  //!< versions[i].version == i
+
+      const ProjectVersion &latest() const { return versions.last(); }
+    };
+
+    struct PushTransaction
+    {
+      QString projectFullName;
+      QJsonObject changes;
+      QString dir;
+    };
+
+    struct Request
+    {
+      QByteArray method;
+      QString path;
+      QUrlQuery query;
+      QHash<QByteArray, QByteArray> headers;  //!< lower case names
+      QByteArray body;
+    };
+
+    struct Response
+    {
+      int status = 200;
+      QByteArray body;
+      QByteArray contentType = "application/json";
+      QList<QPair<QByteArray, QByteArray>> headers;
+      bool dropConnection = false;
+    };
+
+    struct Connection
+    {
+      QPointer<QTcpSocket> socket;
+      QByteArray inBuffer;
+      QByteArray outBuffer;
+      bool busy = false;
+      bool closeAfterWrite = false;
+    };
+
+    struct FailureRule
+    {
+      QRegularExpression pattern;
+      int httpStatus = 500;
+      int remaining = 1;
+      int skip = 0;
+    };
+
+    bool parseRequest( Connection &connection, Request &request );
+    void processRequest( QTcpSocket *socket, const Request &request );
+    void sendResponse( QTcpSocket *socket, const Response &response, bool keepAlive );
+    void writeOut( Connection &connection );
+    void connectionDone( QTcpSocket *socket );
+
+    Response route( const Request &request );
+    Response ping();
+    Response login( const Request &request );
+    Response userInfo( const QString &username );
+    Response listProjects( const Request &request );
+    Response listProjectsByName( const Request &request );
+    Response createProjectRequest( const QString &projectNamespace, const Request &request );
+    Response deleteProjectRequest( const QString &projectFullName );
+    Response projectInfo( const QString &projectFullName, const Request &request );
+    Response rawDownload( const QString &projectFullName, const Request &request );
+    Response blockList( const QString &projectFullName, const Request &request );
+    Response pushStart( const QString &projectFullName, const Request &request );
+    Response pushChunk( const QString &transactionId, const QString &chunkId, const Request &request );
+    Response pushFinish( const QString &transactionId );
+    Response pushCancel( const QString &transactionId );
+
+    static Response error( int status, const QString &detail );
+
+    //! Compresses body of the response if the request accepts it and it pays off, returns whether it did
+    bool compressResponse( const Request &request, Response &response );
+    static QString endpointName( const QByteArray &method, const QString &path );
+
+    //! Stores the file under its checksum, returns the checksum
+    QString storeBlob( const QString &filePath );
+    QString blobPath( const QString &checksum ) const;
+
+    /**
+     * Creates a new version of the project from the changes, returns an error message on failure.
+     * \a content maps paths of added/updated files to files with the uploaded content (the diff for diff uploads,
+     * the missing blocks for block delta uploads)
+     */
+    QString commitVersion( Project &project, const QJsonObject &changes, const QHash<QString, QString> &content );
+
+    QJsonObject projectJson( const Project &project, int sinceVersion = -1 ) const;
+    QJsonObject projectListEntry( const Project &project ) const;
+
+    QTcpServer *mServer = nullptr;
+    QTemporaryDir mStorage;
+    QHash<QTcpSocket *, Connection> mConnections;
+    QTimer *mThrottleTimer = nullptr;
+    qint64 mLastThrottleMs = 0;
+
+    QHash<QString, QString> mUsers;  //!< username -> password
+    QHash<QByteArray, QString> mTokens;  //!< auth token -> username
+    QMap<QString, Project> mProjects;  //!< full name -> project
+    QHash<QString, PushTransaction> mTransactions;  //!< transaction id -> transaction
+
+    bool mBlockDeltaSupported = true;
+    bool mCompressionSupported = true;
+    int mLatencyMs = 0;
+    qint64 mBandwidth = 0;
+    QList<FailureRule> mFailureRules;
+    double mFailureRate = 0;
+    int mFailureRateStatus = 500;
+
+    TestingMerginServerStats mStats;
+};
+
+#endif // TESTINGMERGINSERVER_H
@@ -0,0 +1,163 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "testmaptiles.h"
+
+#include <QDir>
+#include <QImage>
+#include <QTemporaryDir>
+
+#include "qgsquickmapdiskcache.h"
+#include "qgsquickmaptiles.h"
+
+static QgsQuickMapTiles::Range range( qint64 zoom, int firstColumn, int lastColumn, int firstRow, int lastRow )
+{
+  QgsQuickMapTiles::Range r;
+  r.zoom = zoom;
+  r.firstColumn = firstColumn;
+  r.lastColumn = lastColumn;
+  r.firstRow = firstRow;
+  r.lastRow = lastRow;
+  return r;
+}
+
+static QImage rangeImage( const QgsQuickMapTiles::Range &r )
+{
+  QImage image( r.columnCount() * QgsQuickMapTiles::TILE_SIZE, r.rowCount() * QgsQuickMapTiles::TILE_SIZE, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::white );
+  return image;
+}
+
+void TestMapTiles::testGrid()
+{
+  // resolution of a zoom level maps back to the same zoom level
+  const qint64 zoom = QgsQuickMapTiles::zoomLevel( 0.37 );
+  QCOMPARE( QgsQuickMapTiles::zoomLevel( QgsQuickMapTiles::resolution( zoom ) ), zoom );
+
+  // tiles of the zoom level are at most one step finer than the requested resolution, never coarser
+  QVERIFY( QgsQuickMapTiles::resolution( zoom ) <= 0.37 );
+  QVERIFY( QgsQuickMapTiles::resolution( zoom + 1 ) > 0.37 );
+
+  // small zoom steps (like those of a pinch) stay on the same grid
+  QCOMPARE( QgsQuickMapTiles::zoomLevel( 0.37 * 1.01 ), zoom );
+  QCOMPARE( QgsQuickMapTiles::zoomLevel( 0.37 * 0.99 ), zoom );
+
+  // one map unit per pixel, tiles have 256 map units
+  QCOMPARE( QgsQuickMapTiles::zoomLevel( 1 ), qint64( 0 ) );
+  QgsQuickMapTiles::Range r = QgsQuickMapTiles::tilesInExtent( 0, QgsRectangle( 10, -300, 600, 100 ) );
+  QCOMPARE( r.firstColumn, 0 );
+  QCOMPARE( r.lastColumn, 2 );
+  QCOMPARE( r.firstRow, -1 );
+  QCOMPARE( r.lastRow, 1 );
+
+  QCOMPARE( QgsQuickMapTiles::extent( r ), QgsRectangle( 0, -512, 768, 256 ) );
+
+  QgsQuickMapTiles::Key key;
+  key.zoom = 0;
+  key.column = -1;
+  key.row = 2;
+  QCOMPARE( QgsQuickMapTiles::extent( key ), QgsRectangle( -256, -768, 0, -512 ) );
+}
+
+void TestMapTiles::testMissingTiles()
+{
+  QgsQuickMapTiles tiles;
+  const QgsQuickMapTiles::Range view = range( 0, 0, 3, 0, 2 );
+
+  // nothing rendered yet, the whole view is rendered at once
+  QList<QgsQuickMapTiles::Range> missing = tiles.missing( view );
+  QCOMPARE( missing.size(), 1 );
+  QCOMPARE( missing.at( 0 ).columnCount(), 4 );
+  QCOMPARE( missing.at( 0 ).rowCount(), 3 );
+
+  tiles.insert( view, rangeImage( view ) );
+  QCOMPARE( tiles.count(), 12 );
+  QVERIFY( tiles.isComplete( view ) );
+  QCOMPARE( tiles.tile( QgsQuickMapTiles::Key() ).size(), QSize( QgsQuickMapTiles::TILE_SIZE, QgsQuickMapTiles::TILE_SIZE ) );
+
+  // pan by one tile right and down exposes a column and a row
+  const QgsQuickMapTiles::Range panned = range( 0, 1, 4, 1, 3 );
+  missing = tiles.missing( panned );
+  QCOMPARE( missing.size(), 2 );
+  int missingTiles = 0;
+  for ( const QgsQuickMapTiles::Range &block : missing )
+    missingTiles += block.columnCount() * block.rowCount();
+  QCOMPARE( missingTiles, 6 );
+
+  // tiles of a running job are not requested again
+  QVERIFY( tiles.missing( panned, range( 0, 1, 4, 3, 3 ) ).size() == 1 );
+
+  // other zoom level has nothing rendered
+  QCOMPARE( tiles.missing( range( 1, 0, 3, 0, 2 ) ).size(), 1 );
+}
+
+void TestMapTiles::testInvalidateAndTrim()
+{
+  QgsQuickMapTiles tiles;
+  const QgsQuickMapTiles::Range view = range( 0, 0, 3, 0, 2 );
+  tiles.insert( view, rangeImage( view ) );
+  tiles.insert( range( 0, 10, 11, 0, 0 ), rangeImage( range( 0, 10, 11, 0, 0 ) ) );
+  tiles.insert( range( 5, 0, 0, 0, 0 ), rangeImage( range( 5, 0, 0, 0, 0 ) ) );
+  QCOMPARE( tiles.count(), 15 );
+
+  // invalidated tiles are kept for drawing, but need rendering again
+  tiles.invalidate();
+  QVERIFY( !tiles.isComplete( view ) );
+  QCOMPARE( tiles.tiles( view ).size(), 12 );
+  QVERIFY( !tiles.tile( QgsQuickMapTiles::Key() ).isNull() );
+
+  // tiles in view are kept, the other zoom level goes first
+  tiles.trim( 13, view );
+  QCOMPARE( tiles.count(), 13 );
+  QCOMPARE( tiles.zoomLevels(), QSet<qint64>() << 0 );
+  QCOMPARE( tiles.tiles( view ).size(), 12 );
+
+  tiles.trim( 12, view );
+  QCOMPARE( tiles.tiles( view ).size(), 12 );
+  QCOMPARE( tiles.count(), 12 );
+}
+
+void TestMapTiles::testDiskCache()
+{
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+
+  const QgsQuickMapTiles::Range view = range( 3, -1, 1, 0, 1 );
+  QImage image = rangeImage( view );
+  image.setPixel( QgsQuickMapTiles::TILE_SIZE + 1, 1, qRgb( 255, 0, 0 ) );
+  QgsQuickMapDiskCache::saveTiles( dir.path(), "layer/aaaa", view, image );
+
+  QgsQuickMapTiles::Key key;
+  key.zoom = 3;
+  key.column = -1;
+  QVERIFY( QFile::exists( QgsQuickMapDiskCache::tilePath( dir.path(), "layer/aaaa", key ) ) );
+
+  QHash<QString, QString> layerKeys;
+  layerKeys.insert( "layer", "layer/aaaa" );
+  layerKeys.insert( "other", "other/bbbb" );
+
+  // the same range is joined back to the same image, layers without tiles get none
+  QHash<QString, QImage> images = QgsQuickMapDiskCache::loadTiles( dir.path(), layerKeys, view );
+  QCOMPARE( images.size(), 1 );
+  QCOMPARE( images.value( "layer" ).size(), image.size() );
+  QCOMPARE( images.value( "layer" ).pixel( QgsQuickMapTiles::TILE_SIZE + 1, 1 ), qRgb( 255, 0, 0 ) );
+
+  // sub-range is loaded as well, range with a missing tile is not
+  QCOMPARE( QgsQuickMapDiskCache::loadTiles( dir.path(), layerKeys, range( 3, 0, 0, 0, 0 ) ).value( "layer" ).pixel( 1, 1 ), qRgb( 255, 0, 0 ) );
+  QVERIFY( QgsQuickMapDiskCache::loadTiles( dir.path(), layerKeys, range( 3, 0, 2, 0, 0 ) ).isEmpty() );
+
+  // new layer hash replaces tiles of the old one
+  QgsQuickMapDiskCache::saveTiles( dir.path(), "layer/cccc", view, image );
+  QgsQuickMapDiskCache::removeOutdatedTiles( dir.path(), "layer/cccc" );
+  QVERIFY( QgsQuickMapDiskCache::loadTiles( dir.path(), layerKeys, view ).isEmpty() );
+  QCOMPARE( QDir( dir.path() + "/layer" ).entryList( QDir::Dirs | QDir::NoDotAndDotDot ), QStringList() << "cccc" );
+
+  QgsQuickMapDiskCache::trim( dir.path(), 0 );
+  QVERIFY( QDir( dir.path() + "/layer/cccc/3" ).entryList( QDir::Files ).isEmpty() );
+}
@@ -0,0 +1,28 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QObject>
+#include <QtTest>
+
+#ifndef TESTMAPTILES_H
+#define TESTMAPTILES_H
+
+class TestMapTiles: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void testGrid(); // zoom levels and tile extents
+    void testMissingTiles(); // grouping of tiles to render after pan
+    void testInvalidateAndTrim();
+    void testDiskCache(); // tiles written and read back, outdated layer hashes removed
+};
+
+#endif // TESTMAPTILES_H
@@ -1,5 +1,10 @@
 #include <QtTest/QtTest>
 #include <QtCore/QObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <geodiff.h>
 
 #define STR1(x)  #x
 #define STR(x)  STR1(x)
@@ -11,6 +16,11 @@
 #include "testutils.h"
 #include "merginuserauth.h"
 #include "merginuserinfo.h"
+#include "projectchecksumcache.h"
+#include "projectfilesscanner.h"
+#include "uploadchunkdevice.h"
+#include "changesetsummaryservice.h"
+#include "merginprojectstatusmodel.h"
 
 const QString TestMerginApi::TEST_PROJECT_NAME = "TEMPORARY_TEST_PROJECT";
 const QString TestMerginApi::TEST_EMPTY_FILE_NAME = "test_empty_file.md";
@@ -94,6 +104,7 @@ void TestMerginApi::initTestCase()
   deleteRemoteProject( mApiExtra, mUsername, "testCreateProjectTwice" );
   deleteRemoteProject( mApiExtra, mUsername, "testCreateDeleteProject" );
   deleteRemoteProject( mApiExtra, mUsername, "testMultiChunkUploadDownload" );
+  deleteRemoteProject( mApiExtra, mUsername, "testParallelDownload" );
   deleteRemoteProject( mApiExtra, mUsername, "testEmptyFileUploadDownload" );
   deleteRemoteProject( mApiExtra, mUsername, "testUploadWithUpdate" );
   deleteRemoteProject( mApiExtra, mUsername, "testDiffUpload" );
@@ -115,6 +126,7 @@ void TestMerginApi::initTestCase()
   deleteRemoteProject( mApiExtra, mUsername, "testSelectiveSyncCorruptedFormat" );
 
   deleteLocalDir( mApi, "testExcludeFromSync" );
+  deleteLocalDir( mApi, "testChecksumCache" );
 }
 
 void TestMerginApi::cleanupTestCase()
@@ -551,6 +563,106 @@ void TestMerginApi::testMultiChunkUploadDownload()
   QCOMPARE( checksum, checksum2 );
 }
 
+void TestMerginApi::testParallelDownload()
+{
+  // pull a project with several multi-chunk files while many requests are in flight
+  // and make sure all chunks get assembled in the right order
+
+  QString projectName = "testParallelDownload";
+
+  createRemoteProject( mApiExtra, mUsername, projectName, mTestDataPath + "/" + TEST_PROJECT_NAME + "/" );
+  downloadRemoteProject( mApi, mUsername, projectName );
+
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  QHash<QString, QByteArray> checksums;
+  for ( int f = 0; f < 3; ++f )
+  {
+    QString filePath = projectDir + "/" + QStringLiteral( "big_file_%1.dat" ).arg( f );
+    QFile bigFile( filePath );
+    QVERIFY( bigFile.open( QIODevice::WriteOnly ) );
+    for ( int i = 0; i < 15; ++i )   // 15 times 1mb -> two chunks per file
+      bigFile.write( QByteArray( 1024 * 1024, static_cast<char>( 'A' + f + i ) ) );
+    bigFile.close();
+    checksums[filePath] = MerginApi::getChecksum( filePath );
+  }
+
+  uploadRemoteProject( mApi, mUsername, projectName );
+  deleteLocalProject( mApi, mUsername, projectName );
+
+  int originalMaxParallelDownloads = mApi->maxParallelDownloads();
+  mApi->setMaxParallelDownloads( 0 );
+  QCOMPARE( mApi->maxParallelDownloads(), 1 );
+  mApi->setMaxParallelDownloads( 8 );
+  QCOMPARE( mApi->maxParallelDownloads(), 8 );
+
+  downloadRemoteProject( mApi, mUsername, projectName );
+  mApi->setMaxParallelDownloads( originalMaxParallelDownloads );
+
+  for ( auto it = checksums.constBegin(); it != checksums.constEnd(); ++it )
+  {
+    QVERIFY( QFileInfo::exists( it.key() ) );
+    QCOMPARE( MerginApi::getChecksum( it.key() ), it.value() );
+  }
+
+  // nothing should be left in the temp folder
+  QVERIFY( !QDir( mApi->getTempProjectDir( MerginApi::getFullProjectName( mUsername, projectName ) ) ).exists() );
+}
+
+void TestMerginApi::testParallelUpload()
+{
+  // push several multi-chunk files while many chunk requests are in flight
+  // and make sure the server assembles all chunks in the right order
+
+  QString projectName = "testParallelUpload";
+
+  createRemoteProject( mApiExtra, mUsername, projectName, mTestDataPath + "/" + TEST_PROJECT_NAME + "/" );
+  downloadRemoteProject( mApi, mUsername, projectName );
+
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  QHash<QString, QByteArray> checksums;
+  for ( int f = 0; f < 3; ++f )
+  {
+    QString filePath = projectDir + "/" + QStringLiteral( "big_file_%1.dat" ).arg( f );
+    QFile bigFile( filePath );
+    QVERIFY( bigFile.open( QIODevice::WriteOnly ) );
+    for ( int i = 0; i < 25; ++i )   // 25 times 1mb -> three chunks per file, the last one partial
+      bigFile.write( QByteArray( 1024 * 1024, static_cast<char>( 'a' + f + i ) ) );
+    bigFile.close();
+    checksums[filePath] = MerginApi::getChecksum( filePath );
+  }
+
+  // each chunk is streamed from its own range of the file
+  UploadChunkDevice device( projectDir + "/big_file_0.dat", 20 * 1024 * 1024 + 10, 100 );
+  QVERIFY( device.open( QIODevice::ReadOnly ) );
+  QCOMPARE( device.size(), qint64( 100 ) );
+  QCOMPARE( device.readAll(), QByteArray( 100, static_cast<char>( 'a' + 20 ) ) );
+  QVERIFY( device.atEnd() );
+  QVERIFY( device.seek( 50 ) );
+  QCOMPARE( device.readAll().size(), 50 );
+
+  int originalMaxParallelUploads = mApi->maxParallelUploads();
+  mApi->setMaxParallelUploads( 0 );
+  QCOMPARE( mApi->maxParallelUploads(), 1 );
+  mApi->setMaxParallelUploads( 6 );
+  QCOMPARE( mApi->maxParallelUploads(), 6 );
+
+  uploadRemoteProject( mApi, mUsername, projectName );
+  mApi->setMaxParallelUploads( originalMaxParallelUploads );
+
+  // nothing should be left in flight
+  QCOMPARE( mApi->transactions().count(), 0 );
+
+  // download again and compare
+  deleteLocalProject( mApi, mUsername, projectName );
+  downloadRemoteProject( mApi, mUsername, projectName );
+
+  for ( auto it = checksums.constBegin(); it != checksums.constEnd(); ++it )
+  {
+    QVERIFY( QFileInfo::exists( it.key() ) );
+    QCOMPARE( MerginApi::getChecksum( it.key() ), it.value() );
+  }
+}
+
 void TestMerginApi::testEmptyFileUploadDownload()
 {
   // test will try to upload a project with empty file
@@ -1087,6 +1199,13 @@ void TestMerginApi::testDiffUpload()
   GeodiffUtils::ChangesetSummary summary = GeodiffUtils::parseChangesetSummary( changes );
   QCOMPARE( summary, expectedSummary );
 
+  // the summary has been cached by localProjectChanges() - it must be the same
+  QVERIFY( QFileInfo::exists( ChangesetSummaryService::cacheFilePath( projectDir ) ) );
+  MerginProjectMetadata metadata = MerginProjectMetadata::fromCachedJson( projectDir + "/" + MerginApi::sMetadataFile );
+  QByteArray localChecksum = MerginApi::getChecksum( projectDir + "/base.gpkg" );
+  QString cachedChanges = ChangesetSummaryService::summaryJson( projectDir, "base.gpkg", metadata.fileInfo( "base.gpkg" ).checksum, QString::fromLatin1( localChecksum ) );
+  QCOMPARE( GeodiffUtils::parseChangesetSummary( cachedChanges ), expectedSummary );
+
   uploadRemoteProject( mApi, mUsername, projectName );
 
   QCOMPARE( MerginApi::localProjectChanges( projectDir ), ProjectDiff() );  // no local changes expected
@@ -1315,6 +1434,51 @@ void TestMerginApi::testDiffUpdateWithRebaseFailed()
   QCOMPARE( MerginApi::localProjectChanges( projectDir ), expectedDiffFinal );
 }
 
+void TestMerginApi::testDiffUpdateConcatFailed()
+{
+  // changesets that cannot be concatenated (here because the second one is damaged) are applied one by one.
+  // A failure in the middle must not leave the basefile or the local file half-updated
+
+  QString projectName = "testDiffUpdateConcatFailed";
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  QString tempDir = projectDir + "/.temp";
+  QVERIFY( QDir().mkpath( projectDir + "/.mergin" ) );
+  QVERIFY( QDir().mkpath( tempDir ) );
+
+  QString baseSource = mTestDataPath + "/diff_project/base.gpkg";
+  QVERIFY( QFile::copy( baseSource, projectDir + "/base.gpkg" ) );
+  QVERIFY( QFile::copy( baseSource, projectDir + "/.mergin/base.gpkg" ) );
+  QByteArray baseChecksum = MerginApi::getChecksum( baseSource );
+
+  QString addedRowDiff = tempDir + "/diff-1";
+  int res = GEODIFF_createChangeset( baseSource.toUtf8().constData(),
+                                     QString( mTestDataPath + "/added_row.gpkg" ).toUtf8().constData(),
+                                     addedRowDiff.toUtf8().constData() );
+  QCOMPARE( res, GEODIFF_SUCCESS );
+  writeFileContent( tempDir + "/diff-2", QByteArray( "not a changeset" ) );
+
+  QList<DownloadQueueItem> items;
+  for ( int version = 1; version <= 2; ++version )
+  {
+    DownloadQueueItem item( "base.gpkg", 0, version, -1, -1, true );
+    item.tempFileName = QStringLiteral( "diff-%1" ).arg( version );
+    items << item;
+  }
+
+  mApi->finalizeProjectUpdateApplyDiff( projectName, projectDir, tempDir, "base.gpkg", items, false );
+
+  // the first changeset must not have been applied (let alone twice)
+  QCOMPARE( MerginApi::getChecksum( projectDir + "/.mergin/base.gpkg" ), baseChecksum );
+  QCOMPARE( MerginApi::getChecksum( projectDir + "/base.gpkg" ), baseChecksum );
+
+  QgsVectorLayer *vl = new QgsVectorLayer( projectDir + "/base.gpkg|layername=simple", "base", "ogr" );
+  QVERIFY( vl->isValid() );
+  QCOMPARE( vl->featureCount(), static_cast<long>( 3 ) );
+  delete vl;
+
+  deleteLocalDir( mApi, projectName );
+}
+
 void TestMerginApi::testUpdateWithDiffs()
 {
   // a test case where we download initial version (v1), then there will be
@@ -2309,6 +2473,149 @@ void TestMerginApi::testExcludeFromSync()
   QVERIFY( mApi->excludeFromSync( selectiveSyncDir + "/image.jpg", config ) );
 }
 
+void TestMerginApi::testChecksumCache()
+{
+  QString projectDir = mApi->projectsPath() + "/testChecksumCache";
+  QVERIFY( QDir().mkpath( projectDir + "/.mergin" ) );
+
+  QString filePath = projectDir + "/data.txt";
+  writeFileContent( filePath, QByteArray( "AAAA" ) );
+
+  // pretend the file has been written a while ago, otherwise it would not be cached
+  QFile f( filePath );
+  QVERIFY( f.open( QIODevice::ReadWrite ) );
+  QVERIFY( f.setFileTime( QDateTime::currentDateTime().addSecs( -60 ), QFileDevice::FileModificationTime ) );
+  f.close();
+
+  QList<MerginFile> files = MerginApi::getLocalProjectFiles( projectDir + "/" );
+  QCOMPARE( files.count(), 1 );
+  QCOMPARE( files.first().checksum, QString::fromLatin1( MerginApi::getChecksum( filePath ) ) );
+  QVERIFY( QFileInfo::exists( ProjectChecksumCache::cacheFilePath( projectDir ) ) );
+
+  // cached checksum is used as long as size and modification time match
+  ProjectChecksumCache cache( projectDir );
+  QCOMPARE( cache.checksum( "data.txt", QFileInfo( filePath ) ), files.first().checksum );
+
+  // same size, different content and modification time -> must be hashed again
+  writeFileContent( filePath, QByteArray( "BBBB" ) );
+  QVERIFY( cache.checksum( "data.txt", QFileInfo( filePath ) ).isEmpty() );
+  files = MerginApi::getLocalProjectFiles( projectDir + "/" );
+  QCOMPARE( files.first().checksum, QString::fromLatin1( MerginApi::getChecksum( filePath ) ) );
+
+  // entries of removed files are dropped
+  QFile::remove( filePath );
+  files = MerginApi::getLocalProjectFiles( projectDir + "/" );
+  QVERIFY( files.isEmpty() );
+  ProjectChecksumCache cacheAfterRemoval( projectDir );
+  QVERIFY( cacheAfterRemoval.checksum( "data.txt", QFileInfo( filePath ) ).isEmpty() );
+}
+
+void TestMerginApi::testProjectFilesScanner()
+{
+  QString projectName = "testProjectFilesScanner";
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  QVERIFY( QDir().mkpath( projectDir + "/.mergin" ) );
+  QVERIFY( QDir().mkpath( projectDir + "/data" ) );
+
+  for ( int i = 0; i < 20; ++i )
+    writeFileContent( QStringLiteral( "%1/data/file_%2.txt" ).arg( projectDir ).arg( i ), QByteArray::number( i ).repeated( 1000 ) );
+
+  ProjectFilesScanner scanner( projectDir + "/" );
+  QList<MerginFile> files;
+  int finishedCount = 0;
+  connect( &scanner, &ProjectFilesScanner::finished, this, [&files, &finishedCount]( const QList<MerginFile> &result )
+  {
+    files = result;
+    ++finishedCount;
+  } );
+
+  // files are listed and hashed on worker threads
+  scanner.start();
+  QTRY_COMPARE_WITH_TIMEOUT( finishedCount, 1, TestUtils::LONG_REPLY );
+  QCOMPARE( files.count(), 20 );
+  for ( const MerginFile &file : qAsConst( files ) )
+    QCOMPARE( file.checksum, QString::fromLatin1( MerginApi::getChecksum( projectDir + "/" + file.path ) ) );
+
+  // a canceled scan does not report anything
+  writeFileContent( projectDir + "/data/file_0.txt", QByteArray( "changed" ) );
+  scanner.start();
+  scanner.cancel();
+  QTRY_VERIFY_WITH_TIMEOUT( !scanner.isRunning(), TestUtils::LONG_REPLY );
+  QTest::qWait( 100 );  // let the watchers deliver their finished() signals
+  QCOMPARE( finishedCount, 1 );
+
+  // the scanner can be started again after a cancel
+  scanner.start();
+  QTRY_COMPARE_WITH_TIMEOUT( finishedCount, 2, TestUtils::LONG_REPLY );
+  QCOMPARE( files.count(), 20 );
+  for ( const MerginFile &file : qAsConst( files ) )
+    QCOMPARE( file.checksum, QString::fromLatin1( MerginApi::getChecksum( projectDir + "/" + file.path ) ) );
+
+  deleteLocalDir( mApi, projectName );
+}
+
+void TestMerginApi::testProjectStatusModel()
+{
+  QString projectName = "testProjectStatusModel";
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  QVERIFY( QDir().mkpath( projectDir + "/.mergin" ) );
+  QVERIFY( QFile::copy( mTestDataPath + "/diff_project/base.gpkg", projectDir + "/base.gpkg" ) );
+  QVERIFY( QFile::copy( mTestDataPath + "/diff_project/base.gpkg", projectDir + "/.mergin/base.gpkg" ) );
+  writeFileContent( projectDir + "/notes.txt", QByteArray( "notes" ) );
+
+  // the last synced version has the same content, but a different checksum of the GeoPackage
+  QJsonObject gpkgObject;
+  gpkgObject.insert( QStringLiteral( "path" ), QStringLiteral( "base.gpkg" ) );
+  gpkgObject.insert( QStringLiteral( "checksum" ), QStringLiteral( "0000000000000000000000000000000000000000" ) );
+  gpkgObject.insert( QStringLiteral( "size" ), QFileInfo( projectDir + "/base.gpkg" ).size() );
+  QJsonObject notesObject;
+  notesObject.insert( QStringLiteral( "path" ), QStringLiteral( "notes.txt" ) );
+  notesObject.insert( QStringLiteral( "checksum" ), QString::fromLatin1( MerginApi::getChecksum( projectDir + "/notes.txt" ) ) );
+  notesObject.insert( QStringLiteral( "size" ), 5 );
+  QJsonObject metadata;
+  metadata.insert( QStringLiteral( "name" ), projectName );
+  metadata.insert( QStringLiteral( "namespace" ), mUsername );
+  metadata.insert( QStringLiteral( "version" ), QStringLiteral( "v1" ) );
+  metadata.insert( QStringLiteral( "files" ), QJsonArray() << gpkgObject << notesObject );
+  writeFileContent( projectDir + "/" + MerginApi::sMetadataFile, QJsonDocument( metadata ).toJson() );
+  mApi->localProjectsManager().addMerginProject( projectDir, mUsername, projectName );
+
+  MerginProjectStatusModel model( mApi->localProjectsManager() );
+  QList<bool> loaded;
+  connect( &model, &MerginProjectStatusModel::projectInfoLoaded, this, [&loaded]( bool hasLocalChanges )
+  {
+    loaded << hasLocalChanges;
+  } );
+
+  // files are scanned in the background, the GeoPackage without real changes is not listed once its summary is known
+  model.loadProjectInfo( MerginApi::getFullProjectName( mUsername, projectName ) );
+  QCOMPARE( loaded.count(), 0 );
+  QTRY_COMPARE_WITH_TIMEOUT( loaded.count(), 1, TestUtils::LONG_REPLY );
+  QCOMPARE( loaded.last(), false );
+  QCOMPARE( model.rowCount( QModelIndex() ), 0 );
+
+  // other changes are known right after the scan, the row of the GeoPackage gets removed later
+  writeFileContent( projectDir + "/notes.txt", QByteArray( "changed notes" ) );
+  model.loadProjectInfo( MerginApi::getFullProjectName( mUsername, projectName ) );
+  QTRY_COMPARE_WITH_TIMEOUT( loaded.count(), 2, TestUtils::LONG_REPLY );
+  QCOMPARE( loaded.last(), true );
+  QTRY_COMPARE_WITH_TIMEOUT( model.rowCount( QModelIndex() ), 1, TestUtils::LONG_REPLY );
+  QCOMPARE( model.data( model.index( 0 ), MerginProjectStatusModel::Text ).toString(), QStringLiteral( "notes.txt" ) );
+
+  // a modified GeoPackage is listed with the summary of its tables
+  writeFileContent( projectDir + "/notes.txt", QByteArray( "notes" ) );
+  QVERIFY( QFile::remove( projectDir + "/base.gpkg" ) );
+  QVERIFY( QFile::copy( mTestDataPath + "/modified_1_geom.gpkg", projectDir + "/base.gpkg" ) );
+  model.loadProjectInfo( MerginApi::getFullProjectName( mUsername, projectName ) );
+  QTRY_COMPARE_WITH_TIMEOUT( loaded.count(), 3, TestUtils::LONG_REPLY );
+  QCOMPARE( loaded.last(), true );
+  QCOMPARE( model.rowCount( QModelIndex() ), 3 );  // the file and its two tables
+  QCOMPARE( model.data( model.index( 0 ), MerginProjectStatusModel::Status ).toInt(), static_cast<int>( MerginProjectStatusModel::Updated ) );
+
+  deleteLocalProject( mApi, mUsername, projectName );
+  deleteLocalDir( mApi, projectName );
+}
+
 //////// HELPER FUNCTIONS ////////
 
 MerginProjectsList TestMerginApi::getProjectList( QString tag )
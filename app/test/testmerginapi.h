@@ -45,6 +45,8 @@ class TestMerginApi: public QObject
     void testCreateDeleteProject();
     void testUploadProject();
     void testMultiChunkUploadDownload();
+    void testParallelDownload();
+    void testParallelUpload();
     void testEmptyFileUploadDownload();
     void testPushAddedFile();
     void testPushRemovedFile();
@@ -61,6 +63,7 @@ class TestMerginApi: public QObject
     void testDiffUpdateBasic();
     void testDiffUpdateWithRebase();
     void testDiffUpdateWithRebaseFailed();
+    void testDiffUpdateConcatFailed();
     void testUpdateWithDiffs();
     void testUpdateWithMissedVersion();
     void testMigrateProject();
@@ -78,6 +81,9 @@ class TestMerginApi: public QObject
 
     // mergin functions
     void testExcludeFromSync();
+    void testChecksumCache();
+    void testProjectFilesScanner();
+    void testProjectStatusModel();
 
   private:
     MerginApi *mApi;
@@ -0,0 +1,111 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "testsnappingkit.h"
+
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+
+#include "qgsquickmapcanvasmap.h"
+#include "snappingkit.h"
+#include "digitizingcontroller.h"
+
+static QgsVectorLayer *lineLayer()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "LineString?crs=epsg:3857" ), QStringLiteral( "lines" ), QStringLiteral( "memory" ) );
+  QgsFeature f( layer->fields() );
+  f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString(0 0, 10 0)" ) ) );
+  layer->dataProvider()->addFeatures( QgsFeatureList() << f );
+  return layer;
+}
+
+static void setupMap( QgsQuickMapSettings *ms, QgsVectorLayer *layer )
+{
+  // 0.1 map units per pixel, 3 mm are ~1.13 map units
+  ms->setDestinationCrs( layer->crs() );
+  ms->setExtent( QgsRectangle( 0, 0, 100, 50 ) );
+  ms->setOutputSize( QSize( 1000, 500 ) );
+  ms->setOutputDpi( 96 );
+  ms->setLayers( QList<QgsMapLayer *>() << layer );
+}
+
+void TestSnappingKit::snapToVertexAndSegment()
+{
+  QgsQuickMapCanvasMap canvas;
+  QgsVectorLayer *layer = lineLayer();
+  QVERIFY( layer->isValid() );
+  setupMap( canvas.mapSettings(), layer );
+
+  SnappingKit kit;
+  kit.setToleranceMm( 3 );
+  kit.setMapSettings( canvas.mapSettings() );
+  QTRY_VERIFY( kit.isReady() );
+
+  QCOMPARE( kit.snapPoint( QgsPoint( 0.5, 0.3 ) ), QgsPoint( 0, 0 ) );
+  QCOMPARE( kit.snapPoint( QgsPoint( 5, 0.5 ) ), QgsPoint( 5, 0 ) );
+
+  // vertex wins over a closer segment
+  QCOMPARE( kit.snapPoint( QgsPoint( 9.4, 0.2 ) ), QgsPoint( 10, 0 ) );
+
+  // too far
+  QCOMPARE( kit.snapPoint( QgsPoint( 50, 40 ) ), QgsPoint( 50, 40 ) );
+
+  // Z is kept
+  QCOMPARE( kit.snapPoint( QgsPoint( 5, 0.5, 7 ) ), QgsPoint( 5, 0, 7 ) );
+
+  kit.setEnabled( false );
+  QCOMPARE( kit.snapPoint( QgsPoint( 5, 0.5 ) ), QgsPoint( 5, 0.5 ) );
+}
+
+void TestSnappingKit::snapAfterEdit()
+{
+  QgsQuickMapCanvasMap canvas;
+  QgsVectorLayer *layer = lineLayer();
+  setupMap( canvas.mapSettings(), layer );
+
+  SnappingKit kit;
+  kit.setMapSettings( canvas.mapSettings() );
+  QTRY_VERIFY( kit.isReady() );
+
+  QCOMPARE( kit.snapPoint( QgsPoint( 30.5, 30 ) ), QgsPoint( 30.5, 30 ) );
+
+  layer->startEditing();
+  QgsFeature f( layer->fields() );
+  f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString(30 30, 40 30)" ) ) );
+  layer->addFeature( f );
+
+  QTRY_VERIFY( kit.isReady() );
+  QCOMPARE( kit.snapPoint( QgsPoint( 30.5, 30.2 ) ), QgsPoint( 30, 30 ) );
+
+  layer->rollBack();
+  QTRY_VERIFY( kit.isReady() );
+  QCOMPARE( kit.snapPoint( QgsPoint( 30.5, 30.2 ) ), QgsPoint( 30.5, 30.2 ) );
+}
+
+void TestSnappingKit::digitizingWithSnapping()
+{
+  QgsQuickMapCanvasMap canvas;
+  QgsVectorLayer *layer = lineLayer();
+  setupMap( canvas.mapSettings(), layer );
+
+  SnappingKit kit;
+  kit.setMapSettings( canvas.mapSettings() );
+  QTRY_VERIFY( kit.isReady() );
+
+  DigitizingController controller;
+  controller.setLayer( layer );
+  controller.setProperty( "mapSettings", QVariant::fromValue( canvas.mapSettings() ) );
+
+  std::unique_ptr<QgsPoint> point = controller.getLayerPoint( QgsPoint( 5, 0.5 ), false );
+  QCOMPARE( *point, QgsPoint( 5, 0.5 ) );
+
+  controller.setProperty( "snappingKit", QVariant::fromValue( &kit ) );
+  point = controller.getLayerPoint( QgsPoint( 5, 0.5 ), false );
+  QCOMPARE( *point, QgsPoint( 5, 0 ) );
+}
@@ -0,0 +1,27 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QObject>
+#include <QtTest>
+
+#ifndef TESTSNAPPINGKIT_H
+#define TESTSNAPPINGKIT_H
+
+class TestSnappingKit: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void snapToVertexAndSegment();
+    void snapAfterEdit(); // index is updated with edits of the layer
+    void digitizingWithSnapping(); // recorded points are snapped, GPS points are not
+};
+
+#endif // TESTSNAPPINGKIT_H
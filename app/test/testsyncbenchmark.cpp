@@ -0,0 +1,699 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "testsyncbenchmark.h"
+
+#include <QtTest/QtTest>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QTimer>
+
+#include "blockindex.h"
+#include "contentstore.h"
+#include "coreutils.h"
+#include "merginuserauth.h"
+#include "testingmerginserver.h"
+#include "testutils.h"
+#include "transactionjournal.h"
+
+static const QString BENCH_USER = QStringLiteral( "bench" );
+static const QString BENCH_PASSWORD = QStringLiteral( "benchPassword1" );
+
+//! Resident memory of the process in bytes or -1 if not available on the platform
+static qint64 _residentMemory()
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+  QFile f( QStringLiteral( "/proc/self/status" ) );
+  if ( f.open( QIODevice::ReadOnly | QIODevice::Text ) )
+  {
+    while ( !f.atEnd() )
+    {
+      QByteArray line = f.readLine();
+      if ( line.startsWith( "VmRSS:" ) )
+        return line.mid( 6 ).trimmed().split( ' ' ).first().toLongLong() * 1024;
+    }
+  }
+#endif
+  return -1;
+}
+
+static QString _fileChecksum( const QString &filePath )
+{
+  QFile f( filePath );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return QString();
+
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  hash.addData( &f );
+  return QString::fromLatin1( hash.result().toHex() );
+}
+
+static int _envInt( const char *name, int defaultValue )
+{
+  QByteArray value = qgetenv( name );
+  return value.isEmpty() ? defaultValue : value.toInt();
+}
+
+
+void TestSyncBenchmark::initTestCase()
+{
+  mServer.reset( new TestingMerginServer );
+  QVERIFY( mServer->listen() );
+  mServer->addUser( BENCH_USER, BENCH_PASSWORD );
+
+  QVERIFY( mDataDir.isValid() );
+  QVERIFY( mSourceDir.isValid() );
+
+  mLocalProjects.reset( new LocalProjectsManager( mDataDir.path() + "/" ) );
+  mApi.reset( new MerginApi( *mLocalProjects ) );
+  mApi->setApiRoot( mServer->apiRoot() );
+  // the synthetic projects share content, the benchmarks must download all of it
+  mApi->setContentStoreMaxSize( 0 );
+  QTRY_COMPARE_WITH_TIMEOUT( mApi->apiVersionStatus(), MerginApiStatus::OK, TestUtils::SHORT_REPLY );
+
+  QSignalSpy spy( mApi.get(), &MerginApi::authChanged );
+  mApi->authorize( BENCH_USER, BENCH_PASSWORD );
+  QVERIFY( spy.wait( TestUtils::SHORT_REPLY ) );
+  QVERIFY( mApi->userAuth()->hasAuthData() );
+}
+
+void TestSyncBenchmark::cleanupTestCase()
+{
+  mApi.reset();
+  mLocalProjects.reset();
+  mServer.reset();
+}
+
+void TestSyncBenchmark::addBenchmarkRows()
+{
+  QTest::addColumn<int>( "filesCount" );
+  QTest::addColumn<qint64>( "fileSize" );
+  QTest::addColumn<int>( "latency" );
+  QTest::addColumn<qint64>( "bandwidth" );
+
+  QTest::newRow( "200 x 10 kB" ) << 200 << qint64( 10 * 1024 ) << 0 << qint64( 0 );
+  QTest::newRow( "20 x 1 MB" ) << 20 << qint64( 1024 * 1024 ) << 0 << qint64( 0 );
+  QTest::newRow( "2 x 25 MB" ) << 2 << qint64( 25 * 1024 * 1024 ) << 0 << qint64( 0 );  // multiple chunks per file
+  QTest::newRow( "200 x 10 kB, 50 ms" ) << 200 << qint64( 10 * 1024 ) << 50 << qint64( 0 );
+  QTest::newRow( "20 x 1 MB, 50 ms, 4 MB/s" ) << 20 << qint64( 1024 * 1024 ) << 50 << qint64( 4 * 1024 * 1024 );
+
+  if ( !qgetenv( "INPUT_BENCH_FILES" ).isEmpty() || !qgetenv( "INPUT_BENCH_FILE_SIZE" ).isEmpty() )
+  {
+    QTest::newRow( "custom" ) << _envInt( "INPUT_BENCH_FILES", 100 )
+                              << qint64( _envInt( "INPUT_BENCH_FILE_SIZE", 100 * 1024 ) )
+                              << _envInt( "INPUT_BENCH_LATENCY", 0 )
+                              << qint64( _envInt( "INPUT_BENCH_BANDWIDTH", 0 ) );
+  }
+}
+
+QString TestSyncBenchmark::nextProjectName( const QString &prefix )
+{
+  return QStringLiteral( "%1-%2" ).arg( prefix ).arg( ++mProjectCounter );
+}
+
+void TestSyncBenchmark::writeSyntheticProject( const QString &dir, int filesCount, qint64 fileSize )
+{
+  QRandomGenerator generator( static_cast<quint32>( filesCount ) );
+  QByteArray block( 64 * 1024, Qt::Uninitialized );
+
+  for ( int i = 0; i < filesCount; ++i )
+  {
+    // spread the files in subdirectories like in a project with photos
+    QString filePath = QStringLiteral( "%1/data%2/file_%3.bin" ).arg( dir ).arg( i / 50 ).arg( i );
+    QDir().mkpath( QFileInfo( filePath ).absolutePath() );
+
+    QFile f( filePath );
+    QVERIFY( f.open( QIODevice::WriteOnly ) );
+    qint64 written = 0;
+    while ( written < fileSize )
+    {
+      generator.fillRange( reinterpret_cast<quint32 *>( block.data() ), block.size() / 4 );
+      written += f.write( block.constData(), qMin( qint64( block.size() ), fileSize - written ) );
+    }
+  }
+}
+
+void TestSyncBenchmark::editFile( const QString &filePath, qint64 offset, qint64 length, const QByteArray &data )
+{
+  QFile f( filePath );
+  QVERIFY( f.open( QIODevice::ReadOnly ) );
+  QByteArray content = f.readAll();
+  f.close();
+
+  content.replace( static_cast<int>( offset ), static_cast<int>( length ), data );
+  QVERIFY( f.open( QIODevice::WriteOnly ) );
+  QCOMPARE( f.write( content ), qint64( content.size() ) );
+}
+
+bool TestSyncBenchmark::runSync( bool pull, const QString &projectName, qint64 &peakRss )
+{
+  QSignalSpy spy( mApi.get(), &MerginApi::syncProjectFinished );
+
+  peakRss = _residentMemory();
+  QTimer sampler;
+  connect( &sampler, &QTimer::timeout, this, [&peakRss]() { peakRss = qMax( peakRss, _residentMemory() ); } );
+  sampler.start( 20 );
+
+  if ( pull )
+    mApi->updateProject( BENCH_USER, projectName );
+  else
+    mApi->uploadProject( BENCH_USER, projectName );
+
+  bool finished = spy.wait( TestUtils::LONG_REPLY * 5 );
+  sampler.stop();
+  peakRss = qMax( peakRss, _residentMemory() );
+
+  return finished && spy.count() == 1 && spy.first().at( 2 ).toBool();
+}
+
+void TestSyncBenchmark::report( const QString &what, qint64 bytes, qint64 elapsedMs, qint64 peakRss, qint64 baseRss )
+{
+  TestingMerginServerStats stats = mServer->stats();
+  double mb = bytes / ( 1024.0 * 1024.0 );
+  double seconds = qMax( qint64( 1 ), elapsedMs ) / 1000.0;
+
+  QString memory = peakRss < 0 ? QStringLiteral( "n/a" ) :
+                   QStringLiteral( "%1 MB (+%2 MB)" ).arg( peakRss / ( 1024.0 * 1024.0 ), 0, 'f', 1 )
+                   .arg( ( peakRss - baseRss ) / ( 1024.0 * 1024.0 ), 0, 'f', 1 );
+
+  qInfo().noquote() << QStringLiteral( "%1 [%2]: %3 MB in %4 ms = %5 MB/s, %6 requests, peak RSS %7" )
+                    .arg( what, QString::fromLatin1( QTest::currentDataTag() ) )
+                    .arg( mb, 0, 'f', 1 )
+                    .arg( elapsedMs )
+                    .arg( mb / seconds, 0, 'f', 2 )
+                    .arg( stats.requestCount )
+                    .arg( memory );
+
+  QStringList endpoints;
+  for ( auto it = stats.requestsPerEndpoint.constBegin(); it != stats.requestsPerEndpoint.constEnd(); ++it )
+    endpoints << QStringLiteral( "%1: %2" ).arg( it.key() ).arg( it.value() );
+  endpoints.sort();
+  qInfo().noquote() << "  " << endpoints.join( ", " );
+
+  QTest::setBenchmarkResult( mb / seconds * 1024 * 1024, QTest::BytesPerSecond );
+}
+
+void TestSyncBenchmark::benchmarkPull_data()
+{
+  addBenchmarkRows();
+}
+
+void TestSyncBenchmark::benchmarkPull()
+{
+  QFETCH( int, filesCount );
+  QFETCH( qint64, fileSize );
+  QFETCH( int, latency );
+  QFETCH( qint64, bandwidth );
+
+  QString projectName = nextProjectName( "pull" );
+  QString sourceDir = mSourceDir.path() + "/" + projectName;
+  writeSyntheticProject( sourceDir, filesCount, fileSize );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+
+  mServer->setLatency( latency );
+  mServer->setBandwidth( bandwidth );
+  mServer->resetStats();
+
+  qint64 baseRss = _residentMemory();
+  qint64 peakRss = -1;
+  QElapsedTimer timer;
+  timer.start();
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  qint64 elapsedMs = timer.elapsed();
+
+  mServer->setLatency( 0 );
+  mServer->setBandwidth( 0 );
+
+  LocalProject project = mLocalProjects->projectFromMerginName( BENCH_USER, projectName );
+  QVERIFY( project.isValid() );
+  QCOMPARE( project.localVersion, 1 );
+  QCOMPARE( CoreUtils::getProjectFilesCount( project.projectDir ), filesCount );
+
+  report( "pull", qint64( filesCount ) * fileSize, elapsedMs, peakRss, baseRss );
+
+  QDir( sourceDir ).removeRecursively();
+}
+
+void TestSyncBenchmark::benchmarkPush_data()
+{
+  addBenchmarkRows();
+}
+
+void TestSyncBenchmark::benchmarkPush()
+{
+  QFETCH( int, filesCount );
+  QFETCH( qint64, fileSize );
+  QFETCH( int, latency );
+  QFETCH( qint64, bandwidth );
+
+  QString projectName = nextProjectName( "push" );
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  writeSyntheticProject( projectDir, filesCount, fileSize );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  mLocalProjects->addMerginProject( projectDir, BENCH_USER, projectName );
+
+  mServer->setLatency( latency );
+  mServer->setBandwidth( bandwidth );
+  mServer->resetStats();
+
+  qint64 baseRss = _residentMemory();
+  qint64 peakRss = -1;
+  QElapsedTimer timer;
+  timer.start();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  qint64 elapsedMs = timer.elapsed();
+
+  mServer->setLatency( 0 );
+  mServer->setBandwidth( 0 );
+
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 1 );
+  QCOMPARE( mLocalProjects->projectFromMerginName( BENCH_USER, projectName ).localVersion, 1 );
+
+  report( "push", qint64( filesCount ) * fileSize, elapsedMs, peakRss, baseRss );
+}
+
+void TestSyncBenchmark::testPullFailure()
+{
+  QString projectName = nextProjectName( "pullFailure" );
+  QString sourceDir = mSourceDir.path() + "/" + projectName;
+  writeSyntheticProject( sourceDir, 10, 1024 );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+
+  // one of the files fails to download - the whole pull fails and the project is not added
+  mServer->failRequests( "^/v1/project/raw/", 503 );
+  qint64 peakRss;
+  QVERIFY( !runSync( true, projectName, peakRss ) );
+  QVERIFY( !mLocalProjects->projectFromMerginName( BENCH_USER, projectName ).isValid() );
+  QVERIFY( mApi->transactions().isEmpty() );
+
+  // the server is fine again
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  LocalProject project = mLocalProjects->projectFromMerginName( BENCH_USER, projectName );
+  QVERIFY( project.isValid() );
+  QCOMPARE( CoreUtils::getProjectFilesCount( project.projectDir ), 10 );
+
+  mServer->clearFailures();
+}
+
+void TestSyncBenchmark::testPushDroppedConnection()
+{
+  QString projectName = nextProjectName( "pushDropped" );
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  writeSyntheticProject( projectDir, 5, 1024 );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  mLocalProjects->addMerginProject( projectDir, BENCH_USER, projectName );
+
+  // the connection is dropped while uploading a chunk
+  mServer->failRequests( "^/v1/project/push/chunk/", 0 );
+  qint64 peakRss;
+  QVERIFY( !runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 0 );
+  QVERIFY( mApi->transactions().isEmpty() );
+
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 1 );
+
+  mServer->clearFailures();
+}
+
+void TestSyncBenchmark::testPullResume()
+{
+  QString projectName = nextProjectName( "pullResume" );
+  QString projectFullName = MerginApi::getFullProjectName( BENCH_USER, projectName );
+  QString sourceDir = mSourceDir.path() + "/" + projectName;
+  writeSyntheticProject( sourceDir, 10, 1024 );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+
+  // one request at a time so that exactly 4 files get downloaded before the failure
+  int maxParallelDownloads = mApi->maxParallelDownloads();
+  mApi->setMaxParallelDownloads( 1 );
+  mServer->failRequests( "^/v1/project/raw/", 503, 1, 4 );
+  qint64 peakRss;
+  QVERIFY( !runSync( true, projectName, peakRss ) );
+  QVERIFY( !mLocalProjects->projectFromMerginName( BENCH_USER, projectName ).isValid() );
+
+  // the directory of the first time download is kept together with the journal
+  QString projectDir = TransactionJournal::findInterruptedDownload( mApi->projectsPath(), projectFullName );
+  QVERIFY( !projectDir.isEmpty() );
+  TransactionJournal journal( projectDir );
+  QVERIFY( journal.load() );
+  QCOMPARE( journal.type(), TransactionJournal::Pull );
+  QHash<QString, TransactionJournal::DownloadedItem> items = journal.downloadedItems();
+  QCOMPARE( items.count(), 4 );
+
+  // one of the temporary files got damaged meanwhile - it must be downloaded again
+  QString tempDir = mApi->projectsPath() + "/.temp/" + projectFullName;
+  QFile damaged( tempDir + "/" + items.begin()->tempFileName );
+  QVERIFY( damaged.open( QIODevice::WriteOnly ) );
+  damaged.write( "damaged" );
+  damaged.close();
+
+  mServer->resetStats();
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "GET raw" ), 10 - 4 + 1 );
+
+  LocalProject project = mLocalProjects->projectFromMerginName( BENCH_USER, projectName );
+  QVERIFY( project.isValid() );
+  QCOMPARE( project.projectDir, projectDir );
+  QCOMPARE( CoreUtils::getProjectFilesCount( project.projectDir ), 10 );
+  QVERIFY( !QFile::exists( TransactionJournal::journalFilePath( projectDir ) ) );
+  QVERIFY( !QFile::exists( CoreUtils::downloadInProgressFilePath( projectDir ) ) );
+
+  // the content is the same as on the server
+  for ( int i = 0; i < 10; ++i )
+  {
+    QString filePath = QStringLiteral( "data0/file_%1.bin" ).arg( i );
+    QFile downloaded( projectDir + "/" + filePath );
+    QFile original( sourceDir + "/" + filePath );
+    QVERIFY( downloaded.open( QIODevice::ReadOnly ) );
+    QVERIFY( original.open( QIODevice::ReadOnly ) );
+    QCOMPARE( downloaded.readAll(), original.readAll() );
+  }
+
+  mApi->setMaxParallelDownloads( maxParallelDownloads );
+  mServer->clearFailures();
+}
+
+void TestSyncBenchmark::testPushResume()
+{
+  QString projectName = nextProjectName( "pushResume" );
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  writeSyntheticProject( projectDir, 5, 1024 );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  mLocalProjects->addMerginProject( projectDir, BENCH_USER, projectName );
+
+  // the push fails after 3 chunks (one file each) have been uploaded
+  int maxParallelUploads = mApi->maxParallelUploads();
+  mApi->setMaxParallelUploads( 1 );
+  mServer->failRequests( "^/v1/project/push/chunk/", 503, 1, 3 );
+  qint64 peakRss;
+  QVERIFY( !runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 0 );
+
+  TransactionJournal journal( projectDir );
+  QVERIFY( journal.load() );
+  QCOMPARE( journal.type(), TransactionJournal::Push );
+  QCOMPARE( journal.uploadedChunks().count(), 3 );
+
+  // the same transaction continues with the remaining chunks
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "POST push start" ), 0 );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "POST push chunk" ), 2 );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 1 );
+  QVERIFY( !QFile::exists( TransactionJournal::journalFilePath( projectDir ) ) );
+
+  mApi->setMaxParallelUploads( maxParallelUploads );
+  mServer->clearFailures();
+}
+
+void TestSyncBenchmark::testPushResumeExpired()
+{
+  QString projectName = nextProjectName( "pushResumeExpired" );
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  writeSyntheticProject( projectDir, 5, 1024 );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  mLocalProjects->addMerginProject( projectDir, BENCH_USER, projectName );
+
+  int maxParallelUploads = mApi->maxParallelUploads();
+  mApi->setMaxParallelUploads( 1 );
+  mServer->failRequests( "^/v1/project/push/chunk/", 503, 1, 3 );
+  qint64 peakRss;
+  QVERIFY( !runSync( false, projectName, peakRss ) );
+
+  // the server does not know the transaction anymore - the first chunk fails and the push starts over
+  mServer->dropTransactions();
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "POST push start" ), 1 );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "POST push chunk" ), 1 + 5 );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 1 );
+
+  mApi->setMaxParallelUploads( maxParallelUploads );
+  mServer->clearFailures();
+}
+
+void TestSyncBenchmark::testBlockDeltaPull()
+{
+  QString projectName = nextProjectName( "blockDeltaPull" );
+  QString sourceDir = mSourceDir.path() + "/" + projectName;
+  QString filePath = QStringLiteral( "data0/file_0.bin" );
+  qint64 fileSize = 4 * 1024 * 1024;
+  writeSyntheticProject( sourceDir, 1, fileSize );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+
+  qint64 peakRss;
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  QString projectDir = mLocalProjects->projectFromMerginName( BENCH_USER, projectName ).projectDir;
+
+  // bytes inserted in one place and modified in another one
+  editFile( sourceDir + "/" + filePath, 1024 * 1024, 0, QByteArray( 100, 'a' ) );
+  editFile( sourceDir + "/" + filePath, 3 * 1024 * 1024, 10, QByteArray( 10, 'b' ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+
+  mServer->resetStats();
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "GET blocks" ), 1 );
+  QVERIFY( mServer->stats().bytesSent < fileSize / 4 );
+  QCOMPARE( mLocalProjects->projectFromMerginName( BENCH_USER, projectName ).localVersion, 2 );
+
+  QFile downloaded( projectDir + "/" + filePath );
+  QFile original( sourceDir + "/" + filePath );
+  QVERIFY( downloaded.open( QIODevice::ReadOnly ) );
+  QVERIFY( original.open( QIODevice::ReadOnly ) );
+  QCOMPARE( downloaded.readAll(), original.readAll() );
+
+  // the blocks of the new content are indexed for the next sync
+  QString checksum = mServer->projectFileChecksum( BENCH_USER, projectName, filePath );
+  QVERIFY( !BlockIndex( projectDir ).blocks( filePath, checksum ).isEmpty() );
+}
+
+void TestSyncBenchmark::testBlockDeltaPush()
+{
+  QString projectName = nextProjectName( "blockDeltaPush" );
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  QString filePath = QStringLiteral( "data0/file_0.bin" );
+  qint64 fileSize = 4 * 1024 * 1024;
+  writeSyntheticProject( projectDir, 1, fileSize );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  mLocalProjects->addMerginProject( projectDir, BENCH_USER, projectName );
+
+  qint64 peakRss;
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 1 );
+
+  editFile( projectDir + "/" + filePath, 2 * 1024 * 1024, 10, QByteArray( 10, 'c' ) );
+
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QVERIFY( mServer->stats().bytesReceived < fileSize / 4 );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 2 );
+  QCOMPARE( mServer->projectFileChecksum( BENCH_USER, projectName, filePath ), _fileChecksum( projectDir + "/" + filePath ) );
+
+  // the delta file is not left behind
+  QCOMPARE( QDir( projectDir + "/.mergin" ).entryList( QStringList() << "*-blocks" ).count(), 0 );
+}
+
+void TestSyncBenchmark::testBlockDeltaFallback()
+{
+  QString projectName = nextProjectName( "blockDeltaFallback" );
+  QString sourceDir = mSourceDir.path() + "/" + projectName;
+  QString filePath = QStringLiteral( "data0/file_0.bin" );
+  qint64 fileSize = 4 * 1024 * 1024;
+  writeSyntheticProject( sourceDir, 1, fileSize );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+
+  qint64 peakRss;
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  QString projectDir = mLocalProjects->projectFromMerginName( BENCH_USER, projectName ).projectDir;
+
+  // the server fails to list blocks - the file is downloaded in full
+  editFile( sourceDir + "/" + filePath, 1024 * 1024, 10, QByteArray( 10, 'd' ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+  mServer->failRequests( "^/v1/project/blocks/", 404 );
+  mServer->resetStats();
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  QVERIFY( mServer->stats().bytesSent >= fileSize );
+  QCOMPARE( _fileChecksum( projectDir + "/" + filePath ), mServer->projectFileChecksum( BENCH_USER, projectName, filePath ) );
+
+  // blocks of the file downloaded in full are not known - the push uploads it in full too (and indexes it)
+  editFile( projectDir + "/" + filePath, 2 * 1024 * 1024, 10, QByteArray( 10, 'e' ) );
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QVERIFY( mServer->stats().bytesReceived >= fileSize );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 3 );
+
+  // the server does not accept block delta anymore (e.g. it has been downgraded) - the next push uploads the file in full
+  mServer->setBlockDeltaSupported( false );
+  editFile( projectDir + "/" + filePath, 3 * 1024 * 1024, 10, QByteArray( 10, 'f' ) );
+  QVERIFY( !runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 3 );
+
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QVERIFY( mServer->stats().bytesReceived >= fileSize );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 4 );
+  QCOMPARE( _fileChecksum( projectDir + "/" + filePath ), mServer->projectFileChecksum( BENCH_USER, projectName, filePath ) );
+
+  mServer->setBlockDeltaSupported( true );
+  mServer->clearFailures();
+}
+
+void TestSyncBenchmark::testContentStorePull()
+{
+  // all projects on the device share the store - it is enabled only here, so that the other tests download everything
+  mApi->setContentStoreMaxSize( ContentStore::DEFAULT_MAX_SIZE );
+
+  QString projectName = nextProjectName( "contentStore" );
+  QString sourceDir = mSourceDir.path() + "/" + projectName;
+  writeSyntheticProject( sourceDir, 3, 100 * 1024 );
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, projectName, sourceDir ) );
+
+  qint64 peakRss;
+  mServer->resetStats();
+  QVERIFY( runSync( true, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "GET raw" ), 3 );
+
+  // another project has the same files (one of them renamed) and a new one - only the new file gets downloaded
+  QString otherName = nextProjectName( "contentStore" );
+  QString otherSourceDir = mSourceDir.path() + "/" + otherName;
+  QVERIFY( QDir().mkpath( otherSourceDir + "/data0" ) );
+  QVERIFY( QDir().mkpath( otherSourceDir + "/renamed" ) );
+  QVERIFY( QFile::copy( sourceDir + "/data0/file_0.bin", otherSourceDir + "/data0/file_0.bin" ) );
+  QVERIFY( QFile::copy( sourceDir + "/data0/file_1.bin", otherSourceDir + "/data0/file_1.bin" ) );
+  QVERIFY( QFile::copy( sourceDir + "/data0/file_2.bin", otherSourceDir + "/renamed/file_2.bin" ) );
+  QFile newFile( otherSourceDir + "/new.bin" );
+  QVERIFY( newFile.open( QIODevice::WriteOnly ) );
+  newFile.write( QByteArray( 50 * 1024, 'n' ) );
+  newFile.close();
+
+  QVERIFY( mServer->createProject( BENCH_USER, otherName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, otherName, otherSourceDir ) );
+
+  mServer->resetStats();
+  QVERIFY( runSync( true, otherName, peakRss ) );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "GET raw" ), 1 );
+
+  QString otherProjectDir = mLocalProjects->projectFromMerginName( BENCH_USER, otherName ).projectDir;
+  const QStringList files = QStringList() << "data0/file_0.bin" << "data0/file_1.bin" << "renamed/file_2.bin" << "new.bin";
+  for ( const QString &filePath : files )
+    QCOMPARE( _fileChecksum( otherProjectDir + "/" + filePath ), _fileChecksum( otherSourceDir + "/" + filePath ) );
+
+  // a damaged object is not used - the file is downloaded again
+  ContentStore store( mApi->projectsPath() + "/.store" );
+  QString damagedChecksum = _fileChecksum( sourceDir + "/data0/file_0.bin" );
+  QFile damaged( store.objectPath( damagedChecksum ) );
+  QVERIFY( damaged.open( QIODevice::WriteOnly ) );
+  damaged.write( "damaged" );
+  damaged.close();
+
+  QString thirdName = nextProjectName( "contentStore" );
+  QVERIFY( mServer->createProject( BENCH_USER, thirdName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, thirdName, sourceDir ) );
+
+  mServer->resetStats();
+  QVERIFY( runSync( true, thirdName, peakRss ) );
+  QCOMPARE( mServer->stats().requestsPerEndpoint.value( "GET raw" ), 1 );
+
+  QString thirdProjectDir = mLocalProjects->projectFromMerginName( BENCH_USER, thirdName ).projectDir;
+  QCOMPARE( _fileChecksum( thirdProjectDir + "/data0/file_0.bin" ), damagedChecksum );
+  QCOMPARE( _fileChecksum( store.objectPath( damagedChecksum ) ), damagedChecksum );
+
+  // the projects do not share the files with the store, so editing them does not damage it
+  editFile( thirdProjectDir + "/data0/file_1.bin", 0, 10, QByteArray( 10, 'x' ) );
+  QString storedChecksum = _fileChecksum( sourceDir + "/data0/file_1.bin" );
+  QCOMPARE( _fileChecksum( store.objectPath( storedChecksum ) ), storedChecksum );
+
+  mApi->setContentStoreMaxSize( 0 );
+}
+
+void TestSyncBenchmark::testCompression()
+{
+  QString projectName = nextProjectName( "compression" );
+  QString projectDir = mApi->projectsPath() + "/" + projectName;
+  writeSyntheticProject( projectDir, 30, 1024 );  // enough files for a push start request worth compressing
+
+  // a large table - block delta uploads only the changed blocks and they compress well
+  QString tablePath = QStringLiteral( "table.csv" );
+  QByteArray table;
+  for ( int i = 0; table.size() < 2 * 1024 * 1024; ++i )
+    table += QStringLiteral( "%1,point %1,%2\n" ).arg( i ).arg( i % 97 ).toLatin1();
+  QFile tableFile( projectDir + "/" + tablePath );
+  QVERIFY( tableFile.open( QIODevice::WriteOnly ) );
+  tableFile.write( table );
+  tableFile.close();
+
+  // photos are not worth compressing
+  QString photoPath = QStringLiteral( "photo.jpg" );
+  QByteArray photo( 2 * 1024 * 1024, Qt::Uninitialized );
+  QRandomGenerator( 42 ).fillRange( reinterpret_cast<quint32 *>( photo.data() ), photo.size() / 4 );
+  QFile photoFile( projectDir + "/" + photoPath );
+  QVERIFY( photoFile.open( QIODevice::WriteOnly ) );
+  photoFile.write( photo );
+  photoFile.close();
+
+  QVERIFY( mServer->createProject( BENCH_USER, projectName ) );
+  mLocalProjects->addMerginProject( projectDir, BENCH_USER, projectName );
+
+  qint64 peakRss;
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().compressedRequests.value( "POST push start" ), 1 );
+  QCOMPARE( mServer->stats().compressedRequests.value( "POST push chunk" ), 0 );  // full files are streamed as they are
+
+  editFile( projectDir + "/" + tablePath, 1024 * 1024, 10, QByteArray( 10, '0' ) );
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().compressedRequests.value( "POST push chunk" ), 1 );
+  QCOMPARE( mServer->projectFileChecksum( BENCH_USER, projectName, tablePath ), _fileChecksum( projectDir + "/" + tablePath ) );
+
+  editFile( projectDir + "/" + photoPath, 1024 * 1024, 10, QByteArray( 10, '0' ) );
+  mServer->resetStats();
+  QVERIFY( runSync( false, projectName, peakRss ) );
+  QCOMPARE( mServer->stats().compressedRequests.value( "POST push chunk" ), 0 );
+  QCOMPARE( mServer->projectFileChecksum( BENCH_USER, projectName, photoPath ), _fileChecksum( projectDir + "/" + photoPath ) );
+  QCOMPARE( mServer->projectVersion( BENCH_USER, projectName ), 3 );
+
+  // on pull the project info is compressed, the files are not (they are downloaded in ranges)
+  QString pullName = nextProjectName( "compression" );
+  QString sourceDir = mSourceDir.path() + "/" + pullName;
+  writeSyntheticProject( sourceDir, 30, 1024 );
+  QVERIFY( QFile::copy( projectDir + "/" + tablePath, sourceDir + "/" + tablePath ) );
+  QVERIFY( mServer->createProject( BENCH_USER, pullName ) );
+  QVERIFY( mServer->addProjectVersion( BENCH_USER, pullName, sourceDir ) );
+
+  mServer->resetStats();
+  QVERIFY( runSync( true, pullName, peakRss ) );
+  QVERIFY( mServer->stats().compressedResponses.value( "GET project" ) > 0 );
+  QCOMPARE( mServer->stats().compressedResponses.value( "GET raw" ), 0 );
+
+  QString pullDir = mLocalProjects->projectFromMerginName( BENCH_USER, pullName ).projectDir;
+  QCOMPARE( _fileChecksum( pullDir + "/" + tablePath ), _fileChecksum( sourceDir + "/" + tablePath ) );
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TESTSYNCBENCHMARK_H
+#define TESTSYNCBENCHMARK_H
+
+#include <memory>
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include "merginapi.h"
+#include "localprojectsmanager.h"
+
+class TestingMerginServer;
+
+/**
+ * Measures pull/push throughput of MerginApi against TestingMerginServer,
+ * so it runs offline (no TEST_MERGIN_URL needed).
+ *
+ * Each benchmark prints the transferred size, throughput, number of requests and peak
+ * resident memory during the sync. The size of the synthetic project can be overridden
+ * with INPUT_BENCH_FILES, INPUT_BENCH_FILE_SIZE (bytes), INPUT_BENCH_LATENCY (ms)
+ * and INPUT_BENCH_BANDWIDTH (bytes/s) environment variables.
+ */
+class TestSyncBenchmark : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkPull_data();
+    void benchmarkPull();
+    void benchmarkPush_data();
+    void benchmarkPush();
+
+    void testPullFailure(); // injected error fails the pull, next pull succeeds
+    void testPushDroppedConnection(); // dropped chunk upload fails the push
+    void testPullResume(); // interrupted pull downloads only the missing (or corrupted) items next time
+    void testPushResume(); // interrupted push continues with the same transaction next time
+    void testPushResumeExpired(); // a new transaction is started if the server forgot the interrupted one
+    void testBlockDeltaPull(); // small edit of a large file downloads only the changed blocks
+    void testBlockDeltaPush(); // small edit of a large file uploads only the changed blocks
+    void testBlockDeltaFallback(); // the file is transferred in full if the server cannot do block delta
+    void testContentStorePull(); // files already on the device are not downloaded again
+    void testCompression(); // requests and responses are compressed where it pays off
+
+  private:
+    void addBenchmarkRows();
+    QString nextProjectName( const QString &prefix );
+
+    //! Writes \a filesCount files of \a fileSize random bytes
+    void writeSyntheticProject( const QString &dir, int filesCount, qint64 fileSize );
+
+    //! Replaces \a length bytes at \a offset of the file with \a data
+    void editFile( const QString &filePath, qint64 offset, qint64 length, const QByteArray &data );
+
+    //! Runs pull or push and waits for it, returns whether it was successful
+    bool runSync( bool pull, const QString &projectName, qint64 &peakRss );
+
+    void report( const QString &what, qint64 bytes, qint64 elapsedMs, qint64 peakRss, qint64 baseRss );
+
+    std::unique_ptr<TestingMerginServer> mServer;
+    QTemporaryDir mDataDir;
+    QTemporaryDir mSourceDir;
+    std::unique_ptr<LocalProjectsManager> mLocalProjects;
+    std::unique_ptr<MerginApi> mApi;
+    int mProjectCounter = 0;
+};
+
+#endif // TESTSYNCBENCHMARK_H
@@ -0,0 +1,148 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "testtrackrecorder.h"
+
+#include <memory>
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "qgslinestring.h"
+
+#include "trackrecorder.h"
+
+void TestTrackRecorder::appendAcrossChunks()
+{
+  TrackRecorder track;
+  const int count = TrackRecorder::CHUNK_SIZE * 2 + 10;
+  for ( int i = 0; i < count; ++i )
+    track.append( QgsPoint( i, 0, 5 ) );
+
+  QCOMPARE( track.size(), count );
+  QCOMPARE( track.at( TrackRecorder::CHUNK_SIZE ).x(), static_cast<double>( TrackRecorder::CHUNK_SIZE ) );
+  QCOMPARE( track.last().x(), static_cast<double>( count - 1 ) );
+
+  // removing points goes back to the previous chunk
+  for ( int i = 0; i < 11; ++i )
+    track.removeLast();
+  QCOMPARE( track.size(), TrackRecorder::CHUNK_SIZE * 2 - 1 );
+  QCOMPARE( track.last().x(), static_cast<double>( TrackRecorder::CHUNK_SIZE * 2 - 2 ) );
+
+  track.updateLast( QgsPoint( -1, -1, 7 ) );
+  std::unique_ptr<QgsLineString> line( track.lineString() );
+  QCOMPARE( line->numPoints(), track.size() );
+  QVERIFY( line->is3D() );
+  QCOMPARE( line->endPoint(), QgsPoint( -1, -1, 7 ) );
+
+  track.clear();
+  QVERIFY( track.isEmpty() );
+  QCOMPARE( track.displaySize(), 0 );
+}
+
+void TestTrackRecorder::displaySimplification()
+{
+  TrackRecorder track;
+  track.setTolerance( 0.95 );
+
+  // fixes every 0.1 units along a straight line keep every 10th point
+  for ( int i = 0; i <= 100; ++i )
+    track.append( QgsPoint( i * 0.1, 0 ) );
+
+  QCOMPARE( track.size(), 101 );
+  QCOMPARE( track.displaySize(), 11 );
+
+  std::unique_ptr<QgsLineString> display( track.displayLineString() );
+  QCOMPARE( display->numPoints(), 11 );
+  QCOMPARE( display->startPoint(), QgsPoint( 0, 0 ) );
+  QCOMPARE( display->endPoint(), track.last() );
+
+  // the last point follows updates
+  track.updateLast( QgsPoint( 10, 5 ) );
+  display.reset( track.displayLineString() );
+  QCOMPARE( display->endPoint(), QgsPoint( 10, 5 ) );
+
+  // removed points disappear from the display line as well
+  for ( int i = 0; i < 15; ++i )
+    track.removeLast();
+  display.reset( track.displayLineString() );
+  QCOMPARE( display->endPoint(), track.last() );
+  QVERIFY( display->numPoints() <= 10 );
+  for ( int i = 0; i < display->numPoints() - 1; ++i )
+    QVERIFY( display->xAt( i ) < track.last().x() );
+
+  // without tolerance all points are shown
+  TrackRecorder fullTrack;
+  for ( int i = 0; i < 10; ++i )
+    fullTrack.append( QgsPoint( i * 0.1, 0 ) );
+  QCOMPARE( fullTrack.displaySize(), 10 );
+}
+
+void TestTrackRecorder::restoreJournal()
+{
+  QTemporaryDir dir;
+  const QString path = dir.filePath( QStringLiteral( ".mergin/track-journal" ) );
+
+  {
+    TrackRecorder track;
+    QVERIFY( track.startJournal( path, QStringLiteral( "layer1" ) ) );
+    track.append( QgsPoint( 0, 0, 1 ) );
+    track.append( QgsPoint( 1, 1, 2 ) );
+    track.append( QgsPoint( 2, 2, 3 ) );
+    track.updateLast( QgsPoint( 2, 3, 4 ) );
+    track.removeLast();
+    track.append( QgsPoint( 5, 5, 5 ) );
+    // recorder goes away without discarding the journal, like when the app crashes
+  }
+
+  TrackRecorder otherLayer;
+  QCOMPARE( otherLayer.restoreJournal( path, QStringLiteral( "layer2" ) ), 0 );
+  QVERIFY( otherLayer.isEmpty() );
+
+  TrackRecorder track;
+  QCOMPARE( track.restoreJournal( path, QStringLiteral( "layer1" ) ), 3 );
+  QCOMPARE( track.at( 0 ), QgsPoint( 0, 0, 1 ) );
+  QCOMPARE( track.at( 1 ), QgsPoint( 1, 1, 2 ) );
+  QCOMPARE( track.at( 2 ), QgsPoint( 5, 5, 5 ) );
+
+  // journaling continues in the restored file
+  track.append( QgsPoint( 6, 6, 6 ) );
+  TrackRecorder restoredAgain;
+  QCOMPARE( restoredAgain.restoreJournal( path, QStringLiteral( "layer1" ) ), 4 );
+
+  restoredAgain.discardJournal();
+  QVERIFY( !QFile::exists( path ) );
+}
+
+void TestTrackRecorder::restoreTruncatedJournal()
+{
+  QTemporaryDir dir;
+  const QString path = dir.filePath( QStringLiteral( "track-journal" ) );
+
+  {
+    TrackRecorder track;
+    QVERIFY( track.startJournal( path, QStringLiteral( "layer1" ) ) );
+    track.append( QgsPoint( 0, 0 ) );
+    track.append( QgsPoint( 1, 1 ) );
+  }
+
+  // cut the last record in half
+  QFile file( path );
+  QVERIFY( file.open( QIODevice::ReadWrite ) );
+  QVERIFY( file.resize( file.size() - 10 ) );
+  file.close();
+
+  TrackRecorder track;
+  QCOMPARE( track.restoreJournal( path, QStringLiteral( "layer1" ) ), 1 );
+  track.append( QgsPoint( 2, 2 ) );
+
+  TrackRecorder restoredAgain;
+  QCOMPARE( restoredAgain.restoreJournal( path, QStringLiteral( "layer1" ) ), 2 );
+  QCOMPARE( restoredAgain.last(), QgsPoint( 2, 2 ) );
+}
@@ -0,0 +1,28 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include <QObject>
+#include <QtTest>
+
+#ifndef TESTTRACKRECORDER_H
+#define TESTTRACKRECORDER_H
+
+class TestTrackRecorder: public QObject
+{
+    Q_OBJECT
+  private slots:
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void appendAcrossChunks();
+    void displaySimplification(); // radial distance, last point always shown
+    void restoreJournal(); // points are restored after the recorder is gone
+    void restoreTruncatedJournal(); // incomplete last record is dropped
+};
+
+#endif // TESTTRACKRECORDER_H
@@ -10,6 +10,7 @@
 #include "testutilsfunctions.h"
 #include <QApplication>
 #include <QDesktopWidget>
+#include <QTemporaryDir>
 
 #include "qgsapplication.h"
 #include "qgscoordinatereferencesystem.h"
@@ -21,6 +22,11 @@
 #include "qgsunittypes.h"
 
 #include "testutils.h"
+#include "qgsquickcoordinatetransformcache.h"
+#include "qgsquickmapsettings.h"
+#include "coreutils.h"
+#include "logwriter.h"
+#include "localprojectsmanager.h"
 
 #include <QtTest/QtTest>
 #include <QtCore/QObject>
@@ -104,6 +110,41 @@ void TestUtilsFunctions::transformedPoint()
   COMPARENEAR( transformedPoint.y(), 1839491, 1.0 );
 }
 
+void TestUtilsFunctions::transformedPoints()
+{
+  QgsCoordinateReferenceSystem crs3857 = QgsCoordinateReferenceSystem::fromEpsgId( 3857 );
+  QgsCoordinateReferenceSystem crsGPS = QgsCoordinateReferenceSystem::fromEpsgId( 4326 );
+
+  QgsQuickCoordinateTransformCache::clear();
+
+  QVector<double> x = { 49.9, 0 };
+  QVector<double> y = { 16.3, 0 };
+  QVector<double> z;
+  QVERIFY( mUtils->transformPoints( crsGPS, crs3857, QgsCoordinateTransformContext(), x, y, z ) );
+  COMPARENEAR( x[0], 5554843, 1.0 );
+  COMPARENEAR( y[0], 1839491, 1.0 );
+  COMPARENEAR( x[1], 0, 1e-4 );
+  COMPARENEAR( y[1], 0, 1e-4 );
+  QVERIFY( z.isEmpty() );
+
+  // the transform created for the batch is reused for single points
+  QCOMPARE( QgsQuickCoordinateTransformCache::count(), 1 );
+  QgsPointXY transformedPoint = mUtils->transformPoint( crsGPS, crs3857, QgsCoordinateTransformContext(), QgsPointXY( 49.9, 16.3 ) );
+  COMPARENEAR( transformedPoint.x(), 5554843, 1.0 );
+  QCOMPARE( QgsQuickCoordinateTransformCache::count(), 1 );
+
+  // the other direction is a different transform
+  transformedPoint = mUtils->transformPoint( crs3857, crsGPS, QgsCoordinateTransformContext(), transformedPoint );
+  COMPARENEAR( transformedPoint.x(), 49.9, 1e-4 );
+  COMPARENEAR( transformedPoint.y(), 16.3, 1e-4 );
+  QCOMPARE( QgsQuickCoordinateTransformCache::count(), 2 );
+
+  // changes of map CRS drop cached transforms
+  QgsQuickMapSettings ms;
+  ms.setDestinationCrs( crsGPS );
+  QCOMPARE( QgsQuickCoordinateTransformCache::count(), 0 );
+}
+
 void TestUtilsFunctions::formatPoint()
 {
   QgsPoint point( -2.234521, 34.4444421 );
@@ -156,6 +197,66 @@ void TestUtilsFunctions::loadIcon()
   QCOMPARE( fileName, QLatin1String( "ic_save_white.svg" ) );
 }
 
+void TestUtilsFunctions::logToFile()
+{
+  QTemporaryDir dir;
+  const QString logPath = dir.filePath( QStringLiteral( ".logs" ) );
+  const QString originalLogPath = CoreUtils::logFilename();
+  CoreUtils::setLogFilename( logPath );
+
+  for ( int i = 0; i < 100; ++i )
+    CoreUtils::log( QStringLiteral( "TestLog" ), QStringLiteral( "entry %1" ).arg( i ) );
+  CoreUtils::flushLog();
+
+  QFile file( logPath );
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  const QList<QByteArray> lines = file.readAll().split( '\n' );
+  file.close();
+  QCOMPARE( lines.size(), 101 ); // last one is empty
+  QVERIFY( lines.first().endsWith( "TestLog: entry 0" ) );
+  QVERIFY( lines.at( 99 ).endsWith( "TestLog: entry 99" ) );
+
+  // entries over the size limit go to a new file, the old one is kept
+  LogWriter::instance()->setMaxFileSize( file.size() + 10 );
+  CoreUtils::log( QStringLiteral( "TestLog" ), QStringLiteral( "after rotation" ) );
+  CoreUtils::flushLog();
+  LogWriter::instance()->setMaxFileSize( LogWriter::MAX_FILE_SIZE );
+
+  QVERIFY( QFile::exists( LogWriter::rotatedFilePath( logPath ) ) );
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  QVERIFY( file.readAll().trimmed().endsWith( "TestLog: after rotation" ) );
+  file.close();
+
+  CoreUtils::setLogFilename( originalLogPath );
+}
+
+void TestUtilsFunctions::loadLocalProjectsInBackground()
+{
+  QTemporaryDir dir;
+  QDir( dir.path() ).mkpath( QStringLiteral( "first" ) );
+  QDir( dir.path() ).mkpath( QStringLiteral( "second" ) );
+  QFile projectFile( dir.filePath( QStringLiteral( "first/project.qgs" ) ) );
+  QVERIFY( projectFile.open( QIODevice::WriteOnly ) );
+  projectFile.close();
+
+  LocalProjectsManager manager( dir.path(), true );
+  QSignalSpy spy( &manager, &LocalProjectsManager::dataDirReloaded );
+
+  // project created while the data dir is being scanned must not be lost
+  QDir( dir.path() ).mkpath( QStringLiteral( "third" ) );
+  manager.addLocalProject( dir.filePath( QStringLiteral( "third" ) ), QStringLiteral( "third" ) );
+
+  if ( !manager.isLoaded() )
+    QVERIFY( spy.wait() );
+  QVERIFY( manager.isLoaded() );
+
+  const LocalProjectsList projects = manager.projects();
+  QCOMPARE( projects.size(), 3 );
+  QCOMPARE( manager.projectFromDirectory( dir.filePath( QStringLiteral( "first" ) ) ).qgisProjectFilePath, projectFile.fileName() );
+  QVERIFY( manager.projectFromDirectory( dir.filePath( QStringLiteral( "second" ) ) ).projectError.size() > 0 );
+  QCOMPARE( manager.projectFromDirectory( dir.filePath( QStringLiteral( "third" ) ) ).projectName, QStringLiteral( "third" ) );
+}
+
 void TestUtilsFunctions::fileExists()
 {
   QString path = TestUtils::testDataDir() + "/planes/quickapp_project.qgs";
@@ -25,10 +25,13 @@ class TestUtilsFunctions: public QObject
     void dump_screen_info();
     void screenUnitsToMeters();
     void transformedPoint();
+    void transformedPoints(); // batched transform, transforms are cached
     void formatPoint();
     void formatDistance();
     void loadIcon();
     void fileExists();
+    void logToFile(); // buffered writes and rotation of the log file
+    void loadLocalProjectsInBackground();
     void loadQmlComponent();
     void getRelativePath();
     void resolvePhotoPath();
@@ -0,0 +1,281 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "trackrecorder.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+
+#include "qgslinestring.h"
+
+#include "coreutils.h"
+
+static const quint32 JOURNAL_MAGIC = 0x54524b4a; // "TRKJ"
+static const quint32 JOURNAL_VERSION = 1;
+
+static void writePoint( QDataStream &stream, const QgsPoint &point )
+{
+  stream << static_cast<quint32>( point.wkbType() ) << point.x() << point.y() << point.z() << point.m();
+}
+
+static QgsPoint readPoint( QDataStream &stream )
+{
+  quint32 wkbType = 0;
+  double x = 0, y = 0, z = 0, m = 0;
+  stream >> wkbType >> x >> y >> z >> m;
+  return QgsPoint( static_cast<QgsWkbTypes::Type>( wkbType ), x, y, z, m );
+}
+
+TrackRecorder::~TrackRecorder()
+{
+  mJournal.close();
+}
+
+const QgsPoint &TrackRecorder::at( int i ) const
+{
+  Q_ASSERT( i >= 0 && i < mSize );
+  return mChunks.at( i / CHUNK_SIZE ).at( i % CHUNK_SIZE );
+}
+
+const QgsPoint &TrackRecorder::last() const
+{
+  return at( mSize - 1 );
+}
+
+void TrackRecorder::append( const QgsPoint &point )
+{
+  appendPoint( point );
+  writeJournal( JournalAppend, &point );
+}
+
+void TrackRecorder::updateLast( const QgsPoint &point )
+{
+  if ( mSize == 0 )
+    return;
+
+  // the last point is never a kept display point, so the display line stays valid
+  lastRef() = point;
+  writeJournal( JournalUpdateLast, &point );
+}
+
+void TrackRecorder::removeLast()
+{
+  if ( mSize == 0 )
+    return;
+
+  removeLastPoint();
+  writeJournal( JournalRemoveLast );
+}
+
+void TrackRecorder::clear()
+{
+  clearPoints();
+  writeJournal( JournalClear );
+}
+
+int TrackRecorder::displaySize() const
+{
+  return mSize == 0 ? 0 : mDisplayIndexes.size() + 1;
+}
+
+QgsLineString *TrackRecorder::lineString() const
+{
+  QVector<int> indexes( mSize );
+  for ( int i = 0; i < mSize; ++i )
+    indexes[i] = i;
+  return createLineString( indexes );
+}
+
+QgsLineString *TrackRecorder::displayLineString() const
+{
+  QVector<int> indexes = mDisplayIndexes;
+  if ( mSize > 0 )
+    indexes << mSize - 1;
+  return createLineString( indexes );
+}
+
+bool TrackRecorder::startJournal( const QString &path, const QString &layerId )
+{
+  discardJournal();
+  clearPoints();
+
+  QDir().mkpath( QFileInfo( path ).absolutePath() );
+
+  mJournal.setFileName( path );
+  if ( !mJournal.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+  {
+    CoreUtils::log( QStringLiteral( "TrackRecorder" ), QStringLiteral( "Unable to write journal %1" ).arg( path ) );
+    return false;
+  }
+
+  QDataStream stream( &mJournal );
+  stream << JOURNAL_MAGIC << JOURNAL_VERSION << layerId;
+  mJournal.flush();
+  return true;
+}
+
+int TrackRecorder::restoreJournal( const QString &path, const QString &layerId )
+{
+  discardJournal();
+  clearPoints();
+
+  mJournal.setFileName( path );
+  if ( !mJournal.open( QIODevice::ReadWrite ) )
+    return 0;
+
+  QDataStream stream( &mJournal );
+  quint32 magic = 0;
+  quint32 version = 0;
+  QString journalLayerId;
+  stream >> magic >> version >> journalLayerId;
+  if ( stream.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION || journalLayerId != layerId )
+  {
+    mJournal.close();
+    return 0;
+  }
+
+  qint64 validSize = mJournal.pos();
+  while ( !stream.atEnd() )
+  {
+    quint8 record = 0;
+    stream >> record;
+
+    QgsPoint point;
+    if ( record == JournalAppend || record == JournalUpdateLast )
+      point = readPoint( stream );
+
+    // the last record may be incomplete if the app was killed while writing it
+    if ( stream.status() != QDataStream::Ok )
+      break;
+
+    switch ( record )
+    {
+      case JournalAppend:
+        appendPoint( point );
+        break;
+      case JournalUpdateLast:
+        if ( mSize > 0 )
+          lastRef() = point;
+        break;
+      case JournalRemoveLast:
+        if ( mSize > 0 )
+          removeLastPoint();
+        break;
+      case JournalClear:
+        clearPoints();
+        break;
+    }
+
+    validSize = mJournal.pos();
+  }
+
+  // drop the incomplete record and continue journaling after the last complete one
+  mJournal.resize( validSize );
+  mJournal.seek( validSize );
+
+  CoreUtils::log( QStringLiteral( "TrackRecorder" ), QStringLiteral( "Restored %1 points from journal %2" ).arg( mSize ).arg( path ) );
+  return mSize;
+}
+
+void TrackRecorder::discardJournal()
+{
+  if ( mJournal.fileName().isEmpty() )
+    return;
+
+  mJournal.close();
+  mJournal.remove();
+  mJournal.setFileName( QString() );
+}
+
+QgsPoint &TrackRecorder::lastRef()
+{
+  const int i = mSize - 1;
+  return mChunks[i / CHUNK_SIZE][i % CHUNK_SIZE];
+}
+
+void TrackRecorder::appendPoint( const QgsPoint &point )
+{
+  if ( mSize > 0 )
+  {
+    // the previous last point is kept if it is far enough from the last kept point
+    const int previous = mSize - 1;
+    if ( mDisplayIndexes.isEmpty() || at( mDisplayIndexes.last() ).distance( at( previous ) ) >= mTolerance )
+      mDisplayIndexes << previous;
+  }
+
+  if ( mSize == mChunks.size() * CHUNK_SIZE )
+  {
+    mChunks.append( QVector<QgsPoint>() );
+    mChunks.last().reserve( CHUNK_SIZE );
+  }
+
+  mChunks.last().append( point );
+  ++mSize;
+}
+
+void TrackRecorder::removeLastPoint()
+{
+  mChunks.last().removeLast();
+  if ( mChunks.last().isEmpty() )
+    mChunks.removeLast();
+  --mSize;
+
+  // the new last point must not stay among the kept ones
+  while ( !mDisplayIndexes.isEmpty() && mDisplayIndexes.last() >= mSize - 1 )
+    mDisplayIndexes.removeLast();
+}
+
+void TrackRecorder::clearPoints()
+{
+  mChunks.clear();
+  mSize = 0;
+  mDisplayIndexes.clear();
+}
+
+void TrackRecorder::writeJournal( TrackRecorder::JournalRecord record, const QgsPoint *point )
+{
+  if ( !mJournal.isOpen() )
+    return;
+
+  QDataStream stream( &mJournal );
+  stream << static_cast<quint8>( record );
+  if ( point )
+    writePoint( stream, *point );
+
+  // hand the record over to the system right away, so it survives crash of the app
+  mJournal.flush();
+}
+
+QgsLineString *TrackRecorder::createLineString( const QVector<int> &indexes ) const
+{
+  if ( indexes.isEmpty() )
+    return new QgsLineString;
+
+  const bool hasZ = at( indexes.first() ).is3D();
+  const bool hasM = at( indexes.first() ).isMeasure();
+
+  QVector<double> x( indexes.size() );
+  QVector<double> y( indexes.size() );
+  QVector<double> z( hasZ ? indexes.size() : 0 );
+  QVector<double> m( hasM ? indexes.size() : 0 );
+
+  for ( int i = 0; i < indexes.size(); ++i )
+  {
+    const QgsPoint &point = at( indexes.at( i ) );
+    x[i] = point.x();
+    y[i] = point.y();
+    if ( hasZ )
+      z[i] = point.z();
+    if ( hasM )
+      m[i] = point.m();
+  }
+
+  return new QgsLineString( x, y, z, m );
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRACKRECORDER_H
+#define TRACKRECORDER_H
+
+#include <QFile>
+#include <QVector>
+
+#include "qgspoint.h"
+
+class QgsLineString;
+
+/**
+ * Keeps points of a line or polygon being recorded, e.g. a GPS track streamed for hours.
+ *
+ * Points are stored in fixed size chunks, so appending never copies the points recorded so far.
+ *
+ * Every change is appended to a journal file (if started), so the track can be restored
+ * after the app crashes or gets killed by the system in the background.
+ *
+ * Besides all points, a simplified display line is maintained incrementally with the radial
+ * distance algorithm: a point is kept when it is further than tolerance from the previous kept
+ * point. The last recorded point is always part of the display line.
+ */
+class TrackRecorder
+{
+  public:
+    //! Number of points in one chunk of the buffer
+    static const int CHUNK_SIZE = 1024;
+
+    TrackRecorder() = default;
+    ~TrackRecorder();
+
+    TrackRecorder( const TrackRecorder & ) = delete;
+    TrackRecorder &operator=( const TrackRecorder & ) = delete;
+
+    //! Returns number of recorded points
+    int size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+
+    //! Returns recorded point at index \a i
+    const QgsPoint &at( int i ) const;
+
+    //! Returns the last recorded point, the recorder must not be empty
+    const QgsPoint &last() const;
+
+    //! Adds a new point at the end
+    void append( const QgsPoint &point );
+
+    //! Replaces the last point, e.g. with a more recent position fix
+    void updateLast( const QgsPoint &point );
+
+    //! Removes the last point
+    void removeLast();
+
+    //! Removes all points, the journal (if any) is kept open and emptied
+    void clear();
+
+    //! Returns tolerance of the display line simplification in layer units
+    double tolerance() const { return mTolerance; }
+
+    //! Sets tolerance of the display line simplification in layer units, applies to points appended from now on
+    void setTolerance( double tolerance ) { mTolerance = tolerance; }
+
+    //! Returns number of points in the display line
+    int displaySize() const;
+
+    //! Returns new line string with all recorded points, caller takes ownership
+    QgsLineString *lineString() const;
+
+    //! Returns new line string with simplified points for display, caller takes ownership
+    QgsLineString *displayLineString() const;
+
+    /**
+     * Clears recorded points and starts journaling into a new file at \a path.
+     * The \a layerId identifies layer of the recorded feature.
+     * Returns false if the journal file can't be written.
+     */
+    bool startJournal( const QString &path, const QString &layerId );
+
+    /**
+     * Replaces recorded points with the ones from the journal at \a path if it was
+     * written for the layer \a layerId, and continues journaling into the file.
+     * Returns number of restored points.
+     */
+    int restoreJournal( const QString &path, const QString &layerId );
+
+    //! Stops journaling and removes the journal file
+    void discardJournal();
+
+  private:
+    enum JournalRecord
+    {
+      JournalAppend = 1,
+      JournalUpdateLast,
+      JournalRemoveLast,
+      JournalClear,
+    };
+
+    QgsPoint &lastRef();
+    void appendPoint( const QgsPoint &point );
+    void removeLastPoint();
+    void clearPoints();
+    void writeJournal( JournalRecord record, const QgsPoint *point = nullptr );
+
+    QgsLineString *createLineString( const QVector<int> &indexes ) const;
+
+    QVector<QVector<QgsPoint>> mChunks;
+    int mSize = 0;
+
+    double mTolerance = 0;
+    QVector<int> mDisplayIndexes; //!< indexes of kept points, the last point is never included
+
+    QFile mJournal;
+};
+
+#endif // TRACKRECORDER_H
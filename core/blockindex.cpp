@@ -0,0 +1,258 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "blockindex.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include "coreutils.h"
+
+const qint64 BlockIndex::MIN_FILE_SIZE;
+const qint64 BlockIndex::MIN_BLOCK_SIZE;
+const qint64 BlockIndex::MAX_BLOCK_SIZE;
+
+// a block ends where the top 16 bits of the rolling hash are zero - 64 KiB on average (on top of the minimum size).
+// The top bits of the gear hash depend on the last 64 bytes, so that is the window that decides about a boundary
+static const quint64 BLOCK_BOUNDARY_MASK = 0xffff000000000000ULL;
+
+static const qint64 READ_BUFFER_SIZE = 1024 * 1024;
+
+//! Random values for each byte value - generated by SplitMix64 from a fixed seed, so they are the same everywhere
+static const quint64 *gearTable()
+{
+  struct GearTable
+  {
+    GearTable()
+    {
+      quint64 state = 0x4d657267696e2121ULL;
+      for ( quint64 &value : values )
+      {
+        state += 0x9e3779b97f4a7c15ULL;
+        quint64 z = state;
+        z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+        value = z ^ ( z >> 31 );
+      }
+    }
+
+    quint64 values[256];
+  };
+
+  static const GearTable table;
+  return table.values;
+}
+
+BlockIndex::BlockIndex( const QString &projectDir )
+  : mProjectDir( projectDir )
+{
+  load();
+}
+
+QList<BlockIndex::Block> BlockIndex::blocks( const QString &filePath, const QString &fileChecksum ) const
+{
+  auto it = mEntries.constFind( filePath );
+  if ( it == mEntries.constEnd() || fileChecksum.isEmpty() || it->checksum != fileChecksum )
+    return QList<Block>();
+
+  return it->blocks;
+}
+
+void BlockIndex::insert( const QString &filePath, const QString &fileChecksum, const QList<Block> &blocks )
+{
+  Entry entry;
+  entry.checksum = fileChecksum;
+  entry.blocks = blocks;
+  mEntries.insert( filePath, entry );
+  mModified = true;
+}
+
+void BlockIndex::remove( const QString &filePath )
+{
+  if ( mEntries.remove( filePath ) )
+    mModified = true;
+}
+
+bool BlockIndex::save()
+{
+  if ( !mModified )
+    return true;
+
+  if ( !QDir( mProjectDir + "/.mergin" ).exists() )
+    return false;  // not a mergin project
+
+  QJsonObject files;
+  for ( auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it )
+  {
+    // offsets follow from the sizes
+    QJsonArray blocks;
+    for ( const Block &block : it->blocks )
+    {
+      QJsonArray blockArray;
+      blockArray.append( block.size );
+      blockArray.append( block.checksum );
+      blocks.append( blockArray );
+    }
+
+    QJsonObject entry;
+    entry.insert( QStringLiteral( "checksum" ), it->checksum );
+    entry.insert( QStringLiteral( "blocks" ), blocks );
+    files.insert( it.key(), entry );
+  }
+
+  QJsonObject root;
+  root.insert( QStringLiteral( "version" ), INDEX_VERSION );
+  root.insert( QStringLiteral( "files" ), files );
+
+  QSaveFile f( indexFilePath( mProjectDir ) );
+  if ( !f.open( QIODevice::WriteOnly ) )
+  {
+    CoreUtils::log( "block index", "Failed to open for writing: " + f.fileName() );
+    return false;
+  }
+  f.write( QJsonDocument( root ).toJson( QJsonDocument::Compact ) );
+  if ( !f.commit() )
+  {
+    CoreUtils::log( "block index", "Failed to write: " + f.fileName() );
+    return false;
+  }
+
+  mModified = false;
+  return true;
+}
+
+QString BlockIndex::indexFilePath( const QString &projectDir )
+{
+  return projectDir + "/.mergin/blocks.json";
+}
+
+QList<BlockIndex::Block> BlockIndex::computeBlocks( const QString &filePath, const std::atomic<bool> *canceled )
+{
+  QList<Block> blocks;
+
+  QFile f( filePath );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return blocks;
+
+  const quint64 *gear = gearTable();
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  QByteArray buffer( static_cast<int>( READ_BUFFER_SIZE ), Qt::Uninitialized );
+  quint64 rollingHash = 0;
+  qint64 blockStart = 0;
+  qint64 bufferStart = 0;  // offset of the buffer in the file
+
+  while ( true )
+  {
+    if ( canceled && *canceled )
+      return QList<Block>();
+
+    qint64 bytesRead = f.read( buffer.data(), buffer.size() );
+    if ( bytesRead < 0 )
+      return QList<Block>();
+    if ( bytesRead == 0 )
+      break;
+
+    const uchar *data = reinterpret_cast<const uchar *>( buffer.constData() );
+    qint64 hashedUntil = 0;  // part of the buffer already added to the hash of the current block
+    for ( qint64 i = 0; i < bytesRead; ++i )
+    {
+      rollingHash = ( rollingHash << 1 ) + gear[data[i]];
+
+      qint64 blockSize = bufferStart + i + 1 - blockStart;
+      if ( blockSize < MIN_BLOCK_SIZE )
+        continue;
+
+      if ( ( rollingHash & BLOCK_BOUNDARY_MASK ) == 0 || blockSize >= MAX_BLOCK_SIZE )
+      {
+        hash.addData( buffer.constData() + hashedUntil, static_cast<int>( i + 1 - hashedUntil ) );
+
+        Block block;
+        block.offset = blockStart;
+        block.size = blockSize;
+        block.checksum = QString::fromLatin1( hash.result().toHex() );
+        blocks << block;
+
+        hash.reset();
+        rollingHash = 0;
+        blockStart += blockSize;
+        hashedUntil = i + 1;
+      }
+    }
+
+    hash.addData( buffer.constData() + hashedUntil, static_cast<int>( bytesRead - hashedUntil ) );
+    bufferStart += bytesRead;
+  }
+
+  if ( bufferStart > blockStart )
+  {
+    Block block;
+    block.offset = blockStart;
+    block.size = bufferStart - blockStart;
+    block.checksum = QString::fromLatin1( hash.result().toHex() );
+    blocks << block;
+  }
+
+  return blocks;
+}
+
+bool BlockIndex::blocksCoverFile( const QList<Block> &blocks, qint64 fileSize )
+{
+  qint64 offset = 0;
+  for ( const Block &block : blocks )
+  {
+    if ( block.offset != offset || block.size <= 0 || block.checksum.isEmpty() )
+      return false;
+    offset += block.size;
+  }
+  return offset == fileSize;
+}
+
+void BlockIndex::load()
+{
+  QFile f( indexFilePath( mProjectDir ) );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return;
+
+  QJsonDocument doc = QJsonDocument::fromJson( f.readAll() );
+  if ( !doc.isObject() || doc.object().value( QStringLiteral( "version" ) ).toInt() != INDEX_VERSION )
+  {
+    // unknown or corrupted content - start from scratch, it gets overwritten on next save
+    mModified = true;
+    return;
+  }
+
+  const QJsonObject files = doc.object().value( QStringLiteral( "files" ) ).toObject();
+  for ( auto it = files.constBegin(); it != files.constEnd(); ++it )
+  {
+    QJsonObject obj = it.value().toObject();
+    Entry entry;
+    entry.checksum = obj.value( QStringLiteral( "checksum" ) ).toString();
+
+    qint64 offset = 0;
+    const QJsonArray blocks = obj.value( QStringLiteral( "blocks" ) ).toArray();
+    for ( const QJsonValue &value : blocks )
+    {
+      QJsonArray blockArray = value.toArray();
+      Block block;
+      block.offset = offset;
+      block.size = static_cast<qint64>( blockArray.at( 0 ).toDouble() );
+      block.checksum = blockArray.at( 1 ).toString();
+      entry.blocks << block;
+      offset += block.size;
+    }
+
+    if ( !entry.checksum.isEmpty() && blocksCoverFile( entry.blocks, offset ) )
+      mEntries.insert( it.key(), entry );
+  }
+}
@@ -0,0 +1,100 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BLOCKINDEX_H
+#define BLOCKINDEX_H
+
+#include <atomic>
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+/**
+ * Splits files to content-defined blocks and keeps a persistent index of the blocks of large
+ * project files, stored in the project's .mergin directory. It is used for block delta transfer
+ * of files that cannot be diffed with geodiff (e.g. MBTiles, rasters): only the blocks missing
+ * on the other side get transferred.
+ *
+ * Block boundaries are found with a gear rolling hash, so they only depend on the content near them:
+ * an edit (or inserted bytes) changes only the blocks around it, the other blocks keep their checksums.
+ * The server splits files the same way, so the parameters below must not change without a new
+ * version of the protocol.
+ *
+ * Entries are keyed by the relative path of the file and hold blocks of the file content with a given
+ * checksum - typically the content last synced with the server, which is the base for the next push.
+ */
+class BlockIndex
+{
+  public:
+    //! Content-defined block of a file
+    struct Block
+    {
+      qint64 offset = 0;
+      qint64 size = 0;
+      QString checksum;  //!< SHA1 of the block content
+    };
+
+    //! Loads the index of the project in given directory (if there is any)
+    explicit BlockIndex( const QString &projectDir );
+
+    /**
+     * Returns blocks of a file (path relative to the project directory) if they are stored
+     * for content with \a fileChecksum, an empty list otherwise.
+     */
+    QList<Block> blocks( const QString &filePath, const QString &fileChecksum ) const;
+
+    //! Stores blocks of a file with content of given checksum (replaces the previous entry)
+    void insert( const QString &filePath, const QString &fileChecksum, const QList<Block> &blocks );
+
+    //! Forgets entry of a file (path relative to the project directory)
+    void remove( const QString &filePath );
+
+    /**
+     * Writes the index to the disk if it has been modified. The index is only written
+     * to projects that already have .mergin directory.
+     */
+    bool save();
+
+    //! Returns path of the index file for project in given directory
+    static QString indexFilePath( const QString &projectDir );
+
+    /**
+     * Splits the file to content-defined blocks (reads the whole file).
+     * Returns an empty list if the file cannot be read or \a canceled gets set meanwhile.
+     */
+    static QList<Block> computeBlocks( const QString &filePath, const std::atomic<bool> *canceled = nullptr );
+
+    //! Returns true if blocks are contiguous and cover exactly \a fileSize bytes
+    static bool blocksCoverFile( const QList<Block> &blocks, qint64 fileSize );
+
+    //! Files smaller than this are always transferred in full
+    static const qint64 MIN_FILE_SIZE = 1024 * 1024;
+
+    static const qint64 MIN_BLOCK_SIZE = 16 * 1024;
+    static const qint64 MAX_BLOCK_SIZE = 256 * 1024;
+
+  private:
+    struct Entry
+    {
+      QString checksum;
+      QList<Block> blocks;
+    };
+
+    void load();
+
+    QString mProjectDir;
+    QHash<QString, Entry> mEntries;
+    bool mModified = false;
+
+    static const int INDEX_VERSION = 1;
+};
+
+#endif // BLOCKINDEX_H
@@ -0,0 +1,221 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "changesetsummaryservice.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QWaitCondition>
+#include <QtConcurrent>
+
+#include "coreutils.h"
+#include "geodiffutils.h"
+
+namespace
+{
+  struct CachedSummary
+  {
+    QString json;
+    qint64 used = 0;  //!< last time the summary was used, in milliseconds since epoch
+  };
+
+  struct SummaryCache
+  {
+    QMutex mutex;
+    QWaitCondition computed;
+    QHash<QString, QHash<QString, CachedSummary>> projects;  //!< project dir -> cache key -> summary
+    QSet<QString> loadedProjects;  //!< projects whose cache file has been read already
+    QSet<QString> inFlight;  //!< project dir + cache key of summaries that are being computed
+  };
+
+  Q_GLOBAL_STATIC( SummaryCache, sCache )
+}
+
+ChangesetSummaryService::ChangesetSummaryService( QObject *parent )
+  : QObject( parent )
+{
+}
+
+void ChangesetSummaryService::request( const QString &projectDir, const QList<Request> &requests )
+{
+  cancel();
+
+  int generation = mGeneration;
+  mProjectDir = projectDir;
+  mPending = requests.count();
+
+  if ( requests.isEmpty() )
+  {
+    emit finished( projectDir );
+    return;
+  }
+
+  for ( const Request &r : requests )
+  {
+    QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>( this );
+    QString filePath = r.filePath;
+    connect( watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, generation, projectDir, filePath]()
+    {
+      watcher->deleteLater();
+      if ( generation != mGeneration )
+        return;  // nobody is interested anymore (the summary is cached though)
+
+      emit summaryReady( projectDir, filePath, watcher->result() );
+
+      if ( --mPending == 0 )
+        emit finished( projectDir );
+    } );
+    watcher->setFuture( QtConcurrent::run( &ChangesetSummaryService::summaryJson, projectDir, r.filePath, r.baseChecksum, r.modifiedChecksum ) );
+  }
+}
+
+void ChangesetSummaryService::cancel()
+{
+  ++mGeneration;
+  mPending = 0;
+}
+
+QString ChangesetSummaryService::summaryJson( const QString &projectDir, const QString &filePath, const QString &baseChecksum, const QString &modifiedChecksum )
+{
+  if ( baseChecksum.isEmpty() || modifiedChecksum.isEmpty() )
+    return GeodiffUtils::diffableFilePendingChanges( projectDir, filePath, true );
+
+  QString dir = QDir::cleanPath( projectDir );
+  QString key = cacheKey( baseChecksum, modifiedChecksum );
+  QString inFlightId = dir + "/" + key;
+
+  SummaryCache *cache = sCache();
+  {
+    QMutexLocker locker( &cache->mutex );
+    loadProjectCache( dir );
+
+    // somebody else is computing the same summary - wait for the result instead of doing it again
+    while ( cache->inFlight.contains( inFlightId ) )
+      cache->computed.wait( &cache->mutex );
+
+    QHash<QString, CachedSummary> &summaries = cache->projects[dir];
+    auto it = summaries.find( key );
+    if ( it != summaries.end() )
+    {
+      it->used = QDateTime::currentMSecsSinceEpoch();
+      return it->json;
+    }
+
+    cache->inFlight.insert( inFlightId );
+  }
+
+  QString json = GeodiffUtils::diffableFilePendingChanges( projectDir, filePath, true );
+
+  {
+    QMutexLocker locker( &cache->mutex );
+    cache->inFlight.remove( inFlightId );
+
+    if ( !json.startsWith( "ERROR" ) )
+    {
+      QHash<QString, CachedSummary> &summaries = cache->projects[dir];
+      CachedSummary summary;
+      summary.json = json;
+      summary.used = QDateTime::currentMSecsSinceEpoch();
+      summaries.insert( key, summary );
+
+      while ( summaries.count() > MAX_CACHED_SUMMARIES )
+      {
+        auto oldest = summaries.begin();
+        for ( auto it = summaries.begin(); it != summaries.end(); ++it )
+        {
+          if ( it->used < oldest->used )
+            oldest = it;
+        }
+        summaries.erase( oldest );
+      }
+
+      saveProjectCache( dir );
+    }
+
+    cache->computed.wakeAll();
+  }
+
+  return json;
+}
+
+QString ChangesetSummaryService::cacheFilePath( const QString &projectDir )
+{
+  return projectDir + "/.mergin/changeset-summaries.json";
+}
+
+QString ChangesetSummaryService::cacheKey( const QString &baseChecksum, const QString &modifiedChecksum )
+{
+  return baseChecksum + ":" + modifiedChecksum;
+}
+
+void ChangesetSummaryService::loadProjectCache( const QString &projectDir )
+{
+  SummaryCache *cache = sCache();
+  if ( cache->loadedProjects.contains( projectDir ) )
+    return;
+
+  cache->loadedProjects.insert( projectDir );
+
+  QFile f( cacheFilePath( projectDir ) );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return;
+
+  QJsonDocument doc = QJsonDocument::fromJson( f.readAll() );
+  if ( !doc.isObject() || doc.object().value( QStringLiteral( "version" ) ).toInt() != CACHE_VERSION )
+    return;  // unknown or corrupted content - it gets overwritten on next save
+
+  QHash<QString, CachedSummary> &summaries = cache->projects[projectDir];
+  const QJsonObject obj = doc.object().value( QStringLiteral( "summaries" ) ).toObject();
+  for ( auto it = obj.constBegin(); it != obj.constEnd(); ++it )
+  {
+    QJsonObject entry = it.value().toObject();
+    CachedSummary summary;
+    summary.json = entry.value( QStringLiteral( "summary" ) ).toString();
+    summary.used = static_cast<qint64>( entry.value( QStringLiteral( "used" ) ).toDouble() );
+    if ( !summary.json.isEmpty() )
+      summaries.insert( it.key(), summary );
+  }
+}
+
+void ChangesetSummaryService::saveProjectCache( const QString &projectDir )
+{
+  if ( !QDir( projectDir + "/.mergin" ).exists() )
+    return;  // not a mergin project
+
+  QJsonObject obj;
+  const QHash<QString, CachedSummary> summaries = sCache()->projects.value( projectDir );
+  for ( auto it = summaries.constBegin(); it != summaries.constEnd(); ++it )
+  {
+    QJsonObject entry;
+    entry.insert( QStringLiteral( "summary" ), it->json );
+    entry.insert( QStringLiteral( "used" ), it->used );
+    obj.insert( it.key(), entry );
+  }
+
+  QJsonObject root;
+  root.insert( QStringLiteral( "version" ), CACHE_VERSION );
+  root.insert( QStringLiteral( "summaries" ), obj );
+
+  QSaveFile f( cacheFilePath( projectDir ) );
+  if ( !f.open( QIODevice::WriteOnly ) )
+  {
+    CoreUtils::log( "changeset summary", "Failed to open for writing: " + f.fileName() );
+    return;
+  }
+  f.write( QJsonDocument( root ).toJson( QJsonDocument::Compact ) );
+  if ( !f.commit() )
+    CoreUtils::log( "changeset summary", "Failed to write: " + f.fileName() );
+}
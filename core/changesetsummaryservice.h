@@ -0,0 +1,87 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CHANGESETSUMMARYSERVICE_H
+#define CHANGESETSUMMARYSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+/**
+ * Provides summaries of local pending changes of diffable files (see GeodiffUtils::diffableFilePendingChanges()).
+ *
+ * Creating a changeset of a large GeoPackage is expensive, so summaries are cached in memory and
+ * in the project's .mergin directory. The cache is keyed by checksums of the base file (the last
+ * synced version) and of the modified file, so a summary is reused until either of them changes.
+ * A summary that is being computed by one caller is never computed again by another one meanwhile.
+ *
+ * summaryJson() is a blocking variant (used when comparing project files), request() computes
+ * summaries of multiple files in parallel on the global thread pool and delivers them one by one
+ * with summaryReady() signal.
+ */
+class ChangesetSummaryService : public QObject
+{
+    Q_OBJECT
+
+  public:
+    struct Request
+    {
+      QString filePath;          //!< path of the diffable file within the project
+      QString baseChecksum;      //!< checksum of the file in the last synced version
+      QString modifiedChecksum;  //!< checksum of the local file
+    };
+
+    explicit ChangesetSummaryService( QObject *parent = nullptr );
+
+    /**
+     * Starts computation of summaries of given files of a project. Results of previous
+     * requests that have not been delivered yet are dropped.
+     */
+    void request( const QString &projectDir, const QList<Request> &requests );
+
+    //! Drops results of all pending requests
+    void cancel();
+
+    /**
+     * Returns JSON summary of local pending changes of a diffable file or a string starting with "ERROR".
+     * Blocks until the summary is available, can be called from any thread.
+     * If any of the checksums is empty, the summary is computed without using the cache.
+     */
+    static QString summaryJson( const QString &projectDir, const QString &filePath, const QString &baseChecksum, const QString &modifiedChecksum );
+
+    //! Returns path of the file with cached summaries for project in given directory
+    static QString cacheFilePath( const QString &projectDir );
+
+  signals:
+    //! Emitted when summary of a requested file is available (\a summaryJson starts with "ERROR" on failure)
+    void summaryReady( const QString &projectDir, const QString &filePath, const QString &summaryJson );
+
+    //! Emitted when summaries of all files of the last request have been delivered
+    void finished( const QString &projectDir );
+
+  private:
+    static QString cacheKey( const QString &baseChecksum, const QString &modifiedChecksum );
+
+    //! Reads cached summaries of a project from disk to memory (once per project), needs the cache mutex
+    static void loadProjectCache( const QString &projectDir );
+
+    //! Writes cached summaries of a project from memory to disk, needs the cache mutex
+    static void saveProjectCache( const QString &projectDir );
+
+    int mGeneration = 0;   //!< incremented with each request/cancel so that stale results can be dropped
+    int mPending = 0;      //!< number of results of the current request that have not been delivered yet
+    QString mProjectDir;
+
+    static const int CACHE_VERSION = 1;
+    static const int MAX_CACHED_SUMMARIES = 50;  //!< per project, least recently used are dropped first
+};
+
+#endif // CHANGESETSUMMARYSERVICE_H
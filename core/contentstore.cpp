@@ -0,0 +1,183 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "contentstore.h"
+
+#include <algorithm>
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QUuid>
+
+#include "coreutils.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+const qint64 ContentStore::DEFAULT_MAX_SIZE;
+
+//! Checksums come from the server - make sure they cannot point outside of the store
+static bool isValidChecksum( const QString &checksum )
+{
+  static const QRegularExpression re( QStringLiteral( "^[0-9a-f]{40}$" ) );
+  return re.match( checksum ).hasMatch();
+}
+
+ContentStore::ContentStore( const QString &storeDir, qint64 maxSize )
+  : mStoreDir( storeDir )
+  , mMaxSize( maxSize )
+{
+}
+
+bool ContentStore::contains( const QString &checksum ) const
+{
+  return isValidChecksum( checksum ) && QFile::exists( objectPath( checksum ) );
+}
+
+bool ContentStore::insert( const QString &checksum, const QString &filePath, bool canLink )
+{
+  if ( !isValidChecksum( checksum ) )
+    return false;
+
+  QString path = objectPath( checksum );
+  if ( QFile::exists( path ) )
+  {
+    touch( path );
+    return true;
+  }
+
+  QFileInfo info( filePath );
+  if ( !info.isFile() || info.size() > mMaxSize / 4 )
+    return false;
+
+  if ( !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
+    return false;
+
+  // an object must never be seen half-written - it gets its name once it is complete
+  QString partPath = path + "." + CoreUtils::uuidWithoutBraces( QUuid::createUuid() ) + ".part";
+  if ( !( canLink && createHardLink( filePath, partPath ) ) && !QFile::copy( filePath, partPath ) )
+  {
+    CoreUtils::log( "content store", "Failed to store " + filePath );
+    return false;
+  }
+
+  // another sync may have stored the same content meanwhile
+  if ( !QFile::rename( partPath, path ) )
+  {
+    QFile::remove( partPath );
+    return QFile::exists( path );
+  }
+
+  touch( path );
+  return true;
+}
+
+bool ContentStore::retrieve( const QString &checksum, const QString &destPath ) const
+{
+  if ( !contains( checksum ) )
+    return false;
+
+  QString path = objectPath( checksum );
+  if ( !createHardLink( path, destPath ) && !QFile::copy( path, destPath ) )
+    return false;
+
+  touch( path );
+  return true;
+}
+
+void ContentStore::remove( const QString &checksum )
+{
+  if ( isValidChecksum( checksum ) )
+    QFile::remove( objectPath( checksum ) );
+}
+
+void ContentStore::prune()
+{
+  struct Object
+  {
+    QString path;
+    qint64 size;
+    QDateTime lastUsed;
+  };
+
+  QList<Object> objects;
+  qint64 totalSize = 0;
+  QDateTime staleParts = QDateTime::currentDateTime().addDays( -1 );
+
+  QDirIterator it( mStoreDir, QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() )
+  {
+    it.next();
+    QFileInfo info = it.fileInfo();
+
+    // leftovers of inserts interrupted by a crash
+    if ( info.fileName().endsWith( QStringLiteral( ".part" ) ) )
+    {
+      if ( info.lastModified() < staleParts )
+        QFile::remove( info.filePath() );
+      continue;
+    }
+
+    objects << Object { info.filePath(), info.size(), info.lastModified() };
+    totalSize += info.size();
+  }
+
+  if ( totalSize <= mMaxSize )
+    return;
+
+  std::sort( objects.begin(), objects.end(), []( const Object & a, const Object & b )
+  {
+    return a.lastUsed < b.lastUsed;
+  } );
+
+  int removed = 0;
+  for ( const Object &object : qAsConst( objects ) )
+  {
+    if ( totalSize <= mMaxSize )
+      break;
+
+    if ( QFile::remove( object.path ) )
+    {
+      totalSize -= object.size;
+      ++removed;
+    }
+  }
+
+  CoreUtils::log( "content store", QStringLiteral( "Removed %1 least recently used objects, %2 bytes left" ).arg( removed ).arg( totalSize ) );
+}
+
+QString ContentStore::objectPath( const QString &checksum ) const
+{
+  // spread the objects in subdirectories, so that no directory gets too big
+  return mStoreDir + "/" + checksum.left( 2 ) + "/" + checksum;
+}
+
+void ContentStore::touch( const QString &path )
+{
+  QFile f( path );
+  if ( f.open( QIODevice::ReadWrite ) )
+    f.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+}
+
+bool ContentStore::createHardLink( const QString &targetPath, const QString &linkPath )
+{
+#ifdef Q_OS_WIN
+  return CreateHardLinkW( reinterpret_cast<LPCWSTR>( QDir::toNativeSeparators( linkPath ).utf16() ),
+                          reinterpret_cast<LPCWSTR>( QDir::toNativeSeparators( targetPath ).utf16() ), nullptr );
+#else
+  return ::link( QFile::encodeName( targetPath ).constData(), QFile::encodeName( linkPath ).constData() ) == 0;
+#endif
+}
@@ -0,0 +1,74 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CONTENTSTORE_H
+#define CONTENTSTORE_H
+
+#include <QString>
+
+/**
+ * Device-wide store of content of synced files, keyed by SHA1 checksum (the same checksum
+ * the server uses for project files). It lets a pull take files that are already somewhere
+ * on the device (the same photo in another project, a renamed file, a rolled-back version)
+ * instead of downloading them again.
+ *
+ * Objects are never written after they get stored, so they can be handed out as hard links.
+ * Project files are edited in place, so they are never linked into the store - only temp files
+ * of downloaded content are, other files get copied. The content of an object should still be
+ * verified by its user before it is relied on.
+ *
+ * The total size of the store is kept under a limit by removing the least recently used objects.
+ * All methods only work with the file system, so they may be called from worker threads.
+ */
+class ContentStore
+{
+  public:
+    //! Creates store in the given directory (created on the first insert)
+    ContentStore( const QString &storeDir, qint64 maxSize = DEFAULT_MAX_SIZE );
+
+    //! Whether there is an object for the checksum
+    bool contains( const QString &checksum ) const;
+
+    /**
+     * Adds content of \a filePath under \a checksum (the caller is responsible for the checksum being right).
+     * With \a canLink the file may become a hard link to the object, so it must never be modified afterwards.
+     * Files bigger than a quarter of the maximum size are not stored. Returns true if the object exists afterwards.
+     */
+    bool insert( const QString &checksum, const QString &filePath, bool canLink );
+
+    /**
+     * Writes the object for \a checksum to \a destPath (as a hard link if possible, otherwise as a copy).
+     * The destination must not be modified afterwards. Returns false if there is no such object.
+     */
+    bool retrieve( const QString &checksum, const QString &destPath ) const;
+
+    //! Removes the object for the checksum (e.g. when its content turns out to be damaged)
+    void remove( const QString &checksum );
+
+    //! Removes the least recently used objects until the store fits in the maximum size
+    void prune();
+
+    //! Returns path of the object for the checksum
+    QString objectPath( const QString &checksum ) const;
+
+    //! Default limit of the total size of the store in bytes
+    static const qint64 DEFAULT_MAX_SIZE = 512 * 1024 * 1024;
+
+  private:
+    //! Marks the object as recently used
+    static void touch( const QString &path );
+
+    //! Creates hard link \a linkPath to \a targetPath, returns false if the file system does not support it
+    static bool createHardLink( const QString &targetPath, const QString &linkPath );
+
+    QString mStoreDir;
+    qint64 mMaxSize;
+};
+
+#endif // CONTENTSTORE_H
@@ -1,6 +1,7 @@
 
 SOURCES += \
   $$PWD/coreutils.cpp \
+  $$PWD/logwriter.cpp \
   $$PWD/merginapi.cpp \
   $$PWD/merginapistatus.cpp \
   $$PWD/merginsubscriptioninfo.cpp \
@@ -12,10 +13,18 @@ SOURCES += \
   $$PWD/localprojectsmanager.cpp \
   $$PWD/merginprojectmetadata.cpp \
   $$PWD/project.cpp \
-  $$PWD/geodiffutils.cpp
+  $$PWD/geodiffutils.cpp \
+  $$PWD/uploadchunkdevice.cpp \
+  $$PWD/projectchecksumcache.cpp \
+  $$PWD/transactionjournal.cpp \
+  $$PWD/blockindex.cpp \
+  $$PWD/contentstore.cpp \
+  $$PWD/projectfilesscanner.cpp \
+  $$PWD/changesetsummaryservice.cpp
 
 HEADERS += \
   $$PWD/coreutils.h \
+  $$PWD/logwriter.h \
   $$PWD/merginapi.h \
   $$PWD/merginapistatus.h \
   $$PWD/merginsubscriptioninfo.h \
@@ -27,7 +36,14 @@ HEADERS += \
   $$PWD/localprojectsmanager.h \
   $$PWD/merginprojectmetadata.h \
   $$PWD/project.h \
-  $$PWD/geodiffutils.h
+  $$PWD/geodiffutils.h \
+  $$PWD/uploadchunkdevice.h \
+  $$PWD/projectchecksumcache.h \
+  $$PWD/transactionjournal.h \
+  $$PWD/blockindex.h \
+  $$PWD/contentstore.h \
+  $$PWD/projectfilesscanner.h \
+  $$PWD/changesetsummaryservice.h
 
 exists($$PWD/merginsecrets.cpp) {
   message("Using production Mergin API_KEYS")
@@ -18,6 +18,7 @@
 
 #include "qcoreapplication.h"
 #include "merginapi.h"
+#include "logwriter.h"
 
 const QString CoreUtils::LOG_TO_DEVNULL = QStringLiteral();
 const QString CoreUtils::LOG_TO_STDOUT = QStringLiteral( "TO_STDOUT" );
@@ -83,6 +84,7 @@ QString CoreUtils::downloadInProgressFilePath( const QString &projectDir )
 
 void CoreUtils::setLogFilename( const QString &value )
 {
+  flushLog();
   sLogFile = value;
 }
 
@@ -111,18 +113,17 @@ void CoreUtils::appendLog( const QByteArray &data, const QString &path )
     else
     {
       qDebug() << data;
-      QFile file( path );
-      if ( path.isEmpty() || !file.open( QIODevice::Append ) )
-      {
-        qDebug() << "ERROR: Invalid log file";
-        return;
-      }
-      file.write( data );
-      file.close();
+      LogWriter::instance()->append( data, path );
     }
   }
 }
 
+void CoreUtils::flushLog()
+{
+  if ( sLogFile != LOG_TO_DEVNULL && sLogFile != LOG_TO_STDOUT )
+    LogWriter::instance()->flush();
+}
+
 QDateTime CoreUtils::getLastModifiedFileDateTime( const QString &path )
 {
   QDateTime lastModified;
@@ -68,10 +68,16 @@ class CoreUtils
     /**
      * Add a log entry to internal log text file
      *
+     * Entries are written to the file in background, use flushLog() before reading the file.
+     * The log is flushed when the app quits or goes to background, entries still queued on a crash are lost.
+     *
      * \see setLogFilename()
      */
     static void log( const QString &topic, const QString &info );
 
+    //! Writes all log entries that have not been written to the log file yet
+    static void flushLog();
+
   private:
     static QString sLogFile;
     static void appendLog( const QByteArray &data, const QString &path );
@@ -14,8 +14,10 @@
 #include <QJsonObject>
 #include <QTemporaryFile>
 #include <QUuid>
+#include <QVector>
 
 #include <geodiff.h>
+#include "changesetsummaryservice.h"
 #include "coreutils.h"
 
 
@@ -64,9 +66,9 @@ int GeodiffUtils::createChangeset( const QString &projectDir, const QString &fil
 }
 
 
-bool GeodiffUtils::hasPendingChanges( const QString &projectDir, const QString &filePath )
+bool GeodiffUtils::hasPendingChanges( const QString &projectDir, const QString &filePath, const QString &baseChecksum, const QString &modifiedChecksum )
 {
-  QString summaryJson = GeodiffUtils::diffableFilePendingChanges( projectDir, filePath, true );
+  QString summaryJson = ChangesetSummaryService::summaryJson( projectDir, filePath, baseChecksum, modifiedChecksum );
   if ( summaryJson.startsWith( "ERROR" ) )
     return true;  // something went wrong - let's assume the file has changed
 
@@ -112,6 +114,32 @@ bool GeodiffUtils::applyDiffs( const QString &src, const QStringList &diffFiles
   return true;
 }
 
+QString GeodiffUtils::concatDiffs( const QStringList &diffFiles, const QString &scratchDir )
+{
+  if ( diffFiles.isEmpty() )
+    return QString();
+
+  if ( diffFiles.count() == 1 )
+    return diffFiles.first();
+
+  QList<QByteArray> inputs;
+  QVector<const char *> inputPtrs;
+  for ( const QString &diffFile : diffFiles )
+    inputs << diffFile.toUtf8();
+  for ( const QByteArray &input : inputs )
+    inputPtrs << input.constData();
+
+  QString output = scratchDir + "/" + CoreUtils::uuidWithoutBraces( QUuid::createUuid() ) + "-concat.diff";
+  int res = GEODIFF_concatChanges( inputPtrs.count(), inputPtrs.data(), output.toUtf8().constData() );
+  if ( res != GEODIFF_SUCCESS )
+  {
+    CoreUtils::log( "GEODIFF", QStringLiteral( "concat of %1 changesets failed" ).arg( diffFiles.count() ) );
+    QFile::remove( output );
+    return QString();
+  }
+  return output;
+}
+
 void GeodiffUtils::log( GEODIFF_LoggerLevel level, const char *msg )
 {
   QString prefix;
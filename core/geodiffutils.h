@@ -39,8 +39,12 @@ class GeodiffUtils
 
     typedef QMap<QString, TableSummary> ChangesetSummary;
 
-    //! Tests whether the file has changed according to geodiff compared to the original server version
-    static bool hasPendingChanges( const QString &projectDir, const QString &filePath );
+    /**
+     * Tests whether the file has changed according to geodiff compared to the original server version.
+     * When checksums of the original and the local file are passed, the result is looked up in ChangesetSummaryService cache.
+     */
+    static bool hasPendingChanges( const QString &projectDir, const QString &filePath,
+                                   const QString &baseChecksum = QString(), const QString &modifiedChecksum = QString() );
 
     //! Takes JSON changeset summary string and parses it
     static ChangesetSummary parseChangesetSummary( const QString &json );
@@ -58,6 +62,13 @@ class GeodiffUtils
     //! Takes "src" file and applies a sequence of changesets for the list in "diffFiles"
     static bool applyDiffs( const QString &src, const QStringList &diffFiles );
 
+    /**
+     * Concatenates a sequence of changesets to a single changeset in "scratchDir", so that they can be
+     * applied to a file in one pass. Returns path of the new changeset (or of the only changeset if there
+     * is just one) or an empty string on failure.
+     */
+    static QString concatDiffs( const QStringList &diffFiles, const QString &scratchDir );
+
     //! Geodiff logger callback function used to forward logs to Input.
     static void log( GEODIFF_LoggerLevel level, const char *msg );
 };
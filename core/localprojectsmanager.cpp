@@ -15,21 +15,60 @@
 
 #include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
+#include <QtConcurrent>
 
-LocalProjectsManager::LocalProjectsManager( const QString &dataDir )
+LocalProjectsManager::LocalProjectsManager( const QString &dataDir, bool loadInBackground )
   : mDataDir( dataDir )
 {
-  reloadDataDir();
+  connect( &mScanWatcher, &QFutureWatcher<LocalProjectsList>::finished, this, &LocalProjectsManager::dataDirScanned );
+
+  if ( loadInBackground )
+    reloadDataDirInBackground();
+  else
+    reloadDataDir();
+}
+
+LocalProjectsManager::~LocalProjectsManager()
+{
+  mScanWatcher.waitForFinished();
 }
 
 void LocalProjectsManager::reloadDataDir()
 {
-  mProjects.clear();
-  QStringList entryList = QDir( mDataDir ).entryList( QDir::NoDotAndDotDot | QDir::Dirs );
+  // a scan running in background is outdated now
+  ++mScanGeneration;
+  mScanning = false;
+  mRescanRequested = false;
+  mChangedDuringScan.clear();
+
+  setProjects( scanDataDir( mDataDir ) );
+}
+
+void LocalProjectsManager::reloadDataDirInBackground()
+{
+  ++mScanGeneration;
+  if ( mScanning )
+  {
+    // files may have changed after the running scan has passed them
+    mRescanRequested = true;
+    return;
+  }
+
+  startScan();
+}
+
+LocalProjectsList LocalProjectsManager::scanDataDir( const QString &dataDir )
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  LocalProjectsList projects;
+  QStringList entryList = QDir( dataDir ).entryList( QDir::NoDotAndDotDot | QDir::Dirs );
   for ( const QString &folderName : entryList )
   {
     LocalProject info;
-    info.projectDir = mDataDir + "/" + folderName;
+    info.projectDir = dataDir + "/" + folderName;
     info.qgisProjectFilePath = findQgisProjectFile( info.projectDir, info.projectError );
 
     MerginProjectMetadata metadata = MerginProjectMetadata::fromCachedJson( info.projectDir + "/" + MerginApi::sMetadataFile );
@@ -44,14 +83,64 @@ void LocalProjectsManager::reloadDataDir()
       info.projectName = folderName;
     }
 
-    mProjects << info;
+    projects << info;
   }
 
-  QString msg = QString( "Found %1 local projects in %2" ).arg( mProjects.size() ).arg( mDataDir );
+  QString msg = QString( "Found %1 local projects in %2 (%3 ms)" ).arg( projects.size() ).arg( dataDir ).arg( timer.elapsed() );
   CoreUtils::log( "Local projects", msg );
+  return projects;
+}
+
+void LocalProjectsManager::startScan()
+{
+  mScanning = true;
+  mRescanRequested = false;
+  mRunningScanGeneration = mScanGeneration;
+  mScanWatcher.setFuture( QtConcurrent::run( &LocalProjectsManager::scanDataDir, mDataDir ) );
+}
+
+void LocalProjectsManager::dataDirScanned()
+{
+  if ( mRunningScanGeneration != mScanGeneration )
+  {
+    if ( mRescanRequested )
+      startScan();
+    return;
+  }
+
+  mScanning = false;
+
+  // projects added, removed or updated during the scan are already up to date in mProjects
+  LocalProjectsList projects;
+  const LocalProjectsList scanned = mScanWatcher.result();
+  for ( const LocalProject &project : scanned )
+  {
+    if ( !mChangedDuringScan.contains( project.projectDir ) )
+      projects << project;
+  }
+  for ( const LocalProject &project : qAsConst( mProjects ) )
+  {
+    if ( mChangedDuringScan.contains( project.projectDir ) )
+      projects << project;
+  }
+  mChangedDuringScan.clear();
+
+  setProjects( projects );
+}
+
+void LocalProjectsManager::setProjects( const LocalProjectsList &projects )
+{
+  mProjects = projects;
+  mLoaded = true;
   emit dataDirReloaded();
 }
 
+void LocalProjectsManager::projectChanged( const QString &projectDir )
+{
+  if ( mScanning )
+    mChangedDuringScan.insert( projectDir );
+}
+
 LocalProject LocalProjectsManager::projectFromDirectory( const QString &projectDir ) const
 {
   for ( const LocalProject &info : mProjects )
@@ -104,6 +193,7 @@ void LocalProjectsManager::removeLocalProject( const QString &projectId )
     if ( mProjects[i].id() == projectId )
     {
       emit aboutToRemoveLocalProject( mProjects[i] );
+      projectChanged( mProjects[i].projectDir );
 
       CoreUtils::removeDir( mProjects[i].projectDir );
       mProjects.removeAt( i );
@@ -144,6 +234,7 @@ void LocalProjectsManager::updateLocalVersion( const QString &projectDir, int ve
     if ( mProjects[i].projectDir == projectDir )
     {
       mProjects[i].localVersion = version;
+      projectChanged( projectDir );
 
       emit localProjectDataChanged( mProjects[i] );
       return;
@@ -159,6 +250,7 @@ void LocalProjectsManager::updateNamespace( const QString &projectDir, const QSt
     if ( mProjects[i].projectDir == projectDir )
     {
       mProjects[i].projectNamespace = projectNamespace;
+      projectChanged( projectDir );
 
       emit localProjectDataChanged( mProjects[i] );
       return;
@@ -212,6 +304,18 @@ void LocalProjectsManager::addProject( const QString &projectDir, const QString
   project.projectName = projectName;
   project.projectNamespace = projectNamespace;
 
+  // the directory may be already known from a scan, e.g. left by an interrupted download that has been resumed now
+  for ( int i = 0; i < mProjects.count(); ++i )
+  {
+    if ( mProjects[i].projectDir == projectDir )
+    {
+      emit aboutToRemoveLocalProject( mProjects[i] );
+      mProjects.removeAt( i );
+      break;
+    }
+  }
+
   mProjects << project;
+  projectChanged( projectDir );
   emit localProjectAdded( project );
 }
@@ -11,17 +11,35 @@
 #define LOCALPROJECTSMANAGER_H
 
 #include <QObject>
+#include <QFutureWatcher>
+#include <QSet>
 #include <project.h>
 
 class LocalProjectsManager : public QObject
 {
     Q_OBJECT
+
+    //! Whether the data dir has been scanned, the projects are not known until then
+    Q_PROPERTY( bool loaded READ isLoaded NOTIFY dataDirReloaded )
+
   public:
-    explicit LocalProjectsManager( const QString &dataDir );
+    /**
+     * Creates manager of projects in \a dataDir. The directory is scanned right away,
+     * either synchronously or, with \a loadInBackground, on a worker thread -
+     * dataDirReloaded() is emitted once the projects are known.
+     */
+    explicit LocalProjectsManager( const QString &dataDir, bool loadInBackground = false );
+    ~LocalProjectsManager() override;
 
     //! Loads all projects from mDataDir, removes all old projects
     void reloadDataDir();
 
+    //! Loads all projects from mDataDir on a worker thread, dataDirReloaded() is emitted when done
+    void reloadDataDirInBackground();
+
+    //! Returns true once the data dir has been scanned
+    bool isLoaded() const { return mLoaded; }
+
     QString dataDir() const { return mDataDir; }
 
     LocalProjectsList projects() const { return mProjects; }
@@ -52,7 +70,10 @@ class LocalProjectsManager : public QObject
     void updateNamespace( const QString &projectDir, const QString &projectNamespace );
 
     //! Finds all QGIS project files and set the err variable if any occured.
-    QString findQgisProjectFile( const QString &projectDir, QString &err );
+    static QString findQgisProjectFile( const QString &projectDir, QString &err );
+
+    //! Returns projects found in \a dataDir, reads only the files, so it can run on any thread
+    static LocalProjectsList scanDataDir( const QString &dataDir );
 
   signals:
     void projectMetadataChanged( const QString &projectDir );
@@ -62,11 +83,27 @@ class LocalProjectsManager : public QObject
     void localProjectDataChanged( const LocalProject &project );
     void dataDirReloaded();
 
+  private slots:
+    void dataDirScanned();
+
   private:
     void addProject( const QString &projectDir, const QString &projectNamespace, const QString &projectName );
+    void startScan();
+    void setProjects( const LocalProjectsList &projects );
+
+    //! Remembers project changed while the data dir is scanned, its entry is not replaced by the scanned one
+    void projectChanged( const QString &projectDir );
 
     QString mDataDir;   //!< directory with all local projects
     LocalProjectsList mProjects;
+    bool mLoaded = false;
+
+    QFutureWatcher<LocalProjectsList> mScanWatcher;
+    int mScanGeneration = 0; //!< increased by every reload, so results of outdated scans are ignored
+    int mRunningScanGeneration = 0;
+    bool mScanning = false; //!< true until the result of the last started scan is applied
+    bool mRescanRequested = false;
+    QSet<QString> mChangedDuringScan;
 };
 
 
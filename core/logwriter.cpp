@@ -0,0 +1,161 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "logwriter.h"
+
+#include <utility>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QMutexLocker>
+
+LogWriter *LogWriter::instance()
+{
+  // destroyed at exit, which writes the remaining entries
+  static LogWriter sWriter;
+  return &sWriter;
+}
+
+QString LogWriter::rotatedFilePath( const QString &path )
+{
+  return path + QStringLiteral( ".1" );
+}
+
+LogWriter::LogWriter()
+{
+  start( QThread::LowPriority );
+}
+
+LogWriter::~LogWriter()
+{
+  {
+    QMutexLocker locker( &mMutex );
+    mStopping = true;
+  }
+  mWakeUp.wakeOne();
+  wait();
+
+  flush();
+}
+
+void LogWriter::append( const QByteArray &data, const QString &path )
+{
+  bool wakeUp = false;
+  {
+    QMutexLocker locker( &mMutex );
+
+    if ( path != mBufferPath && !mBuffer.isEmpty() )
+    {
+      // entries buffered so far belong to the previous log file
+      locker.unlock();
+      flush();
+      locker.relock();
+    }
+    mBufferPath = path;
+
+    if ( mBuffer.size() + data.size() > MAX_BUFFER_SIZE )
+    {
+      ++mDroppedCount;
+      return;
+    }
+
+    mBuffer.append( data );
+    wakeUp = mBuffer.size() >= BATCH_SIZE;
+  }
+
+  if ( wakeUp )
+    mWakeUp.wakeOne();
+}
+
+void LogWriter::flush()
+{
+  // the file is locked first, so batches taken from the buffer are written in order
+  QMutexLocker writeLocker( &mWriteMutex );
+
+  QByteArray data;
+  QString path;
+  int droppedCount = 0;
+  {
+    QMutexLocker locker( &mMutex );
+    data.swap( mBuffer );
+    path = mBufferPath;
+    std::swap( droppedCount, mDroppedCount );
+  }
+
+  if ( droppedCount > 0 )
+  {
+    data.append( QStringLiteral( "%1 LogWriter: %2 log entries dropped, logging is too fast\n" )
+                 .arg( QDateTime::currentDateTimeUtc().toString( Qt::ISODateWithMs ) ).arg( droppedCount ).toUtf8() );
+  }
+
+  if ( !data.isEmpty() )
+    writeBuffer( data, path );
+}
+
+void LogWriter::setMaxFileSize( qint64 maxFileSize )
+{
+  QMutexLocker writeLocker( &mWriteMutex );
+  mMaxFileSize = maxFileSize;
+}
+
+void LogWriter::run()
+{
+  while ( true )
+  {
+    {
+      QMutexLocker locker( &mMutex );
+      if ( !mStopping && mBuffer.size() < BATCH_SIZE )
+        mWakeUp.wait( &mMutex, FLUSH_INTERVAL_MS );
+      if ( mStopping )
+        return;
+    }
+
+    flush();
+  }
+}
+
+void LogWriter::writeBuffer( const QByteArray &data, const QString &path )
+{
+  if ( path.isEmpty() )
+    return;
+
+  if ( mFile.fileName() != path )
+  {
+    mFile.close();
+    mFile.setFileName( path );
+  }
+
+  if ( !mFile.isOpen() && !mFile.open( QIODevice::Append ) )
+  {
+    qDebug() << "ERROR: Invalid log file";
+    return;
+  }
+
+  if ( mFile.size() > 0 && mFile.size() + data.size() > mMaxFileSize )
+  {
+    rotate();
+    if ( !mFile.open( QIODevice::Append ) )
+    {
+      qDebug() << "ERROR: Invalid log file";
+      return;
+    }
+  }
+
+  mFile.write( data );
+  mFile.flush();
+}
+
+void LogWriter::rotate()
+{
+  const QString path = mFile.fileName();
+  mFile.close();
+
+  QFile::remove( rotatedFilePath( path ) );
+  QFile::rename( path, rotatedFilePath( path ) );
+}
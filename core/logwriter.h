@@ -0,0 +1,86 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+/**
+ * Writes entries of the text log file on a background thread, used by CoreUtils::log.
+ *
+ * Callers only append the entry to a memory buffer. The writer thread writes the buffer
+ * in batches (when enough data is collected or every FLUSH_INTERVAL_MS) to the log file,
+ * which stays open between batches. The buffer is bounded - entries that do not fit in it
+ * are dropped and the number of dropped entries is written to the log instead.
+ *
+ * When the log file grows over the maximum size, it is renamed to rotatedFilePath()
+ * (replacing the previous one) and a new file is started.
+ *
+ * The buffer is written on flush() and when the writer is destroyed at exit. There is no crash
+ * handler - the buffer cannot be written in an async-signal-safe way - so a crash may lose
+ * the entries of the last FLUSH_INTERVAL_MS.
+ */
+class LogWriter : public QThread
+{
+  public:
+    //! Maximum size of the log file before it is rotated
+    static const qint64 MAX_FILE_SIZE = 2 * 1024 * 1024;
+    //! Size of the buffered entries that wakes up the writer
+    static const int BATCH_SIZE = 16 * 1024;
+    //! Maximum size of the buffered entries, further entries are dropped
+    static const int MAX_BUFFER_SIZE = 4 * 1024 * 1024;
+    //! Longest time entries stay in the buffer
+    static const int FLUSH_INTERVAL_MS = 1000;
+
+    //! Returns the writer used by CoreUtils::log, starting it if needed
+    static LogWriter *instance();
+
+    //! Returns path of the file with older entries of the log file at \a path
+    static QString rotatedFilePath( const QString &path );
+
+    ~LogWriter() override;
+
+    //! Adds \a data to the log file at \a path
+    void append( const QByteArray &data, const QString &path );
+
+    //! Writes all buffered entries to the log file, blocks until they are written
+    void flush();
+
+    //! Sets maximum size of the log file before rotation, MAX_FILE_SIZE by default
+    void setMaxFileSize( qint64 maxFileSize );
+
+  protected:
+    void run() override;
+
+  private:
+    LogWriter();
+
+    //! Writes buffered data to the file, must be called with mWriteMutex locked
+    void writeBuffer( const QByteArray &data, const QString &path );
+    void rotate();
+
+    QMutex mMutex; //!< guards the buffer, held only to append or take the data
+    QWaitCondition mWakeUp;
+    QByteArray mBuffer;
+    QString mBufferPath;
+    int mDroppedCount = 0;
+    bool mStopping = false;
+
+    QMutex mWriteMutex; //!< guards the file, held while writing
+    QFile mFile;
+    qint64 mMaxFileSize = MAX_FILE_SIZE;
+};
+
+#endif // LOGWRITER_H
@@ -18,6 +18,7 @@
 #include <QSet>
 #include <QUuid>
 #include <QtMath>
+#include <QtConcurrent>
 
 #include "coreutils.h"
 #include "geodiffutils.h"
@@ -25,6 +26,10 @@
 #include "merginuserauth.h"
 #include "merginuserinfo.h"
 #include "merginsubscriptioninfo.h"
+#include "uploadchunkdevice.h"
+#include "projectchecksumcache.h"
+#include "projectfilesscanner.h"
+#include "transactionjournal.h"
 
 #include <geodiff.h>
 
@@ -33,10 +38,39 @@ const QString MerginApi::sMerginConfigFile = QStringLiteral( "mergin-config.json
 const QString MerginApi::sDefaultApiRoot = QStringLiteral( "https://public.cloudmergin.com/" );
 const QSet<QString> MerginApi::sIgnoreExtensions = QSet<QString>() << "gpkg-shm" << "gpkg-wal" << "qgs~" << "qgz~" << "pyc" << "swap";
 const QSet<QString> MerginApi::sIgnoreImageExtensions = QSet<QString>() << "jpg" << "jpeg" << "png";
+const QSet<QString> MerginApi::sCompressedExtensions = QSet<QString>() << "jpg" << "jpeg" << "png" << "gif" << "webp" << "heic"
+    << "mp3" << "m4a" << "mp4" << "mov" << "zip" << "gz" << "bz2" << "xz" << "7z" << "qgz" << "kmz" << "mbtiles";
 const QSet<QString> MerginApi::sIgnoreFiles = QSet<QString>() << "mergin.json" << ".DS_Store";
 const int MerginApi::UPLOAD_CHUNK_SIZE = 10 * 1024 * 1024; // Should be the same as on Mergin server
 
 
+static MerginFile findFile( const QString &filePath, const QList<MerginFile> &files )
+{
+  for ( const MerginFile &merginFile : files )
+  {
+    if ( merginFile.path == filePath )
+      return merginFile;
+  }
+  qDebug() << "requested findFile() for non-existant file! " << filePath;
+  return MerginFile();
+}
+
+//! Keeps the synced \a content in the \a store within its size, it is called on a worker thread
+static void storeContent( ContentStore store, const QList<StoredContent> &content )
+{
+  bool contentStored = false;
+  for ( const StoredContent &item : content )
+  {
+    contentStored |= store.insert( item.checksum, item.filePath, item.isTempFile );
+    if ( item.isTempFile )
+      QFile::remove( item.filePath );
+  }
+
+  if ( contentStored )
+    store.prune();
+}
+
+
 MerginApi::MerginApi( LocalProjectsManager &localProjects, QObject *parent )
   : QObject( parent )
   , mLocalProjects( localProjects )
@@ -137,7 +171,7 @@ QString MerginApi::listProjectsByName( const QStringList &projectNames )
 
   QString requestId = CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
 
-  QNetworkReply *reply = mManager.post( request, body.toJson() );
+  QNetworkReply *reply = mManager.post( request, compressRequestBody( request, body.toJson() ) );
   CoreUtils::log( "list projects by name", QStringLiteral( "Requesting: " ) + url.toString() );
   connect( reply, &QNetworkReply::finished, this, [this, requestId]() {this->listProjectsByNameReplyFinished( requestId );} );
 
@@ -152,40 +186,88 @@ void MerginApi::downloadNextItem( const QString &projectFullName )
 
   if ( transaction.downloadQueue.isEmpty() )
   {
-    // there's nothing to download so just finalize the update
-    finalizeProjectUpdate( projectFullName );
+    // there's nothing more to request - finalize the update once all pending requests are done
+    if ( transaction.replyPullItems.isEmpty() )
+      finalizeProjectUpdate( projectFullName );
     return;
   }
 
-  DownloadQueueItem item = transaction.downloadQueue.takeFirst();
+  // keep several requests in flight so that the pull is limited by bandwidth rather than by round-trip time.
+  // Each item is stored to its own temp file, so the order in which the replies arrive does not matter
+  while ( !transaction.downloadQueue.isEmpty() && transaction.replyPullItems.count() < mMaxParallelDownloads )
+  {
+    DownloadQueueItem item = transaction.downloadQueue.takeFirst();
 
-  QUrl url( mApiRoot + QStringLiteral( "/v1/project/raw/" ) + projectFullName );
-  QUrlQuery query;
-  // Handles special chars in a filePath (e.g prevents to convert "+" sign into a space)
-  query.addQueryItem( "file", item.filePath.toUtf8().toPercentEncoding() );
-  query.addQueryItem( "version", QStringLiteral( "v%1" ).arg( item.version ) );
-  if ( item.downloadDiff )
-    query.addQueryItem( "diff", "true" );
-  url.setQuery( query );
+    QUrl url( mApiRoot + QStringLiteral( "/v1/project/raw/" ) + projectFullName );
+    QUrlQuery query;
+    // Handles special chars in a filePath (e.g prevents to convert "+" sign into a space)
+    query.addQueryItem( "file", item.filePath.toUtf8().toPercentEncoding() );
+    query.addQueryItem( "version", QStringLiteral( "v%1" ).arg( item.version ) );
+    if ( item.downloadDiff )
+      query.addQueryItem( "diff", "true" );
+    url.setQuery( query );
 
-  QNetworkRequest request = getDefaultRequest();
-  request.setUrl( url );
-  request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ), projectFullName );
-  request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrTempFileName ), item.tempFileName );
+    QNetworkRequest request = getDefaultRequest();
+    request.setUrl( url );
+    request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ), projectFullName );
+    request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrTempFileName ), item.tempFileName );
+
+    // other requests (e.g. diffs) let Qt negotiate a compressed response and decompress it as it arrives
+    QString range;
+    if ( item.rangeFrom != -1 && item.rangeTo != -1 )
+    {
+      range = QStringLiteral( "bytes=%1-%2" ).arg( item.rangeFrom ).arg( item.rangeTo );
+      request.setRawHeader( "Range", range.toUtf8() );
+      // a range of a compressed response would be a range of the compressed data
+      request.setRawHeader( "Accept-Encoding", "identity" );
+    }
+
+    QString tempFilePath = getTempProjectDir( projectFullName ) + "/" + item.tempFileName;
+    createPathIfNotExists( tempFilePath );
+
+    DownloadItemFile itemFile;
+    itemFile.file = std::make_shared<QFile>( tempFilePath );
+    itemFile.hash = std::make_shared<QCryptographicHash>( QCryptographicHash::Sha1 );
+    itemFile.failed = !itemFile.file->open( QIODevice::WriteOnly );
+
+    QNetworkReply *reply = mManager.get( request );
+    transaction.replyPullItems.insert( reply, item );
+    transaction.pullItemFiles.insert( reply, itemFile );
+    connect( reply, &QNetworkReply::readyRead, this, &MerginApi::downloadItemReadyRead );
+    connect( reply, &QNetworkReply::finished, this, &MerginApi::downloadItemReplyFinished );
 
-  QString range;
-  if ( item.rangeFrom != -1 && item.rangeTo != -1 )
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Requesting item: " ) + url.toString() +
+                    ( !range.isEmpty() ? " Range: " + range : QString() ) );
+  }
+}
+
+void MerginApi::abortPendingDownloads( TransactionStatus &transaction )
+{
+  const QList<QNetworkReply *> replies = transaction.replyPullItems.keys();
+  transaction.replyPullItems.clear();
+
+  for ( QNetworkReply *reply : replies )
   {
-    range = QStringLiteral( "bytes=%1-%2" ).arg( item.rangeFrom ).arg( item.rangeTo );
-    request.setRawHeader( "Range", range.toUtf8() );
+    // we are not interested in the result anymore - make sure the slots are not triggered by abort()
+    disconnect( reply, &QNetworkReply::readyRead, this, &MerginApi::downloadItemReadyRead );
+    disconnect( reply, &QNetworkReply::finished, this, &MerginApi::downloadItemReplyFinished );
+    reply->abort();
+    reply->deleteLater();
   }
 
-  Q_ASSERT( !transaction.replyDownloadItem );
-  transaction.replyDownloadItem = mManager.get( request );
-  connect( transaction.replyDownloadItem, &QNetworkReply::finished, this, &MerginApi::downloadItemReplyFinished );
+  // incomplete items are not in the journal, nobody would use them
+  for ( const DownloadItemFile &itemFile : qAsConst( transaction.pullItemFiles ) )
+    itemFile.file->remove();
+  transaction.pullItemFiles.clear();
+}
 
-  CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Requesting item: " ) + url.toString() +
-                  ( !range.isEmpty() ? " Range: " + range : QString() ) );
+void MerginApi::writeDownloadedData( QNetworkReply *reply, DownloadItemFile &itemFile )
+{
+  QByteArray data = reply->readAll();
+  itemFile.size += data.size();
+  itemFile.hash->addData( data );
+  if ( !itemFile.failed && itemFile.file->write( data ) != data.size() )
+    itemFile.failed = true;
 }
 
 void MerginApi::removeProjectsTempFolder( const QString &projectNamespace, const QString &projectName )
@@ -230,6 +312,37 @@ bool MerginApi::hasProjecFileExtension( const QString filePath )
   return filePath.contains( ".qgs" ) || filePath.contains( ".qgz" );
 }
 
+bool MerginApi::isFileCompressed( const QString &fileName )
+{
+  return sCompressedExtensions.contains( QFileInfo( fileName ).suffix().toLower() );
+}
+
+QByteArray MerginApi::compressRequestBody( QNetworkRequest &request, const QByteArray &body, const QString &filePath ) const
+{
+  if ( !mApiSupportsCompression || ( !filePath.isEmpty() && isFileCompressed( filePath ) ) )
+    return body;
+
+  QByteArray compressed = deflateBody( body );
+  if ( compressed.isNull() )
+    return body;
+
+  request.setRawHeader( "Content-Encoding", "deflate" );
+  return compressed;
+}
+
+QByteArray MerginApi::deflateBody( const QByteArray &body )
+{
+  if ( body.size() < COMPRESSION_MIN_SIZE )
+    return QByteArray();
+
+  // "deflate" content coding is the zlib format - that is qCompress() output without its 4 bytes with the original size
+  QByteArray compressed = qCompress( body ).mid( 4 );
+  if ( compressed.size() * 100 > body.size() * ( 100 - COMPRESSION_MIN_SAVING_PERCENT ) )
+    return QByteArray();
+
+  return compressed;
+}
+
 bool MerginApi::supportsSelectiveSync() const
 {
   return mSupportsSelectiveSync;
@@ -240,6 +353,41 @@ void MerginApi::setSupportsSelectiveSync( bool supportsSelectiveSync )
   mSupportsSelectiveSync = supportsSelectiveSync;
 }
 
+int MerginApi::maxParallelDownloads() const
+{
+  return mMaxParallelDownloads;
+}
+
+void MerginApi::setMaxParallelDownloads( int maxParallelDownloads )
+{
+  mMaxParallelDownloads = qMax( 1, maxParallelDownloads );
+}
+
+int MerginApi::maxParallelUploads() const
+{
+  return mMaxParallelUploads;
+}
+
+void MerginApi::setMaxParallelUploads( int maxParallelUploads )
+{
+  mMaxParallelUploads = qMax( 1, maxParallelUploads );
+}
+
+qint64 MerginApi::contentStoreMaxSize() const
+{
+  return mContentStoreMaxSize;
+}
+
+void MerginApi::setContentStoreMaxSize( qint64 contentStoreMaxSize )
+{
+  mContentStoreMaxSize = qMax( qint64( 0 ), contentStoreMaxSize );
+}
+
+ContentStore MerginApi::contentStore() const
+{
+  return ContentStore( mDataDir + "/" + CONTENT_STORE_FOLDER, mContentStoreMaxSize );
+}
+
 bool MerginApi::apiSupportsSubscriptions() const
 {
   return mApiSupportsSubscriptions;
@@ -270,6 +418,25 @@ QString MerginApi::getApiKey( const QString &serverName )
   return "not-secret-key";
 }
 
+void MerginApi::downloadItemReadyRead()
+{
+  QNetworkReply *r = qobject_cast<QNetworkReply *>( sender() );
+  Q_ASSERT( r );
+
+  // the body of an error response is read once the request is finished
+  if ( r->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt() >= 400 )
+    return;
+
+  QString projectFullName = r->request().attribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ) ).toString();
+  if ( !mTransactionalStatus.contains( projectFullName ) )
+    return;
+
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+  auto it = transaction.pullItemFiles.find( r );
+  if ( it != transaction.pullItemFiles.end() )
+    writeDownloadedData( r, it.value() );
+}
+
 void MerginApi::downloadItemReplyFinished()
 {
   QNetworkReply *r = qobject_cast<QNetworkReply *>( sender() );
@@ -280,37 +447,50 @@ void MerginApi::downloadItemReplyFinished()
 
   Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
   TransactionStatus &transaction = mTransactionalStatus[projectFullName];
-  Q_ASSERT( r == transaction.replyDownloadItem );
+  Q_ASSERT( transaction.replyPullItems.contains( r ) );
+
+  DownloadQueueItem item = transaction.replyPullItems.take( r );
+  DownloadItemFile itemFile = transaction.pullItemFiles.take( r );
+  r->deleteLater();
 
   if ( r->error() == QNetworkReply::NoError )
   {
-    QByteArray data = r->readAll();
+    // the rest of the data that have not been written by downloadItemReadyRead()
+    writeDownloadedData( r, itemFile );
 
-    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Downloaded item (%1 bytes)" ).arg( data.size() ) );
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Downloaded item (%1 bytes)" ).arg( itemFile.size ) );
 
-    QString tempFolder = getTempProjectDir( projectFullName );
-    QString tempFilePath = tempFolder + "/" + tempFileName;
-    createPathIfNotExists( tempFilePath );
-
-    // save to a tmp file, assemble at the end
-    QFile file( tempFilePath );
-    if ( file.open( QIODevice::WriteOnly ) )
+    if ( !itemFile.failed && itemFile.file->flush() )
     {
-      file.write( data );
-      file.close();
+      itemFile.file->close();
+
+      // remember the item so that an interrupted pull does not need to download it again
+      if ( transaction.journal )
+      {
+        QByteArray checksum = itemFile.hash->result().toHex();
+        transaction.journal->appendDownloadedItem( item.key(), tempFileName, QString::fromLatin1( checksum ) );
+      }
     }
     else
     {
-      CoreUtils::log( "pull " + projectFullName, "Failed to open for writing: " + file.fileName() );
+      CoreUtils::log( "pull " + projectFullName, "Failed to open for writing: " + itemFile.file->fileName() );
     }
 
-    transaction.transferedSize += data.size();
+    transaction.transferedSize += itemFile.size;
     emit syncProjectStatusChanged( projectFullName, transaction.transferedSize / transaction.totalSize );
 
-    transaction.replyDownloadItem->deleteLater();
-    transaction.replyDownloadItem = nullptr;
+    int pendingItems = transaction.pullItemsPending.value( item.filePath ) - 1;
+    if ( pendingItems <= 0 )
+    {
+      transaction.pullItemsPending.remove( item.filePath );
+      CoreUtils::log( "pull " + projectFullName, QStringLiteral( "All items of %1 downloaded" ).arg( item.filePath ) );
+    }
+    else
+    {
+      transaction.pullItemsPending[item.filePath] = pendingItems;
+    }
 
-    // Send another request (or finish)
+    // Send more requests (or finish)
     downloadNextItem( projectFullName );
   }
   else
@@ -322,17 +502,15 @@ void MerginApi::downloadItemReplyFinished()
     }
     CoreUtils::log( "pull " + projectFullName, QStringLiteral( "FAILED - %1. %2" ).arg( r->errorString(), serverMsg ) );
 
-    transaction.replyDownloadItem->deleteLater();
-    transaction.replyDownloadItem = nullptr;
+    // the item is incomplete
+    itemFile.file->remove();
 
-    // get rid of the temporary download dir where we may have left some downloaded files
-    QDir( getTempProjectDir( projectFullName ) ).removeRecursively();
+    // the whole pull has failed - there is no point to wait for the other requests
+    abortPendingDownloads( transaction );
 
-    if ( transaction.firstTimeDownload )
-    {
-      Q_ASSERT( !transaction.projectDir.isEmpty() );
-      QDir( transaction.projectDir ).removeRecursively();
-    }
+    // keep what has been downloaded so far unless the user canceled the pull - the next pull continues from there
+    bool canceled = r->error() == QNetworkReply::OperationCanceledError;
+    discardProjectUpdate( projectFullName, !canceled );
 
     finishProjectSync( projectFullName, false );
 
@@ -372,16 +550,11 @@ void MerginApi::cacheServerConfig()
     }
     CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Failed to cache mergin config - %1. %2" ).arg( r->errorString(), serverMsg ) );
 
+    bool canceled = r->error() == QNetworkReply::OperationCanceledError;
     transaction.replyDownloadItem->deleteLater();
     transaction.replyDownloadItem = nullptr;
 
-    // get rid of the temporary download dir where we may have left some downloaded files
-    CoreUtils::removeDir( getTempProjectDir( projectFullName ) );
-
-    if ( transaction.firstTimeDownload )
-    {
-      CoreUtils::removeDir( transaction.projectDir );
-    }
+    discardProjectUpdate( projectFullName, !canceled );
 
     finishProjectSync( projectFullName, false );
 
@@ -390,7 +563,7 @@ void MerginApi::cacheServerConfig()
 }
 
 
-void MerginApi::uploadFile( const QString &projectFullName, const QString &transactionUUID, MerginFile file, int chunkNo )
+void MerginApi::uploadFile( const QString &projectFullName, const QString &transactionUUID, const MerginFile &file, int chunkNo )
 {
   if ( !validateAuthAndContinute() || mApiVersionStatus != MerginApiStatus::OK )
   {
@@ -403,33 +576,240 @@ void MerginApi::uploadFile( const QString &projectFullName, const QString &trans
   QString chunkID = file.chunks.at( chunkNo );
 
   QString filePath;
+  qint64 fileSize;
   if ( file.diffName.isEmpty() )
+  {
     filePath = transaction.projectDir + "/" + file.path;
+    fileSize = file.size;
+  }
   else  // use diff file instead of full file
-    filePath = transaction.projectDir + "/.mergin/" + file.diffName;
-
-  QFile f( filePath );
-  QByteArray data;
-
-  if ( f.open( QIODevice::ReadOnly ) )
   {
-    f.seek( chunkNo * UPLOAD_CHUNK_SIZE );
-    data = f.read( UPLOAD_CHUNK_SIZE );
+    filePath = transaction.projectDir + "/.mergin/" + file.diffName;
+    fileSize = file.diffSize;
   }
 
+  qint64 offset = static_cast<qint64>( chunkNo ) * UPLOAD_CHUNK_SIZE;
+  qint64 chunkSize = qBound( qint64( 0 ), fileSize - offset, qint64( UPLOAD_CHUNK_SIZE ) );
+
   QNetworkRequest request = getDefaultRequest();
   QUrl url( mApiRoot + QStringLiteral( "/v1/project/push/chunk/%1/%2" ).arg( transactionUUID ).arg( chunkID ) );
   request.setUrl( url );
   request.setRawHeader( "Content-Type", "application/octet-stream" );
   request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ), projectFullName );
 
-  Q_ASSERT( !transaction.replyUploadFile );
-  transaction.replyUploadFile = mManager.post( request, data );
-  connect( transaction.replyUploadFile, &QNetworkReply::finished, this, &MerginApi::uploadFileReplyFinished );
+  UploadChunkItem item;
+  item.filePath = file.path;
+  item.chunkId = chunkID;
+  item.size = chunkSize;
+
+  // stream the chunk from the disk instead of reading it to memory. Only small chunks of diffs (changesets or block deltas)
+  // may get compressed - content of files like photos is compressed already
+  bool tryCompression = mApiSupportsCompression && !file.diffName.isEmpty() && chunkSize <= COMPRESSION_MAX_CHUNK_SIZE &&
+                        !isFileCompressed( file.path ) && !transaction.incompressibleFiles.contains( file.path );
+  if ( tryCompression )
+  {
+    // the chunk is read and compressed on a worker thread, the request is sent once it is done
+    QFutureWatcher<UploadChunkBody> *watcher = new QFutureWatcher<UploadChunkBody>( this );
+    transaction.pushChunksCompressing.insert( watcher, item );
+
+    connect( watcher, &QFutureWatcher<UploadChunkBody>::finished, this, [this, projectFullName, request, filePath, watcher]()
+    {
+      watcher->deleteLater();
+
+      // the push may have failed or been canceled meanwhile
+      if ( !mTransactionalStatus.contains( projectFullName ) || !mTransactionalStatus[projectFullName].pushChunksCompressing.contains( watcher ) )
+        return;
+
+      TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+      UploadChunkItem item = transaction.pushChunksCompressing.take( watcher );
+      UploadChunkBody body = watcher->result();
+
+      QNetworkRequest chunkRequest = request;
+      if ( !body.isValid )
+      {
+        CoreUtils::log( "push " + projectFullName, "Failed to open for reading: " + filePath );
+      }
+      else if ( !body.isCompressed )
+      {
+        transaction.incompressibleFiles.insert( item.filePath );  // it is not worth trying with the other chunks
+      }
+      else
+      {
+        chunkRequest.setRawHeader( "Content-Encoding", "deflate" );
+        CoreUtils::log( "push " + projectFullName, QStringLiteral( "Chunk compressed from %1 to %2 bytes" ).arg( body.size ).arg( body.data.size() ) );
+      }
+
+      QNetworkReply *reply = mManager.post( chunkRequest, body.data );
+      transaction.replyPushChunks.insert( reply, item );
+      connect( reply, &QNetworkReply::finished, this, &MerginApi::uploadFileReplyFinished );
+
+      CoreUtils::log( "push " + projectFullName, QStringLiteral( "Uploading item: " ) + chunkRequest.url().toString() );
+    } );
+
+    watcher->setFuture( QtConcurrent::run( [filePath, offset, chunkSize]()
+    {
+      UploadChunkBody body;
+      UploadChunkDevice device( filePath, offset, chunkSize );
+      if ( !device.open( QIODevice::ReadOnly ) )
+        return body;
+
+      QByteArray data = device.readAll();
+      QByteArray compressed = deflateBody( data );
+      body.isValid = true;
+      body.size = data.size();
+      body.isCompressed = !compressed.isNull();
+      body.data = body.isCompressed ? compressed : data;
+      return body;
+    } ) );
+    return;
+  }
+
+  QNetworkReply *reply = nullptr;
+  UploadChunkDevice *device = new UploadChunkDevice( filePath, offset, chunkSize );
+  if ( device->open( QIODevice::ReadOnly ) )
+  {
+    request.setHeader( QNetworkRequest::ContentLengthHeader, device->size() );
+    reply = mManager.post( request, device );
+    device->setParent( reply );  // the device must live as long as the reply
+  }
+  else
+  {
+    CoreUtils::log( "push " + projectFullName, "Failed to open for reading: " + filePath );
+    delete device;
+    reply = mManager.post( request, QByteArray() );
+  }
+
+  transaction.replyPushChunks.insert( reply, item );
+  connect( reply, &QNetworkReply::finished, this, &MerginApi::uploadFileReplyFinished );
 
   CoreUtils::log( "push " + projectFullName, QStringLiteral( "Uploading item: " ) + url.toString() );
 }
 
+void MerginApi::uploadNextChunks( const QString &projectFullName )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  // chunks are independent on the server, so we can keep several of them (even from different files) in flight
+  while ( !transaction.uploadQueue.isEmpty() && transaction.replyPushChunks.count() + transaction.pushChunksCompressing.count() < mMaxParallelUploads )
+  {
+    const MerginFile &file = transaction.uploadQueue.first();
+    if ( transaction.uploadChunkNo == 0 )
+    {
+      int pendingChunks = 0;
+      for ( const QString &chunkId : file.chunks )
+      {
+        if ( !transaction.uploadedChunks.contains( chunkId ) )
+          ++pendingChunks;
+      }
+      if ( pendingChunks > 0 )
+        transaction.pushChunksPending[file.path] = pendingChunks;
+    }
+
+    // chunks confirmed to an interrupted push of this transaction are already on the server
+    if ( !transaction.uploadedChunks.contains( file.chunks.at( transaction.uploadChunkNo ) ) )
+      uploadFile( projectFullName, transaction.transactionUUID, file, transaction.uploadChunkNo );
+
+    ++transaction.uploadChunkNo;
+    if ( transaction.uploadChunkNo >= file.chunks.size() )
+    {
+      // all chunks of this file are on their way
+      transaction.uploadQueue.removeFirst();
+      transaction.uploadChunkNo = 0;
+    }
+  }
+
+  // all chunks have been requested - finish the transaction once the server confirmed all of them
+  if ( transaction.uploadQueue.isEmpty() && transaction.replyPushChunks.isEmpty() && transaction.pushChunksCompressing.isEmpty() )
+    uploadFinish( projectFullName, transaction.transactionUUID );
+}
+
+void MerginApi::abortPendingUploads( TransactionStatus &transaction )
+{
+  const QList<QNetworkReply *> replies = transaction.replyPushChunks.keys();
+  transaction.replyPushChunks.clear();
+
+  for ( QNetworkReply *reply : replies )
+  {
+    // we are not interested in the result anymore - make sure the finished() slot is not triggered by abort()
+    disconnect( reply, &QNetworkReply::finished, this, &MerginApi::uploadFileReplyFinished );
+    reply->abort();
+    reply->deleteLater();
+  }
+
+  // requests of chunks that are being compressed are not sent at all
+  transaction.pushChunksCompressing.clear();
+}
+
+QHash<QString, QStringList> MerginApi::resumableUploadChunks( const QString &projectFullName, const QList<MerginFile> &files, const QStringList &removedFiles )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  QHash<QString, QStringList> chunks;
+  if ( !transaction.journal )
+    return chunks;
+
+  TransactionJournal &journal = *transaction.journal;
+  if ( files.isEmpty() || !journal.load() || journal.type() != TransactionJournal::Push )
+    return chunks;
+
+  QStringList sortedRemovedFiles = removedFiles;
+  QStringList journalRemovedFiles = journal.removedFiles();
+  sortedRemovedFiles.sort();
+  journalRemovedFiles.sort();
+  bool sameRemovedFiles = sortedRemovedFiles == journalRemovedFiles;
+  if ( journal.projectFullName() != projectFullName || journal.baseVersion() != transaction.uploadBaseVersion ||
+       journal.transactionUUID().isEmpty() || !sameRemovedFiles )
+  {
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Interrupted push does not match the current state - starting a new transaction" ) );
+    return chunks;
+  }
+
+  // the server knows the transaction with the files as they were announced - they must not have changed since
+  const QList<MerginFile> journalFiles = journal.pushFiles();
+  if ( journalFiles.count() != files.count() )
+    return chunks;
+
+  QHash<QString, MerginFile> journalFilesByPath;
+  for ( const MerginFile &file : journalFiles )
+    journalFilesByPath.insert( file.path, file );
+
+  for ( const MerginFile &file : files )
+  {
+    auto it = journalFilesByPath.constFind( file.path );
+    if ( it == journalFilesByPath.constEnd() || it->checksum != file.checksum || it->size != file.size ||
+         it->diffChecksum != file.diffChecksum || it->chunks.count() != file.chunks.count() )
+    {
+      CoreUtils::log( "push " + projectFullName, QStringLiteral( "Interrupted push has different content of %1 - starting a new transaction" ).arg( file.path ) );
+      return QHash<QString, QStringList>();
+    }
+    chunks.insert( file.path, it->chunks );
+  }
+  return chunks;
+}
+
+void MerginApi::restartProjectUpload( const QString &projectFullName )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  CoreUtils::log( "push " + projectFullName, QStringLiteral( "Server rejected the resumed transaction - starting a new one" ) );
+
+  if ( transaction.journal )
+    transaction.journal->remove();
+  transaction.resumedPush = false;
+  transaction.uploadedChunks.clear();
+  transaction.transactionUUID.clear();
+  transaction.transferedSize = 0;
+  transaction.uploadQueue = transaction.uploadFiles;
+  transaction.uploadChunkNo = 0;
+  transaction.pushChunksPending.clear();
+  emit syncProjectStatusChanged( projectFullName, 0 );
+
+  uploadStart( projectFullName, transaction.uploadStartJson );
+}
+
 void MerginApi::uploadStart( const QString &projectFullName, const QByteArray &json )
 {
   if ( !validateAuthAndContinute() || mApiVersionStatus != MerginApiStatus::OK )
@@ -447,7 +827,7 @@ void MerginApi::uploadStart( const QString &projectFullName, const QByteArray &j
   request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ), projectFullName );
 
   Q_ASSERT( !transaction.replyUploadStart );
-  transaction.replyUploadStart = mManager.post( request, json );
+  transaction.replyUploadStart = mManager.post( request, compressRequestBody( request, json ) );
   connect( transaction.replyUploadStart, &QNetworkReply::finished, this, &MerginApi::uploadStartReplyFinished );
 
   CoreUtils::log( "push " + projectFullName, QStringLiteral( "Starting push request: " ) + url.toString() );
@@ -467,26 +847,56 @@ void MerginApi::uploadCancel( const QString &projectFullName )
 
   TransactionStatus &transaction = mTransactionalStatus[projectFullName];
 
+  // the server transaction gets canceled, there is nothing to resume
+  if ( transaction.journal )
+    transaction.journal->remove();
+
   // There is an open transaction, abort it followed by calling cancelUpload again.
   if ( transaction.replyUploadProjectInfo )
   {
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting project info request" ) );
     transaction.replyUploadProjectInfo->abort();  // will trigger uploadInfoReplyFinished slot and emit sync finished
   }
+  else if ( transaction.localFilesScanner )
+  {
+    // the push transaction has not been started on the server yet
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting scan of local files" ) );
+    transaction.localFilesScanner->cancel();
+    transaction.localFilesScanner->deleteLater();
+
+    finishProjectSync( projectFullName, false );
+  }
+  else if ( transaction.blocksComputation )
+  {
+    // the push transaction has not been started on the server yet - the sync finishes once the computation stops
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting computation of blocks of local files" ) );
+    *transaction.blocksCanceled = true;
+  }
   else if ( transaction.replyUploadStart )
   {
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting upload start" ) );
     transaction.replyUploadStart->abort();  // will trigger uploadStartReplyFinished slot and emit sync finished
   }
-  else if ( transaction.replyUploadFile )
+  else if ( !transaction.replyPushChunks.isEmpty() )
   {
     QString transactionUUID = transaction.transactionUUID;  // copy transaction uuid as the transaction object will be gone after abort
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting upload file" ) );
-    transaction.replyUploadFile->abort();  // will trigger uploadFileReplyFinished slot and emit sync finished
+    // will trigger uploadFileReplyFinished slot which aborts the rest of chunks in flight and emits sync finished
+    transaction.replyPushChunks.begin().key()->abort();
 
     // also need to cancel the transaction
     sendUploadCancelRequest( projectFullName, transactionUUID );
   }
+  else if ( !transaction.pushChunksCompressing.isEmpty() )
+  {
+    QString transactionUUID = transaction.transactionUUID;  // copy transaction uuid as the transaction object will be gone after finish
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Aborting compression of chunks" ) );
+    abortPendingUploads( transaction );
+
+    finishProjectSync( projectFullName, false );
+
+    sendUploadCancelRequest( projectFullName, transactionUUID );
+  }
   else if ( transaction.replyUploadFinish )
   {
     QString transactionUUID = transaction.transactionUUID;  // copy transaction uuid as the transaction object will be gone after abort
@@ -495,6 +905,11 @@ void MerginApi::uploadCancel( const QString &projectFullName )
 
     sendUploadCancelRequest( projectFullName, transactionUUID );
   }
+  else if ( transaction.contentStoring )
+  {
+    // the push has been finished on the server already, only its content is being stored - the sync finishes once it is done
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Push is done, waiting for the content store" ) );
+  }
   else
   {
     Q_ASSERT( false );  // unexpected state
@@ -530,11 +945,63 @@ void MerginApi::updateCancel( const QString &projectFullName )
     CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting project info request" ) );
     transaction.replyProjectInfo->abort();  // abort will trigger updateInfoReplyFinished() slot
   }
-  else if ( transaction.replyDownloadItem )
+  else if ( transaction.localFilesScanner )
+  {
+    // we're still scanning local files, nothing has been downloaded yet
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting scan of local files" ) );
+    transaction.localFilesScanner->cancel();
+    transaction.localFilesScanner->deleteLater();
+
+    discardProjectUpdate( projectFullName, false );
+
+    finishProjectSync( projectFullName, false );
+  }
+  else if ( transaction.resumeVerifier )
+  {
+    // we're checking files downloaded by an interrupted pull (the result gets ignored)
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting verification of downloaded files" ) );
+    transaction.resumeVerifier = nullptr;
+
+    discardProjectUpdate( projectFullName, false );
+
+    finishProjectSync( projectFullName, false );
+  }
+  else if ( !transaction.replyBlockLists.isEmpty() )
+  {
+    // we're asking for blocks of files to be pulled by block delta
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting pending block list requests" ) );
+    // abort will trigger blockListReplyFinished slot which also aborts the rest of requests in flight
+    transaction.replyBlockLists.begin().key()->abort();
+  }
+  else if ( transaction.blocksComputation )
+  {
+    // we're reading local files to be pulled by block delta - the pull is discarded once the computation stops
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting computation of blocks of local files" ) );
+    *transaction.blocksCanceled = true;
+  }
+  else if ( !transaction.replyPullItems.isEmpty() )
   {
     // we're already downloading some files
-    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting pending download" ) );
-    transaction.replyDownloadItem->abort();  // abort will trigger downloadItemReplyFinished slot
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting pending downloads" ) );
+    // abort will trigger downloadItemReplyFinished slot which also aborts the rest of requests in flight
+    transaction.replyPullItems.begin().key()->abort();
+  }
+  else if ( transaction.replyDownloadItem )
+  {
+    // we're downloading mergin config
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting pending config download" ) );
+    transaction.replyDownloadItem->abort();  // abort will trigger cacheServerConfig slot
+  }
+  else if ( transaction.blocksAssembly )
+  {
+    // we're assembling files pulled by block delta in the temp dir - the pull is discarded once the assembly stops
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting assembly of files pulled by block delta" ) );
+    *transaction.blocksCanceled = true;
+  }
+  else if ( transaction.contentStoring )
+  {
+    // the project has been updated already, only its new content is being stored - the pull finishes once it is done
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Pull is done, waiting for the content store" ) );
   }
   else
   {
@@ -1006,9 +1473,20 @@ void MerginApi::pingMerginReplyFinished()
 {
   QNetworkReply *r = qobject_cast<QNetworkReply *>( sender() );
   Q_ASSERT( r );
+
+  // the api root may have changed meanwhile - the result of the old server must not override the new one
+  if ( !r->url().toString().startsWith( mApiRoot ) )
+  {
+    CoreUtils::log( "ping", QStringLiteral( "Ignoring reply of previous api root: " ) + r->url().toString() );
+    r->deleteLater();
+    return;
+  }
+
   QString apiVersion;
   QString serverMsg;
   bool serverSupportsSubscriptions = false;
+  mApiSupportsBlockDelta = false;
+  mApiSupportsCompression = false;
 
   if ( r->error() == QNetworkReply::NoError )
   {
@@ -1019,6 +1497,10 @@ void MerginApi::pingMerginReplyFinished()
       QJsonObject obj = doc.object();
       apiVersion = obj.value( QStringLiteral( "version" ) ).toString();
       serverSupportsSubscriptions = obj.value( QStringLiteral( "subscriptions_enabled" ) ).toBool();
+      // servers without the capability get full files only
+      mApiSupportsBlockDelta = obj.value( QStringLiteral( "block_delta" ) ).toBool();
+      // responses are negotiated with Accept-Encoding, compressed requests only go to servers that list the encoding
+      mApiSupportsCompression = obj.value( QStringLiteral( "request_encodings" ) ).toArray().contains( QStringLiteral( "deflate" ) );
     }
   }
   else
@@ -1289,6 +1771,8 @@ void MerginApi::setApiRoot( const QString &apiRoot )
     settings.beginGroup( QStringLiteral( "Input/" ) );
     settings.setValue( QStringLiteral( "apiRoot" ), mApiRoot );
     settings.endGroup();
+    mApiSupportsBlockDelta = false;
+    mApiSupportsCompression = false;
     setApiVersionStatus( MerginApiStatus::UNKNOWN );
     emit apiRootChanged();
   }
@@ -1301,22 +1785,31 @@ QString MerginApi::merginUserName() const
 
 QList<MerginFile> MerginApi::getLocalProjectFiles( const QString &projectPath )
 {
-  QList<MerginFile> merginFiles;
-  QSet<QString> localFiles = listFiles( projectPath );
-  for ( QString p : localFiles )
+  return ProjectFilesScanner::scan( projectPath );
+}
+
+void MerginApi::scanLocalProjectFiles( const QString &projectFullName, std::function<void( const QList<MerginFile> & )> callback )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+  Q_ASSERT( !transaction.localFilesScanner );
+
+  ProjectFilesScanner *scanner = new ProjectFilesScanner( transaction.projectDir + "/", this );
+  transaction.localFilesScanner = scanner;
+
+  connect( scanner, &ProjectFilesScanner::finished, this, [this, projectFullName, scanner, callback]( const QList<MerginFile> &localFiles )
   {
+    scanner->deleteLater();
 
-    MerginFile file;
-    QByteArray localChecksumBytes = getChecksum( projectPath + p );
-    QString localChecksum = QString::fromLatin1( localChecksumBytes.data(), localChecksumBytes.size() );
-    file.checksum = localChecksum;
-    file.path = p;
-    QFileInfo info( projectPath + p );
-    file.size = info.size();
-    file.mtime = info.lastModified();
-    merginFiles.append( file );
-  }
-  return merginFiles;
+    // the transaction may have been canceled meanwhile
+    if ( !mTransactionalStatus.contains( projectFullName ) || mTransactionalStatus[projectFullName].localFilesScanner != scanner )
+      return;
+
+    mTransactionalStatus[projectFullName].localFilesScanner = nullptr;
+    callback( localFiles );
+  } );
+
+  scanner->start();
 }
 
 void MerginApi::listProjectsReplyFinished( QString requestId )
@@ -1412,13 +1905,24 @@ void MerginApi::finalizeProjectUpdateCopy( const QString &projectFullName, const
       CoreUtils::log( "pull " + projectFullName, "Failed to open temp file for reading " + item.tempFileName );
       return;
     }
-    f.write( fTmp.readAll() );
-  }
 
-  f.close();
-
-  // if diffable, copy to .mergin dir so we have a basefile
-  if ( MerginApi::isFileDiffable( filePath ) )
+    // a temp file may hold the whole content of a large file (e.g. taken from the content store)
+    QByteArray chunk = fTmp.read( CHUNK_SIZE );
+    while ( !chunk.isEmpty() )
+    {
+      if ( f.write( chunk ) != chunk.size() )
+      {
+        CoreUtils::log( "pull " + projectFullName, "Failed to write file " + dest );
+        return;
+      }
+      chunk = fTmp.read( CHUNK_SIZE );
+    }
+  }
+
+  f.close();
+
+  // if diffable, copy to .mergin dir so we have a basefile
+  if ( MerginApi::isFileDiffable( filePath ) )
   {
     QString basefile = projectDir + "/.mergin/" + filePath;
     createPathIfNotExists( basefile );
@@ -1435,7 +1939,7 @@ void MerginApi::finalizeProjectUpdateCopy( const QString &projectFullName, const
 }
 
 
-void MerginApi::finalizeProjectUpdateApplyDiff( const QString &projectFullName, const QString &projectDir, const QString &tempDir, const QString &filePath, const QList<DownloadQueueItem> &items )
+void MerginApi::finalizeProjectUpdateApplyDiff( const QString &projectFullName, const QString &projectDir, const QString &tempDir, const QString &filePath, const QList<DownloadQueueItem> &items, bool hasLocalChanges )
 {
   CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Applying diff to " ) + filePath );
 
@@ -1458,6 +1962,43 @@ void MerginApi::finalizeProjectUpdateApplyDiff( const QString &projectFullName,
   for ( const auto &item : items )
     diffFiles << tempDir + "/" + item.tempFileName;
 
+  // apply all server changes in one pass if possible
+  QString concatDiff = GeodiffUtils::concatDiffs( diffFiles, tempDir );
+  bool hasConcatDiff = !concatDiff.isEmpty() && !diffFiles.contains( concatDiff );
+  if ( !concatDiff.isEmpty() )
+    diffFiles = QStringList() << concatDiff;
+
+  // geodiff applies a changeset in a single transaction, so a failed attempt leaves the file untouched.
+  // That does not hold for a sequence of changesets (when they could not be concatenated) - a failure
+  // in the middle would leave the file half-updated, so those are always applied to a copy
+  if ( !hasLocalChanges && diffFiles.count() == 1 )
+  {
+    //
+    // there are no local changes to keep - update the basefile and our local file in place
+    //
+
+    if ( GeodiffUtils::applyDiffs( basefile, diffFiles ) )
+    {
+      if ( GeodiffUtils::applyDiffs( dest, diffFiles ) )
+      {
+        CoreUtils::log( "pull " + projectFullName, "server changes applied in place: " + filePath );
+      }
+      else
+      {
+        // the basefile already has the server content, which is what we want in the local file too
+        CoreUtils::log( "pull " + projectFullName, "applying diff to local file failed, replacing it with the basefile: " + filePath );
+        if ( !QFile::remove( dest ) || !QFile::copy( basefile, dest ) )
+          CoreUtils::log( "pull " + projectFullName, "failed to update local file: " + filePath );
+      }
+
+      if ( hasConcatDiff )
+        QFile::remove( concatDiff );
+      return;
+    }
+
+    CoreUtils::log( "pull " + projectFullName, "applying diff in place failed, assembling server file from a copy: " + filePath );
+  }
+
   //
   // let's first assemble server's file from our basefile + diffs
   //
@@ -1469,22 +2010,27 @@ void MerginApi::finalizeProjectUpdateApplyDiff( const QString &projectFullName,
     // TODO: this is a critical failure - we should abort pull
   }
 
-  if ( !GeodiffUtils::applyDiffs( src, diffFiles ) )
+  bool assembled = GeodiffUtils::applyDiffs( src, diffFiles );
+
+  if ( hasConcatDiff )
+    QFile::remove( concatDiff );
+
+  if ( !assembled )
   {
+    // keep the basefile and our local file as they are rather than swapping in a half-updated copy
     CoreUtils::log( "pull " + projectFullName, "server file assembly failed: " + filePath );
+    QFile::remove( src );
 
     // TODO: this is a critical failure - we should abort pull
     // TODO: we could try to delete the basefile and re-download it from scratch on next sync
+    return;
   }
-  else
-  {
-    CoreUtils::log( "pull " + projectFullName, "server file assembly successful: " + filePath );
-  }
+
+  CoreUtils::log( "pull " + projectFullName, "server file assembly successful: " + filePath );
 
   //
   // now we are ready for the update of our local file
   //
-
   int res = GEODIFF_rebase( basefile.toUtf8().constData(),
                             src.toUtf8().constData(),
                             dest.toUtf8().constData(),
@@ -1530,16 +2076,181 @@ void MerginApi::finalizeProjectUpdateApplyDiff( const QString &projectFullName,
   }
 }
 
+bool MerginApi::assembleFileFromBlocks( const QString &projectFullName, const QString &projectDir, const QString &tempDir,
+                                        const UpdateTask &task, const QString &outputPath, const std::atomic<bool> &canceled )
+{
+  QFile localFile( projectDir + "/" + task.filePath );
+  if ( !localFile.open( QIODevice::ReadOnly ) )
+  {
+    CoreUtils::log( "pull " + projectFullName, "Failed to open file for reading " + localFile.fileName() );
+    return false;
+  }
+
+  QFile f( outputPath );
+  if ( !f.open( QIODevice::WriteOnly ) )
+  {
+    CoreUtils::log( "pull " + projectFullName, "Failed to open file for writing " + outputPath );
+    return false;
+  }
+
+  for ( const BlockIndex::Block &block : task.blocks )
+  {
+    if ( canceled )
+      return false;
+
+    QByteArray data;
+    auto localIt = task.localBlocks.constFind( block.checksum );
+    if ( localIt != task.localBlocks.constEnd() )
+    {
+      if ( localFile.seek( localIt.value() ) )
+        data = localFile.read( block.size );
+    }
+    else
+    {
+      // downloaded items are ranges of the new file made of whole blocks
+      for ( const DownloadQueueItem &item : task.data )
+      {
+        if ( item.rangeFrom <= block.offset && block.offset + block.size - 1 <= item.rangeTo )
+        {
+          QFile fTmp( tempDir + "/" + item.tempFileName );
+          if ( fTmp.open( QIODevice::ReadOnly ) && fTmp.seek( block.offset - item.rangeFrom ) )
+            data = fTmp.read( block.size );
+          break;
+        }
+      }
+    }
+
+    if ( data.size() != block.size || f.write( data ) != data.size() )
+    {
+      CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Failed to assemble block at %1 of %2" ).arg( block.offset ).arg( task.filePath ) );
+      return false;
+    }
+  }
+
+  return f.flush();
+}
+
 void MerginApi::finalizeProjectUpdate( const QString &projectFullName )
 {
   Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
   TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+  Q_ASSERT( !transaction.blocksAssembly );
+
+  QList<UpdateTask> blockTasks;
+  for ( const UpdateTask &task : qAsConst( transaction.updateTasks ) )
+  {
+    if ( task.method == UpdateTask::ApplyBlocks )
+      blockTasks << task;
+  }
 
+  if ( blockTasks.isEmpty() )
+  {
+    applyProjectUpdateTasks( projectFullName, QHash<QString, QString>() );
+    return;
+  }
+
+  // files updated by block delta must match the server before anything in the project gets touched.
+  // They may be big, assembling and hashing them must not block the UI
   QString projectDir = transaction.projectDir;
   QString tempProjectDir = getTempProjectDir( projectFullName );
+  MerginProjectMetadata serverProject = MerginProjectMetadata::fromJson( transaction.projectMetadata );
+  std::shared_ptr<std::atomic<bool>> canceled = transaction.blocksCanceled;
+  QFutureWatcher<QHash<QString, QString>> *watcher = new QFutureWatcher<QHash<QString, QString>>( this );
+  transaction.blocksAssembly = watcher;
+
+  connect( watcher, &QFutureWatcher<QHash<QString, QString>>::finished, this, [this, projectFullName, watcher]()
+  {
+    watcher->deleteLater();
+
+    // the transaction may have been canceled meanwhile
+    if ( !mTransactionalStatus.contains( projectFullName ) || mTransactionalStatus[projectFullName].blocksAssembly != watcher )
+    {
+      const QHash<QString, QString> assembledFiles = watcher->result();
+      for ( const QString &assembledPath : assembledFiles )
+        QFile::remove( assembledPath );
+      return;
+    }
+
+    TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+    transaction.blocksAssembly = nullptr;
+
+    // the temp dir is removed only now, when nothing writes to it anymore
+    if ( *transaction.blocksCanceled )
+    {
+      const QHash<QString, QString> assembledFiles = watcher->result();
+      for ( const QString &assembledPath : assembledFiles )
+        QFile::remove( assembledPath );
+
+      discardProjectUpdate( projectFullName, false );
+      finishProjectSync( projectFullName, false );
+      return;
+    }
+
+    applyProjectUpdateTasks( projectFullName, watcher->result() );
+  } );
+
+  watcher->setFuture( QtConcurrent::run( [projectFullName, projectDir, tempProjectDir, serverProject, blockTasks, canceled]()
+  {
+    QHash<QString, QString> assembledFiles;
+    for ( const UpdateTask &task : blockTasks )
+    {
+      QString assembledPath = tempProjectDir + "/" + CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
+      if ( assembleFileFromBlocks( projectFullName, projectDir, tempProjectDir, task, assembledPath, *canceled ) &&
+           QString::fromLatin1( getChecksum( assembledPath ) ) == serverProject.fileInfo( task.filePath ).checksum )
+        assembledFiles.insert( task.filePath, assembledPath );
+      else
+        QFile::remove( assembledPath );
+    }
+    return assembledFiles;
+  } ) );
+}
+
+void MerginApi::applyProjectUpdateTasks( const QString &projectFullName, const QHash<QString, QString> &assembledFiles )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  QString projectDir = transaction.projectDir;
+  QString tempProjectDir = getTempProjectDir( projectFullName );
+  MerginProjectMetadata serverProject = MerginProjectMetadata::fromJson( transaction.projectMetadata );
+
+  // files that do not match the server are downloaded again in full (e.g. the local file has been modified meanwhile)
+  bool needsFullDownload = false;
+  for ( UpdateTask &task : transaction.updateTasks )
+  {
+    if ( task.method != UpdateTask::ApplyBlocks || assembledFiles.contains( task.filePath ) )
+      continue;
+
+    MerginFile serverFile = serverProject.fileInfo( task.filePath );
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Block delta of %1 does not match the server file - downloading it in full" ).arg( task.filePath ) );
+    for ( const DownloadQueueItem &item : qAsConst( task.data ) )
+      QFile::remove( tempProjectDir + "/" + item.tempFileName );
+
+    task = UpdateTask( UpdateTask::Copy, task.filePath, itemsForFileChunks( serverFile, transaction.version ) );
+    transaction.downloadQueue << task.data;
+    transaction.pullItemsPending[task.filePath] = task.data.count();
+    transaction.totalSize += serverFile.size;
+    needsFullDownload = true;
+  }
+
+  if ( needsFullDownload )
+  {
+    // the other assembled files are cheap to create again once the download is done
+    for ( const QString &assembledPath : qAsConst( assembledFiles ) )
+      QFile::remove( assembledPath );
+
+    // there may have been nothing to download so far
+    if ( transaction.journal && transaction.journal->type() != TransactionJournal::Pull )
+      transaction.journal->startPull( projectFullName );
+
+    downloadNextItem( projectFullName );
+    return;
+  }
 
   CoreUtils::log( "pull " + projectFullName, "Running update tasks" );
 
+  QList<StoredContent> storedContent;
+
   for ( const UpdateTask &finalizationItem : transaction.updateTasks )
   {
     switch ( finalizationItem.method )
@@ -1570,7 +2281,35 @@ void MerginApi::finalizeProjectUpdate( const QString &projectFullName )
 
       case UpdateTask::ApplyDiff:
       {
-        finalizeProjectUpdateApplyDiff( projectFullName, projectDir, tempProjectDir, finalizationItem.filePath, finalizationItem.data );
+        bool hasLocalChanges = transaction.diff.conflictRemoteUpdatedLocalUpdated.contains( finalizationItem.filePath );
+        finalizeProjectUpdateApplyDiff( projectFullName, projectDir, tempProjectDir, finalizationItem.filePath, finalizationItem.data, hasLocalChanges );
+        break;
+      }
+
+      case UpdateTask::ApplyBlocks:
+      {
+        CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Replacing content of %1 assembled from blocks" ).arg( finalizationItem.filePath ) );
+        QString dest = projectDir + "/" + finalizationItem.filePath;
+        QString assembledPath = assembledFiles.value( finalizationItem.filePath );
+
+        // the local file is kept aside until the new one is in place, so that it is not lost if the rename fails
+        QString backupPath = tempProjectDir + "/" + CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
+        if ( !QFile::rename( dest, backupPath ) )
+        {
+          CoreUtils::log( "pull " + projectFullName, "Failed to replace file " + dest );
+          QFile::remove( assembledPath );
+        }
+        else if ( !QFile::rename( assembledPath, dest ) )
+        {
+          CoreUtils::log( "pull " + projectFullName, "Failed to replace file " + dest + " - restoring the local file" );
+          QFile::remove( assembledPath );
+          if ( !QFile::rename( backupPath, dest ) )
+            CoreUtils::log( "pull " + projectFullName, "Failed to restore file " + dest );
+        }
+        else
+        {
+          QFile::remove( backupPath );
+        }
         break;
       }
 
@@ -1583,14 +2322,82 @@ void MerginApi::finalizeProjectUpdate( const QString &projectFullName )
       }
     }
 
-    // remove tmp files associated with this item
+    // keep the new content for other pulls on the device. A single temp file holds the whole file and it is
+    // not going to change, so it can be linked, content of the project file gets copied (it may be edited in place)
+    bool isCopy = finalizationItem.method == UpdateTask::Copy || finalizationItem.method == UpdateTask::CopyConflict;
+    bool tempFileStored = false;
+    if ( mContentStoreMaxSize > 0 && isCopy && !finalizationItem.data.isEmpty() )
+    {
+      QString checksum = finalizationItem.data.first().fileChecksum;
+      tempFileStored = finalizationItem.data.count() == 1;
+      if ( tempFileStored )
+        storedContent << StoredContent { checksum, tempProjectDir + "/" + finalizationItem.data.first().tempFileName, true };
+      else
+        storedContent << StoredContent { checksum, projectDir + "/" + finalizationItem.filePath, false };
+    }
+
+    // remove tmp files associated with this item (a temp file for the content store is removed once it is stored)
     for ( const auto &downloadItem : finalizationItem.data )
     {
-      if ( !QFile::remove( tempProjectDir + "/" + downloadItem.tempFileName ) )
+      if ( !tempFileStored && !QFile::remove( tempProjectDir + "/" + downloadItem.tempFileName ) )
         CoreUtils::log( "pull " + projectFullName, "Failed to remove temporary file " + downloadItem.tempFileName );
     }
   }
 
+  // files written by the update tasks must be hashed again on the next scan
+  QStringList updatedFiles;
+  for ( const UpdateTask &finalizationItem : transaction.updateTasks )
+    updatedFiles << finalizationItem.filePath;
+  ProjectChecksumCache::invalidate( projectDir, updatedFiles );
+
+  // blocks of files updated by block delta are known now - they are the base for the next push or pull.
+  // Other files may have changed, so their blocks are not valid anymore
+  if ( QFile::exists( BlockIndex::indexFilePath( projectDir ) ) || !assembledFiles.isEmpty() )
+  {
+    BlockIndex blockIndex( projectDir );
+    for ( const UpdateTask &finalizationItem : transaction.updateTasks )
+    {
+      if ( finalizationItem.method == UpdateTask::ApplyBlocks )
+        blockIndex.insert( finalizationItem.filePath, serverProject.fileInfo( finalizationItem.filePath ).checksum, finalizationItem.blocks );
+      else
+        blockIndex.remove( finalizationItem.filePath );
+    }
+    blockIndex.save();
+  }
+
+  if ( storedContent.isEmpty() )
+  {
+    finishProjectUpdate( projectFullName );
+    return;
+  }
+
+  // copying the files may take a while - the pull finishes once the content is stored
+  Q_ASSERT( !transaction.contentStoring );
+  QFutureWatcher<void> *watcher = new QFutureWatcher<void>( this );
+  transaction.contentStoring = watcher;
+
+  connect( watcher, &QFutureWatcher<void>::finished, this, [this, projectFullName, watcher]()
+  {
+    watcher->deleteLater();
+
+    if ( !mTransactionalStatus.contains( projectFullName ) || mTransactionalStatus[projectFullName].contentStoring != watcher )
+      return;
+
+    mTransactionalStatus[projectFullName].contentStoring = nullptr;
+    finishProjectUpdate( projectFullName );
+  } );
+
+  watcher->setFuture( QtConcurrent::run( storeContent, contentStore(), storedContent ) );
+}
+
+void MerginApi::finishProjectUpdate( const QString &projectFullName )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  QString projectDir = transaction.projectDir;
+  QString tempProjectDir = getTempProjectDir( projectFullName );
+
   // check there are no files left
   int tmpFilesLeft = QDir( tempProjectDir ).entryList( QDir::NoDotAndDotDot ).count();
   if ( tmpFilesLeft )
@@ -1649,8 +2456,14 @@ void MerginApi::uploadStartReplyFinished()
 
       CoreUtils::log( "push " + projectFullName, QStringLiteral( "Push request accepted. Transaction ID: " ) + transactionUUID );
 
-      MerginFile file = files.first();
-      uploadFile( projectFullName, transactionUUID, file );
+      // from now on the push can be resumed if it gets interrupted
+      if ( transaction.journal )
+      {
+        transaction.journal->startPush( projectFullName, transactionUUID, transaction.uploadBaseVersion,
+                                        transaction.uploadFiles, transaction.diff.localDeleted.values() );
+      }
+
+      uploadNextChunks( projectFullName );
       emit pushFilesStarted();
     }
     else  // pushing only files to be removed
@@ -1717,52 +2530,56 @@ void MerginApi::uploadFileReplyFinished()
 
   Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
   TransactionStatus &transaction = mTransactionalStatus[projectFullName];
-  Q_ASSERT( r == transaction.replyUploadFile );
+  Q_ASSERT( transaction.replyPushChunks.contains( r ) );
 
-  QStringList params = ( r->url().toString().split( "/" ) );
-  QString transactionUUID = params.at( params.length() - 2 );
-  QString chunkID = params.at( params.length() - 1 );
-  Q_ASSERT( transactionUUID == transaction.transactionUUID );
+  UploadChunkItem item = transaction.replyPushChunks.take( r );
+  r->deleteLater();
 
   if ( r->error() == QNetworkReply::NoError )
   {
-    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Uploaded successfully: " ) + chunkID );
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Uploaded successfully: " ) + item.chunkId );
 
-    transaction.replyUploadFile->deleteLater();
-    transaction.replyUploadFile = nullptr;
+    if ( transaction.journal )
+      transaction.journal->appendUploadedChunk( item.chunkId );
+
+    transaction.transferedSize += item.size;
+    emit syncProjectStatusChanged( projectFullName, transaction.transferedSize / transaction.totalSize );
 
-    MerginFile currentFile = transaction.uploadQueue.first();
-    int chunkNo = currentFile.chunks.indexOf( chunkID );
-    if ( chunkNo < currentFile.chunks.size() - 1 )
+    int pendingChunks = transaction.pushChunksPending.value( item.filePath ) - 1;
+    if ( pendingChunks <= 0 )
     {
-      uploadFile( projectFullName, transactionUUID, currentFile, chunkNo + 1 );
+      transaction.pushChunksPending.remove( item.filePath );
+      CoreUtils::log( "push " + projectFullName, QStringLiteral( "All chunks of %1 uploaded" ).arg( item.filePath ) );
     }
     else
     {
-      transaction.transferedSize += currentFile.size;
-
-      emit syncProjectStatusChanged( projectFullName, transaction.transferedSize / transaction.totalSize );
-      transaction.uploadQueue.removeFirst();
-
-      if ( !transaction.uploadQueue.isEmpty() )
-      {
-        MerginFile nextFile = transaction.uploadQueue.first();
-        uploadFile( projectFullName, transactionUUID, nextFile );
-      }
-      else
-      {
-        uploadFinish( projectFullName, transactionUUID );
-      }
+      transaction.pushChunksPending[item.filePath] = pendingChunks;
     }
+
+    // Send more chunks (or finish)
+    uploadNextChunks( projectFullName );
   }
   else
   {
+    int status = r->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
     QString serverMsg = extractServerErrorMsg( r->readAll() );
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "FAILED - %1. %2" ).arg( r->errorString(), serverMsg ) );
-    emit networkErrorOccurred( serverMsg, QStringLiteral( "Mergin API error: uploadFile" ) );
 
-    transaction.replyUploadFile->deleteLater();
-    transaction.replyUploadFile = nullptr;
+    // the whole push has failed - there is no point to wait for the other chunks
+    abortPendingUploads( transaction );
+
+    if ( transaction.resumedPush && status == 404 )
+    {
+      // the transaction of the interrupted push has expired on the server meanwhile
+      restartProjectUpload( projectFullName );
+      return;
+    }
+
+    // when the server refused the chunk, the transaction is not worth resuming (unlike after a network or server failure)
+    if ( status >= 400 && status < 500 && transaction.journal )
+      transaction.journal->remove();
+
+    emit networkErrorOccurred( serverMsg, QStringLiteral( "Mergin API error: uploadFile" ) );
 
     finishProjectSync( projectFullName, false );
   }
@@ -1807,10 +2624,22 @@ void MerginApi::prepareProjectUpdate( const QString &projectFullName, const QByt
   TransactionStatus &transaction = mTransactionalStatus[projectFullName];
 
   LocalProject projectInfo = mLocalProjects.projectFromMerginName( projectFullName );
+  QString interruptedDownloadDir;
+  if ( !projectInfo.isValid() )
+    interruptedDownloadDir = TransactionJournal::findInterruptedDownload( mDataDir, projectFullName );
+
   if ( projectInfo.isValid() )
   {
     transaction.projectDir = projectInfo.projectDir;
   }
+  else if ( !interruptedDownloadDir.isEmpty() )
+  {
+    // continue with the first time download that got interrupted - its temp files are still around
+    transaction.projectDir = interruptedDownloadDir;
+    transaction.firstTimeDownload = true;
+
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "First time download - resuming in directory: " ) + transaction.projectDir );
+  }
   else
   {
     QString projectNamespace;
@@ -1856,7 +2685,18 @@ void MerginApi::startProjectUpdate( const QString &projectFullName )
   Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
   TransactionStatus &transaction = mTransactionalStatus[projectFullName];
 
-  QList<MerginFile> localFiles = getLocalProjectFiles( transaction.projectDir + "/" );
+  // hashing of local files may take a while - do not block the UI meanwhile
+  scanLocalProjectFiles( projectFullName, [this, projectFullName]( const QList<MerginFile> &localFiles )
+  {
+    continueProjectUpdate( projectFullName, localFiles );
+  } );
+}
+
+void MerginApi::continueProjectUpdate( const QString &projectFullName, const QList<MerginFile> &localFiles )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
   MerginProjectMetadata serverProject = MerginProjectMetadata::fromJson( transaction.projectMetadata );
   MerginProjectMetadata oldServerProject = MerginProjectMetadata::fromCachedJson( transaction.projectDir + "/" + sMetadataFile );
   MerginConfig oldTransactionConfig = MerginConfig::fromFile( transaction.projectDir + "/" + sMerginConfigFile );
@@ -1882,9 +2722,11 @@ void MerginApi::startProjectUpdate( const QString &projectFullName )
     transaction.updateTasks << UpdateTask( UpdateTask::Copy, filePath, items );
   }
 
+  QList<MerginFile> blockDeltaFiles;
   for ( QString filePath : transaction.diff.remoteUpdated )
   {
     MerginFile file = serverProject.fileInfo( filePath );
+    MerginFile localFile = findFile( filePath, localFiles );
 
     // for diffable files - download and apply to the basefile (without rebase)
     if ( isFileDiffable( filePath ) && file.pullCanUseDiff )
@@ -1892,6 +2734,11 @@ void MerginApi::startProjectUpdate( const QString &projectFullName )
       QList<DownloadQueueItem> items = itemsForFileDiffs( file );
       transaction.updateTasks << UpdateTask( UpdateTask::ApplyDiff, filePath, items );
     }
+    else if ( !localFile.path.isEmpty() && canUseBlockDelta( filePath, file.size ) )
+    {
+      // large files that cannot be diffed - only blocks that are not in the local file get downloaded
+      blockDeltaFiles << localFile;
+    }
     else
     {
       QList<DownloadQueueItem> items = itemsForFileChunks( file, transaction.version );
@@ -1902,57 +2749,527 @@ void MerginApi::startProjectUpdate( const QString &projectFullName )
   // also download files which were changed both on the server and locally (the local version will be renamed as conflicting copy)
   for ( QString filePath : transaction.diff.conflictRemoteUpdatedLocalUpdated )
   {
-    MerginFile file = serverProject.fileInfo( filePath );
-
-    // for diffable files - download and apply to the basefile (will also do rebase)
-    if ( isFileDiffable( filePath ) && file.pullCanUseDiff )
+    MerginFile file = serverProject.fileInfo( filePath );
+
+    // for diffable files - download and apply to the basefile (will also do rebase)
+    if ( isFileDiffable( filePath ) && file.pullCanUseDiff )
+    {
+      QList<DownloadQueueItem> items = itemsForFileDiffs( file );
+      transaction.updateTasks << UpdateTask( UpdateTask::ApplyDiff, filePath, items );
+    }
+    else
+    {
+      QList<DownloadQueueItem> items = itemsForFileChunks( file, transaction.version );
+      transaction.updateTasks << UpdateTask( UpdateTask::CopyConflict, filePath, items );
+    }
+  }
+
+  // also download files which were added both on the server and locally (the local version will be renamed as conflicting copy)
+  for ( QString filePath : transaction.diff.conflictRemoteAddedLocalAdded )
+  {
+    MerginFile file = serverProject.fileInfo( filePath );
+    QList<DownloadQueueItem> items = itemsForFileChunks( file, transaction.version );
+    transaction.updateTasks << UpdateTask( UpdateTask::CopyConflict, filePath, items );
+  }
+
+  // schedule removed files to be deleted
+  for ( QString filePath : transaction.diff.remoteDeleted )
+  {
+    transaction.updateTasks << UpdateTask( UpdateTask::Delete, filePath, QList<DownloadQueueItem>() );
+  }
+
+  if ( blockDeltaFiles.isEmpty() )
+  {
+    prepareDownload( projectFullName );
+    return;
+  }
+
+  // the download continues once the server told us its blocks of the files and we know blocks of the local files
+  computePullLocalBlocks( projectFullName, blockDeltaFiles );
+  for ( const MerginFile &localFile : qAsConst( blockDeltaFiles ) )
+    requestBlockList( projectFullName, localFile );
+}
+
+bool MerginApi::canUseBlockDelta( const QString &filePath, qint64 fileSize ) const
+{
+  // diffable files have geodiff and small files are not worth the extra work
+  return mApiSupportsBlockDelta && !isFileDiffable( filePath ) && fileSize >= BlockIndex::MIN_FILE_SIZE;
+}
+
+void MerginApi::requestBlockList( const QString &projectFullName, const MerginFile &localFile )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  QUrl url( mApiRoot + QStringLiteral( "/v1/project/blocks/" ) + projectFullName );
+  QUrlQuery query;
+  query.addQueryItem( "file", localFile.path.toUtf8().toPercentEncoding() );
+  query.addQueryItem( "version", QStringLiteral( "v%1" ).arg( transaction.version ) );
+  url.setQuery( query );
+
+  QNetworkRequest request = getDefaultRequest();
+  request.setUrl( url );
+  request.setAttribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ), projectFullName );
+
+  QNetworkReply *reply = mManager.get( request );
+  transaction.replyBlockLists.insert( reply, localFile );
+  connect( reply, &QNetworkReply::finished, this, &MerginApi::blockListReplyFinished );
+
+  CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Requesting block list: " ) + url.toString() );
+}
+
+void MerginApi::blockListReplyFinished()
+{
+  QNetworkReply *r = qobject_cast<QNetworkReply *>( sender() );
+  Q_ASSERT( r );
+
+  QString projectFullName = r->request().attribute( static_cast<QNetworkRequest::Attribute>( AttrProjectFullName ) ).toString();
+
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+  Q_ASSERT( transaction.replyBlockLists.contains( r ) );
+
+  MerginFile localFile = transaction.replyBlockLists.take( r );
+  r->deleteLater();
+
+  if ( r->error() == QNetworkReply::OperationCanceledError )
+  {
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Aborting block list requests" ) );
+
+    const QList<QNetworkReply *> replies = transaction.replyBlockLists.keys();
+    transaction.replyBlockLists.clear();
+    for ( QNetworkReply *reply : replies )
+    {
+      disconnect( reply, &QNetworkReply::finished, this, &MerginApi::blockListReplyFinished );
+      reply->abort();
+      reply->deleteLater();
+    }
+
+    // local blocks may still be computed - the pull is discarded once the computation stops
+    if ( transaction.blocksComputation )
+    {
+      *transaction.blocksCanceled = true;
+      return;
+    }
+
+    discardProjectUpdate( projectFullName, false );
+
+    finishProjectSync( projectFullName, false );
+    return;
+  }
+
+  MerginFile serverFile = MerginProjectMetadata::fromJson( transaction.projectMetadata ).fileInfo( localFile.path );
+  bool hasServerBlocks = false;
+
+  if ( r->error() == QNetworkReply::NoError )
+  {
+    QJsonObject obj = QJsonDocument::fromJson( r->readAll() ).object();
+
+    QList<BlockIndex::Block> serverBlocks;
+    const QJsonArray blocks = obj.value( QStringLiteral( "blocks" ) ).toArray();
+    for ( const QJsonValue &value : blocks )
+    {
+      QJsonObject blockObject = value.toObject();
+      BlockIndex::Block block;
+      block.offset = static_cast<qint64>( blockObject.value( QStringLiteral( "offset" ) ).toDouble() );
+      block.size = static_cast<qint64>( blockObject.value( QStringLiteral( "size" ) ).toDouble() );
+      block.checksum = blockObject.value( QStringLiteral( "checksum" ) ).toString();
+      serverBlocks << block;
+    }
+
+    if ( obj.value( QStringLiteral( "checksum" ) ).toString() == serverFile.checksum && BlockIndex::blocksCoverFile( serverBlocks, serverFile.size ) )
+    {
+      transaction.pullServerBlocks.insert( localFile.path, serverBlocks );
+      hasServerBlocks = true;
+    }
+    else
+    {
+      CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Block list of %1 does not match the server file - downloading it in full" ).arg( localFile.path ) );
+    }
+  }
+  else
+  {
+    QString serverMsg = extractServerErrorMsg( r->readAll() );
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Failed to get block list of %1 - downloading it in full. %2. %3" )
+                    .arg( localFile.path, r->errorString(), serverMsg ) );
+  }
+
+  // without usable blocks the file gets downloaded in full
+  if ( !hasServerBlocks )
+    transaction.updateTasks << UpdateTask( UpdateTask::Copy, localFile.path, itemsForFileChunks( serverFile, transaction.version ) );
+
+  if ( transaction.replyBlockLists.isEmpty() && !transaction.blocksComputation )
+    planBlockDownloads( projectFullName );
+}
+
+void MerginApi::computePullLocalBlocks( const QString &projectFullName, const QList<MerginFile> &localFiles )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+  Q_ASSERT( !transaction.blocksComputation );
+
+  // reading large files must not block the UI, meanwhile the block lists are requested from the server
+  QString projectDir = transaction.projectDir;
+  std::shared_ptr<std::atomic<bool>> canceled = transaction.blocksCanceled;
+  QFutureWatcher<LocalFileBlocks> *watcher = new QFutureWatcher<LocalFileBlocks>( this );
+  transaction.blocksComputation = watcher;
+
+  connect( watcher, &QFutureWatcher<LocalFileBlocks>::finished, this, [this, projectFullName, watcher]()
+  {
+    watcher->deleteLater();
+
+    // the transaction may have been canceled meanwhile
+    if ( !mTransactionalStatus.contains( projectFullName ) || mTransactionalStatus[projectFullName].blocksComputation != watcher )
+      return;
+
+    TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+    transaction.blocksComputation = nullptr;
+
+    // block list requests have been aborted already when the pull got canceled
+    if ( *transaction.blocksCanceled )
+    {
+      discardProjectUpdate( projectFullName, false );
+      finishProjectSync( projectFullName, false );
+      return;
+    }
+
+    transaction.pullLocalBlocks = watcher->result().blocks;
+
+    if ( transaction.replyBlockLists.isEmpty() )
+      planBlockDownloads( projectFullName );
+  } );
+
+  watcher->setFuture( QtConcurrent::run( [projectDir, localFiles, canceled]()
+  {
+    // blocks of the local files are usually indexed since their last sync, otherwise the files need to be read now
+    LocalFileBlocks result;
+    BlockIndex index( projectDir );
+    bool indexChanged = false;
+    for ( const MerginFile &localFile : localFiles )
+    {
+      if ( *canceled )
+        break;
+
+      QList<BlockIndex::Block> blocks = index.blocks( localFile.path, localFile.checksum );
+      if ( blocks.isEmpty() )
+      {
+        blocks = BlockIndex::computeBlocks( projectDir + "/" + localFile.path, canceled.get() );
+        if ( blocks.isEmpty() )
+          continue;
+
+        index.insert( localFile.path, localFile.checksum, blocks );
+        indexChanged = true;
+      }
+      result.blocks.insert( localFile.path, blocks );
+    }
+
+    if ( indexChanged )
+      index.save();
+    return result;
+  } ) );
+}
+
+void MerginApi::planBlockDownloads( const QString &projectFullName )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  MerginProjectMetadata serverProject = MerginProjectMetadata::fromJson( transaction.projectMetadata );
+  for ( auto it = transaction.pullServerBlocks.constBegin(); it != transaction.pullServerBlocks.constEnd(); ++it )
+  {
+    // without blocks of the local file it gets downloaded in full
+    MerginFile serverFile = serverProject.fileInfo( it.key() );
+    UpdateTask task( UpdateTask::Copy, it.key(), itemsForFileChunks( serverFile, transaction.version ) );
+    QList<BlockIndex::Block> localBlocks = transaction.pullLocalBlocks.value( it.key() );
+    if ( !localBlocks.isEmpty() )
+      planBlockDownload( projectFullName, serverFile, it.value(), localBlocks, task );
+
+    transaction.updateTasks << task;
+  }
+  transaction.pullServerBlocks.clear();
+  transaction.pullLocalBlocks.clear();
+
+  prepareDownload( projectFullName );
+}
+
+bool MerginApi::planBlockDownload( const QString &projectFullName, const MerginFile &serverFile, const QList<BlockIndex::Block> &serverBlocks,
+                                   const QList<BlockIndex::Block> &localBlocks, UpdateTask &task )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  QHash<QString, qint64> localOffsets;
+  for ( const BlockIndex::Block &block : localBlocks )
+  {
+    if ( !localOffsets.contains( block.checksum ) )
+      localOffsets.insert( block.checksum, block.offset );
+  }
+
+  // missing blocks next to each other are downloaded by a single request (up to the chunk size)
+  QList<DownloadQueueItem> items;
+  qint64 downloadSize = 0;
+  for ( const BlockIndex::Block &block : serverBlocks )
+  {
+    if ( localOffsets.contains( block.checksum ) )
+      continue;
+
+    downloadSize += block.size;
+    if ( !items.isEmpty() && items.last().rangeTo + 1 == block.offset && items.last().size + block.size <= UPLOAD_CHUNK_SIZE )
+    {
+      items.last().rangeTo += block.size;
+      items.last().size += block.size;
+    }
+    else
+    {
+      DownloadQueueItem item( serverFile.path, block.size, transaction.version, block.offset, block.offset + block.size - 1 );
+      item.fileChecksum = serverFile.checksum;
+      items << item;
+    }
+  }
+
+  if ( downloadSize * 100 > serverFile.size * BLOCK_DELTA_MAX_PERCENT )
+  {
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Block delta of %1 would download %2 of %3 bytes - downloading it in full" )
+                    .arg( serverFile.path ).arg( downloadSize ).arg( serverFile.size ) );
+    return false;
+  }
+
+  CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Block delta of %1: downloading %2 of %3 bytes (%4 items)" )
+                  .arg( serverFile.path ).arg( downloadSize ).arg( serverFile.size ).arg( items.count() ) );
+
+  task = UpdateTask( UpdateTask::ApplyBlocks, serverFile.path, items );
+  task.blocks = serverBlocks;
+  task.localBlocks = localOffsets;
+  return true;
+}
+
+void MerginApi::prepareDownload( const QString &projectFullName )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  bool hasItems = std::any_of( transaction.updateTasks.constBegin(), transaction.updateTasks.constEnd(), []( const UpdateTask & task )
+  {
+    return !task.data.isEmpty();
+  } );
+
+  transaction.journal = std::make_shared<TransactionJournal>( transaction.projectDir );
+  if ( !hasItems )
+  {
+    startDownload( projectFullName, ReusableContent() );
+    return;
+  }
+
+  // an interrupted pull may have left some items downloaded - reuse them if they are still fine
+  bool resuming = transaction.journal->load() && transaction.journal->type() == TransactionJournal::Pull &&
+                  transaction.journal->projectFullName() == projectFullName && !transaction.journal->downloadedItems().isEmpty();
+  if ( !resuming )
+    transaction.journal->startPull( projectFullName );
+
+  // whole files with content that is somewhere on the device already do not need to be downloaded
+  QHash<QString, QString> storedFiles;
+  if ( mContentStoreMaxSize > 0 )
+  {
+    ContentStore store = contentStore();
+    for ( const UpdateTask &task : qAsConst( transaction.updateTasks ) )
+    {
+      if ( ( task.method == UpdateTask::Copy || task.method == UpdateTask::CopyConflict ) && !task.data.isEmpty() &&
+           store.contains( task.data.first().fileChecksum ) )
+        storedFiles.insert( task.filePath, task.data.first().fileChecksum );
+    }
+  }
+
+  if ( resuming || !storedFiles.isEmpty() )
+    verifyReusableContent( projectFullName, resuming, storedFiles );
+  else
+    startDownload( projectFullName, ReusableContent() );
+}
+
+void MerginApi::verifyReusableContent( const QString &projectFullName, bool resuming, const QHash<QString, QString> &storedFiles )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+  Q_ASSERT( !transaction.resumeVerifier );
+
+  // only items that we still need are worth checking
+  QHash<QString, TransactionJournal::DownloadedItem> items;
+  if ( resuming )
+  {
+    const QHash<QString, TransactionJournal::DownloadedItem> downloadedItems = transaction.journal->downloadedItems();
+    for ( const UpdateTask &task : transaction.updateTasks )
+    {
+      for ( const DownloadQueueItem &item : task.data )
+      {
+        auto it = downloadedItems.constFind( item.key() );
+        if ( it != downloadedItems.constEnd() )
+          items.insert( it.key(), it.value() );
+      }
+    }
+
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Verifying %1 items downloaded by interrupted pull" ).arg( items.count() ) );
+  }
+
+  if ( !storedFiles.isEmpty() )
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Verifying %1 files found in the content store" ).arg( storedFiles.count() ) );
+
+  // the temp files may be big, hashing them must not block the UI
+  QString tempDir = getTempProjectDir( projectFullName );
+  ContentStore store = contentStore();
+  QFutureWatcher<ReusableContent> *watcher = new QFutureWatcher<ReusableContent>( this );
+  transaction.resumeVerifier = watcher;
+
+  connect( watcher, &QFutureWatcher<ReusableContent>::finished, this, [this, projectFullName, watcher]()
+  {
+    watcher->deleteLater();
+
+    // the transaction may have been canceled meanwhile
+    if ( !mTransactionalStatus.contains( projectFullName ) || mTransactionalStatus[projectFullName].resumeVerifier != watcher )
+      return;
+
+    mTransactionalStatus[projectFullName].resumeVerifier = nullptr;
+    startDownload( projectFullName, watcher->result() );
+  } );
+
+  watcher->setFuture( QtConcurrent::run( [tempDir, items, storedFiles, store]() mutable
+  {
+    ReusableContent reusable;
+    for ( auto it = items.constBegin(); it != items.constEnd(); ++it )
+    {
+      if ( QString::fromLatin1( getChecksum( tempDir + "/" + it->tempFileName ) ) == it->checksum )
+        reusable.downloadedItems.insert( it.key() );
+    }
+
+    QDir().mkpath( tempDir );
+    for ( auto it = storedFiles.constBegin(); it != storedFiles.constEnd(); ++it )
+    {
+      QString tempFileName = CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
+      QString tempFilePath = tempDir + "/" + tempFileName;
+      if ( store.retrieve( it.value(), tempFilePath ) && QString::fromLatin1( getChecksum( tempFilePath ) ) == it.value() )
+      {
+        reusable.storedFiles.insert( it.key(), tempFileName );
+      }
+      else
+      {
+        // damaged (or removed meanwhile) - the file gets downloaded
+        QFile::remove( tempFilePath );
+        store.remove( it.value() );
+      }
+    }
+    return reusable;
+  } ) );
+}
+
+void MerginApi::startDownload( const QString &projectFullName, const ReusableContent &reusable )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  QHash<QString, TransactionJournal::DownloadedItem> downloadedItems;
+  if ( transaction.journal )
+    downloadedItems = transaction.journal->downloadedItems();
+
+  // prepare the download queue
+  qint64 totalSize = 0;
+  qint64 resumedSize = 0;
+  int resumedItems = 0;
+  qint64 storedSize = 0;
+  for ( UpdateTask &task : transaction.updateTasks )
+  {
+    QString storedTempFileName = reusable.storedFiles.value( task.filePath );
+    if ( !storedTempFileName.isEmpty() )
     {
-      QList<DownloadQueueItem> items = itemsForFileDiffs( file );
-      transaction.updateTasks << UpdateTask( UpdateTask::ApplyDiff, filePath, items );
+      // the whole content is in a single temp file already - the update task copies it from there
+      qint64 fileSize = 0;
+      for ( const DownloadQueueItem &item : qAsConst( task.data ) )
+        fileSize += item.size;
+
+      DownloadQueueItem item( task.filePath, fileSize, transaction.version );
+      item.fileChecksum = task.data.first().fileChecksum;
+      item.tempFileName = storedTempFileName;
+      task.data = QList<DownloadQueueItem>() << item;
+
+      totalSize += fileSize;
+      storedSize += fileSize;
+      continue;
     }
-    else
+
+    int pendingItems = 0;
+    for ( DownloadQueueItem &item : task.data )
     {
-      QList<DownloadQueueItem> items = itemsForFileChunks( file, transaction.version );
-      transaction.updateTasks << UpdateTask( UpdateTask::CopyConflict, filePath, items );
+      totalSize += item.size;
+
+      if ( reusable.downloadedItems.contains( item.key() ) )
+      {
+        // downloaded by an interrupted pull - the update task uses its temp file
+        item.tempFileName = downloadedItems.value( item.key() ).tempFileName;
+        resumedSize += item.size;
+        ++resumedItems;
+      }
+      else
+      {
+        transaction.downloadQueue << item;
+        ++pendingItems;
+      }
     }
-  }
 
-  // also download files which were added both on the server and locally (the local version will be renamed as conflicting copy)
-  for ( QString filePath : transaction.diff.conflictRemoteAddedLocalAdded )
-  {
-    MerginFile file = serverProject.fileInfo( filePath );
-    QList<DownloadQueueItem> items = itemsForFileChunks( file, transaction.version );
-    transaction.updateTasks << UpdateTask( UpdateTask::CopyConflict, filePath, items );
+    if ( pendingItems > 0 )
+      transaction.pullItemsPending[task.filePath] = pendingItems;
   }
+  transaction.totalSize = totalSize;
+  transaction.transferedSize = resumedSize + storedSize;
 
-  // schedule removed files to be deleted
-  for ( QString filePath : transaction.diff.remoteDeleted )
-  {
-    transaction.updateTasks << UpdateTask( UpdateTask::Delete, filePath, QList<DownloadQueueItem>() );
-  }
+  CoreUtils::log( "pull " + projectFullName, QStringLiteral( "%1 update tasks, %2 items to download (total size %3 bytes, %4 parallel requests)" )
+                  .arg( transaction.updateTasks.count() )
+                  .arg( transaction.downloadQueue.count() )
+                  .arg( transaction.totalSize )
+                  .arg( mMaxParallelDownloads ) );
 
-  // prepare the download queue
-  for ( const UpdateTask &item : transaction.updateTasks )
+  if ( resumedItems > 0 )
   {
-    transaction.downloadQueue << item.data;
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Resuming interrupted pull: %1 items (%2 bytes) already downloaded" )
+                    .arg( resumedItems ).arg( resumedSize ) );
   }
 
-  qint64 totalSize = 0;
-  for ( const DownloadQueueItem &item : transaction.downloadQueue )
+  if ( !reusable.storedFiles.isEmpty() )
   {
-    totalSize += item.size;
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "%1 files (%2 bytes) taken from the content store" )
+                    .arg( reusable.storedFiles.count() ).arg( storedSize ) );
   }
-  transaction.totalSize = totalSize;
 
-  CoreUtils::log( "pull " + projectFullName, QStringLiteral( "%1 update tasks, %2 items to download (total size %3 bytes)" )
-                  .arg( transaction.updateTasks.count() )
-                  .arg( transaction.downloadQueue.count() )
-                  .arg( transaction.totalSize ) );
+  if ( transaction.transferedSize > 0 )
+    emit syncProjectStatusChanged( projectFullName, transaction.transferedSize / transaction.totalSize );
 
   emit pullFilesStarted();
   downloadNextItem( projectFullName );
 }
 
+void MerginApi::discardProjectUpdate( const QString &projectFullName, bool keepResumable )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  if ( keepResumable && QFile::exists( TransactionJournal::journalFilePath( transaction.projectDir ) ) )
+  {
+    CoreUtils::log( "pull " + projectFullName, QStringLiteral( "Keeping downloaded items for the next pull" ) );
+    return;
+  }
+
+  // get rid of the temporary download dir where we may have left some downloaded files
+  QDir( getTempProjectDir( projectFullName ) ).removeRecursively();
+
+  // the transaction's journal keeps its file open
+  if ( transaction.journal )
+    transaction.journal->remove();
+  else
+    TransactionJournal( transaction.projectDir ).remove();
+
+  if ( transaction.firstTimeDownload )
+  {
+    Q_ASSERT( !transaction.projectDir.isEmpty() );
+    QDir( transaction.projectDir ).removeRecursively();
+  }
+}
+
 void MerginApi::prepareDownloadConfig( const QString &projectFullName, bool downloaded )
 {
   Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
@@ -2076,11 +3393,13 @@ void MerginApi::requestServerConfig( const QString &projectFullName )
 QList<DownloadQueueItem> MerginApi::itemsForFileChunks( const MerginFile &file, int version )
 {
   QList<DownloadQueueItem> lst;
-  int from = 0;
+  qint64 from = 0;
   while ( from < file.size )
   {
-    int size = qMin( MerginApi::UPLOAD_CHUNK_SIZE, static_cast<int>( file.size ) - from );
-    lst << DownloadQueueItem( file.path, size, version, from, from + size - 1 );
+    qint64 size = qMin( qint64( MerginApi::UPLOAD_CHUNK_SIZE ), file.size - from );
+    DownloadQueueItem item( file.path, size, version, from, from + size - 1 );
+    item.fileChecksum = file.checksum;
+    lst << item;
     from += size;
   }
   return lst;
@@ -2098,18 +3417,6 @@ QList<DownloadQueueItem> MerginApi::itemsForFileDiffs( const MerginFile &file )
 }
 
 
-static MerginFile findFile( const QString &filePath, const QList<MerginFile> &files )
-{
-  for ( const MerginFile &merginFile : files )
-  {
-    if ( merginFile.path == filePath )
-      return merginFile;
-  }
-  qDebug() << "requested findFile() for non-existant file! " << filePath;
-  return MerginFile();
-}
-
-
 void MerginApi::uploadInfoReplyFinished()
 {
   QNetworkReply *r = qobject_cast<QNetworkReply *>( sender() );
@@ -2148,144 +3455,355 @@ void MerginApi::uploadInfoReplyFinished()
       return;
     }
 
-    QList<MerginFile> localFiles = getLocalProjectFiles( transaction.projectDir + "/" );
-    MerginProjectMetadata oldServerProject = MerginProjectMetadata::fromCachedJson( transaction.projectDir + "/" + sMetadataFile );
+    // hashing of local files may take a while - do not block the UI meanwhile
+    scanLocalProjectFiles( projectFullName, [this, projectFullName, data]( const QList<MerginFile> &localFiles )
+    {
+      continueProjectUpload( projectFullName, data, localFiles );
+    } );
+  }
+  else
+  {
+    QString message = QStringLiteral( "Network API error: %1(): %2" ).arg( QStringLiteral( "projectInfo" ), r->errorString() );
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "FAILED - %1" ).arg( message ) );
+
+    transaction.replyUploadProjectInfo->deleteLater();
+    transaction.replyUploadProjectInfo = nullptr;
+
+    finishProjectSync( projectFullName, false );
+  }
+}
+
+void MerginApi::continueProjectUpload( const QString &projectFullName, const QByteArray &data, const QList<MerginFile> &localFiles )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  MerginProjectMetadata serverProject = MerginProjectMetadata::fromJson( data );
+  MerginProjectMetadata oldServerProject = MerginProjectMetadata::fromCachedJson( transaction.projectDir + "/" + sMetadataFile );
+
+  // Cache mergin-config, since we are on the most recent version, it is sufficient to just read the local version
+  if ( transaction.configAllowed )
+  {
+    transaction.config = MerginConfig::fromFile( transaction.projectDir + "/" + MerginApi::sMerginConfigFile );
+  }
+
+  transaction.diff = compareProjectFiles(
+                       oldServerProject.files,
+                       serverProject.files,
+                       localFiles,
+                       transaction.projectDir,
+                       transaction.configAllowed,
+                       transaction.config
+                     );
+
+  CoreUtils::log( "push " + projectFullName, transaction.diff.dump() );
+
+  // TODO: make sure there are no remote files to add/update/remove nor conflicts
+
+  QList<MerginFile> addedMerginFiles, updatedMerginFiles, deletedMerginFiles;
+  QList<MerginFile> diffFiles;
+  QList<MerginFile> blockFiles;  // large files whose blocks are needed
+  QHash<QString, QString> baseChecksums;  // server checksums of updated large files (by path)
+  for ( QString filePath : transaction.diff.localAdded )
+  {
+    MerginFile merginFile = findFile( filePath, localFiles );
+    merginFile.chunks = generateChunkIdsForSize( merginFile.size );
+
+    // blocks of a new large file are indexed, so that its next update can be pushed by block delta
+    if ( canUseBlockDelta( filePath, merginFile.size ) )
+      blockFiles << merginFile;
+
+    addedMerginFiles.append( merginFile );
+  }
+
+  for ( QString filePath : transaction.diff.localUpdated )
+  {
+    MerginFile merginFile = findFile( filePath, localFiles );
+    merginFile.chunks = generateChunkIdsForSize( merginFile.size );
 
-    // Cache mergin-config, since we are on the most recent version, it is sufficient to just read the local version
-    if ( transaction.configAllowed )
+    if ( MerginApi::isFileDiffable( filePath ) )
     {
-      transaction.config = MerginConfig::fromFile( transaction.projectDir + "/" + MerginApi::sMerginConfigFile );
-    }
+      // try to create a diff
+      QString diffName;
+      int geodiffRes = GeodiffUtils::createChangeset( transaction.projectDir, filePath, diffName );
+      QString diffPath = transaction.projectDir + "/.mergin/" + diffName;
+      QString basePath = transaction.projectDir + "/.mergin/" + filePath;
 
-    transaction.diff = compareProjectFiles(
-                         oldServerProject.files,
-                         serverProject.files,
-                         localFiles,
-                         transaction.projectDir,
-                         transaction.configAllowed,
-                         transaction.config
-                       );
+      if ( geodiffRes == GEODIFF_SUCCESS )
+      {
+        QByteArray checksumDiff = getChecksum( diffPath );
 
-    CoreUtils::log( "push " + projectFullName, transaction.diff.dump() );
+        // TODO: this is ugly. our basefile may not need to have the same checksum as the server's
+        // basefile (because each of them have applied the diff independently) so we have to fake it
+        QByteArray checksumBase = serverProject.fileInfo( filePath ).checksum.toLatin1();
 
-    // TODO: make sure there are no remote files to add/update/remove nor conflicts
+        merginFile.diffName = diffName;
+        merginFile.diffChecksum = QString::fromLatin1( checksumDiff.data(), checksumDiff.size() );
+        merginFile.diffSize = QFileInfo( diffPath ).size();
+        merginFile.chunks = generateChunkIdsForSize( merginFile.diffSize );
+        merginFile.diffBaseChecksum = QString::fromLatin1( checksumBase.data(), checksumBase.size() );
 
-    QList<MerginFile> filesToUpload;
-    QList<MerginFile> addedMerginFiles, updatedMerginFiles, deletedMerginFiles;
-    QList<MerginFile> diffFiles;
-    for ( QString filePath : transaction.diff.localAdded )
+        diffFiles.append( merginFile );
+
+        CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 successful: total size %2 bytes" ).arg( filePath ).arg( merginFile.diffSize ) );
+      }
+      else
+      {
+        // TODO: remove the diff file (if exists)
+        CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 FAILED with error %2 (will do full upload)" ).arg( filePath ).arg( geodiffRes ) );
+      }
+    }
+    else if ( canUseBlockDelta( filePath, merginFile.size ) )
     {
-      MerginFile merginFile = findFile( filePath, localFiles );
-      merginFile.chunks = generateChunkIdsForSize( merginFile.size );
-      addedMerginFiles.append( merginFile );
+      // only blocks that are not in the server file get uploaded - if we know its blocks (indexed at the last sync)
+      blockFiles << merginFile;
+      baseChecksums.insert( filePath, serverProject.fileInfo( filePath ).checksum );
     }
 
-    for ( QString filePath : transaction.diff.localUpdated )
-    {
-      MerginFile merginFile = findFile( filePath, localFiles );
-      merginFile.chunks = generateChunkIdsForSize( merginFile.size );
+    updatedMerginFiles.append( merginFile );
+  }
 
-      if ( MerginApi::isFileDiffable( filePath ) )
-      {
-        // try to create a diff
-        QString diffName;
-        int geodiffRes = GeodiffUtils::createChangeset( transaction.projectDir, filePath, diffName );
-        QString diffPath = transaction.projectDir + "/.mergin/" + diffName;
-        QString basePath = transaction.projectDir + "/.mergin/" + filePath;
+  for ( QString filePath : transaction.diff.localDeleted )
+  {
+    MerginFile merginFile = findFile( filePath, serverProject.files );
+    deletedMerginFiles.append( merginFile );
+  }
 
-        if ( geodiffRes == GEODIFF_SUCCESS )
-        {
-          QByteArray checksumDiff = getChecksum( diffPath );
+  if ( addedMerginFiles.isEmpty() && updatedMerginFiles.isEmpty() && deletedMerginFiles.isEmpty() )
+  {
+    // if nothing has changed, there is no point to even start upload transaction
+    transaction.projectMetadata = data;
+    transaction.version = MerginProjectMetadata::fromJson( data ).version;
 
-          // TODO: this is ugly. our basefile may not need to have the same checksum as the server's
-          // basefile (because each of them have applied the diff independently) so we have to fake it
-          QByteArray checksumBase = serverProject.fileInfo( filePath ).checksum.toLatin1();
+    finishProjectSync( projectFullName, true );
+    return;
+  }
 
-          merginFile.diffName = diffName;
-          merginFile.diffChecksum = QString::fromLatin1( checksumDiff.data(), checksumDiff.size() );
-          merginFile.diffSize = QFileInfo( diffPath ).size();
-          merginFile.chunks = generateChunkIdsForSize( merginFile.diffSize );
-          merginFile.diffBaseChecksum = QString::fromLatin1( checksumBase.data(), checksumBase.size() );
+  if ( blockFiles.isEmpty() )
+  {
+    startProjectUpload( projectFullName, data, addedMerginFiles, updatedMerginFiles, deletedMerginFiles, diffFiles );
+    return;
+  }
 
-          diffFiles.append( merginFile );
+  // reading large files must not block the UI
+  QString projectDir = transaction.projectDir;
+  std::shared_ptr<std::atomic<bool>> canceled = transaction.blocksCanceled;
+  QFutureWatcher<LocalFileBlocks> *watcher = new QFutureWatcher<LocalFileBlocks>( this );
+  transaction.blocksComputation = watcher;
 
-          CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 successful: total size %2 bytes" ).arg( filePath ).arg( merginFile.diffSize ) );
-        }
-        else
-        {
-          // TODO: remove the diff file (if exists)
-          CoreUtils::log( "push " + projectFullName, QString( "Geodiff create changeset on %1 FAILED with error %2 (will do full upload)" ).arg( filePath ).arg( geodiffRes ) );
-        }
-      }
+  connect( watcher, &QFutureWatcher<LocalFileBlocks>::finished, this,
+           [this, projectFullName, projectDir, data, addedMerginFiles, updatedMerginFiles, deletedMerginFiles, diffFiles, watcher]() mutable
+  {
+    watcher->deleteLater();
+    LocalFileBlocks result = watcher->result();
 
-      updatedMerginFiles.append( merginFile );
+    // the transaction may have been canceled meanwhile
+    if ( !mTransactionalStatus.contains( projectFullName ) || mTransactionalStatus[projectFullName].blocksComputation != watcher )
+    {
+      for ( const MerginFile &merginFile : qAsConst( result.deltaFiles ) )
+        QFile::remove( projectDir + "/.mergin/" + merginFile.diffName );
+      return;
     }
 
-    for ( QString filePath : transaction.diff.localDeleted )
+    TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+    transaction.blocksComputation = nullptr;
+
+    if ( *transaction.blocksCanceled )
     {
-      MerginFile merginFile = findFile( filePath, serverProject.files );
-      deletedMerginFiles.append( merginFile );
+      for ( const MerginFile &merginFile : qAsConst( result.deltaFiles ) )
+        QFile::remove( projectDir + "/.mergin/" + merginFile.diffName );
+
+      finishProjectSync( projectFullName, false );
+      return;
     }
 
-    if ( addedMerginFiles.isEmpty() && updatedMerginFiles.isEmpty() && deletedMerginFiles.isEmpty() )
+    transaction.uploadFileBlocks = result.blocks;
+    for ( MerginFile &merginFile : updatedMerginFiles )
+      merginFile = result.deltaFiles.value( merginFile.path, merginFile );
+
+    startProjectUpload( projectFullName, data, addedMerginFiles, updatedMerginFiles, deletedMerginFiles, diffFiles );
+  } );
+
+  watcher->setFuture( QtConcurrent::run( [projectFullName, projectDir, blockFiles, baseChecksums, canceled]()
+  {
+    LocalFileBlocks result;
+    BlockIndex blockIndex( projectDir );
+    for ( const MerginFile &blockFile : blockFiles )
     {
-      // if nothing has changed, there is no point to even start upload transaction
-      transaction.projectMetadata = data;
-      transaction.version = MerginProjectMetadata::fromJson( data ).version;
+      if ( *canceled )
+        break;
 
-      finishProjectSync( projectFullName, true );
-      return;
+      QList<BlockIndex::Block> newBlocks = BlockIndex::computeBlocks( projectDir + "/" + blockFile.path, canceled.get() );
+      if ( newBlocks.isEmpty() )
+        continue;
+      result.blocks.insert( blockFile.path, newBlocks );
+
+      if ( !baseChecksums.contains( blockFile.path ) )
+        continue;
+
+      MerginFile merginFile = blockFile;
+      QList<BlockIndex::Block> baseBlocks = blockIndex.blocks( blockFile.path, baseChecksums.value( blockFile.path ) );
+      if ( !baseBlocks.isEmpty() && createBlockDelta( projectFullName, projectDir, baseBlocks, newBlocks, merginFile, *canceled ) )
+        result.deltaFiles.insert( merginFile.path, merginFile );
     }
+    return result;
+  } ) );
+}
+
+void MerginApi::startProjectUpload( const QString &projectFullName, const QByteArray &data, QList<MerginFile> addedMerginFiles,
+                                    QList<MerginFile> updatedMerginFiles, const QList<MerginFile> &deletedMerginFiles, const QList<MerginFile> &diffFiles )
+{
+  Q_ASSERT( mTransactionalStatus.contains( projectFullName ) );
+  TransactionStatus &transaction = mTransactionalStatus[projectFullName];
+
+  MerginProjectMetadata serverProject = MerginProjectMetadata::fromJson( data );
+  QList<MerginFile> filesToUpload;
 
-    QJsonArray added = prepareUploadChangesJSON( addedMerginFiles );
-    filesToUpload.append( addedMerginFiles );
+  // an interrupted push of the same changes continues with its transaction, so the chunk IDs must be the same
+  transaction.journal = std::make_shared<TransactionJournal>( transaction.projectDir );
+  transaction.uploadBaseVersion = serverProject.version;
+  const QHash<QString, QStringList> resumedChunks = resumableUploadChunks( projectFullName, addedMerginFiles + updatedMerginFiles, transaction.diff.localDeleted.values() );
+  if ( !resumedChunks.isEmpty() )
+  {
+    for ( MerginFile &merginFile : addedMerginFiles )
+      merginFile.chunks = resumedChunks.value( merginFile.path );
+    for ( MerginFile &merginFile : updatedMerginFiles )
+      merginFile.chunks = resumedChunks.value( merginFile.path );
+  }
+
+  QJsonArray added = prepareUploadChangesJSON( addedMerginFiles );
+  filesToUpload.append( addedMerginFiles );
+
+  QJsonArray modified = prepareUploadChangesJSON( updatedMerginFiles );
+  filesToUpload.append( updatedMerginFiles );
+
+  QJsonArray removed = prepareUploadChangesJSON( deletedMerginFiles );
+  // removed not in filesToUpload
+
+  QJsonObject changes;
+  changes.insert( "added", added );
+  changes.insert( "removed", removed );
+  changes.insert( "updated", modified );
+  changes.insert( "renamed", QJsonArray() );
+
+  qint64 totalSize = 0;
+  for ( MerginFile file : filesToUpload )
+  {
+    if ( !file.diffName.isEmpty() )
+      totalSize += file.diffSize;
+    else
+      totalSize += file.size;
+  }
 
-    QJsonArray modified = prepareUploadChangesJSON( updatedMerginFiles );
-    filesToUpload.append( updatedMerginFiles );
+  CoreUtils::log( "push " + projectFullName, QStringLiteral( "%1 items to upload (total size %2 bytes)" )
+                  .arg( filesToUpload.count() ).arg( totalSize ) );
+
+  transaction.totalSize = totalSize;
+  transaction.uploadQueue = filesToUpload;
+  transaction.uploadFiles = filesToUpload;
+  transaction.uploadDiffFiles = diffFiles;
+
+  QJsonObject json;
+  json.insert( QStringLiteral( "changes" ), changes );
+  json.insert( QStringLiteral( "version" ), QString( "v%1" ).arg( serverProject.version ) );
+  QJsonDocument jsonDoc;
+  jsonDoc.setObject( json );
+  transaction.uploadStartJson = jsonDoc.toJson( QJsonDocument::Compact );
 
-    QJsonArray removed = prepareUploadChangesJSON( deletedMerginFiles );
-    // removed not in filesToUpload
+  if ( resumedChunks.isEmpty() )
+  {
+    uploadStart( projectFullName, transaction.uploadStartJson );
+    return;
+  }
 
-    QJsonObject changes;
-    changes.insert( "added", added );
-    changes.insert( "removed", removed );
-    changes.insert( "updated", modified );
-    changes.insert( "renamed", QJsonArray() );
+  transaction.resumedPush = true;
+  transaction.transactionUUID = transaction.journal->transactionUUID();
+  transaction.uploadedChunks = transaction.journal->uploadedChunks();
 
-    qint64 totalSize = 0;
-    for ( MerginFile file : filesToUpload )
+  for ( const MerginFile &file : filesToUpload )
+  {
+    qint64 fileSize = file.diffName.isEmpty() ? file.size : file.diffSize;
+    for ( int i = 0; i < file.chunks.count(); ++i )
     {
-      if ( !file.diffName.isEmpty() )
-        totalSize += file.diffSize;
-      else
-        totalSize += file.size;
+      if ( transaction.uploadedChunks.contains( file.chunks.at( i ) ) )
+        transaction.transferedSize += qBound( qint64( 0 ), fileSize - static_cast<qint64>( i ) * UPLOAD_CHUNK_SIZE, qint64( UPLOAD_CHUNK_SIZE ) );
     }
+  }
 
-    CoreUtils::log( "push " + projectFullName, QStringLiteral( "%1 items to upload (total size %2 bytes)" )
-                    .arg( filesToUpload.count() ).arg( totalSize ) );
+  CoreUtils::log( "push " + projectFullName, QStringLiteral( "Resuming interrupted push. Transaction ID: %1, %2 chunks (%3 bytes) already uploaded" )
+                  .arg( transaction.transactionUUID ).arg( transaction.uploadedChunks.count() ).arg( transaction.transferedSize ) );
+
+  uploadNextChunks( projectFullName );
+  emit pushFilesStarted();
+}
 
-    transaction.totalSize = totalSize;
-    transaction.uploadQueue = filesToUpload;
-    transaction.uploadDiffFiles = diffFiles;
+bool MerginApi::createBlockDelta( const QString &projectFullName, const QString &projectDir, const QList<BlockIndex::Block> &baseBlocks,
+                                  const QList<BlockIndex::Block> &newBlocks, MerginFile &merginFile, const std::atomic<bool> &canceled )
+{
+  // blocks in the server file or earlier in the delta are not uploaded (again)
+  QSet<QString> knownBlocks;
+  for ( const BlockIndex::Block &block : baseBlocks )
+    knownBlocks.insert( block.checksum );
 
-    QJsonObject json;
-    json.insert( QStringLiteral( "changes" ), changes );
-    json.insert( QStringLiteral( "version" ), QString( "v%1" ).arg( serverProject.version ) );
-    QJsonDocument jsonDoc;
-    jsonDoc.setObject( json );
+  QString deltaName = CoreUtils::uuidWithoutBraces( QUuid::createUuid() ) + "-blocks";
+  QString deltaPath = projectDir + "/.mergin/" + deltaName;
 
-    uploadStart( projectFullName, jsonDoc.toJson( QJsonDocument::Compact ) );
+  QFile in( projectDir + "/" + merginFile.path );
+  QFile out( deltaPath );
+  if ( !in.open( QIODevice::ReadOnly ) || !out.open( QIODevice::WriteOnly ) )
+  {
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Failed to create block delta of %1 (will do full upload)" ).arg( merginFile.path ) );
+    return false;
   }
-  else
+
+  QList< QPair<QString, qint64> > deltaBlocks;
+  for ( const BlockIndex::Block &block : newBlocks )
   {
-    QString message = QStringLiteral( "Network API error: %1(): %2" ).arg( QStringLiteral( "projectInfo" ), r->errorString() );
-    CoreUtils::log( "push " + projectFullName, QStringLiteral( "FAILED - %1" ).arg( message ) );
+    if ( canceled )
+    {
+      out.close();
+      QFile::remove( deltaPath );
+      return false;
+    }
 
-    transaction.replyUploadProjectInfo->deleteLater();
-    transaction.replyUploadProjectInfo = nullptr;
+    deltaBlocks << qMakePair( block.checksum, block.size );
+    if ( knownBlocks.contains( block.checksum ) )
+      continue;
+    knownBlocks.insert( block.checksum );
 
-    finishProjectSync( projectFullName, false );
+    QByteArray data;
+    if ( in.seek( block.offset ) )
+      data = in.read( block.size );
+
+    if ( data.size() != block.size || out.write( data ) != data.size() )
+    {
+      CoreUtils::log( "push " + projectFullName, QStringLiteral( "Failed to write block delta of %1 (will do full upload)" ).arg( merginFile.path ) );
+      out.close();
+      QFile::remove( deltaPath );
+      return false;
+    }
+  }
+  out.close();
+
+  qint64 deltaSize = QFileInfo( deltaPath ).size();
+  if ( deltaSize * 100 > merginFile.size * BLOCK_DELTA_MAX_PERCENT )
+  {
+    CoreUtils::log( "push " + projectFullName, QStringLiteral( "Block delta of %1 would upload %2 of %3 bytes (will do full upload)" )
+                    .arg( merginFile.path ).arg( deltaSize ).arg( merginFile.size ) );
+    QFile::remove( deltaPath );
+    return false;
   }
+
+  QByteArray checksumDelta = getChecksum( deltaPath );
+  merginFile.diffName = deltaName;
+  merginFile.diffChecksum = QString::fromLatin1( checksumDelta.data(), checksumDelta.size() );
+  merginFile.diffSize = deltaSize;
+  merginFile.chunks = generateChunkIdsForSize( deltaSize );
+  merginFile.deltaBlocks = deltaBlocks;
+
+  CoreUtils::log( "push " + projectFullName, QStringLiteral( "Block delta of %1: uploading %2 of %3 bytes" )
+                  .arg( merginFile.path ).arg( deltaSize ).arg( merginFile.size ) );
+  return true;
 }
 
 void MerginApi::uploadFinishReplyFinished()
@@ -2350,10 +3868,56 @@ void MerginApi::uploadFinishReplyFinished()
         CoreUtils::log( "push " + projectFullName, "Failed to remove diff: " + diffPath );
     }
 
-    finishProjectSync( projectFullName, true );
+    // blocks of the uploaded files are the base for their next push by block delta
+    if ( !transaction.uploadFileBlocks.isEmpty() )
+    {
+      BlockIndex blockIndex( transaction.projectDir );
+      for ( const MerginFile &merginFile : qAsConst( transaction.uploadFiles ) )
+      {
+        if ( transaction.uploadFileBlocks.contains( merginFile.path ) )
+          blockIndex.insert( merginFile.path, merginFile.checksum, transaction.uploadFileBlocks.value( merginFile.path ) );
+      }
+      blockIndex.save();
+    }
+
+    // uploaded files may be pulled to other projects on the device (copies - the project files get edited in place)
+    QList<StoredContent> storedContent;
+    if ( mContentStoreMaxSize > 0 )
+    {
+      for ( const MerginFile &merginFile : qAsConst( transaction.uploadFiles ) )
+      {
+        if ( merginFile.diffName.isEmpty() )
+          storedContent << StoredContent { merginFile.checksum, transaction.projectDir + "/" + merginFile.path, false };
+      }
+    }
+
+    if ( storedContent.isEmpty() )
+    {
+      finishProjectSync( projectFullName, true );
+      return;
+    }
+
+    // copying the files may take a while - the push finishes once the content is stored
+    Q_ASSERT( !transaction.contentStoring );
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>( this );
+    transaction.contentStoring = watcher;
+
+    connect( watcher, &QFutureWatcher<void>::finished, this, [this, projectFullName, watcher]()
+    {
+      watcher->deleteLater();
+
+      if ( !mTransactionalStatus.contains( projectFullName ) || mTransactionalStatus[projectFullName].contentStoring != watcher )
+        return;
+
+      mTransactionalStatus[projectFullName].contentStoring = nullptr;
+      finishProjectSync( projectFullName, true );
+    } );
+
+    watcher->setFuture( QtConcurrent::run( storeContent, contentStore(), storedContent ) );
   }
   else
   {
+    int status = r->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
     QString serverMsg = extractServerErrorMsg( r->readAll() );
     QString message = QStringLiteral( "Network API error: %1(): %2. %3" ).arg( QStringLiteral( "uploadFinish" ), r->errorString(), serverMsg );
     CoreUtils::log( "push " + projectFullName, QStringLiteral( "FAILED - %1" ).arg( message ) );
@@ -2361,6 +3925,29 @@ void MerginApi::uploadFinishReplyFinished()
     transaction.replyUploadFinish->deleteLater();
     transaction.replyUploadFinish = nullptr;
 
+    if ( transaction.resumedPush && status == 404 )
+    {
+      // the transaction of the interrupted push has expired on the server meanwhile
+      restartProjectUpload( projectFullName );
+      return;
+    }
+
+    // after a network or server failure the next push only needs to ask for finish again
+    if ( status >= 400 && status < 500 )
+    {
+      if ( transaction.journal )
+        transaction.journal->remove();
+
+      // the server may have rejected a block delta - the next push uploads the files in full
+      BlockIndex blockIndex( transaction.projectDir );
+      for ( const MerginFile &merginFile : qAsConst( transaction.uploadFiles ) )
+      {
+        if ( !merginFile.deltaBlocks.isEmpty() )
+          blockIndex.remove( merginFile.path );
+      }
+      blockIndex.save();
+    }
+
     finishProjectSync( projectFullName, false );
   }
 }
@@ -2449,7 +4036,8 @@ ProjectDiff MerginApi::compareProjectFiles(
   const QString &projectDir,
   bool allowConfig,
   const MerginConfig &config,
-  const MerginConfig &lastSyncConfig
+  const MerginConfig &lastSyncConfig,
+  bool checkDiffableFiles
 )
 {
   ProjectDiff diff;
@@ -2512,11 +4100,11 @@ ProjectDiff MerginApi::compareProjectFiles(
         if ( chkNew != chkLocal )
         {
           // L-U
-          if ( isFileDiffable( filePath ) )
+          if ( isFileDiffable( filePath ) && checkDiffableFiles )
           {
             // we need to do a diff here to figure out whether the file is actually changed or not
             // because the real content may be the same although the checksums do not match
-            if ( GeodiffUtils::hasPendingChanges( projectDir, filePath ) )
+            if ( GeodiffUtils::hasPendingChanges( projectDir, filePath, chkOld, chkLocal ) )
               diff.localUpdated << filePath;
           }
           else
@@ -2532,11 +4120,11 @@ ProjectDiff MerginApi::compareProjectFiles(
         if ( chkNew != chkLocal && chkOld != chkLocal )
         {
           // C/R-U/L-U
-          if ( isFileDiffable( filePath ) )
+          if ( isFileDiffable( filePath ) && checkDiffableFiles )
           {
             // we need to do a diff here to figure out whether the file is actually changed or not
             // because the real content may be the same although the checksums do not match
-            if ( GeodiffUtils::hasPendingChanges( projectDir, filePath ) )
+            if ( GeodiffUtils::hasPendingChanges( projectDir, filePath, chkOld, chkLocal ) )
               diff.conflictRemoteUpdatedLocalUpdated << filePath;
             else
               diff.remoteUpdated << filePath;
@@ -2737,7 +4325,29 @@ QJsonArray MerginApi::prepareUploadChangesJSON( const QList<MerginFile> &files )
     fileObject.insert( "size", file.size );
     fileObject.insert( "mtime", file.mtime.toString( Qt::ISODateWithMs ) );
 
-    if ( !file.diffName.isEmpty() )
+    if ( !file.deltaBlocks.isEmpty() )
+    {
+      // doing block delta upload: blocks of the new file that are not in the server file (nor earlier
+      // in the list) are uploaded in their order, the server copies the rest from its current file
+      QJsonArray blocksJson;
+      for ( const auto &block : file.deltaBlocks )
+      {
+        QJsonObject blockObject;
+        blockObject.insert( "checksum", block.first );
+        blockObject.insert( "size", block.second );
+        blocksJson.append( blockObject );
+      }
+
+      QJsonObject deltaObject;
+      deltaObject.insert( "path", file.diffName );
+      deltaObject.insert( "checksum", file.diffChecksum );
+      deltaObject.insert( "size", file.diffSize );
+      deltaObject.insert( "blocks", blocksJson );
+
+      fileObject.insert( "delta", deltaObject );
+      fileObject.insert( "checksum", file.checksum );
+    }
+    else if ( !file.diffName.isEmpty() )
     {
       // doing diff-based upload
       QJsonObject diffObject;
@@ -2771,6 +4381,13 @@ void MerginApi::finishProjectSync( const QString &projectFullName, bool syncSucc
 
   emit syncProjectStatusChanged( projectFullName, -1 );   // -1 means there's no sync going on
 
+  // block deltas get created again by the next push
+  for ( const MerginFile &merginFile : qAsConst( transaction.uploadFiles ) )
+  {
+    if ( !merginFile.deltaBlocks.isEmpty() )
+      QFile::remove( transaction.projectDir + "/.mergin/" + merginFile.diffName );
+  }
+
   if ( syncSuccessful )
   {
     // update the local metadata file
@@ -2779,6 +4396,10 @@ void MerginApi::finishProjectSync( const QString &projectFullName, bool syncSucc
     // update info of local projects
     mLocalProjects.updateLocalVersion( transaction.projectDir, transaction.version );
 
+    // nothing to resume anymore
+    if ( transaction.journal )
+      transaction.journal->remove();
+
     CoreUtils::log( "sync " + projectFullName, QStringLiteral( "### Finished ###  New project version: %1\n" ).arg( transaction.version ) );
   }
   else
@@ -2912,8 +4533,17 @@ QSet<QString> MerginApi::listFiles( const QString &path )
   return files;
 }
 
-DownloadQueueItem::DownloadQueueItem( const QString &fp, int s, int v, int rf, int rt, bool diff )
+DownloadQueueItem::DownloadQueueItem( const QString &fp, qint64 s, int v, qint64 rf, qint64 rt, bool diff )
   : filePath( fp ), size( s ), version( v ), rangeFrom( rf ), rangeTo( rt ), downloadDiff( diff )
 {
   tempFileName = CoreUtils::uuidWithoutBraces( QUuid::createUuid() );
 }
+
+QString DownloadQueueItem::key() const
+{
+  // a diff of a particular version never changes, a chunk of a file is identified by the checksum of the whole file
+  if ( downloadDiff )
+    return filePath + QStringLiteral( "|diff|v" ) + QString::number( version );
+
+  return filePath + "|" + fileChecksum + "|" + QString::number( rangeFrom ) + "-" + QString::number( rangeTo );
+}
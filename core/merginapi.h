@@ -10,7 +10,9 @@
 #ifndef MERGINAPI_H
 #define MERGINAPI_H
 
+#include <atomic>
 #include <memory>
+#include <functional>
 
 #include <QObject>
 #include <QNetworkAccessManager>
@@ -20,16 +22,23 @@
 #include <QUuid>
 #include <QPointer>
 #include <QSet>
+#include <QHash>
 #include <QByteArray>
 #include <QDateTime>
+#include <QFutureWatcher>
+#include <QCryptographicHash>
 
 #include "merginapistatus.h"
 #include "merginsubscriptionstatus.h"
 #include "merginprojectmetadata.h"
 #include "localprojectsmanager.h"
+#include "blockindex.h"
+#include "contentstore.h"
 #include "project.h"
 
 class MerginUserAuth;
+class ProjectFilesScanner;
+class TransactionJournal;
 class MerginUserInfo;
 class MerginSubscriptionInfo;
 class Purchasing;
@@ -98,15 +107,31 @@ struct ProjectDiff
  */
 struct DownloadQueueItem
 {
-  DownloadQueueItem( const QString &fp, int s, int v, int rf = -1, int rt = -1, bool diff = false );
+  DownloadQueueItem( const QString &fp, qint64 s, int v, qint64 rf = -1, qint64 rt = -1, bool diff = false );
 
   QString filePath;          //!< path within the project
-  int size;                  //!< size of the item in bytes
+  qint64 size;               //!< size of the item in bytes
   int version = -1;          //!< what version to download  (for ordinary files it will be the target version, for diffs it can be different version)
-  int rangeFrom = -1;        //!< what range of bytes to download (-1 if downloading the whole file)
-  int rangeTo = -1;          //!< what range of bytes to download (-1 if downloading the whole file)
+  qint64 rangeFrom = -1;     //!< what range of bytes to download (-1 if downloading the whole file)
+  qint64 rangeTo = -1;       //!< what range of bytes to download (-1 if downloading the whole file)
   bool downloadDiff = false; //!< whether to download just the diff between the previous version and the current one
   QString tempFileName;      //!< relative filename of the temporary file where the downloaded content will be stored
+  QString fileChecksum;      //!< checksum of the whole file on the server (only for chunks of full files)
+
+  //! Identifies the content of the item across transactions (used to find items already downloaded by an interrupted pull)
+  QString key() const;
+};
+
+/**
+ * Temp file of a download request that is written as the data arrive (already decompressed
+ * if the server compressed the response), so that the items are never held in memory as a whole.
+ */
+struct DownloadItemFile
+{
+  std::shared_ptr<QFile> file;
+  std::shared_ptr<QCryptographicHash> hash;  //!< checksum of the written content (for the journal)
+  qint64 size = 0;      //!< bytes received so far
+  bool failed = false;  //!< whether the temp file could not be written
 };
 
 
@@ -121,6 +146,7 @@ struct UpdateTask
     Copy,           //!< simply write a new version of the file
     CopyConflict,   //!< like Copy, but also create a conflict file of the locally modified file
     ApplyDiff,      //!< apply diffs
+    ApplyBlocks,    //!< assemble the new file from blocks of the local file and downloaded blocks
     Delete,         //!< remove files that have been removed from the server
   };
 
@@ -130,31 +156,108 @@ struct UpdateTask
   Method method;                  //!< what to do with the file
   QString filePath;               //!< what is the file path within project
   QList<DownloadQueueItem> data;  //!< list of chunks / list of diffs to apply
+
+  QList<BlockIndex::Block> blocks;     //!< only for ApplyBlocks: blocks of the new file (ranges of data cover those not in localBlocks)
+  QHash<QString, qint64> localBlocks;  //!< only for ApplyBlocks: offsets of blocks in the local file (by checksum)
+};
+
+/**
+ * Content available on the device that a pull does not need to download (verified on a worker thread)
+ */
+struct ReusableContent
+{
+  QSet<QString> downloadedItems;        //!< keys of items downloaded by an interrupted pull that are still fine
+  QHash<QString, QString> storedFiles;  //!< temp file names with the whole content of files (by path) taken from the content store
+};
+
+/**
+ * Content of a synced file to be kept in the content store (stored on a worker thread once the sync is done)
+ */
+struct StoredContent
+{
+  QString checksum;
+  QString filePath;
+  bool isTempFile;  //!< a temp file gets linked to the store and removed, a project file gets copied (it may be edited in place)
+};
+
+/**
+ * Blocks of large local files computed on a worker thread, so that a pull or push can use block delta
+ */
+struct LocalFileBlocks
+{
+  QHash<QString, QList<BlockIndex::Block>> blocks;  //!< blocks of the local files (by path), files that could not be read are missing
+  QHash<QString, MerginFile> deltaFiles;  //!< only for push: updated files set up to upload their block delta
+};
+
+/**
+ * A chunk of a file (or of its diff file) that is being uploaded during project upload (push).
+ */
+struct UploadChunkItem
+{
+  QString filePath;   //!< path within the project
+  QString chunkId;    //!< ID of the chunk as announced to the server in the push start request
+  qint64 size = 0;    //!< size of the chunk in bytes
+};
+
+/**
+ * Content of an upload chunk read (and compressed when it is worth it) on a worker thread
+ */
+struct UploadChunkBody
+{
+  bool isValid = false;       //!< whether the chunk could be read
+  QByteArray data;            //!< content of the chunk, deflated when isCompressed is true
+  bool isCompressed = false;
+  qint64 size = 0;            //!< size of the chunk before compression
 };
 
 struct TransactionStatus
 {
   qreal totalSize = 0;     //!< total size (in bytes) of files to be uploaded or downloaded
-  int transferedSize = 0;  //!< size (in bytes) of amount of data transferred so far
+  qint64 transferedSize = 0;  //!< size (in bytes) of amount of data transferred so far
   QString transactionUUID; //!< only for upload. Initially dummy non-empty string, after server confirms a valid UUID, on finish/cancel it is empty
 
   // download replies
   QPointer<QNetworkReply> replyProjectInfo;
-  QPointer<QNetworkReply> replyDownloadItem;
+  QPointer<QNetworkReply> replyDownloadItem;  //!< only used for download of mergin config
+  QHash<QNetworkReply *, DownloadQueueItem> replyPullItems;  //!< download requests currently in flight (up to MerginApi::maxParallelDownloads())
+  QHash<QNetworkReply *, DownloadItemFile> pullItemFiles;  //!< temp files being written by the download requests in flight
+  QHash<QNetworkReply *, MerginFile> replyBlockLists;  //!< requests of server blocks of files to be pulled by block delta (with the local file)
 
   // upload replies
   QPointer<QNetworkReply> replyUploadProjectInfo;
   QPointer<QNetworkReply> replyUploadStart;
-  QPointer<QNetworkReply> replyUploadFile;
+  QHash<QNetworkReply *, UploadChunkItem> replyPushChunks;  //!< chunk upload requests currently in flight (up to MerginApi::maxParallelUploads())
+  QHash<QFutureWatcher<UploadChunkBody> *, UploadChunkItem> pushChunksCompressing;  //!< chunks being compressed before their upload request (count as in flight)
   QPointer<QNetworkReply> replyUploadFinish;
 
+  QPointer<ProjectFilesScanner> localFilesScanner;  //!< set while local files are being scanned (before the pull/push can continue)
+  QPointer<QFutureWatcher<ReusableContent>> resumeVerifier;  //!< set while content of an interrupted pull or from the content store is being verified
+  QPointer<QFutureWatcher<LocalFileBlocks>> blocksComputation;  //!< set while blocks of large local files are being computed (for block delta)
+  QPointer<QFutureWatcher<QHash<QString, QString>>> blocksAssembly;  //!< set while files pulled by block delta are being assembled and verified
+  QPointer<QFutureWatcher<void>> contentStoring;  //!< set while content of the finished pull or push is being stored in the content store
+  std::shared_ptr<std::atomic<bool>> blocksCanceled = std::make_shared<std::atomic<bool>>( false );  //!< stops blocksComputation or blocksAssembly on the worker thread
+
+  std::shared_ptr<TransactionJournal> journal;  //!< persistent record of the transferred data, so that the transaction can be resumed
+
   // download-related data
   QList<DownloadQueueItem> downloadQueue;  //!< pending list of stuff to download - chunks of project files or diff files (at the end of transaction it is empty)
   QList<UpdateTask> updateTasks;  //!< tasks to do at the end of update (pull) when everything has been downloaded
+  QHash<QString, int> pullItemsPending;  //!< number of download items per file path that have not been downloaded yet
+  QHash<QString, QList<BlockIndex::Block>> pullServerBlocks;  //!< blocks of server files to be pulled by block delta (by path), planned once local blocks are known
+  QHash<QString, QList<BlockIndex::Block>> pullLocalBlocks;  //!< blocks of local files to be pulled by block delta (by path)
 
   // upload-related data
   QList<MerginFile> uploadQueue; //!< pending list of files to upload (at the end of transaction it is empty)
+  int uploadChunkNo = 0;  //!< index of the next chunk of the first file in uploadQueue that should be uploaded
+  QHash<QString, int> pushChunksPending;  //!< number of chunks per file path that have not been confirmed by the server yet
   QList<MerginFile> uploadDiffFiles;  //!< these are just diff files for upload - we don't remove them when uploading chunks (needed for finalization)
+  QSet<QString> uploadedChunks;  //!< chunks confirmed by the server in an interrupted push that is being resumed
+  int uploadBaseVersion = -1;  //!< server version on top of which we are pushing
+  QByteArray uploadStartJson;  //!< body of the push start request (to start again if the server forgot the resumed transaction)
+  QList<MerginFile> uploadFiles;  //!< all files to upload (uploadQueue gets consumed)
+  bool resumedPush = false;  //!< whether we continue with a transaction started by an interrupted push
+  QHash<QString, QList<BlockIndex::Block>> uploadFileBlocks;  //!< blocks of uploaded large files, stored to the block index once the push is finished
+  QSet<QString> incompressibleFiles;  //!< files whose uploaded chunks did not compress well - the other chunks are sent as they are
 
   QString projectDir;
   QByteArray projectMetadata;  //!< metadata of the new project (not parsed)
@@ -327,6 +430,9 @@ class MerginApi: public QObject
 
     static bool isFileDiffable( const QString &fileName ) { return fileName.endsWith( ".gpkg" ); }
 
+    //! Whether the file format is compressed already (photos, archives, ...), so compressing it for a transfer does not pay off
+    static bool isFileCompressed( const QString &fileName );
+
     //! Get a list of all files that can be used with geodiff
     QStringList projectDiffableFiles( const QString &projectFullName );
 
@@ -373,6 +479,10 @@ class MerginApi: public QObject
      *  after changes in "config"
      *
      * Without the three sources it is possible to miss some of the updates that need to be handled (e.g. conflicts)
+     *
+     * Locally updated diffable files are checked with geodiff whether they really contain changes. With "checkDiffableFiles"
+     * set to false the check is skipped and such files are reported as updated based on their checksums only
+     * (the caller is then expected to check them on its own, e.g. using ChangesetSummaryService).
      */
     static ProjectDiff compareProjectFiles(
       const QList<MerginFile> &oldServerFiles,
@@ -381,7 +491,8 @@ class MerginApi: public QObject
       const QString &projectDir,
       bool allowConfig = false,
       const MerginConfig &config = MerginConfig(),
-      const MerginConfig &lastSyncConfig = MerginConfig()
+      const MerginConfig &lastSyncConfig = MerginConfig(),
+      bool checkDiffableFiles = true
     );
 
     static QList<MerginFile> getLocalProjectFiles( const QString &projectPath );
@@ -426,6 +537,39 @@ class MerginApi: public QObject
     bool supportsSelectiveSync() const;
     void setSupportsSelectiveSync( bool supportsSelectiveSync );
 
+    /**
+     * Returns maximum number of download requests (chunks or diffs) that may be in flight
+     * at the same time for a single pull transaction.
+     */
+    int maxParallelDownloads() const;
+
+    /**
+     * Sets maximum number of download requests per pull transaction. Values lower than 1 are clamped to 1
+     * (strictly serial download). The change is applied to the next requests that are sent.
+     */
+    void setMaxParallelDownloads( int maxParallelDownloads );
+
+    /**
+     * Returns maximum number of chunk upload requests that may be in flight at the same time
+     * for a single push transaction. Chunks of different files may be uploaded concurrently.
+     */
+    int maxParallelUploads() const;
+
+    /**
+     * Sets maximum number of chunk upload requests per push transaction. Values lower than 1 are clamped to 1
+     * (strictly serial upload). The change is applied to the next requests that are sent.
+     */
+    void setMaxParallelUploads( int maxParallelUploads );
+
+    /**
+     * Returns maximum size (in bytes) of the device-wide store of synced file content, which lets pulls
+     * take files already present on the device instead of downloading them.
+     */
+    qint64 contentStoreMaxSize() const;
+
+    //! Sets maximum size of the content store, zero disables the store. Objects over the limit are removed on the next sync
+    void setContentStoreMaxSize( qint64 contentStoreMaxSize );
+
   signals:
     void apiSupportsSubscriptionsChanged();
     void supportsSelectiveSyncChanged();
@@ -472,7 +616,9 @@ class MerginApi: public QObject
 
     // Pull slots
     void updateInfoReplyFinished();
+    void downloadItemReadyRead();
     void downloadItemReplyFinished();
+    void blockListReplyFinished();
     void cacheServerConfig();
 
     // Push slots
@@ -512,12 +658,28 @@ class MerginApi: public QObject
 
     /**
      * Sends non-blocking POST request to the server to upload a file (chunk).
+     * The chunk content is streamed from the disk, it is not read to memory upfront.
      * \param projectFullName Namespace/name
      * \param transactionUUID Transaction ID which servers sends on uploadStart
      * \param file Mergin file to upload
      * \param chunkNo Chunk number of given file to be uploaded
      */
-    void uploadFile( const QString &projectFullName, const QString &transactionUUID, MerginFile file, int chunkNo = 0 );
+    void uploadFile( const QString &projectFullName, const QString &transactionUUID, const MerginFile &file, int chunkNo = 0 );
+
+    //! Starts upload requests of next chunks until the parallel upload window is full (or finishes the upload)
+    void uploadNextChunks( const QString &projectFullName );
+
+    //! Aborts and forgets all chunk upload requests of the transaction that are still in flight (or being compressed)
+    void abortPendingUploads( TransactionStatus &transaction );
+
+    /**
+     * Returns chunk IDs (by file path) of the push transaction recorded in the journal by an interrupted push,
+     * if it has been started with the same \a files and \a removedFiles. Returns empty hash otherwise.
+     */
+    QHash<QString, QStringList> resumableUploadChunks( const QString &projectFullName, const QList<MerginFile> &files, const QStringList &removedFiles );
+
+    //! Starts a new push transaction after the server rejected the resumed one
+    void restartProjectUpload( const QString &projectFullName );
 
     /**
      * Closing request after successful upload.
@@ -561,26 +723,138 @@ class MerginApi: public QObject
      */
     QNetworkReply *getProjectInfo( const QString &projectFullName, bool withoutAuth = false );
 
-    //! Called when download/update of project data has finished to finalize things and emit sync finished signal
+    /**
+     * Called when download/update of project data has finished. Files pulled by block delta get assembled
+     * and verified on a worker thread first, then continues with applyProjectUpdateTasks()
+     */
     void finalizeProjectUpdate( const QString &projectFullName );
 
+    /**
+     * Runs the update tasks with files pulled by block delta already assembled in temp files (\a assembledFiles by path),
+     * files that failed to assemble are downloaded in full first. New content is kept in the content store
+     * on a worker thread, then continues with finishProjectUpdate()
+     */
+    void applyProjectUpdateTasks( const QString &projectFullName, const QHash<QString, QString> &assembledFiles );
+
+    //! Removes the temp dir of the finished pull, adds the project if it is new and emits sync finished signal
+    void finishProjectUpdate( const QString &projectFullName );
+
     void finalizeProjectUpdateCopy( const QString &projectFullName, const QString &projectDir, const QString &tempDir, const QString &filePath, const QList<DownloadQueueItem> &items );
-    void finalizeProjectUpdateApplyDiff( const QString &projectFullName, const QString &projectDir, const QString &tempDir, const QString &filePath, const QList<DownloadQueueItem> &items );
+    /**
+     * Applies downloaded diffs to a diffable file and its basefile. Local changes are rebased on top of the server changes
+     * when \a hasLocalChanges is true, otherwise both files are updated in place. \a tempDir is used as a scratch area.
+     */
+    void finalizeProjectUpdateApplyDiff( const QString &projectFullName, const QString &projectDir, const QString &tempDir, const QString &filePath, const QList<DownloadQueueItem> &items, bool hasLocalChanges );
 
     //! Takes care of removal of the transaction, writing new metadata and emits syncProjectFinished()
     void finishProjectSync( const QString &projectFullName, bool syncSuccessful );
 
     void prepareProjectUpdate( const QString &projectFullName, const QByteArray &data );
 
+    //! Starts scan of local project files and then continues with continueProjectUpdate()
     void startProjectUpdate( const QString &projectFullName );
 
+    //! Figures out what needs to be downloaded based on the scanned local files and starts the download
+    void continueProjectUpdate( const QString &projectFullName, const QList<MerginFile> &localFiles );
+
+    /**
+     * Verifies (on a worker thread) temp files left by an interrupted pull of the project and links \a storedFiles
+     * (checksums by file path) from the content store to the temp directory, then continues with startDownload().
+     * Items whose content does not match the expected checksum are downloaded.
+     */
+    void verifyReusableContent( const QString &projectFullName, bool resuming, const QHash<QString, QString> &storedFiles );
+
+    /**
+     * Continues the download of update tasks - with files left by an interrupted pull and files
+     * from the content store if there are any
+     */
+    void prepareDownload( const QString &projectFullName );
+
+    //! Whether the file may be transferred by block delta (only blocks missing on the other side)
+    bool canUseBlockDelta( const QString &filePath, qint64 fileSize ) const;
+
+    //! Requests blocks of the server version of a file that is going to be pulled by block delta
+    void requestBlockList( const QString &projectFullName, const MerginFile &localFile );
+
+    /**
+     * Gets blocks of \a localFiles to be pulled by block delta on a worker thread (from the block index
+     * or by reading the files), then continues with planBlockDownloads() once the block lists have arrived too
+     */
+    void computePullLocalBlocks( const QString &projectFullName, const QList<MerginFile> &localFiles );
+
+    //! Adds update tasks of files pulled by block delta once both local and server blocks are known, then continues with prepareDownload()
+    void planBlockDownloads( const QString &projectFullName );
+
+    /**
+     * Turns \a task to ApplyBlocks task that downloads only the \a serverBlocks missing in the local file (made of \a localBlocks).
+     * Returns false (and leaves the task untouched) if the delta would not save enough.
+     */
+    bool planBlockDownload( const QString &projectFullName, const MerginFile &serverFile, const QList<BlockIndex::Block> &serverBlocks,
+                            const QList<BlockIndex::Block> &localBlocks, UpdateTask &task );
+
+    //! Writes the new file of ApplyBlocks \a task to \a outputPath, returns false on failure or when \a canceled gets set. Runs on worker threads
+    static bool assembleFileFromBlocks( const QString &projectFullName, const QString &projectDir, const QString &tempDir,
+                                        const UpdateTask &task, const QString &outputPath, const std::atomic<bool> &canceled );
+
+    /**
+     * Writes blocks of the locally updated file that are not in \a baseBlocks to a file in the .mergin directory
+     * and sets it up as the data to upload in \a merginFile. Returns false if the delta would not save enough
+     * or when \a canceled gets set. Runs on worker threads
+     */
+    static bool createBlockDelta( const QString &projectFullName, const QString &projectDir, const QList<BlockIndex::Block> &baseBlocks,
+                                  const QList<BlockIndex::Block> &newBlocks, MerginFile &merginFile, const std::atomic<bool> &canceled );
+
+    //! Starts download of items of update tasks, skipping the content that is already on the device
+    void startDownload( const QString &projectFullName, const ReusableContent &reusable );
+
+    //! Returns store of file content shared by all projects on the device
+    ContentStore contentStore() const;
+
+    /**
+     * Removes temp files and the journal of a failed pull and for first time download also the project directory.
+     * With \a keepResumable nothing is removed if the journal exists, so that the next pull can continue.
+     */
+    void discardProjectUpdate( const QString &projectFullName, bool keepResumable );
+
+    /**
+     * Figures out what needs to be uploaded based on the scanned local files. Blocks of large files
+     * are computed on a worker thread (for block delta), then continues with startProjectUpload()
+     */
+    void continueProjectUpload( const QString &projectFullName, const QByteArray &data, const QList<MerginFile> &localFiles );
+
+    //! Starts the push transaction (or resumes an interrupted one) with the files to upload
+    void startProjectUpload( const QString &projectFullName, const QByteArray &data, QList<MerginFile> addedMerginFiles,
+                             QList<MerginFile> updatedMerginFiles, const QList<MerginFile> &deletedMerginFiles, const QList<MerginFile> &diffFiles );
+
+    /**
+     * Scans files of the transaction's project on worker threads and calls \a callback
+     * with the result (unless the transaction gets canceled meanwhile)
+     */
+    void scanLocalProjectFiles( const QString &projectFullName, std::function<void( const QList<MerginFile> & )> callback );
+
     //! Takes care of finding the correct config file, appends it to current transaction and proceeds with project update
     void prepareDownloadConfig( const QString &projectFullName, bool downloaded = false );
     void requestServerConfig( const QString &projectFullName );
 
-    //! Starts download request of another item
+    //! Starts download requests of next items until the parallel download window is full (or finalizes the update)
     void downloadNextItem( const QString &projectFullName );
 
+    //! Aborts and forgets all download requests of the transaction that are still in flight
+    void abortPendingDownloads( TransactionStatus &transaction );
+
+    //! Writes data received so far by the download request to its temp file
+    void writeDownloadedData( QNetworkReply *reply, DownloadItemFile &itemFile );
+
+    /**
+     * Returns \a body compressed with "deflate" content coding (and sets Content-Encoding of the \a request)
+     * if the server accepts compressed requests and it saves enough, otherwise returns \a body as it is.
+     * Content of already compressed file formats (by \a filePath) is not compressed.
+     */
+    QByteArray compressRequestBody( QNetworkRequest &request, const QByteArray &body, const QString &filePath = QString() ) const;
+
+    //! Returns \a body in "deflate" content coding, or a null array when it is too small or it does not save enough. May be called from worker threads
+    static QByteArray deflateBody( const QByteArray &body );
+
     //! Removes temp folder for project
     void removeProjectsTempFolder( const QString &projectNamespace, const QString &projectName );
 
@@ -608,16 +882,29 @@ class MerginApi: public QObject
     Transactions mTransactionalStatus; //projectFullname -> transactionStatus
     static const QSet<QString> sIgnoreExtensions;
     static const QSet<QString> sIgnoreImageExtensions;
+    static const QSet<QString> sCompressedExtensions;
     static const QSet<QString> sIgnoreFiles;
     QEventLoop mAuthLoopEvent;
     MerginApiStatus::VersionStatus mApiVersionStatus = MerginApiStatus::VersionStatus::UNKNOWN;
     bool mApiSupportsSubscriptions = false;
+    bool mApiSupportsBlockDelta = false;  //!< whether the server lists blocks of files and accepts block delta uploads
+    bool mApiSupportsCompression = false;  //!< whether the server accepts request bodies with "deflate" content coding
     bool mSupportsSelectiveSync = true;
+    int mMaxParallelDownloads = DOWNLOAD_PARALLEL_REQUESTS;
+    int mMaxParallelUploads = UPLOAD_PARALLEL_REQUESTS;
+    qint64 mContentStoreMaxSize = ContentStore::DEFAULT_MAX_SIZE;
 
     static const int CHUNK_SIZE = 65536;
+    static const int DOWNLOAD_PARALLEL_REQUESTS = 4;
+    static const int UPLOAD_PARALLEL_REQUESTS = 4;
     static const int UPLOAD_CHUNK_SIZE;
+    static const int BLOCK_DELTA_MAX_PERCENT = 50;  //!< block delta is used only if it transfers at most this part of the file
+    static const int COMPRESSION_MIN_SIZE = 1024;  //!< smaller request bodies are sent as they are
+    static const int COMPRESSION_MIN_SAVING_PERCENT = 10;  //!< request bodies that compress worse are sent as they are
+    static const int COMPRESSION_MAX_CHUNK_SIZE = 1024 * 1024;  //!< larger upload chunks are streamed as they are (not read to memory to be compressed)
     const int PROJECT_PER_PAGE = 50;
     const QString TEMP_FOLDER = QStringLiteral( ".temp/" );
+    const QString CONTENT_STORE_FOLDER = QStringLiteral( ".store" );
 
     static QList<DownloadQueueItem> itemsForFileChunks( const MerginFile &file, int version );
     static QList<DownloadQueueItem> itemsForFileDiffs( const MerginFile &file );
@@ -625,6 +912,7 @@ class MerginApi: public QObject
     friend class TestMerginApi;
     friend class Purchasing;
     friend class PurchasingTransaction;
+    friend class ProjectFilesScanner;
 };
 
 #endif // MERGINAPI_H
@@ -31,6 +31,13 @@ struct MerginFile
   QString diffBaseChecksum;  //!< checksum of the base file
   qint64 diffSize;           //!< size (in bytes) of the diff file
 
+  //
+  // these are members only used for upload of changed file through a block delta (non-diffable files).
+  // The uploaded data (blocks that the server does not have) are stored in the diff file
+  //
+
+  QList< QPair<QString, qint64> > deltaBlocks;  //!< if non-empty, checksums and sizes of all blocks of the new file
+
   //
   // these are members only user for update of changed file through geodiff
   // (could be multiple diffs that need to be applied sequentially)
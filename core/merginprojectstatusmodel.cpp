@@ -15,6 +15,8 @@ MerginProjectStatusModel::MerginProjectStatusModel( LocalProjectsManager &localP
   : QAbstractListModel( parent )
   , mLocalProjects( localProjects )
 {
+  connect( &mSummaryService, &ChangesetSummaryService::summaryReady, this, &MerginProjectStatusModel::summaryReady );
+  connect( &mSummaryService, &ChangesetSummaryService::finished, this, &MerginProjectStatusModel::summariesFinished );
 }
 
 int MerginProjectStatusModel::rowCount( const QModelIndex &parent ) const
@@ -77,65 +79,160 @@ void MerginProjectStatusModel::infoProjectUpdated( const ProjectDiff &projectDif
 {
   beginResetModel();
   mItems.clear();
+  mProjectDir = projectDir;
 
   insertIntoItems( projectDiff.localUpdated, ProjectChangelogStatus::Updated, projectDir );
   insertIntoItems( projectDiff.localAdded, ProjectChangelogStatus::Added, projectDir );
   insertIntoItems( projectDiff.localDeleted, ProjectChangelogStatus::Deleted, projectDir );
 
-  for ( const QString &file : projectDiff.localUpdated )
+  endResetModel();
+}
+
+void MerginProjectStatusModel::summaryReady( const QString &projectDir, const QString &filePath, const QString &summaryJson )
+{
+  if ( projectDir != mProjectDir )
+    return;
+
+  QList<ProjectStatusItem> items;
+
+  if ( summaryJson.startsWith( "ERROR" ) )
   {
-    if ( MerginApi::isFileDiffable( file ) )
-    {
-      QString summaryJson = GeodiffUtils::diffableFilePendingChanges( projectDir, file, true );
-      if ( summaryJson.startsWith( "ERROR" ) )
-      {
-        CoreUtils::log( "MerginProjectStatusModel", QString( "Diff summary JSON for %1 in %2 has an error." ).arg( projectDir ).arg( file ) );
+    CoreUtils::log( "MerginProjectStatusModel", QString( "Diff summary JSON for %1 in %2 has an error." ).arg( projectDir ).arg( filePath ) );
 
-        ProjectStatusItem item;
-        item.status = ProjectChangelogStatus::Message;
-        item.text =  tr( "Failed to determine changes" );
-        item.filename = file;
-        item.section = file;
+    ProjectStatusItem item;
+    item.status = ProjectChangelogStatus::Message;
+    item.text =  tr( "Failed to determine changes" );
+    item.filename = filePath;
+    item.section = filePath;
 
-        mItems.append( item );
-      }
-      else
+    items.append( item );
+  }
+  else
+  {
+    GeodiffUtils::ChangesetSummary summary = GeodiffUtils::parseChangesetSummary( summaryJson ) ;
+    if ( summary.isEmpty() )
+    {
+      // checksums differ, but the content is the same - the file is not really updated
+      for ( int i = 0; i < mItems.count(); ++i )
       {
-        GeodiffUtils::ChangesetSummary summary = GeodiffUtils::parseChangesetSummary( summaryJson ) ;
-        for ( QString key : summary.keys() )
+        if ( mItems[i].status == ProjectChangelogStatus::Updated && mItems[i].text == filePath )
         {
-
-          ProjectStatusItem item;
-          item.status = ProjectChangelogStatus::Changelog;
-          item.text =  key;
-          item.filename = file;
-          item.inserts = summary[key].inserts;
-          item.updates = summary[key].updates;
-          item.deletes = summary[key].deletes;
-          item.section = file;
-
-          mItems.append( item );
+          beginRemoveRows( QModelIndex(), i, i );
+          mItems.removeAt( i );
+          endRemoveRows();
+          break;
         }
-
       }
+      return;
+    }
+
+    for ( QString key : summary.keys() )
+    {
+      ProjectStatusItem item;
+      item.status = ProjectChangelogStatus::Changelog;
+      item.text =  key;
+      item.filename = filePath;
+      item.inserts = summary[key].inserts;
+      item.updates = summary[key].updates;
+      item.deletes = summary[key].deletes;
+      item.section = filePath;
+
+      items.append( item );
     }
   }
-  endResetModel();
+
+  appendItems( items );
+}
+
+void MerginProjectStatusModel::appendItems( const QList<ProjectStatusItem> &items )
+{
+  if ( items.isEmpty() )
+    return;
+
+  beginInsertRows( QModelIndex(), mItems.count(), mItems.count() + items.count() - 1 );
+  mItems.append( items );
+  endInsertRows();
 }
 
-bool MerginProjectStatusModel::loadProjectInfo( const QString &projectFullName )
+void MerginProjectStatusModel::summariesFinished( const QString &projectDir )
 {
+  if ( projectDir != mProjectDir || !mInfoPending )
+    return;
+
+  // rows of diffable files without real changes have been removed meanwhile
+  mInfoPending = false;
+  emit projectInfoLoaded( !mItems.isEmpty() );
+}
+
+void MerginProjectStatusModel::loadProjectInfo( const QString &projectFullName )
+{
+  mSummaryService.cancel();
+  mInfoPending = false;
+  if ( mScanner )
+  {
+    mScanner->cancel();
+    mScanner->deleteLater();
+  }
+
   LocalProject projectInfo = mLocalProjects.projectFromMerginName( projectFullName );
-  if ( !projectInfo.projectDir.isEmpty() )
+  if ( projectInfo.projectDir.isEmpty() )
   {
-    ProjectDiff diff = MerginApi::localProjectChanges( projectInfo.projectDir );
+    emit projectInfoLoaded( false );
+    return;
+  }
 
-    bool hasLocalChanges = !diff.localAdded.isEmpty() || !diff.localUpdated.isEmpty() || !diff.localDeleted.isEmpty();
+  // hashing of modified files must not block the UI
+  mProjectDir = projectInfo.projectDir;
+  mScanner = new ProjectFilesScanner( mProjectDir + "/", this );
+  connect( mScanner, &ProjectFilesScanner::finished, this, &MerginProjectStatusModel::localFilesScanned );
+  mScanner->start();
+}
+
+void MerginProjectStatusModel::localFilesScanned( const QList<MerginFile> &localFiles )
+{
+  ProjectFilesScanner *scanner = qobject_cast<ProjectFilesScanner *>( sender() );
+  if ( scanner != mScanner )
+    return;
+
+  mScanner = nullptr;
+  scanner->deleteLater();
+
+  QString projectDir = mProjectDir;
+  MerginProjectMetadata projectMetadata = MerginProjectMetadata::fromCachedJson( projectDir + "/" + MerginApi::sMetadataFile );
+  MerginConfig config = MerginConfig::fromFile( projectDir + "/" + MerginApi::sMerginConfigFile );
+
+  // updated diffable files are checked with geodiff in the background (see summaryReady())
+  ProjectDiff diff = MerginApi::compareProjectFiles( projectMetadata.files, projectMetadata.files, localFiles, projectDir,
+                     config.isValid, config, MerginConfig(), false );
 
-    if ( hasLocalChanges )
-      infoProjectUpdated( diff, projectInfo.projectDir );
+  infoProjectUpdated( diff, projectDir );
 
-    return hasLocalChanges;
+  QHash<QString, QString> localChecksums;
+  for ( const MerginFile &file : localFiles )
+    localChecksums.insert( file.path, file.checksum );
+
+  // per-table summaries of updated diffable files also tell whether they have any changes at all
+  QList<ChangesetSummaryService::Request> requests;
+  for ( const QString &file : qAsConst( diff.localUpdated ) )
+  {
+    if ( !MerginApi::isFileDiffable( file ) )
+      continue;
+
+    ChangesetSummaryService::Request request;
+    request.filePath = file;
+    request.baseChecksum = projectMetadata.fileInfo( file ).checksum;
+    request.modifiedChecksum = localChecksums.value( file );
+    requests << request;
   }
-  return false;
+
+  // with other changes the answer is known already, otherwise it waits for the summaries
+  bool hasOtherChanges = std::any_of( mItems.constBegin(), mItems.constEnd(), []( const ProjectStatusItem & item )
+  {
+    return item.status != ProjectChangelogStatus::Updated || !MerginApi::isFileDiffable( item.text );
+  } );
+  mInfoPending = !hasOtherChanges && !mItems.isEmpty();
+  if ( !mInfoPending )
+    emit projectInfoLoaded( hasOtherChanges );
+
+  mSummaryService.request( projectDir, requests );
 }
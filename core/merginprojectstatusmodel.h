@@ -12,7 +12,10 @@
 
 #include <QObject>
 #include <QAbstractListModel>
+#include <QPointer>
 #include "merginapi.h"
+#include "changesetsummaryservice.h"
+#include "projectfilesscanner.h"
 
 class MerginProjectStatusModel : public QAbstractListModel
 {
@@ -59,14 +62,34 @@ class MerginProjectStatusModel : public QAbstractListModel
     QHash<int, QByteArray> roleNames() const override;
     Q_INVOKABLE QVariant data( const QModelIndex &index, int role ) const override;
 
-    Q_INVOKABLE bool loadProjectInfo( const QString &projectFullName );
+    /**
+     * Starts loading of local changes of the project, projectInfoLoaded() is emitted once it is known whether there are any.
+     * Project files are scanned and summaries of changes in diffable files are computed in the background,
+     * the summaries are added to the model once available.
+     */
+    Q_INVOKABLE void loadProjectInfo( const QString &projectFullName );
+
+  signals:
+    //! Emitted when the list of local changes requested by loadProjectInfo() is available
+    void projectInfoLoaded( bool hasLocalChanges );
+
+  private slots:
+    void localFilesScanned( const QList<MerginFile> &localFiles );
+    void summaryReady( const QString &projectDir, const QString &filePath, const QString &summaryJson );
+    void summariesFinished( const QString &projectDir );
 
   private:
     void insertIntoItems( const QSet<QString> &files, const ProjectChangelogStatus &status, const QString &projectDir );
     void infoProjectUpdated( const ProjectDiff &projectDiff, const QString &projectDir );
+    void appendItems( const QList<ProjectStatusItem> &items );
 
     ProjectDiff mProjectDiff;
     QList<ProjectStatusItem> mItems;
+    QString mProjectDir;  //!< project whose changes are in the model
+    bool mInfoPending = false;  //!< whether projectInfoLoaded() waits for summaries (only unchanged diffable files may be listed)
+
+    QPointer<ProjectFilesScanner> mScanner;  //!< set while files of the project are being scanned
+    ChangesetSummaryService mSummaryService;
 
     LocalProjectsManager &mLocalProjects;
 
@@ -0,0 +1,157 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "projectchecksumcache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include "coreutils.h"
+
+ProjectChecksumCache::ProjectChecksumCache( const QString &projectDir )
+  : mProjectDir( projectDir )
+{
+  load();
+}
+
+QString ProjectChecksumCache::checksum( const QString &filePath, const QFileInfo &info ) const
+{
+  auto it = mEntries.constFind( filePath );
+  if ( it == mEntries.constEnd() )
+    return QString();
+
+  if ( it->size != info.size() || it->mtime != info.lastModified().toMSecsSinceEpoch() )
+    return QString();
+
+  return it->checksum;
+}
+
+void ProjectChecksumCache::insert( const QString &filePath, const QFileInfo &info, const QString &checksum )
+{
+  // the file could be still written to without changing its modification time - do not trust it yet
+  if ( info.lastModified() > QDateTime::currentDateTime().addSecs( -RACY_MTIME_SECS ) )
+  {
+    remove( filePath );
+    return;
+  }
+
+  Entry entry;
+  entry.size = info.size();
+  entry.mtime = info.lastModified().toMSecsSinceEpoch();
+  entry.checksum = checksum;
+  mEntries.insert( filePath, entry );
+  mModified = true;
+}
+
+void ProjectChecksumCache::remove( const QString &filePath )
+{
+  if ( mEntries.remove( filePath ) )
+    mModified = true;
+}
+
+void ProjectChecksumCache::retain( const QSet<QString> &filePaths )
+{
+  for ( auto it = mEntries.begin(); it != mEntries.end(); )
+  {
+    if ( !filePaths.contains( it.key() ) )
+    {
+      it = mEntries.erase( it );
+      mModified = true;
+    }
+    else
+      ++it;
+  }
+}
+
+bool ProjectChecksumCache::save()
+{
+  if ( !mModified )
+    return true;
+
+  if ( !QDir( mProjectDir + "/.mergin" ).exists() )
+    return false;  // not a mergin project
+
+  QJsonObject files;
+  for ( auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it )
+  {
+    QJsonObject entry;
+    entry.insert( QStringLiteral( "size" ), it->size );
+    entry.insert( QStringLiteral( "mtime" ), it->mtime );
+    entry.insert( QStringLiteral( "checksum" ), it->checksum );
+    files.insert( it.key(), entry );
+  }
+
+  QJsonObject root;
+  root.insert( QStringLiteral( "version" ), CACHE_VERSION );
+  root.insert( QStringLiteral( "files" ), files );
+
+  // write to a temporary file first so that a crash never leaves a half-written index behind
+  QSaveFile f( cacheFilePath( mProjectDir ) );
+  if ( !f.open( QIODevice::WriteOnly ) )
+  {
+    CoreUtils::log( "checksum cache", "Failed to open for writing: " + f.fileName() );
+    return false;
+  }
+  f.write( QJsonDocument( root ).toJson( QJsonDocument::Compact ) );
+  if ( !f.commit() )
+  {
+    CoreUtils::log( "checksum cache", "Failed to write: " + f.fileName() );
+    return false;
+  }
+
+  mModified = false;
+  return true;
+}
+
+void ProjectChecksumCache::invalidate( const QString &projectDir, const QStringList &filePaths )
+{
+  if ( filePaths.isEmpty() || !QFile::exists( cacheFilePath( projectDir ) ) )
+    return;
+
+  ProjectChecksumCache cache( projectDir );
+  for ( const QString &filePath : filePaths )
+    cache.remove( filePath );
+  cache.save();
+}
+
+QString ProjectChecksumCache::cacheFilePath( const QString &projectDir )
+{
+  return projectDir + "/.mergin/checksums.json";
+}
+
+void ProjectChecksumCache::load()
+{
+  QFile f( cacheFilePath( mProjectDir ) );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return;
+
+  QJsonDocument doc = QJsonDocument::fromJson( f.readAll() );
+  if ( !doc.isObject() || doc.object().value( QStringLiteral( "version" ) ).toInt() != CACHE_VERSION )
+  {
+    // unknown or corrupted content - start from scratch, it gets overwritten on next save
+    mModified = true;
+    return;
+  }
+
+  const QJsonObject files = doc.object().value( QStringLiteral( "files" ) ).toObject();
+  for ( auto it = files.constBegin(); it != files.constEnd(); ++it )
+  {
+    QJsonObject obj = it.value().toObject();
+    Entry entry;
+    entry.size = static_cast<qint64>( obj.value( QStringLiteral( "size" ) ).toDouble( -1 ) );
+    entry.mtime = static_cast<qint64>( obj.value( QStringLiteral( "mtime" ) ).toDouble( -1 ) );
+    entry.checksum = obj.value( QStringLiteral( "checksum" ) ).toString();
+    if ( !entry.checksum.isEmpty() )
+      mEntries.insert( it.key(), entry );
+  }
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROJECTCHECKSUMCACHE_H
+#define PROJECTCHECKSUMCACHE_H
+
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+/**
+ * Persistent index of checksums of project files, stored in the project's .mergin directory.
+ * Entries are keyed by the relative path of the file and are valid only as long as
+ * the size and modification time of the file stay the same, so only files that have changed
+ * since the last scan need to be hashed again.
+ *
+ * Files modified just before they got hashed are not stored in the index: their modification time
+ * could stay the same after another quick write (low resolution of file system timestamps).
+ */
+class ProjectChecksumCache
+{
+  public:
+    //! Loads the index of the project in given directory (if there is any)
+    explicit ProjectChecksumCache( const QString &projectDir );
+
+    /**
+     * Returns cached checksum of a file (path relative to the project directory) or an empty
+     * string if there is no entry or the file has been changed since it was stored.
+     */
+    QString checksum( const QString &filePath, const QFileInfo &info ) const;
+
+    //! Stores checksum of a file (path relative to the project directory)
+    void insert( const QString &filePath, const QFileInfo &info, const QString &checksum );
+
+    //! Forgets entry of a file (path relative to the project directory)
+    void remove( const QString &filePath );
+
+    //! Forgets entries of all files that are not in the given list of paths
+    void retain( const QSet<QString> &filePaths );
+
+    /**
+     * Writes the index to the disk if it has been modified. The index is only written
+     * to projects that already have .mergin directory.
+     */
+    bool save();
+
+    //! Removes cached checksums of given files of a project (e.g. when they get overwritten during sync)
+    static void invalidate( const QString &projectDir, const QStringList &filePaths );
+
+    //! Returns path of the index file for project in given directory
+    static QString cacheFilePath( const QString &projectDir );
+
+  private:
+    struct Entry
+    {
+      qint64 size = -1;
+      qint64 mtime = -1;  //!< modification time in milliseconds since epoch
+      QString checksum;
+    };
+
+    void load();
+
+    QString mProjectDir;
+    QHash<QString, Entry> mEntries;
+    bool mModified = false;
+
+    static const int CACHE_VERSION = 1;
+    static const int RACY_MTIME_SECS = 2;
+};
+
+#endif // PROJECTCHECKSUMCACHE_H
@@ -0,0 +1,146 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "projectfilesscanner.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+#include "coreutils.h"
+#include "merginapi.h"
+#include "projectchecksumcache.h"
+
+ProjectFilesScanner::ProjectFilesScanner( const QString &projectPath, QObject *parent )
+  : QObject( parent )
+  , mProjectPath( projectPath )
+{
+  connect( &mListingWatcher, &QFutureWatcher<Listing>::finished, this, &ProjectFilesScanner::listingFinished );
+  connect( &mHashingWatcher, &QFutureWatcher<QByteArray>::finished, this, &ProjectFilesScanner::hashingFinished );
+  connect( &mHashingWatcher, &QFutureWatcher<QByteArray>::progressValueChanged, this, [this]( int value )
+  {
+    emit progressChanged( value, mListing.filesToHash.count() );
+  } );
+}
+
+ProjectFilesScanner::~ProjectFilesScanner()
+{
+  cancel();
+
+  // the worker threads must not outlive the watchers
+  mListingWatcher.waitForFinished();
+  mHashingWatcher.waitForFinished();
+}
+
+void ProjectFilesScanner::start()
+{
+  Q_ASSERT( !isRunning() );
+
+  mCanceled = false;
+  mListingWatcher.setFuture( QtConcurrent::run( &ProjectFilesScanner::listFiles, mProjectPath ) );
+}
+
+void ProjectFilesScanner::cancel()
+{
+  mCanceled = true;
+  mHashingWatcher.cancel();  // directory listing can't be canceled, its result will be just ignored
+}
+
+bool ProjectFilesScanner::isRunning() const
+{
+  return mListingWatcher.isRunning() || mHashingWatcher.isRunning();
+}
+
+QList<MerginFile> ProjectFilesScanner::scan( const QString &projectPath )
+{
+  Listing listing = listFiles( projectPath );
+  QList<QByteArray> checksums = QtConcurrent::blockingMapped<QList<QByteArray>>( listing.filesToHash, &ProjectFilesScanner::hashFile );
+  return mergeChecksums( listing, checksums );
+}
+
+void ProjectFilesScanner::listingFinished()
+{
+  if ( mCanceled )
+    return;
+
+  mListing = mListingWatcher.result();
+
+  if ( mListing.filesToHash.isEmpty() )
+  {
+    emit finished( mergeChecksums( mListing, QList<QByteArray>() ) );
+    return;
+  }
+
+  mHashingWatcher.setFuture( QtConcurrent::mapped( mListing.filesToHash, &ProjectFilesScanner::hashFile ) );
+}
+
+void ProjectFilesScanner::hashingFinished()
+{
+  if ( mCanceled || mHashingWatcher.isCanceled() )
+    return;
+
+  emit finished( mergeChecksums( mListing, mHashingWatcher.future().results() ) );
+}
+
+ProjectFilesScanner::Listing ProjectFilesScanner::listFiles( const QString &projectPath )
+{
+  Listing listing;
+  listing.projectPath = projectPath;
+  listing.cache = std::make_shared<ProjectChecksumCache>( QDir::cleanPath( projectPath ) );
+
+  const QSet<QString> localFiles = MerginApi::listFiles( projectPath );
+  for ( const QString &p : localFiles )
+  {
+    QFileInfo info( projectPath + p );
+
+    MerginFile file;
+    file.path = p;
+    file.size = info.size();
+    file.mtime = info.lastModified();
+    file.checksum = listing.cache->checksum( p, info );
+
+    if ( file.checksum.isEmpty() )
+    {
+      listing.filesToHashIndexes << listing.files.count();
+      listing.filesToHash << projectPath + p;
+      listing.filesToHashInfo << info;
+    }
+    listing.files << file;
+  }
+
+  listing.cache->retain( localFiles );
+  return listing;
+}
+
+QList<MerginFile> ProjectFilesScanner::mergeChecksums( Listing &listing, const QList<QByteArray> &checksums )
+{
+  Q_ASSERT( checksums.count() == listing.filesToHashIndexes.count() );
+
+  for ( int i = 0; i < checksums.count(); ++i )
+  {
+    MerginFile &file = listing.files[listing.filesToHashIndexes.at( i )];
+    const QByteArray &checksum = checksums.at( i );
+    file.checksum = QString::fromLatin1( checksum.data(), checksum.size() );
+    if ( !file.checksum.isEmpty() )
+      listing.cache->insert( file.path, listing.filesToHashInfo.at( i ), file.checksum );
+  }
+
+  listing.cache->save();
+
+  if ( !checksums.isEmpty() )
+    CoreUtils::log( "local files", QStringLiteral( "Computed checksum of %1 out of %2 files in %3" )
+                    .arg( checksums.count() ).arg( listing.files.count() ).arg( listing.projectPath ) );
+
+  return listing.files;
+}
+
+QByteArray ProjectFilesScanner::hashFile( const QString &filePath )
+{
+  return MerginApi::getChecksum( filePath );
+}
@@ -0,0 +1,92 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PROJECTFILESSCANNER_H
+#define PROJECTFILESSCANNER_H
+
+#include <memory>
+
+#include <QObject>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QList>
+#include <QStringList>
+
+#include "merginprojectmetadata.h"
+
+class ProjectChecksumCache;
+
+/**
+ * Scans files of a local project and computes their checksums (see MerginApi::getLocalProjectFiles()).
+ *
+ * Directory listing runs on a worker thread and checksums of new or modified files
+ * (those that are not in ProjectChecksumCache) are computed in parallel on the global thread pool.
+ * With start() the scan does not block the calling thread and the result is delivered
+ * with finished() signal, scan() is a blocking variant for code that needs the result immediately.
+ */
+class ProjectFilesScanner : public QObject
+{
+    Q_OBJECT
+
+  public:
+    //! Creates scanner for project in \a projectPath (with a trailing slash)
+    explicit ProjectFilesScanner( const QString &projectPath, QObject *parent = nullptr );
+    ~ProjectFilesScanner() override;
+
+    //! Starts the scan on worker threads and returns immediately
+    void start();
+
+    //! Stops the scan as soon as possible, finished() is not emitted afterwards
+    void cancel();
+
+    bool isRunning() const;
+
+    QString projectPath() const { return mProjectPath; }
+
+    //! Scans the project and returns when all checksums are computed (still using multiple threads)
+    static QList<MerginFile> scan( const QString &projectPath );
+
+  signals:
+    //! Emitted whenever another file has been hashed
+    void progressChanged( int hashedFiles, int filesToHash );
+
+    //! Emitted when the scan is done with the list of all project files
+    void finished( const QList<MerginFile> &files );
+
+  private slots:
+    void listingFinished();
+    void hashingFinished();
+
+  private:
+    struct Listing
+    {
+      QString projectPath;
+      QList<MerginFile> files;          //!< all project files, checksum is empty if not cached
+      QList<int> filesToHashIndexes;    //!< indexes to files that need to be hashed
+      QStringList filesToHash;          //!< absolute paths of files that need to be hashed
+      QList<QFileInfo> filesToHashInfo; //!< file info taken before hashing (stored to the cache with the checksum)
+      std::shared_ptr<ProjectChecksumCache> cache;
+    };
+
+    //! Lists project files and fills in cached checksums
+    static Listing listFiles( const QString &projectPath );
+
+    //! Adds computed checksums to the listing, updates the cache and returns the final list of files
+    static QList<MerginFile> mergeChecksums( Listing &listing, const QList<QByteArray> &checksums );
+
+    static QByteArray hashFile( const QString &filePath );
+
+    QString mProjectPath;
+    bool mCanceled = false;
+    Listing mListing;
+    QFutureWatcher<Listing> mListingWatcher;
+    QFutureWatcher<QByteArray> mHashingWatcher;
+};
+
+#endif // PROJECTFILESSCANNER_H
@@ -0,0 +1,241 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "transactionjournal.h"
+
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "coreutils.h"
+
+TransactionJournal::TransactionJournal( const QString &projectDir )
+  : mProjectDir( projectDir )
+{
+}
+
+bool TransactionJournal::load()
+{
+  mType = None;
+  mProjectFullName.clear();
+  mDownloadedItems.clear();
+  mTransactionUUID.clear();
+  mBaseVersion = -1;
+  mPushFiles.clear();
+  mRemovedFiles.clear();
+  mUploadedChunks.clear();
+
+  QFile f( journalFilePath( mProjectDir ) );
+  if ( !f.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QJsonDocument headerDoc = QJsonDocument::fromJson( f.readLine() );
+  if ( !headerDoc.isObject() )
+    return false;
+
+  QJsonObject header = headerDoc.object();
+  if ( header.value( QStringLiteral( "journal" ) ).toInt() != JOURNAL_VERSION )
+    return false;
+
+  QString type = header.value( QStringLiteral( "type" ) ).toString();
+  mProjectFullName = header.value( QStringLiteral( "project" ) ).toString();
+  if ( type == QStringLiteral( "pull" ) )
+  {
+    mType = Pull;
+  }
+  else if ( type == QStringLiteral( "push" ) )
+  {
+    mType = Push;
+    mTransactionUUID = header.value( QStringLiteral( "transaction" ) ).toString();
+    mBaseVersion = header.value( QStringLiteral( "version" ) ).toInt( -1 );
+
+    const QJsonArray files = header.value( QStringLiteral( "files" ) ).toArray();
+    for ( const QJsonValue &value : files )
+    {
+      QJsonObject obj = value.toObject();
+      MerginFile file;
+      file.path = obj.value( QStringLiteral( "path" ) ).toString();
+      file.checksum = obj.value( QStringLiteral( "checksum" ) ).toString();
+      file.size = static_cast<qint64>( obj.value( QStringLiteral( "size" ) ).toDouble() );
+      file.diffChecksum = obj.value( QStringLiteral( "diff_checksum" ) ).toString();
+      for ( const QJsonValue &chunk : obj.value( QStringLiteral( "chunks" ) ).toArray() )
+        file.chunks.append( chunk.toString() );
+      mPushFiles.append( file );
+    }
+    for ( const QJsonValue &value : header.value( QStringLiteral( "removed" ) ).toArray() )
+      mRemovedFiles.append( value.toString() );
+  }
+  else
+  {
+    return false;
+  }
+
+  while ( !f.atEnd() )
+  {
+    QJsonDocument doc = QJsonDocument::fromJson( f.readLine() );
+    if ( !doc.isObject() )
+      break;  // incomplete last line - the rest is not trustworthy
+
+    QJsonObject obj = doc.object();
+    if ( mType == Pull )
+    {
+      DownloadedItem item;
+      item.tempFileName = obj.value( QStringLiteral( "temp" ) ).toString();
+      item.checksum = obj.value( QStringLiteral( "checksum" ) ).toString();
+      QString key = obj.value( QStringLiteral( "item" ) ).toString();
+      if ( !key.isEmpty() && !item.tempFileName.isEmpty() )
+        mDownloadedItems.insert( key, item );
+    }
+    else
+    {
+      QString chunkId = obj.value( QStringLiteral( "chunk" ) ).toString();
+      if ( !chunkId.isEmpty() )
+        mUploadedChunks.insert( chunkId );
+    }
+  }
+  return true;
+}
+
+bool TransactionJournal::startPull( const QString &projectFullName )
+{
+  mType = Pull;
+  mProjectFullName = projectFullName;
+  mDownloadedItems.clear();
+
+  QJsonObject header;
+  header.insert( QStringLiteral( "journal" ), JOURNAL_VERSION );
+  header.insert( QStringLiteral( "type" ), QStringLiteral( "pull" ) );
+  header.insert( QStringLiteral( "project" ), projectFullName );
+  return write( QJsonDocument( header ).toJson( QJsonDocument::Compact ), true );
+}
+
+bool TransactionJournal::appendDownloadedItem( const QString &itemKey, const QString &tempFileName, const QString &checksum )
+{
+  Q_ASSERT( mType == Pull );
+
+  DownloadedItem item;
+  item.tempFileName = tempFileName;
+  item.checksum = checksum;
+  mDownloadedItems.insert( itemKey, item );
+
+  QJsonObject obj;
+  obj.insert( QStringLiteral( "item" ), itemKey );
+  obj.insert( QStringLiteral( "temp" ), tempFileName );
+  obj.insert( QStringLiteral( "checksum" ), checksum );
+  return write( QJsonDocument( obj ).toJson( QJsonDocument::Compact ), false );
+}
+
+bool TransactionJournal::startPush( const QString &projectFullName, const QString &transactionUUID, int baseVersion,
+                                    const QList<MerginFile> &files, const QStringList &removedFiles )
+{
+  mType = Push;
+  mProjectFullName = projectFullName;
+  mTransactionUUID = transactionUUID;
+  mBaseVersion = baseVersion;
+  mPushFiles = files;
+  mRemovedFiles = removedFiles;
+  mUploadedChunks.clear();
+
+  QJsonArray filesArray;
+  for ( const MerginFile &file : files )
+  {
+    QJsonObject obj;
+    obj.insert( QStringLiteral( "path" ), file.path );
+    obj.insert( QStringLiteral( "checksum" ), file.checksum );
+    obj.insert( QStringLiteral( "size" ), file.size );
+    if ( !file.diffChecksum.isEmpty() )
+      obj.insert( QStringLiteral( "diff_checksum" ), file.diffChecksum );
+    obj.insert( QStringLiteral( "chunks" ), QJsonArray::fromStringList( file.chunks ) );
+    filesArray.append( obj );
+  }
+
+  QJsonObject header;
+  header.insert( QStringLiteral( "journal" ), JOURNAL_VERSION );
+  header.insert( QStringLiteral( "type" ), QStringLiteral( "push" ) );
+  header.insert( QStringLiteral( "project" ), projectFullName );
+  header.insert( QStringLiteral( "transaction" ), transactionUUID );
+  header.insert( QStringLiteral( "version" ), baseVersion );
+  header.insert( QStringLiteral( "files" ), filesArray );
+  header.insert( QStringLiteral( "removed" ), QJsonArray::fromStringList( removedFiles ) );
+  return write( QJsonDocument( header ).toJson( QJsonDocument::Compact ), true );
+}
+
+bool TransactionJournal::appendUploadedChunk( const QString &chunkId )
+{
+  Q_ASSERT( mType == Push );
+
+  mUploadedChunks.insert( chunkId );
+
+  QJsonObject obj;
+  obj.insert( QStringLiteral( "chunk" ), chunkId );
+  return write( QJsonDocument( obj ).toJson( QJsonDocument::Compact ), false );
+}
+
+void TransactionJournal::remove()
+{
+  mType = None;
+  mFile.close();
+  if ( mProjectDir.isEmpty() )
+    return;
+
+  QFile::remove( journalFilePath( mProjectDir ) );
+}
+
+QString TransactionJournal::journalFilePath( const QString &projectDir )
+{
+  return projectDir + "/.mergin/transaction.json";
+}
+
+QString TransactionJournal::findInterruptedDownload( const QString &dataDir, const QString &projectFullName )
+{
+  const QStringList dirs = QDir( dataDir ).entryList( QDir::Dirs | QDir::NoDotAndDotDot );
+  for ( const QString &dirName : dirs )
+  {
+    QString projectDir = dataDir + "/" + dirName;
+    if ( !QFile::exists( CoreUtils::downloadInProgressFilePath( projectDir ) ) )
+      continue;
+
+    TransactionJournal journal( projectDir );
+    if ( journal.load() && journal.type() == Pull && journal.projectFullName() == projectFullName )
+      return projectDir;
+  }
+  return QString();
+}
+
+bool TransactionJournal::write( const QByteArray &line, bool truncate )
+{
+  // the file stays open for further entries, a new transaction starts it again
+  if ( truncate || !mFile.isOpen() )
+  {
+    mFile.close();
+
+    // never recreate a project directory that has been removed meanwhile
+    if ( mProjectDir.isEmpty() || !QDir( mProjectDir ).exists() || !QDir( mProjectDir ).mkpath( ".mergin" ) )
+      return false;
+
+    mFile.setFileName( journalFilePath( mProjectDir ) );
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | ( truncate ? QIODevice::Truncate : QIODevice::Append );
+    if ( !mFile.open( mode ) )
+    {
+      CoreUtils::log( "transaction journal", "Failed to open for writing: " + mFile.fileName() );
+      return false;
+    }
+  }
+
+  // the entry must be on the disk before we rely on it - e.g. before the temporary file is used
+  if ( mFile.write( line + '\n' ) < 0 || !mFile.flush() )
+  {
+    CoreUtils::log( "transaction journal", "Failed to write: " + mFile.fileName() );
+    mFile.close();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TRANSACTIONJOURNAL_H
+#define TRANSACTIONJOURNAL_H
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "merginprojectmetadata.h"
+
+/**
+ * Persistent record of a pull or push in progress, stored in the project's .mergin directory,
+ * so that the transfer can continue where it stopped after the app got killed or the network failed.
+ *
+ * The journal is append-only (one JSON object per line): the first line describes the transaction,
+ * each further line records one item that has been transferred. A truncated last line (app killed
+ * while writing) is ignored. The file is kept open while the transaction writes to it, each entry
+ * is flushed.
+ *
+ * - pull: downloaded items with the name of their temporary file and checksum of the content
+ * - push: the server transaction ID, base version, announced files with their chunk IDs
+ *   and IDs of the chunks confirmed by the server
+ */
+class TransactionJournal
+{
+  public:
+    enum Type
+    {
+      None,
+      Pull,
+      Push
+    };
+
+    //! Item downloaded to a temporary file during pull
+    struct DownloadedItem
+    {
+      QString tempFileName;
+      QString checksum;
+    };
+
+    //! Does not read anything - call load() to read an existing journal
+    explicit TransactionJournal( const QString &projectDir );
+
+    //! Reads the journal, returns false if there is none (or it cannot be parsed)
+    bool load();
+
+    Type type() const { return mType; }
+    QString projectFullName() const { return mProjectFullName; }
+
+    //! Starts a new pull journal (replaces any previous content)
+    bool startPull( const QString &projectFullName );
+
+    //! Records an item downloaded to a temporary file
+    bool appendDownloadedItem( const QString &itemKey, const QString &tempFileName, const QString &checksum );
+
+    //! Downloaded items by their key (see DownloadQueueItem::key())
+    QHash<QString, DownloadedItem> downloadedItems() const { return mDownloadedItems; }
+
+    /**
+     * Starts a new push journal (replaces any previous content).
+     * \a files are the added/updated files as announced to the server (with chunk IDs),
+     * \a removedFiles are paths of removed files.
+     */
+    bool startPush( const QString &projectFullName, const QString &transactionUUID, int baseVersion,
+                    const QList<MerginFile> &files, const QStringList &removedFiles );
+
+    //! Records a chunk confirmed by the server
+    bool appendUploadedChunk( const QString &chunkId );
+
+    QString transactionUUID() const { return mTransactionUUID; }
+    int baseVersion() const { return mBaseVersion; }
+    QList<MerginFile> pushFiles() const { return mPushFiles; }
+    QStringList removedFiles() const { return mRemovedFiles; }
+    QSet<QString> uploadedChunks() const { return mUploadedChunks; }
+
+    //! Closes and removes the journal from the disk
+    void remove();
+
+    //! Returns path of the journal file for project in given directory
+    static QString journalFilePath( const QString &projectDir );
+
+    /**
+     * Looks for a directory of an interrupted first time download of the project
+     * (it still has the "download in progress" mark and a pull journal of the project).
+     * Returns empty string if there is none.
+     */
+    static QString findInterruptedDownload( const QString &dataDir, const QString &projectFullName );
+
+  private:
+    bool write( const QByteArray &line, bool truncate );
+
+    QString mProjectDir;
+    QFile mFile;  //!< open for writing since the first entry written by this instance
+    Type mType = None;
+    QString mProjectFullName;
+
+    QHash<QString, DownloadedItem> mDownloadedItems;
+
+    QString mTransactionUUID;
+    int mBaseVersion = -1;
+    QList<MerginFile> mPushFiles;
+    QStringList mRemovedFiles;
+    QSet<QString> mUploadedChunks;
+
+    static const int JOURNAL_VERSION = 1;
+};
+
+#endif // TRANSACTIONJOURNAL_H
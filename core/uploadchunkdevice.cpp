@@ -0,0 +1,89 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "uploadchunkdevice.h"
+
+UploadChunkDevice::UploadChunkDevice( const QString &filePath, qint64 offset, qint64 length, QObject *parent )
+  : QIODevice( parent )
+  , mFile( filePath )
+  , mOffset( offset )
+  , mLength( length )
+{
+}
+
+UploadChunkDevice::~UploadChunkDevice()
+{
+  close();
+}
+
+bool UploadChunkDevice::open( OpenMode mode )
+{
+  if ( mode != QIODevice::ReadOnly )
+    return false;
+
+  if ( !mFile.open( QIODevice::ReadOnly ) )
+    return false;
+
+  // the file may be shorter than expected - never expose more than what is really there
+  mLength = qBound( qint64( 0 ), mLength, mFile.size() - mOffset );
+
+  if ( !mFile.seek( mOffset ) )
+  {
+    mFile.close();
+    return false;
+  }
+
+  return QIODevice::open( mode );
+}
+
+void UploadChunkDevice::close()
+{
+  if ( !isOpen() )
+    return;
+
+  mFile.close();
+  QIODevice::close();
+}
+
+qint64 UploadChunkDevice::size() const
+{
+  return mLength;
+}
+
+bool UploadChunkDevice::seek( qint64 pos )
+{
+  if ( pos < 0 || pos > mLength )
+    return false;
+
+  if ( !mFile.seek( mOffset + pos ) )
+    return false;
+
+  return QIODevice::seek( pos );
+}
+
+bool UploadChunkDevice::atEnd() const
+{
+  return pos() >= mLength;
+}
+
+qint64 UploadChunkDevice::readData( char *data, qint64 maxSize )
+{
+  qint64 remaining = mLength - ( mFile.pos() - mOffset );
+  if ( remaining <= 0 )
+    return -1;  // end of the chunk
+
+  return mFile.read( data, qMin( maxSize, remaining ) );
+}
+
+qint64 UploadChunkDevice::writeData( const char *data, qint64 maxSize )
+{
+  Q_UNUSED( data )
+  Q_UNUSED( maxSize )
+  return -1;  // read-only device
+}
@@ -0,0 +1,44 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef UPLOADCHUNKDEVICE_H
+#define UPLOADCHUNKDEVICE_H
+
+#include <QIODevice>
+#include <QFile>
+
+/**
+ * Read-only device exposing a byte range of a file. It is used as the body of chunk upload
+ * requests, so the chunk is streamed from disk and never needs to be held in memory as a whole.
+ */
+class UploadChunkDevice : public QIODevice
+{
+  public:
+    UploadChunkDevice( const QString &filePath, qint64 offset, qint64 length, QObject *parent = nullptr );
+    ~UploadChunkDevice() override;
+
+    bool open( OpenMode mode ) override;
+    void close() override;
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override;
+    bool seek( qint64 pos ) override;
+    bool atEnd() const override;
+
+  protected:
+    qint64 readData( char *data, qint64 maxSize ) override;
+    qint64 writeData( const char *data, qint64 maxSize ) override;
+
+  private:
+    QFile mFile;
+    qint64 mOffset = 0;
+    qint64 mLength = 0;
+};
+
+#endif // UPLOADCHUNKDEVICE_H
@@ -47,6 +47,27 @@ Item {
    */
   property alias incrementalRendering: mapCanvasWrapper.incrementalRendering
 
+  /**
+   * When the tiledRendering property is set to true, the map is rendered in tiles and panning renders only newly exposed tiles.
+   */
+  property alias tiledRendering: mapCanvasWrapper.tiledRendering
+
+  /**
+   * Directory for persistent cache of rendered tiles of local raster layers, used with tiledRendering.
+   * Empty string disables the cache.
+   */
+  property alias renderCacheDir: mapCanvasWrapper.renderCacheDir
+
+  /**
+   * When the progressiveRendering property is set to true, a fast preview of priority layers is shown before the full rendering.
+   */
+  property alias progressiveRendering: mapCanvasWrapper.progressiveRendering
+
+  /**
+   * Layers shown in the preview of progressive rendering, editable vector layers when empty.
+   */
+  property alias priorityLayers: mapCanvasWrapper.priorityLayers
+
   /**
    * What is the minimum distance (in pixels) in order to start dragging map
    */
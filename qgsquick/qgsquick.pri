@@ -1,14 +1,20 @@
 SOURCES += \
+  $$PWD/qgsquickcoordinatetransformcache.cpp \
   $$PWD/qgsquickcoordinatetransformer.cpp \
   $$PWD/qgsquickmapcanvasmap.cpp \
+  $$PWD/qgsquickmapdiskcache.cpp \
   $$PWD/qgsquickmapsettings.cpp \
+  $$PWD/qgsquickmaptiles.cpp \
   $$PWD/qgsquickmaptransform.cpp \
   $$PWD/qgsquickutils.cpp
 
 HEADERS += \
+  $$PWD/qgsquickcoordinatetransformcache.h \
   $$PWD/qgsquickcoordinatetransformer.h \
   $$PWD/qgsquickmapcanvasmap.h \
+  $$PWD/qgsquickmapdiskcache.h \
   $$PWD/qgsquickmapsettings.h \
+  $$PWD/qgsquickmaptiles.h \
   $$PWD/qgsquickmaptransform.h \
   $$PWD/qgsquickutils.h \
   $$PWD/qgis_quick.h \
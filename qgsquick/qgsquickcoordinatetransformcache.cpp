@@ -0,0 +1,134 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "qgsexception.h"
+
+#include "qgsquickcoordinatetransformcache.h"
+
+namespace
+{
+  struct CachedTransform
+  {
+    QString key;
+    QgsCoordinateTransformContext context;
+    QgsCoordinateTransform transform;
+  };
+
+  QMutex sMutex;
+  QList<CachedTransform> sTransforms; // most recently used first
+
+  QString crsKey( const QgsCoordinateReferenceSystem &crs )
+  {
+    // comparing auth ids is much cheaper than comparing the definitions
+    return crs.authid().isEmpty() ? crs.toWkt() : crs.authid();
+  }
+}
+
+QgsCoordinateTransform QgsQuickCoordinateTransformCache::transform( const QgsCoordinateReferenceSystem &source,
+    const QgsCoordinateReferenceSystem &destination,
+    const QgsCoordinateTransformContext &context )
+{
+  const QString key = crsKey( source ) + QStringLiteral( "|" ) + crsKey( destination );
+
+  QMutexLocker locker( &sMutex );
+
+  for ( int i = 0; i < sTransforms.size(); ++i )
+  {
+    if ( sTransforms.at( i ).key == key && sTransforms.at( i ).context == context )
+    {
+      if ( i > 0 )
+        sTransforms.move( i, 0 );
+      return sTransforms.first().transform;
+    }
+  }
+
+  CachedTransform cached;
+  cached.key = key;
+  cached.context = context;
+  cached.transform = QgsCoordinateTransform( source, destination, context );
+  sTransforms.prepend( cached );
+
+  while ( sTransforms.size() > MAX_TRANSFORMS )
+    sTransforms.removeLast();
+
+  return cached.transform;
+}
+
+QgsPointXY QgsQuickCoordinateTransformCache::transformPoint( const QgsCoordinateReferenceSystem &source,
+    const QgsCoordinateReferenceSystem &destination,
+    const QgsCoordinateTransformContext &context,
+    const QgsPointXY &point )
+{
+  try
+  {
+    const QgsCoordinateTransform ct = transform( source, destination, context );
+    if ( ct.isValid() )
+      return ct.transform( point );
+  }
+  catch ( QgsCsException &cse )
+  {
+    Q_UNUSED( cse )
+  }
+  return point;
+}
+
+bool QgsQuickCoordinateTransformCache::transformPoints( const QgsCoordinateReferenceSystem &source,
+    const QgsCoordinateReferenceSystem &destination,
+    const QgsCoordinateTransformContext &context,
+    QVector<double> &x, QVector<double> &y, QVector<double> &z )
+{
+  Q_ASSERT( x.size() == y.size() );
+  Q_ASSERT( z.isEmpty() || z.size() == x.size() );
+
+  if ( x.isEmpty() )
+    return true;
+
+  const QgsCoordinateTransform ct = transform( source, destination, context );
+  if ( !ct.isValid() )
+    return false;
+
+  if ( ct.isShortCircuited() )
+    return true;
+
+  // work on copies, so the input stays untouched if the transform fails halfway
+  QVector<double> tx = x;
+  QVector<double> ty = y;
+  QVector<double> tz = z.isEmpty() ? QVector<double>( x.size(), 0.0 ) : z;
+  try
+  {
+    ct.transformCoords( tx.size(), tx.data(), ty.data(), tz.data() );
+  }
+  catch ( QgsCsException &cse )
+  {
+    Q_UNUSED( cse )
+    return false;
+  }
+
+  x = tx;
+  y = ty;
+  if ( !z.isEmpty() )
+    z = tz;
+  return true;
+}
+
+void QgsQuickCoordinateTransformCache::clear()
+{
+  QMutexLocker locker( &sMutex );
+  sTransforms.clear();
+}
+
+int QgsQuickCoordinateTransformCache::count()
+{
+  QMutexLocker locker( &sMutex );
+  return sTransforms.size();
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSQUICKCOORDINATETRANSFORMCACHE_H
+#define QGSQUICKCOORDINATETRANSFORMCACHE_H
+
+#include <QVector>
+
+#include "qgscoordinatereferencesystem.h"
+#include "qgscoordinatetransform.h"
+#include "qgscoordinatetransformcontext.h"
+#include "qgspointxy.h"
+
+#include "qgis_quick.h"
+
+/**
+ * \ingroup quick
+ * \brief Shared cache of coordinate transforms.
+ *
+ * Creating QgsCoordinateTransform looks up the PROJ pipeline between the two CRS, which
+ * is far more expensive than transforming a few points. Code that transforms points often
+ * (e.g. every GPS fix) should get the transform from this cache instead.
+ *
+ * Transforms are keyed by source CRS, destination CRS and transform context. Only a few
+ * recently used transforms are kept. The cache is cleared whenever CRS or transform context
+ * of QgsQuickMapSettings changes.
+ *
+ * All methods are thread-safe. Returned transforms are copies that can be used from the calling thread.
+ */
+class QUICK_EXPORT QgsQuickCoordinateTransformCache
+{
+  public:
+    //! Maximum number of cached transforms
+    static const int MAX_TRANSFORMS = 32;
+
+    //! Returns transform between the CRSs, created only if it is not cached yet
+    static QgsCoordinateTransform transform( const QgsCoordinateReferenceSystem &source,
+        const QgsCoordinateReferenceSystem &destination,
+        const QgsCoordinateTransformContext &context );
+
+    /**
+     * Transforms \a point from \a source to \a destination CRS.
+     * Returns the point unchanged if the transform fails.
+     */
+    static QgsPointXY transformPoint( const QgsCoordinateReferenceSystem &source,
+                                      const QgsCoordinateReferenceSystem &destination,
+                                      const QgsCoordinateTransformContext &context,
+                                      const QgsPointXY &point );
+
+    /**
+     * Transforms arrays of coordinates in place, \a z may be empty.
+     * Returns false if the transform fails, coordinates are unchanged then.
+     */
+    static bool transformPoints( const QgsCoordinateReferenceSystem &source,
+                                 const QgsCoordinateReferenceSystem &destination,
+                                 const QgsCoordinateTransformContext &context,
+                                 QVector<double> &x, QVector<double> &y, QVector<double> &z );
+
+    //! Removes all cached transforms
+    static void clear();
+
+    //! Returns number of cached transforms
+    static int count();
+};
+
+#endif // QGSQUICKCOORDINATETRANSFORMCACHE_H
@@ -13,12 +13,17 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <algorithm>
+#include <cstdlib>
+
+#include <QPainter>
 #include <QQuickWindow>
 #include <QScreen>
 #include <QSGSimpleTextureNode>
 #include <QtConcurrent>
 
 #include "qgslabelingresults.h"
+#include "qgsmaprenderercache.h"
 #include "qgsmaprendererparalleljob.h"
 #include "qgsmessagelog.h"
 #include "qgspallabeling.h"
@@ -38,9 +43,16 @@ QgsQuickMapCanvasMap::QgsQuickMapCanvasMap( QQuickItem *parent )
   connect( this, &QQuickItem::windowChanged, this, &QgsQuickMapCanvasMap::onWindowChanged );
   connect( &mRefreshTimer, &QTimer::timeout, this, &QgsQuickMapCanvasMap::refreshMap );
   connect( &mMapUpdateTimer, &QTimer::timeout, this, &QgsQuickMapCanvasMap::renderJobUpdated );
+  connect( &mDiskCacheLoad, &QFutureWatcher<QHash<QString, QImage>>::finished, this, &QgsQuickMapCanvasMap::onDiskCacheLoaded );
 
   connect( mMapSettings.get(), &QgsQuickMapSettings::extentChanged, this, &QgsQuickMapCanvasMap::onExtentChanged );
   connect( mMapSettings.get(), &QgsQuickMapSettings::layersChanged, this, &QgsQuickMapCanvasMap::onLayersChanged );
+  connect( mMapSettings.get(), &QgsQuickMapSettings::destinationCrsChanged, this, &QgsQuickMapCanvasMap::clearTiles );
+  connect( mMapSettings.get(), &QgsQuickMapSettings::rotationChanged, this, &QgsQuickMapCanvasMap::clearTiles );
+  connect( mMapSettings.get(), &QgsQuickMapSettings::backgroundColorChanged, this, &QgsQuickMapCanvasMap::invalidateTiles );
+  connect( mMapSettings.get(), &QgsQuickMapSettings::outputDpiChanged, this, &QgsQuickMapCanvasMap::invalidateTiles );
+
+  connect( this, &QgsQuickMapCanvasMap::priorityLayersChanged, this, &QgsQuickMapCanvasMap::refresh );
 
   connect( this, &QgsQuickMapCanvasMap::renderStarting, this, &QgsQuickMapCanvasMap::isRenderingChanged );
   connect( this, &QgsQuickMapCanvasMap::mapCanvasRefreshed, this, &QgsQuickMapCanvasMap::isRenderingChanged );
@@ -52,6 +64,13 @@ QgsQuickMapCanvasMap::QgsQuickMapCanvasMap( QQuickItem *parent )
   setFlags( QQuickItem::ItemHasContents );
 }
 
+QgsQuickMapCanvasMap::~QgsQuickMapCanvasMap()
+{
+  // do not leave half written tiles behind
+  for ( QFuture<void> &write : mDiskCacheWrites )
+    write.waitForFinished();
+}
+
 QgsQuickMapSettings *QgsQuickMapCanvasMap::mapSettings() const
 {
   return mMapSettings.get();
@@ -93,8 +112,21 @@ void QgsQuickMapCanvasMap::pan( QPointF oldPos, QPointF newPos )
 
 void QgsQuickMapCanvasMap::refreshMap()
 {
+  if ( mTiledRendering )
+  {
+    refreshTiles();
+    return;
+  }
+
   stopRendering(); // if any...
 
+  const QgsMapSettings mapSettings = prepareMapSettings();
+  if ( !startPreviewJob( mapSettings ) )
+    startJob( mapSettings );
+}
+
+QgsMapSettings QgsQuickMapCanvasMap::prepareMapSettings() const
+{
   QgsMapSettings mapSettings = mMapSettings->mapSettings();
 
   //build the expression context
@@ -117,6 +149,11 @@ void QgsQuickMapCanvasMap::refreshMap()
   // with incremental rendering - enables updates of partially rendered layers (good for WMTS, XYZ layers)
   mapSettings.setFlag( QgsMapSettings::RenderPartialOutput, mIncrementalRendering );
 
+  return mapSettings;
+}
+
+void QgsQuickMapCanvasMap::startJob( const QgsMapSettings &mapSettings, QgsMapRendererCache *cache )
+{
   // create the renderer job
   Q_ASSERT( !mJob );
   mJob = new QgsMapRendererParallelJob( mapSettings );
@@ -126,15 +163,356 @@ void QgsQuickMapCanvasMap::refreshMap()
 
   connect( mJob, &QgsMapRendererJob::renderingLayersFinished, this, &QgsQuickMapCanvasMap::renderJobUpdated );
   connect( mJob, &QgsMapRendererJob::finished, this, &QgsQuickMapCanvasMap::renderJobFinished );
-  mJob->setCache( mCache );
+  mJob->setCache( cache ? cache : mCache );
 
   mJob->start();
 
   emit renderStarting();
 }
 
+bool QgsQuickMapCanvasMap::startPreviewJob( const QgsMapSettings &mapSettings )
+{
+  Q_ASSERT( !mPreviewJob );
+  if ( !mProgressiveRendering )
+    return false;
+
+  const QList<QgsMapLayer *> layers = mapSettings.layers();
+  QList<QgsMapLayer *> previewLayers;
+  for ( QgsMapLayer *layer : layers )
+  {
+    if ( isPriorityLayer( layer ) )
+      previewLayers << layer;
+  }
+
+  // the preview pays off only when it leaves out some layers
+  if ( previewLayers.isEmpty() || previewLayers.size() == layers.size() )
+    return false;
+
+  // half resolution with the same scale and symbol sizes
+  QgsMapSettings previewSettings = mapSettings;
+  previewSettings.setLayers( previewLayers );
+  previewSettings.setOutputSize( mapSettings.outputSize() / 2 );
+  previewSettings.setOutputDpi( mapSettings.outputDpi() / 2 );
+  previewSettings.setExtent( mapSettings.visibleExtent() );
+  previewSettings.setBackgroundColor( Qt::transparent );
+  previewSettings.setFlag( QgsMapSettings::Antialiasing, false );
+  previewSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+  previewSettings.setFlag( QgsMapSettings::RenderPartialOutput, false );
+
+  mPreviewJob = new QgsMapRendererParallelJob( previewSettings );
+  connect( mPreviewJob, &QgsMapRendererJob::finished, this, &QgsQuickMapCanvasMap::previewJobFinished );
+  mPreviewJob->start();
+
+  emit renderStarting();
+  return true;
+}
+
+void QgsQuickMapCanvasMap::stopPreviewJob()
+{
+  if ( !mPreviewJob )
+    return;
+
+  disconnect( mPreviewJob, &QgsMapRendererJob::finished, this, &QgsQuickMapCanvasMap::previewJobFinished );
+  mPreviewJob->cancelWithoutBlocking();
+  mPreviewJob = nullptr;
+}
+
+bool QgsQuickMapCanvasMap::isPriorityLayer( QgsMapLayer *layer ) const
+{
+  if ( !mPriorityLayerIds.isEmpty() )
+    return mPriorityLayerIds.contains( layer->id() );
+
+  // layers the user records to
+  QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer );
+  return vectorLayer && !vectorLayer->readOnly();
+}
+
+void QgsQuickMapCanvasMap::previewJobFinished()
+{
+  const QImage preview = mPreviewJob->renderedImage();
+  const QgsMapSettings previewSettings = mPreviewJob->mapSettings();
+
+  mPreviewJob->deleteLater();
+  mPreviewJob = nullptr;
+
+  if ( mTiledRendering )
+  {
+    mPreview = preview;
+    mPreviewExtent = previewSettings.visibleExtent();
+    update();
+
+    if ( !startNextTileJob() && !startLabelJob() )
+      emit mapCanvasRefreshed();
+    return;
+  }
+
+  const QgsMapSettings mapSettings = prepareMapSettings();
+
+  // the previous image moved to the new extent keeps the other layers in place until the full rendering finishes
+  QImage image( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+  image.fill( mapSettings.backgroundColor() );
+  {
+    QPainter painter( &image );
+    painter.setRenderHint( QPainter::SmoothPixmapTransform );
+
+    if ( !mImage.isNull() &&
+         mImageMapSettings.destinationCrs() == mapSettings.destinationCrs() &&
+         qgsDoubleNear( mImageMapSettings.rotation(), 0 ) && qgsDoubleNear( mapSettings.rotation(), 0 ) )
+    {
+      const QgsRectangle imageExtent = mImageMapSettings.visibleExtent();
+      const QgsRectangle extent = mapSettings.visibleExtent();
+      const double mapUnitsPerPixel = mapSettings.mapUnitsPerPixel();
+      painter.drawImage( QRectF( ( imageExtent.xMinimum() - extent.xMinimum() ) / mapUnitsPerPixel,
+                                 ( extent.yMaximum() - imageExtent.yMaximum() ) / mapUnitsPerPixel,
+                                 imageExtent.width() / mapUnitsPerPixel,
+                                 imageExtent.height() / mapUnitsPerPixel ), mImage );
+    }
+
+    painter.drawImage( QRectF( QPointF( 0, 0 ), mapSettings.outputSize() ), preview );
+  }
+
+  mImage = image;
+  mImageMapSettings = mapSettings;
+  mDirty = true;
+  // Temporarily freeze the canvas, we only need to reset the geometry but not trigger a repaint
+  bool freeze = mFreeze;
+  mFreeze = true;
+  updateTransform();
+  mFreeze = freeze;
+  update();
+
+  startJob( mapSettings );
+}
+
+void QgsQuickMapCanvasMap::refreshTiles()
+{
+  const QgsQuickMapTiles::Range visible = visibleTiles();
+
+  // the running job is kept as long as some of its tiles are still in view
+  if ( !mJobTiles.isEmpty() && !mJobTiles.intersects( visible ) )
+    stopRendering();
+
+  mTilesQueue = mTiles.missing( visible, mJobTiles );
+  update();
+
+  if ( !mJobTiles.isEmpty() || mPreviewJob )
+    return;
+
+  // the preview of the whole view goes first, tiles are rendered when it is finished
+  if ( !mTilesQueue.isEmpty() && startPreviewJob( prepareMapSettings() ) )
+    return;
+
+  if ( !startNextTileJob() && !startLabelJob() )
+    emit mapCanvasRefreshed();
+}
+
+bool QgsQuickMapCanvasMap::startNextTileJob()
+{
+  if ( mTilesQueue.isEmpty() )
+    return false;
+
+  mJobTiles = mTilesQueue.takeFirst();
+
+  QgsMapSettings mapSettings = prepareMapSettings();
+  mapSettings.setOutputSize( QSize( mJobTiles.columnCount() * QgsQuickMapTiles::TILE_SIZE,
+                                    mJobTiles.rowCount() * QgsQuickMapTiles::TILE_SIZE ) );
+  mapSettings.setExtent( QgsQuickMapTiles::extent( mJobTiles ) );
+  // labels placed per block would be cut at the block edges, they are placed for the whole view in startLabelJob()
+  mapSettings.setFlag( QgsMapSettings::DrawLabeling, false );
+
+  QHash<QString, QString> layerKeys;
+  if ( mDiskCache.isEnabled() )
+  {
+    const QList<QgsMapLayer *> layers = mapSettings.layers();
+    for ( QgsMapLayer *layer : layers )
+    {
+      if ( QgsQuickMapDiskCache::isCacheable( layer ) )
+        layerKeys.insert( layer->id(), mDiskCache.layerKey( layer, mapSettings ) );
+    }
+  }
+
+  if ( layerKeys.isEmpty() )
+  {
+    startJob( mapSettings );
+    return true;
+  }
+
+  // static layers are read from the disk cache in background first, the job starts afterwards
+  mJobSettings = mapSettings;
+  mJobLayerKeys = layerKeys;
+
+  const QString directory = mDiskCache.directory();
+  const QgsQuickMapTiles::Range range = mJobTiles;
+  mDiskCacheLoad.setFuture( QtConcurrent::run( [directory, layerKeys, range]()
+  {
+    return QgsQuickMapDiskCache::loadTiles( directory, layerKeys, range );
+  } ) );
+
+  emit renderStarting();
+  return true;
+}
+
+bool QgsQuickMapCanvasMap::startLabelJob()
+{
+  if ( mLabelJob )
+    return true;
+
+  QgsMapSettings mapSettings = prepareMapSettings();
+  if ( mLabelsValid && mLabelsExtent == mapSettings.visibleExtent() )
+    return false;
+
+  QList<QgsMapLayer *> labelLayers;
+  const QList<QgsMapLayer *> layers = mapSettings.layers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer );
+    if ( vectorLayer && vectorLayer->labelsEnabled() )
+      labelLayers << layer;
+  }
+
+  if ( labelLayers.isEmpty() )
+  {
+    mLabels = QImage();
+    mLabelsExtent = mapSettings.visibleExtent();
+    mLabelsValid = true;
+    delete mLabelingResults;
+    mLabelingResults = nullptr;
+    update();
+    return false;
+  }
+
+  // the job renders the labelled layers once more, with a renderer cache the labels end up in an image of their own
+  mapSettings.setLayers( labelLayers );
+  mapSettings.setBackgroundColor( Qt::transparent );
+  mapSettings.setFlag( QgsMapSettings::RenderPartialOutput, false );
+
+  mLabelJob = new QgsMapRendererParallelJob( mapSettings );
+  QgsMapRendererCache *cache = new QgsMapRendererCache();
+  cache->setParent( mLabelJob );
+  mLabelJobCache = cache;
+  mLabelJob->setCache( cache );
+  connect( mLabelJob, &QgsMapRendererJob::finished, this, &QgsQuickMapCanvasMap::labelJobFinished );
+  mLabelJob->start();
+
+  emit renderStarting();
+  return true;
+}
+
+void QgsQuickMapCanvasMap::stopLabelJob()
+{
+  if ( !mLabelJob )
+    return;
+
+  disconnect( mLabelJob, &QgsMapRendererJob::finished, this, &QgsQuickMapCanvasMap::labelJobFinished );
+  mLabelJob->cancelWithoutBlocking();
+  mLabelJob = nullptr;
+  mLabelJobCache = nullptr;
+}
+
+void QgsQuickMapCanvasMap::labelJobFinished()
+{
+  // take labeling results before emitting renderComplete, so labeling map tools
+  // connected to signal work with correct results
+  delete mLabelingResults;
+  mLabelingResults = mLabelJob->takeLabelingResults();
+
+  mLabels = mLabelJobCache ? mLabelJobCache->cacheImage( QgsMapRendererJob::LABEL_CACHE_ID ) : QImage();
+  mLabelsExtent = mLabelJob->mapSettings().visibleExtent();
+  mLabelsValid = true;
+
+  mLabelJob->deleteLater();
+  mLabelJob = nullptr;
+  mLabelJobCache = nullptr;
+
+  update();
+  emit mapCanvasRefreshed();
+}
+
+void QgsQuickMapCanvasMap::onDiskCacheLoaded()
+{
+  // rendering has been stopped or restarted meanwhile
+  if ( mJob || mJobTiles.isEmpty() || mDiskCacheLoad.isCanceled() )
+    return;
+
+  const QHash<QString, QImage> images = mDiskCacheLoad.result();
+
+  // layers with a cached image in the renderer cache are not rendered by the job
+  QgsMapRendererCache *cache = new QgsMapRendererCache();
+  cache->init( mJobSettings.visibleExtent(), mJobSettings.scale() );
+
+  const QList<QgsMapLayer *> layers = mJobSettings.layers();
+  for ( QgsMapLayer *layer : layers )
+  {
+    const QImage image = images.value( layer->id() );
+    if ( !image.isNull() )
+    {
+      cache->setCacheImage( layer->id(), image, QList<QgsMapLayer *>() << layer );
+      mJobLayerKeys.remove( layer->id() );
+    }
+  }
+
+  startJob( mJobSettings, cache );
+  cache->setParent( mJob );
+  mJobCache = cache;
+}
+
+QgsQuickMapTiles::Range QgsQuickMapCanvasMap::visibleTiles() const
+{
+  const QgsMapSettings mapSettings = mMapSettings->mapSettings();
+  if ( mapSettings.visibleExtent().isEmpty() || mapSettings.mapUnitsPerPixel() <= 0 )
+    return QgsQuickMapTiles::Range();
+
+  const qint64 zoom = QgsQuickMapTiles::zoomLevel( mapSettings.mapUnitsPerPixel() );
+  return QgsQuickMapTiles::tilesInExtent( zoom, mapSettings.visibleExtent() );
+}
+
+int QgsQuickMapCanvasMap::maximumTiles() const
+{
+  // tiles of about three screens, so panning back and forth and zooming in and out does not render again
+  const QSize size = mMapSettings->outputSize();
+  const int tilesInView = ( size.width() / QgsQuickMapTiles::TILE_SIZE + 2 ) * ( size.height() / QgsQuickMapTiles::TILE_SIZE + 2 );
+  return 3 * tilesInView;
+}
+
+void QgsQuickMapCanvasMap::invalidateTiles()
+{
+  mTiles.invalidate();
+  mPreview = QImage();
+  // outdated labels stay in view until the new ones are placed, like the outdated tiles
+  mLabelsValid = false;
+  mDiskCache.clearLayerKeys();
+  if ( mTiledRendering )
+    stopRendering();
+  refresh();
+}
+
+void QgsQuickMapCanvasMap::clearTiles()
+{
+  mTiles.clear();
+  mPreview = QImage();
+  mLabels = QImage();
+  mLabelsValid = false;
+  mDiskCache.clearLayerKeys();
+  if ( mTiledRendering )
+  {
+    stopRendering();
+    update();
+    refresh();
+  }
+}
+
 void QgsQuickMapCanvasMap::renderJobUpdated()
 {
+  if ( mTiledRendering )
+  {
+    if ( mIncrementalRendering )
+    {
+      mJobPreview = mJob->renderedImage();
+      update();
+    }
+    return;
+  }
+
   mImage = mJob->renderedImage();
   mImageMapSettings = mJob->mapSettings();
   mDirty = true;
@@ -156,6 +534,51 @@ void QgsQuickMapCanvasMap::renderJobFinished()
     QgsMessageLog::logMessage( QStringLiteral( "%1 :: %2" ).arg( error.layerID, error.message ), tr( "Rendering" ) );
   }
 
+  if ( mTiledRendering )
+  {
+    mTiles.insert( mJobTiles, mJob->renderedImage() );
+
+    // static layers rendered by the job (i.e. not read from the disk cache) are written to the disk cache
+    if ( mJobCache )
+    {
+      mDiskCacheWrites.erase( std::remove_if( mDiskCacheWrites.begin(), mDiskCacheWrites.end(), []( const QFuture<void> &write )
+      {
+        return write.isFinished();
+      } ), mDiskCacheWrites.end() );
+
+      for ( auto it = mJobLayerKeys.constBegin(); it != mJobLayerKeys.constEnd(); ++it )
+      {
+        const bool failed = std::any_of( errors.constBegin(), errors.constEnd(), [&it]( const QgsMapRendererJob::Error & error )
+        {
+          return error.layerID == it.key();
+        } );
+
+        const QImage image = mJobCache->cacheImage( it.key() );
+        if ( !failed && !image.isNull() )
+          mDiskCacheWrites << QtConcurrent::run( &QgsQuickMapDiskCache::saveTiles, mDiskCache.directory(), it.value(), mJobTiles, image );
+      }
+    }
+    mJobLayerKeys.clear();
+    mJobCache = nullptr;
+
+    mJobTiles = QgsQuickMapTiles::Range();
+    mJobPreview = QImage();
+
+    mJob->deleteLater();
+    mJob = nullptr;
+    mMapUpdateTimer.stop();
+
+    const QgsQuickMapTiles::Range visible = visibleTiles();
+    mTiles.trim( maximumTiles(), visible );
+    if ( mTiles.isComplete( visible ) )
+      mPreview = QImage();
+    update();
+
+    if ( !startNextTileJob() && !startLabelJob() )
+      emit mapCanvasRefreshed();
+    return;
+  }
+
   // take labeling results before emitting renderComplete, so labeling map tools
   // connected to signal work with correct results
   delete mLabelingResults;
@@ -201,6 +624,10 @@ void QgsQuickMapCanvasMap::onScreenChanged( QScreen *screen )
 
 void QgsQuickMapCanvasMap::onExtentChanged()
 {
+  // the preview and the labels are useful only for the extent they have been started for
+  stopPreviewJob();
+  stopLabelJob();
+
   updateTransform();
 
   // And trigger a new rendering job
@@ -209,6 +636,16 @@ void QgsQuickMapCanvasMap::onExtentChanged()
 
 void QgsQuickMapCanvasMap::updateTransform()
 {
+  if ( mTiledRendering )
+  {
+    // tiles are positioned in the scene graph, the item itself stays in place
+    setScale( 1 );
+    setX( 0 );
+    setY( 0 );
+    update();
+    return;
+  }
+
   QgsMapSettings currentMapSettings = mMapSettings->mapSettings();
   QgsMapToPixel mtp = currentMapSettings.mapToPixel();
 
@@ -250,6 +687,89 @@ void QgsQuickMapCanvasMap::setIncrementalRendering( bool incrementalRendering )
   emit incrementalRenderingChanged();
 }
 
+bool QgsQuickMapCanvasMap::tiledRendering() const
+{
+  return mTiledRendering;
+}
+
+void QgsQuickMapCanvasMap::setTiledRendering( bool tiledRendering )
+{
+  if ( tiledRendering == mTiledRendering )
+    return;
+
+  stopRendering();
+  mTiledRendering = tiledRendering;
+  mTiles.clear();
+  mTilesQueue.clear();
+  mImage = QImage();
+  mImageMapSettings = mMapSettings->mapSettings();
+  mDirty = true;
+  updateTransform();
+  refresh();
+
+  emit tiledRenderingChanged();
+}
+
+QString QgsQuickMapCanvasMap::renderCacheDir() const
+{
+  return mDiskCache.directory();
+}
+
+void QgsQuickMapCanvasMap::setRenderCacheDir( const QString &renderCacheDir )
+{
+  if ( mDiskCache.directory() == renderCacheDir )
+    return;
+
+  mDiskCache.setDirectory( renderCacheDir );
+  emit renderCacheDirChanged();
+}
+
+bool QgsQuickMapCanvasMap::progressiveRendering() const
+{
+  return mProgressiveRendering;
+}
+
+void QgsQuickMapCanvasMap::setProgressiveRendering( bool progressiveRendering )
+{
+  if ( progressiveRendering == mProgressiveRendering )
+    return;
+
+  mProgressiveRendering = progressiveRendering;
+  mPreview = QImage();
+  emit progressiveRenderingChanged();
+}
+
+QList<QgsMapLayer *> QgsQuickMapCanvasMap::priorityLayers() const
+{
+  QList<QgsMapLayer *> layers;
+  QgsProject *project = mMapSettings->project();
+  if ( !project )
+    return layers;
+
+  for ( const QString &layerId : mPriorityLayerIds )
+  {
+    if ( QgsMapLayer *layer = project->mapLayer( layerId ) )
+      layers << layer;
+  }
+  return layers;
+}
+
+void QgsQuickMapCanvasMap::setPriorityLayers( const QList<QgsMapLayer *> &priorityLayers )
+{
+  QStringList layerIds;
+  for ( QgsMapLayer *layer : priorityLayers )
+  {
+    if ( layer )
+      layerIds << layer->id();
+  }
+
+  if ( layerIds == mPriorityLayerIds )
+    return;
+
+  mPriorityLayerIds = layerIds;
+  emit priorityLayersChanged();
+}
+
 bool QgsQuickMapCanvasMap::freeze() const
 {
   return mFreeze;
@@ -275,7 +795,8 @@ void QgsQuickMapCanvasMap::setFreeze( bool freeze )
 
 bool QgsQuickMapCanvasMap::isRendering() const
 {
-  return mJob;
+  // in tiled rendering, the job can wait for the disk cache
+  return mJob || mPreviewJob || mLabelJob || !mJobTiles.isEmpty();
 }
 
 QSGNode *QgsQuickMapCanvasMap::updatePaintNode( QSGNode *oldNode, QQuickItem::UpdatePaintNodeData * )
@@ -287,6 +808,9 @@ QSGNode *QgsQuickMapCanvasMap::updatePaintNode( QSGNode *oldNode, QQuickItem::Up
     mDirty = false;
   }
 
+  if ( mTiledRendering )
+    return updateTilesPaintNode( oldNode );
+
   QSGSimpleTextureNode *node = static_cast<QSGSimpleTextureNode *>( oldNode );
   if ( !node )
   {
@@ -318,6 +842,161 @@ QSGNode *QgsQuickMapCanvasMap::updatePaintNode( QSGNode *oldNode, QQuickItem::Up
   return node;
 }
 
+namespace
+{
+  //! Texture node of a single tile, remembers the image it was created from
+  class TileNode : public QSGSimpleTextureNode
+  {
+    public:
+      qint64 imageKey = 0;
+  };
+
+  //! Root node of the tiled rendering, keeps tile nodes between updates to reuse their textures
+  class TilesNode : public QSGNode
+  {
+    public:
+      ~TilesNode() override
+      {
+        // nodes currently in the tree are deleted by the parent
+        removeAllChildNodes();
+        qDeleteAll( tiles );
+        delete preview;
+        delete progressivePreview;
+        delete labels;
+      }
+
+      QHash<QgsQuickMapTiles::Key, TileNode *> tiles;
+      TileNode *preview = nullptr; //!< partial output of the running job
+      TileNode *progressivePreview = nullptr; //!< priority layers of the whole view
+      TileNode *labels = nullptr; //!< labels of the whole view, over all tiles
+  };
+}
+
+QSGNode *QgsQuickMapCanvasMap::updateTilesPaintNode( QSGNode *oldNode )
+{
+  TilesNode *root = static_cast<TilesNode *>( oldNode );
+  if ( !root )
+    root = new TilesNode();
+
+  const QgsMapSettings mapSettings = mMapSettings->mapSettings();
+  const QgsRectangle visibleExtent = mapSettings.visibleExtent();
+  const double mapUnitsPerPixel = mapSettings.mapUnitsPerPixel();
+  if ( visibleExtent.isEmpty() || mapUnitsPerPixel <= 0 )
+    return root;
+
+  const qint64 zoom = QgsQuickMapTiles::zoomLevel( mapUnitsPerPixel );
+
+  auto itemRect = [&]( const QgsRectangle & extent )
+  {
+    return QRectF( ( extent.xMinimum() - visibleExtent.xMinimum() ) / mapUnitsPerPixel,
+                   ( visibleExtent.yMaximum() - extent.yMaximum() ) / mapUnitsPerPixel,
+                   extent.width() / mapUnitsPerPixel,
+                   extent.height() / mapUnitsPerPixel );
+  };
+
+  auto updateNode = [&]( TileNode * node, const QImage & image, const QgsRectangle & extent ) -> TileNode *
+  {
+    if ( node && node->imageKey != image.cacheKey() )
+    {
+      delete node;
+      node = nullptr;
+    }
+
+    if ( !node )
+    {
+      node = new TileNode();
+      node->setTexture( window()->createTextureFromImage( image ) );
+      node->setOwnsTexture( true );
+      node->setFiltering( QSGTexture::Linear );
+      node->imageKey = image.cacheKey();
+    }
+    node->setRect( itemRect( extent ) );
+    return node;
+  };
+
+  // Tiles of all stored zoom levels in view, the ones closest to the current zoom level on top.
+  // Tiles of other zoom levels fill the gaps until the current zoom level is rendered.
+  QList<QgsQuickMapTiles::Key> keys;
+  const QSet<qint64> zooms = mTiles.zoomLevels();
+  for ( qint64 z : zooms )
+    keys << mTiles.tiles( QgsQuickMapTiles::tilesInExtent( z, visibleExtent ) );
+
+  // valid tiles of the current zoom level go on top, the preview is placed below them
+  auto isCurrent = [&]( const QgsQuickMapTiles::Key & key )
+  {
+    return key.zoom == zoom && mTiles.contains( key );
+  };
+
+  std::stable_sort( keys.begin(), keys.end(), [&]( const QgsQuickMapTiles::Key & a, const QgsQuickMapTiles::Key & b )
+  {
+    if ( isCurrent( a ) != isCurrent( b ) )
+      return isCurrent( b );
+    return std::llabs( a.zoom - zoom ) > std::llabs( b.zoom - zoom );
+  } );
+
+  root->removeAllChildNodes();
+  QHash<QgsQuickMapTiles::Key, TileNode *> previousTiles = root->tiles;
+  root->tiles.clear();
+
+  bool previewAdded = false;
+  auto addPreview = [&]()
+  {
+    previewAdded = true;
+    if ( mPreview.isNull() )
+      return;
+
+    root->progressivePreview = updateNode( root->progressivePreview, mPreview, mPreviewExtent );
+    root->appendChildNode( root->progressivePreview );
+  };
+
+  for ( const QgsQuickMapTiles::Key &key : qAsConst( keys ) )
+  {
+    if ( !previewAdded && isCurrent( key ) )
+      addPreview();
+
+    TileNode *node = updateNode( previousTiles.take( key ), mTiles.tile( key ), QgsQuickMapTiles::extent( key ) );
+    root->appendChildNode( node );
+    root->tiles.insert( key, node );
+  }
+  qDeleteAll( previousTiles );
+
+  if ( !previewAdded )
+    addPreview();
+
+  if ( mPreview.isNull() )
+  {
+    delete root->progressivePreview;
+    root->progressivePreview = nullptr;
+  }
+
+  if ( !mJobPreview.isNull() && !mJobTiles.isEmpty() )
+  {
+    root->preview = updateNode( root->preview, mJobPreview, QgsQuickMapTiles::extent( mJobTiles ) );
+    root->appendChildNode( root->preview );
+  }
+  else
+  {
+    delete root->preview;
+    root->preview = nullptr;
+  }
+
+  // labels placed for another zoom level would not match the tiles, they are hidden until placed again
+  const bool labelsMatch = !mLabels.isNull() &&
+                           qgsDoubleNear( mLabelsExtent.width() / mLabels.width(), mapUnitsPerPixel, mapUnitsPerPixel * 0.001 );
+  if ( labelsMatch )
+  {
+    root->labels = updateNode( root->labels, mLabels, mLabelsExtent );
+    root->appendChildNode( root->labels );
+  }
+  else
+  {
+    delete root->labels;
+    root->labels = nullptr;
+  }
+
+  return root;
+}
+
 void QgsQuickMapCanvasMap::geometryChanged( const QRectF &newGeometry, const QRectF &oldGeometry )
 {
   Q_UNUSED( oldGeometry )
@@ -345,10 +1024,10 @@ void QgsQuickMapCanvasMap::onLayersChanged()
   const QList<QgsMapLayer *> layers = mMapSettings->layers();
   for ( QgsMapLayer *layer : layers )
   {
-    mLayerConnections << connect( layer, &QgsMapLayer::repaintRequested, this, &QgsQuickMapCanvasMap::refresh );
+    mLayerConnections << connect( layer, &QgsMapLayer::repaintRequested, this, &QgsQuickMapCanvasMap::invalidateTiles );
   }
 
-  refresh();
+  invalidateTiles();
 }
 
 void QgsQuickMapCanvasMap::destroyJob( QgsMapRendererJob *job )
@@ -359,6 +1038,9 @@ void QgsQuickMapCanvasMap::destroyJob( QgsMapRendererJob *job )
 
 void QgsQuickMapCanvasMap::stopRendering()
 {
+  stopPreviewJob();
+  stopLabelJob();
+
   if ( mJob )
   {
     disconnect( mJob, &QgsMapRendererJob::renderingLayersFinished, this, &QgsQuickMapCanvasMap::renderJobUpdated );
@@ -367,6 +1049,12 @@ void QgsQuickMapCanvasMap::stopRendering()
     mJob->cancelWithoutBlocking();
     mJob = nullptr;
   }
+
+  mMapUpdateTimer.stop();
+  mJobTiles = QgsQuickMapTiles::Range();
+  mJobPreview = QImage();
+  mJobLayerKeys.clear();
+  mJobCache = nullptr;
 }
 
 void QgsQuickMapCanvasMap::zoomToFullExtent()
@@ -20,6 +20,8 @@
 
 #include <QtQuick/QQuickItem>
 #include <QFutureSynchronizer>
+#include <QFutureWatcher>
+#include <QPointer>
 #include <QTimer>
 
 #include "qgsmapsettings.h"
@@ -27,6 +29,8 @@
 
 #include "qgis_quick.h"
 #include "qgsquickmapsettings.h"
+#include "qgsquickmaptiles.h"
+#include "qgsquickmapdiskcache.h"
 
 class QgsMapRendererParallelJob;
 class QgsMapRendererCache;
@@ -88,10 +92,43 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
      */
     Q_PROPERTY( bool incrementalRendering READ incrementalRendering WRITE setIncrementalRendering NOTIFY incrementalRenderingChanged )
 
+    /**
+     * When the tiledRendering property is set to TRUE, the map is rendered in tiles that are kept
+     * for the zoom levels seen recently. Panning re-uses tiles still in view and renders only the newly
+     * exposed ones. Tiles of other zoom levels are shown scaled until the current zoom level is rendered.
+     * Labels are not part of the tiles, they are placed for the whole view once its tiles are rendered.
+     * Default is FALSE.
+     */
+    Q_PROPERTY( bool tiledRendering READ tiledRendering WRITE setTiledRendering NOTIFY tiledRenderingChanged )
+
+    /**
+     * Directory for persistent cache of rendered tiles of static layers (local raster files).
+     * Cached tiles are used instead of rendering these layers again, also after restart.
+     * This only has an effect if tiledRendering is activated. Empty string disables the cache.
+     * Default is empty.
+     */
+    Q_PROPERTY( QString renderCacheDir READ renderCacheDir WRITE setRenderCacheDir NOTIFY renderCacheDirChanged )
+
+    /**
+     * When the progressiveRendering property is set to TRUE, each refresh starts with a fast preview
+     * of the priority layers only (half resolution, no antialiasing or labels). The preview is shown
+     * over the previous map image moved to the new extent, then the full rendering of all layers follows.
+     * The preview is cancelled when the extent changes before it finishes.
+     * Default is FALSE.
+     */
+    Q_PROPERTY( bool progressiveRendering READ progressiveRendering WRITE setProgressiveRendering NOTIFY progressiveRenderingChanged )
+
+    /**
+     * Layers rendered in the preview of progressive rendering.
+     * When empty, the editable vector layers of the map settings are used.
+     * Default is empty.
+     */
+    Q_PROPERTY( QList<QgsMapLayer *> priorityLayers READ priorityLayers WRITE setPriorityLayers NOTIFY priorityLayersChanged )
+
   public:
     //! Create map canvas map
     QgsQuickMapCanvasMap( QQuickItem *parent = nullptr );
-    ~QgsQuickMapCanvasMap() = default;
+    ~QgsQuickMapCanvasMap() override;
 
     QSGNode *updatePaintNode( QSGNode *oldNode, QQuickItem::UpdatePaintNodeData * ) override;
 
@@ -119,6 +156,30 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
     //! \copydoc QgsQuickMapCanvasMap::incrementalRendering
     void setIncrementalRendering( bool incrementalRendering );
 
+    //! \copydoc QgsQuickMapCanvasMap::tiledRendering
+    bool tiledRendering() const;
+
+    //! \copydoc QgsQuickMapCanvasMap::tiledRendering
+    void setTiledRendering( bool tiledRendering );
+
+    //! \copydoc QgsQuickMapCanvasMap::renderCacheDir
+    QString renderCacheDir() const;
+
+    //! \copydoc QgsQuickMapCanvasMap::renderCacheDir
+    void setRenderCacheDir( const QString &renderCacheDir );
+
+    //! \copydoc QgsQuickMapCanvasMap::progressiveRendering
+    bool progressiveRendering() const;
+
+    //! \copydoc QgsQuickMapCanvasMap::progressiveRendering
+    void setProgressiveRendering( bool progressiveRendering );
+
+    //! \copydoc QgsQuickMapCanvasMap::priorityLayers
+    QList<QgsMapLayer *> priorityLayers() const;
+
+    //! \copydoc QgsQuickMapCanvasMap::priorityLayers
+    void setPriorityLayers( const QList<QgsMapLayer *> &priorityLayers );
+
   signals:
 
     /**
@@ -143,6 +204,18 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
     //!\copydoc QgsQuickMapCanvasMap::incrementalRendering
     void incrementalRenderingChanged();
 
+    //!\copydoc QgsQuickMapCanvasMap::tiledRendering
+    void tiledRenderingChanged();
+
+    //!\copydoc QgsQuickMapCanvasMap::renderCacheDir
+    void renderCacheDirChanged();
+
+    //!\copydoc QgsQuickMapCanvasMap::progressiveRendering
+    void progressiveRenderingChanged();
+
+    //!\copydoc QgsQuickMapCanvasMap::priorityLayers
+    void priorityLayersChanged();
+
   protected:
     void geometryChanged( const QRectF &newGeometry, const QRectF &oldGeometry ) override;
 
@@ -170,11 +243,22 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
     void refreshMap();
     void renderJobUpdated();
     void renderJobFinished();
+    void previewJobFinished();
+    void labelJobFinished();
     void onWindowChanged( QQuickWindow *window );
     void onScreenChanged( QScreen *screen );
     void onExtentChanged();
     void onLayersChanged();
 
+    //! Marks rendered tiles as outdated (they are shown until rendered again) and refreshes the map
+    void invalidateTiles();
+
+    //! Removes rendered tiles that can no longer be shown, e.g. after CRS change
+    void clearTiles();
+
+    //! Starts the tiles job with cached images of static layers read from the disk cache
+    void onDiskCacheLoaded();
+
   private:
 
     /**
@@ -182,9 +266,46 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
      */
     void destroyJob( QgsMapRendererJob *job );
     QgsMapSettings prepareMapSettings() const;
+    void startJob( const QgsMapSettings &mapSettings, QgsMapRendererCache *cache = nullptr );
+
+    /**
+     * Starts the preview of priority layers for the map settings of the full rendering.
+     * Returns false if there is nothing to preview, i.e. progressive rendering is off,
+     * or the map has no priority layers or only priority layers.
+     */
+    bool startPreviewJob( const QgsMapSettings &mapSettings );
+
+    //! Cancels the preview job, if any
+    void stopPreviewJob();
+
+    //! Returns true if the layer is rendered in the preview
+    bool isPriorityLayer( QgsMapLayer *layer ) const;
     void updateTransform();
     void zoomToFullExtent();
 
+    //! Queues rendering of tiles missing in the current view and starts it, if not already running
+    void refreshTiles();
+
+    //! Starts rendering of the next queued block of tiles, returns false if there is none
+    bool startNextTileJob();
+
+    /**
+     * Starts placement of labels for the whole view (shown over the tiles), returns false
+     * if the labels of the view are rendered already
+     */
+    bool startLabelJob();
+
+    //! Cancels the labels job, if any
+    void stopLabelJob();
+
+    //! Returns range of tiles of the current zoom level needed for the current view
+    QgsQuickMapTiles::Range visibleTiles() const;
+
+    //! Returns how many tiles are kept in memory for the current output size
+    int maximumTiles() const;
+
+    QSGNode *updateTilesPaintNode( QSGNode *oldNode );
+
     std::unique_ptr<QgsQuickMapSettings> mMapSettings;
     bool mPinching = false;
     QPoint mPinchStartPoint;
@@ -200,6 +321,31 @@ class QUICK_EXPORT QgsQuickMapCanvasMap : public QQuickItem
     QList<QMetaObject::Connection> mLayerConnections;
     QTimer mMapUpdateTimer;
     bool mIncrementalRendering = false;
+
+    bool mTiledRendering = false;
+    QgsQuickMapTiles mTiles;
+    QgsQuickMapTiles::Range mJobTiles; //!< tiles rendered by the current job
+    QList<QgsQuickMapTiles::Range> mTilesQueue; //!< blocks of tiles waiting for rendering
+    QImage mJobPreview; //!< partial output of the current tiles job with incremental rendering
+
+    QgsQuickMapDiskCache mDiskCache;
+    QFutureWatcher<QHash<QString, QImage>> mDiskCacheLoad;
+    QList<QFuture<void>> mDiskCacheWrites;
+    QgsMapSettings mJobSettings; //!< settings of the tiles job waiting for the disk cache
+    QHash<QString, QString> mJobLayerKeys; //!< disk cache keys of static layers in the tiles job, by layer id
+    QPointer<QgsMapRendererCache> mJobCache; //!< owned by the job
+
+    bool mProgressiveRendering = false;
+    QStringList mPriorityLayerIds;
+    QgsMapRendererParallelJob *mPreviewJob = nullptr;
+    QImage mPreview; //!< preview of priority layers shown below the valid tiles in tiled rendering
+    QgsRectangle mPreviewExtent;
+
+    QgsMapRendererParallelJob *mLabelJob = nullptr;
+    QPointer<QgsMapRendererCache> mLabelJobCache; //!< owned by the labels job, receives the image of the labels
+    QImage mLabels; //!< labels of the whole view shown over the tiles in tiled rendering
+    QgsRectangle mLabelsExtent;
+    bool mLabelsValid = false; //!< whether the labels are up to date for mLabelsExtent
 };
 
 #endif // QGSQUICKMAPCANVASMAP_H
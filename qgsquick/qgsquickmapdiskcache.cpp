@@ -0,0 +1,231 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <algorithm>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include "qgsmaplayer.h"
+#include "qgsmaplayerstyle.h"
+#include "qgsmapsettings.h"
+#include "qgsproviderregistry.h"
+#include "qgsrasterlayer.h"
+
+#include "qgsquickmapdiskcache.h"
+
+QString QgsQuickMapDiskCache::directory() const
+{
+  return mDirectory;
+}
+
+void QgsQuickMapDiskCache::setDirectory( const QString &directory )
+{
+  if ( mDirectory == directory )
+    return;
+
+  mDirectory = directory;
+  mLayerKeys.clear();
+
+  if ( !mDirectory.isEmpty() )
+    QtConcurrent::run( &QgsQuickMapDiskCache::trim, mDirectory, qint64( MAX_CACHE_SIZE ) );
+}
+
+bool QgsQuickMapDiskCache::isEnabled() const
+{
+  return !mDirectory.isEmpty();
+}
+
+bool QgsQuickMapDiskCache::isCacheable( const QgsMapLayer *layer )
+{
+  // local raster files do not change while the map is shown, unlike vector layers that are edited
+  // or online services that can be updated on the server
+  const QgsRasterLayer *rasterLayer = qobject_cast<const QgsRasterLayer *>( layer );
+  return rasterLayer && rasterLayer->isValid() && rasterLayer->providerType() == QLatin1String( "gdal" );
+}
+
+QString QgsQuickMapDiskCache::layerKey( QgsMapLayer *layer, const QgsMapSettings &mapSettings )
+{
+  auto it = mLayerKeys.constFind( layer->id() );
+  if ( it != mLayerKeys.constEnd() )
+    return it.value();
+
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+  // source, including changes of the file itself (e.g. after synchronization)
+  hash.addData( layer->source().toUtf8() );
+  const QVariantMap uriParts = QgsProviderRegistry::instance()->decodeUri( layer->providerType(), layer->source() );
+  const QFileInfo fileInfo( uriParts.value( QStringLiteral( "path" ) ).toString() );
+  hash.addData( QByteArray::number( fileInfo.size() ) );
+  hash.addData( QByteArray::number( fileInfo.lastModified().toMSecsSinceEpoch() ) );
+
+  // style
+  QgsMapLayerStyle style;
+  style.readFromLayer( layer );
+  hash.addData( style.xmlData().toUtf8() );
+
+  // map settings that change the rendered image for the same tile
+  hash.addData( mapSettings.destinationCrs().toWkt().toUtf8() );
+  hash.addData( QByteArray::number( mapSettings.outputDpi() ) );
+
+  // zoom levels of tiles stored with another grid have different resolutions
+  hash.addData( QByteArray::number( QgsQuickMapTiles::ZOOM_LEVELS_PER_OCTAVE ) );
+
+  // layer ids are generated from layer names, so they can contain about anything
+  QString layerDir = layer->id();
+  layerDir.replace( QRegularExpression( QStringLiteral( "[^A-Za-z0-9_.-]" ) ), QStringLiteral( "_" ) );
+
+  const QString key = layerDir + QStringLiteral( "/" ) + QString::fromLatin1( hash.result().toHex().left( 16 ) );
+  mLayerKeys.insert( layer->id(), key );
+
+  if ( !mDirectory.isEmpty() )
+    QtConcurrent::run( &QgsQuickMapDiskCache::removeOutdatedTiles, mDirectory, key );
+
+  return key;
+}
+
+void QgsQuickMapDiskCache::clearLayerKeys()
+{
+  mLayerKeys.clear();
+}
+
+QString QgsQuickMapDiskCache::tilePath( const QString &directory, const QString &layerKey, const QgsQuickMapTiles::Key &key )
+{
+  return QStringLiteral( "%1/%2/%3/%4_%5.png" ).arg( directory, layerKey ).arg( key.zoom ).arg( key.column ).arg( key.row );
+}
+
+QHash<QString, QImage> QgsQuickMapDiskCache::loadTiles( const QString &directory, const QHash<QString, QString> &layerKeys, const QgsQuickMapTiles::Range &range )
+{
+  QHash<QString, QImage> images;
+
+  for ( auto it = layerKeys.constBegin(); it != layerKeys.constEnd(); ++it )
+  {
+    QImage image( range.columnCount() * QgsQuickMapTiles::TILE_SIZE, range.rowCount() * QgsQuickMapTiles::TILE_SIZE, QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::transparent );
+
+    bool complete = true;
+    {
+      QPainter painter( &image );
+      for ( int row = range.firstRow; row <= range.lastRow && complete; ++row )
+      {
+        for ( int column = range.firstColumn; column <= range.lastColumn && complete; ++column )
+        {
+          QgsQuickMapTiles::Key key;
+          key.zoom = range.zoom;
+          key.column = column;
+          key.row = row;
+
+          const QImage tile( tilePath( directory, it.value(), key ) );
+          if ( tile.isNull() )
+          {
+            complete = false;
+            break;
+          }
+
+          painter.drawImage( ( column - range.firstColumn ) * QgsQuickMapTiles::TILE_SIZE,
+                             ( row - range.firstRow ) * QgsQuickMapTiles::TILE_SIZE,
+                             tile );
+        }
+      }
+    }
+
+    if ( complete )
+      images.insert( it.key(), image );
+  }
+
+  return images;
+}
+
+void QgsQuickMapDiskCache::saveTiles( const QString &directory, const QString &layerKey, const QgsQuickMapTiles::Range &range, const QImage &image )
+{
+  if ( range.isEmpty() || image.isNull() )
+    return;
+
+  const int tileWidth = image.width() / range.columnCount();
+  const int tileHeight = image.height() / range.rowCount();
+
+  QgsQuickMapTiles::Key key;
+  key.zoom = range.zoom;
+
+  const QString zoomDir = QFileInfo( tilePath( directory, layerKey, key ) ).absolutePath();
+  if ( !QDir().mkpath( zoomDir ) )
+    return;
+
+  for ( int row = range.firstRow; row <= range.lastRow; ++row )
+  {
+    for ( int column = range.firstColumn; column <= range.lastColumn; ++column )
+    {
+      key.column = column;
+      key.row = row;
+
+      // written via temporary file, so a crash can't leave a broken tile behind
+      QSaveFile file( tilePath( directory, layerKey, key ) );
+      if ( !file.open( QIODevice::WriteOnly ) )
+        return;
+
+      const QImage tile = image.copy( ( column - range.firstColumn ) * tileWidth, ( row - range.firstRow ) * tileHeight, tileWidth, tileHeight );
+      if ( tile.save( &file, "PNG" ) )
+        file.commit();
+      else
+        file.cancelWriting();
+    }
+  }
+}
+
+void QgsQuickMapDiskCache::removeOutdatedTiles( const QString &directory, const QString &layerKey )
+{
+  const QString layerDir = layerKey.section( '/', 0, 0 );
+  const QString currentHash = layerKey.section( '/', 1, 1 );
+
+  QDir dir( directory + QStringLiteral( "/" ) + layerDir );
+  const QStringList hashes = dir.entryList( QDir::Dirs | QDir::NoDotAndDotDot );
+  for ( const QString &hash : hashes )
+  {
+    if ( hash != currentHash )
+      QDir( dir.filePath( hash ) ).removeRecursively();
+  }
+}
+
+void QgsQuickMapDiskCache::trim( const QString &directory, qint64 maxSize )
+{
+  QList<QFileInfo> files;
+  qint64 totalSize = 0;
+
+  QDirIterator it( directory, QStringList() << QStringLiteral( "*.png" ), QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() )
+  {
+    it.next();
+    files << it.fileInfo();
+    totalSize += it.fileInfo().size();
+  }
+
+  if ( totalSize <= maxSize )
+    return;
+
+  std::sort( files.begin(), files.end(), []( const QFileInfo & a, const QFileInfo & b )
+  {
+    return a.lastModified() < b.lastModified();
+  } );
+
+  for ( const QFileInfo &file : qAsConst( files ) )
+  {
+    if ( totalSize <= maxSize )
+      break;
+
+    if ( QFile::remove( file.absoluteFilePath() ) )
+      totalSize -= file.size();
+  }
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSQUICKMAPDISKCACHE_H
+#define QGSQUICKMAPDISKCACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QString>
+
+#include "qgis_quick.h"
+#include "qgsquickmaptiles.h"
+
+class QgsMapLayer;
+class QgsMapSettings;
+
+/**
+ * \ingroup quick
+ * \brief Persistent cache of rendered tiles of static layers, used by QgsQuickMapCanvasMap in tiled rendering mode.
+ *
+ * Only layers that do not change while the map is shown are cached, i.e. raster layers from local files.
+ * Each layer is rendered to its own transparent tiles, stored as PNG files in
+ * `<directory>/<layer id>/<layer hash>/<zoom>/<column>_<row>.png`.
+ *
+ * The layer hash covers the layer source (including size and modification time of the file), style
+ * and the map settings that affect rendering. When any of these changes, tiles are stored
+ * under a new hash and tiles under the old one are removed.
+ *
+ * Static functions that read and write tiles are thread safe, so they can run on worker threads.
+ */
+class QUICK_EXPORT QgsQuickMapDiskCache
+{
+  public:
+    //! Maximum size of all cached tiles in bytes, the oldest ones are removed when exceeded
+    static const qint64 MAX_CACHE_SIZE = 256 * 1024 * 1024;
+
+    //! Returns directory of the cache, empty if disabled
+    QString directory() const;
+
+    /**
+     * Sets directory of the cache, empty directory disables the cache.
+     * Trims the content of the directory to MAX_CACHE_SIZE in the background.
+     */
+    void setDirectory( const QString &directory );
+
+    //! Returns true if the cache has a directory
+    bool isEnabled() const;
+
+    //! Returns true if rendered tiles of the layer can be cached
+    static bool isCacheable( const QgsMapLayer *layer );
+
+    /**
+     * Returns key of the layer's tiles in the cache, "<layer id>/<layer hash>".
+     * Keys are computed once and kept until clearLayerKeys() is called.
+     */
+    QString layerKey( QgsMapLayer *layer, const QgsMapSettings &mapSettings );
+
+    //! Forgets computed layer keys, so they are computed again with the next request (e.g. after a style change)
+    void clearLayerKeys();
+
+    //! Returns path of the tile file
+    static QString tilePath( const QString &directory, const QString &layerKey, const QgsQuickMapTiles::Key &key );
+
+    /**
+     * Reads tiles of the range for each of the layer keys (by layer id) and joins them to a single image.
+     * Layers with any of the tiles missing get no image.
+     */
+    static QHash<QString, QImage> loadTiles( const QString &directory, const QHash<QString, QString> &layerKeys, const QgsQuickMapTiles::Range &range );
+
+    //! Cuts image of the layer rendered for the range into tiles and writes them
+    static void saveTiles( const QString &directory, const QString &layerKey, const QgsQuickMapTiles::Range &range, const QImage &image );
+
+    //! Removes tiles of the layer stored with other than the current layer hash
+    static void removeOutdatedTiles( const QString &directory, const QString &layerKey );
+
+    //! Removes the least recently written tiles, so all tiles in the directory take at most maxSize bytes
+    static void trim( const QString &directory, qint64 maxSize );
+
+  private:
+    QString mDirectory;
+    QHash<QString, QString> mLayerKeys; // by layer id
+};
+
+#endif // QGSQUICKMAPDISKCACHE_H
@@ -20,6 +20,7 @@
 #include "qgsproject.h"
 #include "qgis.h"
 
+#include "qgsquickcoordinatetransformcache.h"
 #include "qgsquickmapsettings.h"
 
 QgsQuickMapSettings::QgsQuickMapSettings( QObject *parent )
@@ -27,6 +28,10 @@ QgsQuickMapSettings::QgsQuickMapSettings( QObject *parent )
 {
   // Connect signals for derived values
   connect( this, &QgsQuickMapSettings::destinationCrsChanged, this, &QgsQuickMapSettings::mapUnitsPerPixelChanged );
+
+  // transforms to the old CRS or with the old context are not needed anymore
+  connect( this, &QgsQuickMapSettings::destinationCrsChanged, this, &QgsQuickCoordinateTransformCache::clear );
+  connect( this, &QgsQuickMapSettings::transformContextChanged, this, &QgsQuickCoordinateTransformCache::clear );
   connect( this, &QgsQuickMapSettings::extentChanged, this, &QgsQuickMapSettings::mapUnitsPerPixelChanged );
   connect( this, &QgsQuickMapSettings::outputSizeChanged, this, &QgsQuickMapSettings::mapUnitsPerPixelChanged );
   connect( this, &QgsQuickMapSettings::extentChanged, this, &QgsQuickMapSettings::visibleExtentChanged );
@@ -51,6 +56,7 @@ void QgsQuickMapSettings::setProject( QgsProject *project )
   if ( mProject )
   {
     connect( mProject, &QgsProject::readProject, this, &QgsQuickMapSettings::onReadProject );
+    connect( mProject, &QgsProject::transformContextChanged, this, &QgsQuickMapSettings::onProjectTransformContextChanged );
     setDestinationCrs( mProject->crs() );
     mMapSettings.setTransformContext( mProject->transformContext() );
   }
@@ -59,6 +65,7 @@ void QgsQuickMapSettings::setProject( QgsProject *project )
     mMapSettings.setTransformContext( QgsCoordinateTransformContext() );
   }
 
+  emit transformContextChanged();
   emit projectChanged();
 }
 
@@ -188,6 +195,15 @@ void QgsQuickMapSettings::setLayers( const QList<QgsMapLayer *> &layers )
   emit layersChanged();
 }
 
+void QgsQuickMapSettings::onProjectTransformContextChanged()
+{
+  if ( !mProject )
+    return;
+
+  mMapSettings.setTransformContext( mProject->transformContext() );
+  emit transformContextChanged();
+}
+
 void QgsQuickMapSettings::onReadProject( const QDomDocument &doc )
 {
   if ( mProject )
@@ -257,6 +257,9 @@ class QUICK_EXPORT QgsQuickMapSettings : public QObject
     //! \copydoc QgsQuickMapSettings::layers
     void layersChanged();
 
+    //! Emitted when the transform context of the map settings changes, e.g. when the project changes it
+    void transformContextChanged();
+
   private slots:
 
     /**
@@ -266,6 +269,9 @@ class QUICK_EXPORT QgsQuickMapSettings : public QObject
      */
     void onReadProject( const QDomDocument &doc );
 
+    //! Takes over transform context of the project
+    void onProjectTransformContextChanged();
+
   private:
     QgsProject *mProject = nullptr;
     QgsMapSettings mMapSettings;
@@ -0,0 +1,254 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "qgsquickmaptiles.h"
+
+bool QgsQuickMapTiles::Range::contains( const Key &key ) const
+{
+  return key.zoom == zoom &&
+         key.column >= firstColumn && key.column <= lastColumn &&
+         key.row >= firstRow && key.row <= lastRow;
+}
+
+bool QgsQuickMapTiles::Range::intersects( const Range &other ) const
+{
+  return !isEmpty() && !other.isEmpty() && zoom == other.zoom &&
+         firstColumn <= other.lastColumn && other.firstColumn <= lastColumn &&
+         firstRow <= other.lastRow && other.firstRow <= lastRow;
+}
+
+qint64 QgsQuickMapTiles::zoomLevel( double mapUnitsPerPixel )
+{
+  // rounded down, so tiles get scaled down rather than up - the small offset keeps exact resolutions of levels on their level
+  return static_cast<qint64>( std::floor( std::log2( mapUnitsPerPixel ) * ZOOM_LEVELS_PER_OCTAVE + 1e-9 ) );
+}
+
+double QgsQuickMapTiles::resolution( qint64 zoom )
+{
+  return std::exp2( static_cast<double>( zoom ) / ZOOM_LEVELS_PER_OCTAVE );
+}
+
+QgsQuickMapTiles::Range QgsQuickMapTiles::tilesInExtent( qint64 zoom, const QgsRectangle &extent )
+{
+  Range range;
+  range.zoom = zoom;
+  if ( extent.isEmpty() )
+    return range;
+
+  // rows grow downwards from the origin, like pixels of the map image
+  const double tileSize = TILE_SIZE * resolution( zoom );
+  range.firstColumn = static_cast<int>( std::floor( extent.xMinimum() / tileSize ) );
+  range.lastColumn = static_cast<int>( std::ceil( extent.xMaximum() / tileSize ) ) - 1;
+  range.firstRow = static_cast<int>( std::floor( -extent.yMaximum() / tileSize ) );
+  range.lastRow = static_cast<int>( std::ceil( -extent.yMinimum() / tileSize ) ) - 1;
+  return range;
+}
+
+QgsRectangle QgsQuickMapTiles::extent( const Key &key )
+{
+  Range range;
+  range.zoom = key.zoom;
+  range.firstColumn = range.lastColumn = key.column;
+  range.firstRow = range.lastRow = key.row;
+  return extent( range );
+}
+
+QgsRectangle QgsQuickMapTiles::extent( const Range &range )
+{
+  const double tileSize = TILE_SIZE * resolution( range.zoom );
+  return QgsRectangle( range.firstColumn * tileSize,
+                       -( range.lastRow + 1 ) * tileSize,
+                       ( range.lastColumn + 1 ) * tileSize,
+                       -range.firstRow * tileSize );
+}
+
+bool QgsQuickMapTiles::contains( const Key &key ) const
+{
+  auto it = mTiles.constFind( key );
+  return it != mTiles.constEnd() && it->generation == mGeneration;
+}
+
+QImage QgsQuickMapTiles::tile( const Key &key ) const
+{
+  return mTiles.value( key ).image;
+}
+
+QSet<qint64> QgsQuickMapTiles::zoomLevels() const
+{
+  QSet<qint64> zooms;
+  for ( auto it = mTiles.constBegin(); it != mTiles.constEnd(); ++it )
+    zooms.insert( it.key().zoom );
+  return zooms;
+}
+
+QList<QgsQuickMapTiles::Key> QgsQuickMapTiles::tiles( const Range &range ) const
+{
+  QList<Key> keys;
+  for ( auto it = mTiles.constBegin(); it != mTiles.constEnd(); ++it )
+  {
+    if ( range.contains( it.key() ) )
+      keys << it.key();
+  }
+  return keys;
+}
+
+bool QgsQuickMapTiles::isComplete( const Range &range ) const
+{
+  return missing( range ).isEmpty();
+}
+
+void QgsQuickMapTiles::insert( const Range &range, const QImage &image )
+{
+  if ( range.isEmpty() || image.isNull() )
+    return;
+
+  // the image can be larger than the range in pixels on high DPI screens
+  const int tileWidth = image.width() / range.columnCount();
+  const int tileHeight = image.height() / range.rowCount();
+
+  for ( int row = range.firstRow; row <= range.lastRow; ++row )
+  {
+    for ( int column = range.firstColumn; column <= range.lastColumn; ++column )
+    {
+      Key key;
+      key.zoom = range.zoom;
+      key.column = column;
+      key.row = row;
+
+      Tile tile;
+      tile.image = image.copy( ( column - range.firstColumn ) * tileWidth, ( row - range.firstRow ) * tileHeight, tileWidth, tileHeight );
+      tile.generation = mGeneration;
+      mTiles.insert( key, tile );
+    }
+  }
+}
+
+QList<QgsQuickMapTiles::Range> QgsQuickMapTiles::missing( const Range &range, const Range &pending ) const
+{
+  QList<Range> blocks;
+  if ( range.isEmpty() )
+    return blocks;
+
+  // blocks that may still grow by the next row
+  QList<Range> open;
+
+  for ( int row = range.firstRow; row <= range.lastRow; ++row )
+  {
+    // runs of missing tiles in this row
+    QList<Range> runs;
+    for ( int column = range.firstColumn; column <= range.lastColumn; ++column )
+    {
+      Key key;
+      key.zoom = range.zoom;
+      key.column = column;
+      key.row = row;
+
+      if ( contains( key ) || pending.contains( key ) )
+        continue;
+
+      if ( !runs.isEmpty() && runs.last().lastColumn == column - 1 )
+      {
+        runs.last().lastColumn = column;
+      }
+      else
+      {
+        Range run;
+        run.zoom = range.zoom;
+        run.firstColumn = run.lastColumn = column;
+        run.firstRow = run.lastRow = row;
+        runs << run;
+      }
+    }
+
+    // extend blocks from the previous row by runs spanning the same columns
+    QList<Range> stillOpen;
+    for ( Range &run : runs )
+    {
+      auto block = std::find_if( open.begin(), open.end(), [&run]( const Range & b )
+      {
+        return b.firstColumn == run.firstColumn && b.lastColumn == run.lastColumn;
+      } );
+
+      if ( block != open.end() )
+      {
+        block->lastRow = row;
+        stillOpen << *block;
+        open.erase( block );
+      }
+      else
+      {
+        stillOpen << run;
+      }
+    }
+
+    blocks << open;
+    open = stillOpen;
+  }
+
+  blocks << open;
+  return blocks;
+}
+
+void QgsQuickMapTiles::trim( int maximumTiles, const Range &keep )
+{
+  if ( mTiles.size() <= maximumTiles )
+    return;
+
+  const double keepColumn = ( keep.firstColumn + keep.lastColumn ) / 2.0;
+  const double keepRow = ( keep.firstRow + keep.lastRow ) / 2.0;
+
+  QList<Key> keys = mTiles.keys();
+  auto priority = [&]( const Key & key ) -> double
+  {
+    if ( keep.contains( key ) )
+      return 0.0;
+
+    double value = 1 + std::hypot( key.column - keepColumn, key.row - keepRow );
+    if ( key.zoom != keep.zoom )
+      value = std::numeric_limits<double>::max() / 2;
+
+    if ( !contains( key ) )
+      value += std::numeric_limits<double>::max() / 4;
+    return value;
+  };
+
+  // least important tiles go first
+  std::sort( keys.begin(), keys.end(), [&]( const Key & a, const Key & b )
+  {
+    return priority( a ) > priority( b );
+  } );
+
+  const int toRemove = mTiles.size() - maximumTiles;
+  for ( int i = 0; i < toRemove; ++i )
+    mTiles.remove( keys.at( i ) );
+}
+
+void QgsQuickMapTiles::invalidate()
+{
+  ++mGeneration;
+}
+
+void QgsQuickMapTiles::clear()
+{
+  mTiles.clear();
+}
+
+int QgsQuickMapTiles::count() const
+{
+  return mTiles.size();
+}
+
+uint qHash( const QgsQuickMapTiles::Key &key, uint seed )
+{
+  return qHash( key.zoom, seed ) ^ qHash( ( static_cast<quint64>( static_cast<quint32>( key.column ) ) << 32 ) | static_cast<quint32>( key.row ), seed );
+}
@@ -0,0 +1,146 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSQUICKMAPTILES_H
+#define QGSQUICKMAPTILES_H
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QSet>
+
+#include "qgsrectangle.h"
+
+#include "qgis_quick.h"
+
+/**
+ * \ingroup quick
+ * \brief Grid of rendered map tiles used by QgsQuickMapCanvasMap in tiled rendering mode.
+ *
+ * Tiles are squares of TILE_SIZE pixels aligned to the origin of the map CRS.
+ * Every zoom level has its own grid. Zoom levels are derived from map units per pixel
+ * in ZOOM_LEVELS_PER_OCTAVE steps per halving of the resolution, so the same
+ * resolution always maps to the same zoom level and grid. The steps are coarse, so that
+ * zooming by a pinch stays on the same grid for a while: tiles are rendered at the finer
+ * end of the step and shown scaled down to the current resolution.
+ *
+ * Invalidated tiles are kept until they are rendered again, so they can still be shown meanwhile.
+ */
+class QUICK_EXPORT QgsQuickMapTiles
+{
+  public:
+    //! Size of a tile side in pixels of the map output
+    static const int TILE_SIZE = 256;
+
+    //! Number of zoom levels between two resolutions that differ by factor of two
+    static const int ZOOM_LEVELS_PER_OCTAVE = 4;
+
+    //! Identifies a single tile
+    struct Key
+    {
+      qint64 zoom = 0;
+      int column = 0;
+      int row = 0;
+
+      bool operator==( const Key &other ) const
+      {
+        return zoom == other.zoom && column == other.column && row == other.row;
+      }
+    };
+
+    //! Rectangular block of tiles of one zoom level, both bounds are inclusive
+    struct Range
+    {
+      qint64 zoom = 0;
+      int firstColumn = 0;
+      int lastColumn = -1;
+      int firstRow = 0;
+      int lastRow = -1;
+
+      bool isEmpty() const { return lastColumn < firstColumn || lastRow < firstRow; }
+      int columnCount() const { return lastColumn - firstColumn + 1; }
+      int rowCount() const { return lastRow - firstRow + 1; }
+      bool contains( const Key &key ) const;
+      bool intersects( const Range &other ) const;
+    };
+
+    //! Returns zoom level for the given map units per pixel (the level's resolution is never coarser than that)
+    static qint64 zoomLevel( double mapUnitsPerPixel );
+
+    //! Returns map units per pixel of the zoom level
+    static double resolution( qint64 zoom );
+
+    //! Returns the smallest range of tiles of the zoom level that covers the extent
+    static Range tilesInExtent( qint64 zoom, const QgsRectangle &extent );
+
+    //! Returns map extent of the tile
+    static QgsRectangle extent( const Key &key );
+
+    //! Returns map extent of the range of tiles
+    static QgsRectangle extent( const Range &range );
+
+    //! Returns true if the tile is stored and has not been invalidated since
+    bool contains( const Key &key ) const;
+
+    //! Returns image of the tile, including invalidated tiles
+    QImage tile( const Key &key ) const;
+
+    //! Returns zoom levels with any stored tiles
+    QSet<qint64> zoomLevels() const;
+
+    //! Returns keys of all stored tiles in the range, including invalidated tiles
+    QList<Key> tiles( const Range &range ) const;
+
+    //! Returns true if all tiles of the range are stored and valid
+    bool isComplete( const Range &range ) const;
+
+    /**
+     * Cuts the image rendered for the range into tiles and stores them.
+     * The image is expected to cover exactly the extent of the range.
+     */
+    void insert( const Range &range, const QImage &image );
+
+    /**
+     * Returns blocks of tiles of the range that are neither valid nor in the pending range.
+     * Missing tiles are grouped to as few rectangular blocks as possible, so they can be rendered
+     * by a few map renderer jobs.
+     */
+    QList<Range> missing( const Range &range, const Range &pending = Range() ) const;
+
+    /**
+     * Removes tiles until at most maximumTiles are stored.
+     * Tiles outside of the kept range are removed first: tiles of other zoom levels before the tiles
+     * of the same zoom level, and tiles further away from the kept range before the closer ones.
+     * Invalidated tiles are removed before valid ones.
+     */
+    void trim( int maximumTiles, const Range &keep );
+
+    //! Marks all stored tiles as outdated, e.g. after a layer has changed
+    void invalidate();
+
+    //! Removes all tiles
+    void clear();
+
+    //! Returns number of stored tiles
+    int count() const;
+
+  private:
+    struct Tile
+    {
+      QImage image;
+      int generation = 0;
+    };
+
+    QHash<Key, Tile> mTiles;
+    int mGeneration = 0; //!< tiles of older generation have been invalidated
+};
+
+QUICK_EXPORT uint qHash( const QgsQuickMapTiles::Key &key, uint seed = 0 );
+
+#endif // QGSQUICKMAPTILES_H
@@ -45,6 +45,21 @@ NFAILURES=$(($NFAILURES+$?))
 $INPUT_EXECUTABLE --testFormEditors
 NFAILURES=$(($NFAILURES+$?))
 
+$INPUT_EXECUTABLE --testMapTiles
+NFAILURES=$(($NFAILURES+$?))
+
+$INPUT_EXECUTABLE --testFeatureHighlight
+NFAILURES=$(($NFAILURES+$?))
+
+$INPUT_EXECUTABLE --testSnappingKit
+NFAILURES=$(($NFAILURES+$?))
+
+$INPUT_EXECUTABLE --testTrackRecorder
+NFAILURES=$(($NFAILURES+$?))
+
+$INPUT_EXECUTABLE --testSyncBenchmark
+NFAILURES=$(($NFAILURES+$?))
+
 echo "Total $NFAILURES failures found in testing"
 
 exit $NFAILURES